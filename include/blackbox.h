@@ -0,0 +1,107 @@
+// include/blackbox.h - Чёрный ящик: телеметрия FC во flash-раздел из фоновой задачи
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "esp_partition.h"
+#include "blackbox_format.h"
+#include "fc_telemetry.h"
+
+namespace BlackboxConfig {
+    constexpr const char* PARTITION_LABEL = "blackbox";     // See partitions.csv
+    constexpr uint8_t BUFFER_BLOCKS = 8;            // Internal RAM between the FC task and flash
+    constexpr uint16_t DEFAULT_RATE_HZ = 250;
+    constexpr uint16_t MIN_RATE_HZ = 10;
+    constexpr uint16_t MAX_RATE_HZ = 500;
+    constexpr uint32_t WRITER_STACK = 4096;
+    constexpr UBaseType_t WRITER_PRIORITY = 4;      // Below the FC UART task
+    constexpr BaseType_t WRITER_CORE = 0;
+    constexpr size_t ERASE_STEP = 64 * 1024;        // One flash block erase per call
+}
+
+enum class BlackboxState : uint8_t {
+    DISABLED,       // No partition
+    IDLE,
+    LOGGING,
+    ERASING,
+    FULL            // Partition full; erase to log again
+};
+
+const char* blackboxStateName(BlackboxState state);
+
+struct BlackboxStats {
+    uint32_t records{0};
+    uint32_t dropped_records{0};    // No free buffer (flash fell behind) or log full
+    uint32_t blocks_written{0};
+    uint32_t write_errors{0};
+    uint32_t avg_write_us{0};
+    uint32_t max_write_us{0};
+    uint32_t max_queued{0};         // Peak sealed blocks waiting for flash
+};
+
+// Records are encoded on the FC UART task into RAM blocks; a writer task
+// programs full blocks to the partition in order. record() never waits: with
+// every buffer queued for flash it drops the record and counts it.
+//
+// Flash is only written, never erased, while logging: a sector erase stalls
+// both cores' caches for tens of ms, longer than the UART FIFO lasts at high
+// baud. `erase()` clears the partition beforehand, like an FC dataflash.
+class Blackbox {
+public:
+    Blackbox();
+
+    // Finds the partition and the end of the log already in it
+    bool begin();
+    bool start(uint16_t rate_hz = BlackboxConfig::DEFAULT_RATE_HZ);
+    void stop();
+    // Runs on the writer task; false while logging
+    bool erase();
+
+    // FC UART task
+    void record(FcField field, const FcTelemetry& telemetry);
+
+    BlackboxState getState() const { return state_; }
+    bool isLogging() const { return state_ == BlackboxState::LOGGING; }
+    uint16_t getRate() const { return rate_hz_; }
+    uint16_t getSession() const { return session_; }
+    // Bytes of complete blocks from the start of the partition
+    size_t getUsedBytes() const { return write_offset_; }
+    size_t getCapacity() const { return partition_ ? partition_->size : 0; }
+    bool read(size_t offset, uint8_t* buffer, size_t length) const;
+    const BlackboxStats& getStats() const { return stats_; }
+    void printStatus(Print& out = Serial) const;
+
+private:
+    static const uint8_t ERASE_REQUEST = 0xFE;      // In the full queue, after the blocks ahead of it
+
+    const esp_partition_t* partition_;
+    volatile BlackboxState state_;
+    uint16_t rate_hz_;
+    uint16_t session_;
+    uint32_t sequence_;
+    volatile size_t write_offset_;
+    volatile size_t erase_offset_;
+
+    uint8_t* buffers_;
+    QueueHandle_t free_queue_;
+    QueueHandle_t full_queue_;
+    SemaphoreHandle_t lock_;        // Current block: FC task vs stop()
+    TaskHandle_t writer_task_;
+    int current_;                   // Buffer being filled, -1 = none
+    BlackboxBlockWriter writer_;
+
+    size_t session_start_offset_;
+    unsigned long session_start_ms_;
+    BlackboxStats stats_;
+
+    static void writerTask(void* parameter);
+    void writeBlock(uint8_t index);
+    void eraseAll();
+    size_t findLogEnd();
+    bool takeBlock(uint32_t start_us);
+    void sealBlock();
+    uint8_t* buffer(uint8_t index) const { return buffers_ + (size_t)index * BlackboxFormat::BLOCK_SIZE; }
+};
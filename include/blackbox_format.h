@@ -0,0 +1,105 @@
+// include/blackbox_format.h - Формат блоков чёрного ящика (дельта + zigzag varint, CRC на блок)
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Pure C++ so tools/blackbox_decode.cpp reads the exact format the firmware writes.
+//
+// The log is a run of BLOCK_SIZE blocks written in order from the start of
+// the partition; the first erased block (magic 0xFFFFFFFF) ends it.
+// Layout, all fields little-endian:
+//   header  20 bytes: magic "BBX1", sequence u32 (blocks since erase), session u16,
+//           length u16 (payload bytes), start_us u32, crc32 u32
+//   payload records, then 0xFF up to BLOCK_SIZE (erased flash stays erased)
+//   record  tag u8 = field << 5 | value count,
+//           varint time delta (us since the previous record of the block, the first since start_us),
+//           per value a zigzag varint of the difference to the same value in the
+//           previous record of that field in this block (0 at the block start)
+// The CRC-32 (IEEE 802.3) covers header bytes 0..15 and the payload. Every
+// block decodes on its own, so a bad block costs only its own records.
+
+namespace BlackboxFormat {
+    constexpr uint32_t MAGIC = 0x31584242;          // "BBX1"
+    constexpr uint32_t ERASED = 0xFFFFFFFF;
+    constexpr size_t BLOCK_SIZE = 1024;
+    constexpr size_t HEADER_SIZE = 20;
+    constexpr size_t PAYLOAD_SIZE = BLOCK_SIZE - HEADER_SIZE;
+    constexpr size_t MAX_FIELDS = 8;                // 3 tag bits
+    constexpr size_t MAX_VALUES = 31;               // 5 tag bits
+    constexpr size_t MAX_VARINT = 5;
+}
+
+enum class BlackboxBlockStatus : uint8_t {
+    OK,
+    ERASED,         // End of the log
+    BAD_MAGIC,
+    BAD_LENGTH,
+    BAD_CRC
+};
+
+const char* blackboxBlockStatusName(BlackboxBlockStatus status);
+
+struct BlackboxBlockInfo {
+    uint32_t sequence{0};
+    uint16_t session{0};
+    uint16_t length{0};
+    uint32_t start_us{0};
+};
+
+struct BlackboxSample {
+    uint8_t field{0};
+    uint8_t count{0};
+    uint32_t time_us{0};            // start_us plus the deltas, esp_timer clock (wraps at 2^32)
+    int32_t values[BlackboxFormat::MAX_VALUES];
+};
+
+// Standard CRC-32; pass the previous result to continue over several buffers
+uint32_t blackboxCrc32(const uint8_t* data, size_t length, uint32_t crc = 0);
+
+// Header only, no CRC check: enough to find the end of the log
+BlackboxBlockStatus blackboxReadHeader(const uint8_t* block, BlackboxBlockInfo& info);
+
+// Encodes records into a caller-owned BLOCK_SIZE buffer
+class BlackboxBlockWriter {
+public:
+    BlackboxBlockWriter() : block_(nullptr), length_(0), records_(0), last_us_(0) {}
+
+    void begin(uint8_t* block, uint32_t sequence, uint16_t session, uint32_t start_us);
+    // False, and nothing written, when the record might not fit: finish() the block
+    bool append(uint8_t field, uint32_t time_us, const int32_t* values, size_t count);
+    // Header, CRC and 0xFF padding; the buffer is then ready for flash
+    void finish();
+
+    bool active() const { return block_ != nullptr; }
+    size_t length() const { return length_; }
+    uint32_t records() const { return records_; }
+
+private:
+    uint8_t* block_;
+    BlackboxBlockInfo info_;
+    size_t length_;
+    uint32_t records_;
+    uint32_t last_us_;
+    int32_t previous_[BlackboxFormat::MAX_FIELDS][BlackboxFormat::MAX_VALUES];
+};
+
+class BlackboxBlockReader {
+public:
+    BlackboxBlockReader() : block_(nullptr), offset_(0), last_us_(0), malformed_(false) {}
+
+    // Checks magic, length and CRC; records are readable only after OK
+    BlackboxBlockStatus open(const uint8_t* block);
+    const BlackboxBlockInfo& info() const { return info_; }
+    // False at the end of the payload or on a malformed record
+    bool next(BlackboxSample& sample);
+    bool malformed() const { return malformed_; }
+
+private:
+    const uint8_t* block_;
+    BlackboxBlockInfo info_;
+    size_t offset_;
+    uint32_t last_us_;
+    bool malformed_;
+    int32_t previous_[BlackboxFormat::MAX_FIELDS][BlackboxFormat::MAX_VALUES];
+};
@@ -0,0 +1,51 @@
+// include/camera_bench.h - Матрица замеров драйвера камеры (размер × качество × fb × режим × XCLK)
+#pragma once
+
+#include <Arduino.h>
+#include "ov2640.h"
+
+namespace CameraBenchConfig {
+    constexpr size_t MAX_VALUES = 6;            // Per axis
+    constexpr size_t MAX_COMBINATIONS = 96;
+    constexpr uint16_t DEFAULT_FRAMES = 60;
+    constexpr uint16_t MAX_FRAMES = 300;
+    constexpr uint8_t WARMUP_FRAMES = 5;        // AEC settles and the fb queue fills first
+    constexpr uint32_t COMBINATION_TIMEOUT_MS = 10000;
+}
+
+// One value list per driver parameter; a single value holds the axis fixed
+struct CameraBenchMatrix {
+    framesize_t sizes[CameraBenchConfig::MAX_VALUES];
+    uint8_t qualities[CameraBenchConfig::MAX_VALUES];
+    uint8_t fb_counts[CameraBenchConfig::MAX_VALUES];
+    camera_grab_mode_t grab_modes[CameraBenchConfig::MAX_VALUES];
+    uint8_t xclk_mhz[CameraBenchConfig::MAX_VALUES];
+    uint8_t size_count;
+    uint8_t quality_count;
+    uint8_t fb_count_count;
+    uint8_t grab_mode_count;
+    uint8_t xclk_count;
+    uint16_t frames;
+
+    // Every axis starts at the camera's current setting
+    void reset(const DriverSettings& current);
+    // "size"=hd,vga  "q"=12,25  "fb"=2,3  "grab"=empty,latest  "xclk"=10,20  "n"=60
+    bool set(const char* key, const char* values, size_t values_length);
+    size_t combinations() const;
+    DriverSettings at(size_t index, const DriverSettings& base) const;
+};
+
+const char* frameSizeName(framesize_t size);
+
+// Runs each combination through the normal capture path and prints one CSV
+// row per combination. Blocks the caller (streaming pauses) and restores the
+// driver settings, watchdog and statistics it found.
+class CameraBench {
+public:
+    static void printHeader(Print& out);
+    static bool run(OV2640Camera& camera, const CameraBenchMatrix& matrix, Print& out);
+
+private:
+    static void measure(OV2640Camera& camera, const DriverSettings& settings, uint16_t frames,
+                        size_t free_internal, size_t free_psram, Print& out);
+};
@@ -2,33 +2,90 @@
 #pragma once
 
 #include <Arduino.h>
+#include "command_table.h"
+#include "control_channel.h"
+#include "event_loop.h"
 
 class SystemManager; // Forward declaration
+struct CommandTable; // Compile-time dispatch table (command_handler.cpp)
 
 class CommandHandler {
 private:
+    friend struct CommandTable;
+
     SystemManager* systemManager;
+    LineReader<CommandConfig::MAX_LINE_LENGTH> lineReader;
+    ControlChannel controlChannel;
+    Print* out;     // Sink of the command being executed (Serial or a network response)
     
     // Command processing
-    void processCommand(const String& command);
-    void showHelp();
+    void processSerial();
+    void processCommand(char* line);
+    void showHelp(const CommandArgs& args);
     
     // System commands
-    void handleSystemCommands(const String& command);
-    void showMemoryInfo();
-    void showUptimeInfo();
+    void handleStatus(const CommandArgs& args);
+    void handleRestart(const CommandArgs& args);
+    void showMemoryInfo(const CommandArgs& args);
+    void showUptimeInfo(const CommandArgs& args);
+    void handleWarmStart(const CommandArgs& args);
+    void handlePower(const CommandArgs& args);
     
     // Camera commands
-    void handleCameraCommands(const String& command);
+    void handleStart(const CommandArgs& args);
+    void handleStop(const CommandArgs& args);
+    void handleReset(const CommandArgs& args);
+    void handleFps(const CommandArgs& args);
+    void handleStats(const CommandArgs& args);
+    void handleClear(const CommandArgs& args);
+    void handleQuality(const CommandArgs& args);
+    void handleGrayscale(const CommandArgs& args);
+    void handleColor(const CommandArgs& args);
+    void handleCameraWatchdog(const CommandArgs& args);
+    void handleJpegCheck(const CommandArgs& args);
+    void handleMotion(const CommandArgs& args);
+    void handleViewers(const CommandArgs& args);
+    void handleProfile(const CommandArgs& args);
+    void handlePipelineMode(const CommandArgs& args);
+    void handleRawPipeline(const CommandArgs& args);
+    void handleBench(const CommandArgs& args);
+    void runRawPipelineBench(uint32_t window_ms);
+    void handleThumb(const CommandArgs& args);
+    void handleRoi(const CommandArgs& args);
+    void handleZoom(const CommandArgs& args);
+    void printRegionOfInterest();
     
     // WiFi commands
-    void handleWiFiCommands(const String& command);
-    void handleMJPEGCommands(const String& command);
-    void handleFlightControllerCommands(const String& command);
+    void handleWiFiStatus(const CommandArgs& args);
+    void handleWiFiReset(const CommandArgs& args);
+    void handleWiFiClients(const CommandArgs& args);
+    void handleWiFiScan(const CommandArgs& args);
+    void handleWiFiSurvey(const CommandArgs& args);
+    void handleWiFiBest(const CommandArgs& args);
+    void handleWiFiAuto(const CommandArgs& args);
+    void handleMJPEGStatus(const CommandArgs& args);
+    void handleFlightControllerTest(const CommandArgs& args);
+    void handleFlightControllerBaud(const CommandArgs& args);
+    void handleFlightControllerProtocol(const CommandArgs& args);
+    void handleFlightControllerStats(const CommandArgs& args);
+    void handleBlackbox(const CommandArgs& args);
+
+    // Debug commands
+    void handleVerbose(const CommandArgs& args);
+    void handleTasks(const CommandArgs& args);
+    void handleEvents(const CommandArgs& args);
+    void handleCommandBenchmark(const CommandArgs& args);
+    void handleTrace(const CommandArgs& args);
 
 public:
     CommandHandler();
     
     void setSystemManager(SystemManager* manager) { systemManager = manager; }
-    void processCommands();
-};
\ No newline at end of file
+    void beginNetwork(uint16_t port = ControlProtocol::DEFAULT_PORT);
+    // Serial RX and the network poll tick wake command processing
+    void attachEvents(EventLoop& events);
+
+    // Runs one command line (modified in place), writing its output to `output`.
+    // Returns false if the command is unknown.
+    bool execute(char* line, Print& output);
+};
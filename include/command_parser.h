@@ -0,0 +1,136 @@
+// include/command_parser.h - Разбор команд без выделения памяти
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Non-owning view of one token inside the line buffer
+struct CommandToken {
+    const char* data{nullptr};
+    size_t length{0};
+
+    // Three-way comparison against a NUL-terminated string
+    int compare(const char* str) const {
+        for (size_t i = 0; i < length; i++) {
+            unsigned char a = (unsigned char)data[i];
+            unsigned char b = (unsigned char)str[i];
+            if (b == '\0' || a != b) {
+                return (int)a - (int)b;
+            }
+        }
+        return str[length] == '\0' ? 0 : -1;
+    }
+
+    bool equals(const char* str) const { return compare(str) == 0; }
+
+    bool toInt(long& value) const {
+        if (length == 0) {
+            return false;
+        }
+        char* end = nullptr;
+        value = strtol(data, &end, 10);
+        return end == data + length;
+    }
+};
+
+// Tokens of one command line; tokens[0] is the command name
+struct CommandArgs {
+    const CommandToken* tokens{nullptr};
+    size_t count{0};
+
+    size_t argc() const { return count > 0 ? count - 1 : 0; }
+    const CommandToken& arg(size_t index) const { return tokens[index + 1]; }
+};
+
+// Fixed-size line accumulator fed one byte at a time
+template <size_t Capacity>
+class LineReader {
+public:
+    // Returns true once a complete, non-empty line is available
+    bool feed(char c) {
+        if (c == '\r' || c == '\n') {
+            if (overflow_) {
+                overflow_ = false;
+                length_ = 0;
+                return false;
+            }
+            buffer_[length_] = '\0';
+            return length_ > 0;
+        }
+        if (c == '\b' || c == 0x7F) {
+            if (length_ > 0) length_--;
+            return false;
+        }
+        if (length_ + 1 >= Capacity) {
+            overflow_ = true;   // Drop the whole line rather than run a truncated command
+            return false;
+        }
+        buffer_[length_++] = c;
+        return false;
+    }
+
+    char* line() { return buffer_; }
+    size_t length() const { return length_; }
+    void clear() { length_ = 0; buffer_[0] = '\0'; }
+
+private:
+    char buffer_[Capacity] = {0};
+    size_t length_{0};
+    bool overflow_{false};
+};
+
+// Splits `line` in place: lowercases it, terminates every token with NUL and
+// fills `tokens`. Returns the number of tokens found.
+inline size_t tokenizeCommand(char* line, CommandToken* tokens, size_t max_tokens) {
+    size_t count = 0;
+    char* p = line;
+
+    while (*p != '\0') {
+        while (*p == ' ' || *p == '\t') {
+            *p++ = '\0';
+        }
+        if (*p == '\0' || count == max_tokens) {
+            break;
+        }
+
+        tokens[count].data = p;
+        while (*p != '\0' && *p != ' ' && *p != '\t') {
+            if (*p >= 'A' && *p <= 'Z') {
+                *p = (char)(*p - 'A' + 'a');
+            }
+            p++;
+        }
+        tokens[count].length = (size_t)(p - tokens[count].data);
+        count++;
+
+        if (*p != '\0') {
+            *p++ = '\0';
+        }
+    }
+    return count;
+}
+
+// Binary search over a table sorted by its `name` member. Shared by the
+// dispatch table and the host bench in tools/command_dispatch_bench.cpp.
+template <typename Entry>
+const Entry* findCommand(const Entry* entries, size_t count, const CommandToken& name) {
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int cmp = name.compare(entries[mid].name);
+        if (cmp == 0) return &entries[mid];
+        if (cmp < 0) hi = mid;
+        else lo = mid + 1;
+    }
+    return nullptr;
+}
+
+// Compile-time string ordering, used to validate the dispatch table
+constexpr int constexprStrcmp(const char* a, const char* b) {
+    return (*a != *b || *a == '\0')
+        ? (int)(unsigned char)*a - (int)(unsigned char)*b
+        : constexprStrcmp(a + 1, b + 1);
+}
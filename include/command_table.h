@@ -0,0 +1,90 @@
+// include/command_table.h - Таблица консольных команд без зависимостей от Arduino
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "command_parser.h"
+
+class CommandHandler;   // Handlers are members; only the firmware takes their address
+
+namespace CommandConfig {
+    constexpr size_t MAX_LINE_LENGTH = 96;
+    constexpr size_t MAX_TOKENS = 8;
+    constexpr uint32_t CONSOLE_BACKSTOP_MS = 500;   // Console check in case an RX event was missed
+}
+
+enum class CommandGroup : uint8_t {
+    CAMERA,
+    NETWORK,
+    FLIGHT,
+    SYSTEM,
+    DEBUG
+};
+
+struct CommandSpec {
+    const char* name;
+    const char* alias_of;   // nullptr for primary names; aliases are folded into help
+    CommandGroup group;
+    const char* usage;
+    const char* help;
+    void (CommandHandler::*handler)(const CommandArgs&);
+};
+
+// Every command as X(name, alias_of, group, usage, help, handler), sorted by
+// name for binary-search dispatch. The firmware expands it into the dispatch
+// table (command_handler.cpp, order checked at compile time); the host bench
+// in tools/command_dispatch_bench.cpp expands the same rows without handlers.
+#define COMMAND_TABLE(X) \
+    X("?",          "help",        DEBUG,   "",       "",                                           showHelp) \
+    X("bench",      nullptr,       CAMERA,  "[size= q= fb= grab= xclk= n=]", "🧪 Матрица замеров драйвера (CSV)",           handleBench) \
+    X("blackbox",   nullptr,       FLIGHT,  "[start [hz]|stop|erase]", "📼 Чёрный ящик: телеметрия FC во flash",      handleBlackbox) \
+    X("bw",         "grayscale",   CAMERA,  "",       "",                                           handleGrayscale) \
+    X("camwd",      nullptr,       CAMERA,  "[on|off]", "🐕 Вотчдог захвата (перезапуск камеры на месте)", handleCameraWatchdog) \
+    X("clear",      nullptr,       DEBUG,   "",       "🧹 Сбросить статистику камеры",               handleClear) \
+    X("clients",    nullptr,       NETWORK, "",       "👥 Список подключенных клиентов",             handleWiFiClients) \
+    X("cmdbench",   nullptr,       DEBUG,   "",       "⏱️  Замер времени поиска команд",            handleCommandBenchmark) \
+    X("color",      nullptr,       CAMERA,  "",       "🌈 Цветной режим (больше размер)",            handleColor) \
+    X("events",     nullptr,       DEBUG,   "[reset]", "⏰ Цикл событий: пробуждения, задержка, простой CPU", handleEvents) \
+    X("fcbaud",     nullptr,       FLIGHT,  "[rate]", "🔌 Скорость UART контроллера полёта",         handleFlightControllerBaud) \
+    X("fcproto",    nullptr,       FLIGHT,  "[msp|mavlink]", "🔀 Протокол контроллера полёта: MSP или MAVLink v2", handleFlightControllerProtocol) \
+    X("fcstat",     nullptr,       FLIGHT,  "[reset]", "📈 Статистика UART: кадры, переполнения, задержка", handleFlightControllerStats) \
+    X("fctest",     nullptr,       FLIGHT,  "",       "🛩️  Проверка связи: MSP запрос или MAVLink HEARTBEAT", handleFlightControllerTest) \
+    X("fps",        nullptr,       CAMERA,  "",       "📊 Показать текущий FPS",                     handleFps) \
+    X("grayscale",  nullptr,       CAMERA,  "",       "🎬 Черно-белый режим (меньше размер)",        handleGrayscale) \
+    X("help",       nullptr,       DEBUG,   "",       "❓ Показать эту справку",                     showHelp) \
+    X("info",       "status",      SYSTEM,  "",       "",                                           handleStatus) \
+    X("jpegcheck",  nullptr,       CAMERA,  "[off|fast|strict]", "🧩 Проверка структуры JPEG кадров",           handleJpegCheck) \
+    X("mem",        "memory",      SYSTEM,  "",       "",                                           showMemoryInfo) \
+    X("memory",     nullptr,       SYSTEM,  "",       "💾 Использование памяти",                     showMemoryInfo) \
+    X("mjpegstatus", nullptr,       NETWORK, "[reset]", "🔌 MJPEG сервер, UDP канал, ритм кадров",     handleMJPEGStatus) \
+    X("motion",     nullptr,       CAMERA,  "[on|off|skip|every <n>|reset]", "🎯 Детектор движения и пропуск статичных кадров", handleMotion) \
+    X("pipeline",   nullptr,       CAMERA,  "[latency|throughput]", "⚖️  Режим конвейера: задержка или пропускная способность", handlePipelineMode) \
+    X("power",      nullptr,       SYSTEM,  "[auto|80|160|240]", "🔋 Частота CPU по нагрузке, оценка тока",     handlePower) \
+    X("profile",    nullptr,       CAMERA,  "[<name>|resync]", "🎛️  Профили сенсора (запись только изменений)", handleProfile) \
+    X("quality",    nullptr,       CAMERA,  "<0-63>", "🎨 Качество JPEG (без аргумента - текущее)",  handleQuality) \
+    X("rawpipe",    nullptr,       CAMERA,  "[on [rgb|yuv]|off|osd|bench]", "🎞️  RAW захват + OSD + программный JPEG",    handleRawPipeline) \
+    X("reboot",     "restart",     SYSTEM,  "",       "",                                           handleRestart) \
+    X("reset",      nullptr,       CAMERA,  "",       "🔄 Перезапустить модуль камеры",              handleReset) \
+    X("restart",    nullptr,       SYSTEM,  "",       "🔄 Перезагрузка ESP32-S3",                    handleRestart) \
+    X("rgb",        "color",       CAMERA,  "",       "",                                           handleColor) \
+    X("roi",        nullptr,       CAMERA,  "<x> <y> <w> <h> [ow oh]|off", "🔲 Окно сенсора (ROI) без переинициализации", handleRoi) \
+    X("start",      nullptr,       CAMERA,  "",       "▶️  Запустить видео стриминг",               handleStart) \
+    X("stats",      nullptr,       CAMERA,  "",       "📈 Статистика камеры",                        handleStats) \
+    X("status",     nullptr,       SYSTEM,  "",       "ℹ️  Полный статус системы",                  handleStatus) \
+    X("stop",       nullptr,       CAMERA,  "",       "⏹️  Остановить видео стриминг",              handleStop) \
+    X("tasks",      nullptr,       SYSTEM,  "[reset]", "🧮 CPU/стек задач и джиттер loop()",          handleTasks) \
+    X("thumb",      nullptr,       CAMERA,  "",       "🖼️  Миниатюры 1/8 (/thumb): размер и время", handleThumb) \
+    X("trace",      nullptr,       DEBUG,   "[start [mb]|stop|clear]", "🎬 Запись трассы кадров (/trace)",            handleTrace) \
+    X("uptime",     nullptr,       SYSTEM,  "",       "⏱️  Время работы системы",                   showUptimeInfo) \
+    X("verbose",    nullptr,       DEBUG,   "",       "🔍 Переключить подробные логи",               handleVerbose) \
+    X("viewers",    nullptr,       NETWORK, "[token|pilot|unpilot|observer]", "🎮 Зрители: пилоты и наблюдатели",            handleViewers) \
+    X("warm",       nullptr,       SYSTEM,  "[save|clear]", "💾 Тёплый старт: сохранённое состояние (NVS)", handleWarmStart) \
+    X("wifi",       nullptr,       NETWORK, "",       "📶 Статус WiFi точки доступа",                handleWiFiStatus) \
+    X("wifiauto",   nullptr,       NETWORK, "",       "🔁 Вкл/выкл фоновый обзор каналов",           handleWiFiAuto) \
+    X("wifibest",   nullptr,       NETWORK, "",       "🔀 Перейти на лучший канал (без клиентов)",   handleWiFiBest) \
+    X("wificlients", nullptr,       NETWORK, "",       "🩺 Проверка стабильности точки доступа",      handleWiFiClients) \
+    X("wifireset",  nullptr,       NETWORK, "",       "♻️  Полный перезапуск WiFi",                 handleWiFiReset) \
+    X("wifiscan",   nullptr,       NETWORK, "",       "🔍 Сканировать сети (без отключения)",        handleWiFiScan) \
+    X("wifisurvey", nullptr,       NETWORK, "",       "📊 Загрузка каналов и рекомендация",          handleWiFiSurvey) \
+    X("ws",         "mjpegstatus", NETWORK, "",       "",                                           handleMJPEGStatus) \
+    X("zoom",       nullptr,       CAMERA,  "<100-800> [cx cy]|off", "🔎 Цифровой зум окном сенсора (%)",           handleZoom)
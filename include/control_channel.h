@@ -0,0 +1,64 @@
+// include/control_channel.h - Сетевой канал команд (UDP)
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include "control_protocol.h"
+
+// Fixed-capacity Print sink that captures command output for one response
+class ResponseBuffer : public Print {
+public:
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    void clear() { length_ = 0; truncated_ = false; }
+    const uint8_t* data() const { return data_; }
+    size_t length() const { return length_; }
+    bool isTruncated() const { return truncated_; }
+
+private:
+    uint8_t data_[ControlProtocol::MAX_PAYLOAD];
+    size_t length_{0};
+    bool truncated_{false};
+};
+
+class CommandHandler;
+
+// Receives framed requests over UDP and executes them on the caller's task
+class ControlChannel {
+public:
+    ControlChannel();
+
+    bool begin(CommandHandler* handler, uint16_t port = ControlProtocol::DEFAULT_PORT);
+    void stop();
+    void poll();
+
+    bool isRunning() const { return running_; }
+    uint16_t getPort() const { return port_; }
+    uint32_t getRequestCount() const { return requests_; }
+    uint32_t getRejectedCount() const { return rejected_; }
+
+private:
+    WiFiUDP udp_;
+    CommandHandler* handler_;
+    uint16_t port_;
+    bool running_;
+
+    uint8_t rx_[ControlProtocol::MAX_DATAGRAM + 1];
+    uint8_t tx_[ControlProtocol::MAX_DATAGRAM];     // Also the retransmit cache
+    uint8_t reject_tx_[ControlProtocol::HEADER_SIZE];
+    ResponseBuffer response_;
+
+    // Last answered request, replayed on client retransmits instead of re-executing
+    uint32_t last_ip_;
+    uint16_t last_port_;
+    uint16_t last_request_id_;
+    size_t last_tx_length_;
+
+    uint32_t requests_;
+    uint32_t rejected_;
+
+    void sendDatagram(const uint8_t* data, size_t length);
+    void reject(const ControlFrame& request, ControlStatus status);
+};
@@ -0,0 +1,88 @@
+// include/control_protocol.h - Бинарный протокол сетевого канала команд
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Wire format (little endian), one request or response per UDP datagram:
+//
+//   0  'D' 'C'          magic
+//   2  version          ControlProtocol::VERSION
+//   3  type             ControlMessageType
+//   4  request_id       u16, echoed in the response
+//   6  status           ControlStatus (0 in requests)
+//   7  flags            ControlFlags
+//   8  payload_length   u16
+//  10  payload          request: command line, response: command output
+//
+// Shared by the firmware and the host tools in tools/.
+namespace ControlProtocol {
+    constexpr uint8_t MAGIC_0 = 'D';
+    constexpr uint8_t MAGIC_1 = 'C';
+    constexpr uint8_t VERSION = 1;
+    constexpr uint16_t DEFAULT_PORT = 4242;
+    constexpr size_t HEADER_SIZE = 10;
+    constexpr size_t MAX_DATAGRAM = 1400;   // Stays below the 1472-byte UDP MTU payload
+    constexpr size_t MAX_PAYLOAD = MAX_DATAGRAM - HEADER_SIZE;
+}
+
+enum class ControlMessageType : uint8_t {
+    REQUEST = 1,
+    RESPONSE = 2
+};
+
+enum class ControlStatus : uint8_t {
+    OK = 0,
+    UNKNOWN_COMMAND = 1,
+    BAD_REQUEST = 2,
+    BUSY = 3
+};
+
+namespace ControlFlags {
+    constexpr uint8_t TRUNCATED = 0x01;     // Response output did not fit the datagram
+}
+
+struct ControlFrame {
+    ControlMessageType type{ControlMessageType::REQUEST};
+    uint16_t request_id{0};
+    ControlStatus status{ControlStatus::OK};
+    uint8_t flags{0};
+    const uint8_t* payload{nullptr};
+    uint16_t payload_length{0};
+};
+
+// Parses a datagram; payload points into `data`
+inline bool decodeControlFrame(const uint8_t* data, size_t length, ControlFrame& frame) {
+    if (length < ControlProtocol::HEADER_SIZE ||
+        data[0] != ControlProtocol::MAGIC_0 || data[1] != ControlProtocol::MAGIC_1 ||
+        data[2] != ControlProtocol::VERSION) {
+        return false;
+    }
+
+    uint16_t payload_length = (uint16_t)(data[8] | (data[9] << 8));
+    if (ControlProtocol::HEADER_SIZE + payload_length != length) {
+        return false;
+    }
+
+    frame.type = (ControlMessageType)data[3];
+    frame.request_id = (uint16_t)(data[4] | (data[5] << 8));
+    frame.status = (ControlStatus)data[6];
+    frame.flags = data[7];
+    frame.payload = data + ControlProtocol::HEADER_SIZE;
+    frame.payload_length = payload_length;
+    return frame.type == ControlMessageType::REQUEST || frame.type == ControlMessageType::RESPONSE;
+}
+
+// Writes the header for `frame` into `out`; the payload follows at HEADER_SIZE
+inline void encodeControlHeader(const ControlFrame& frame, uint8_t* out) {
+    out[0] = ControlProtocol::MAGIC_0;
+    out[1] = ControlProtocol::MAGIC_1;
+    out[2] = ControlProtocol::VERSION;
+    out[3] = (uint8_t)frame.type;
+    out[4] = (uint8_t)(frame.request_id & 0xFF);
+    out[5] = (uint8_t)(frame.request_id >> 8);
+    out[6] = (uint8_t)frame.status;
+    out[7] = frame.flags;
+    out[8] = (uint8_t)(frame.payload_length & 0xFF);
+    out[9] = (uint8_t)(frame.payload_length >> 8);
+}
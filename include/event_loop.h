@@ -0,0 +1,125 @@
+// include/event_loop.h - Диспетчер событий главной задачи вместо опроса loop()
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <functional>
+
+namespace EventLoopConfig {
+    constexpr size_t MAX_HANDLERS = 12;
+    constexpr size_t MAX_TIMERS = 16;
+    constexpr uint32_t MAX_WAIT_MS = 1000;          // Upper bound of one sleep without timers
+    constexpr uint32_t TIMER_SLACK_MS = 2;          // Timers due this close run in the same wake-up
+    constexpr uint32_t NET_POLL_ACTIVE_MS = 5;      // HTTP/UDP polling with stations connected
+    constexpr uint32_t NET_POLL_IDLE_MS = 100;      // ... and with nobody on the AP
+    constexpr size_t LATENCY_BUCKETS = 6;           // <50us, <200us, <1ms, <5ms, <20ms, >=20ms
+}
+
+// One notification bit per source. Sources without an interrupt or callback
+// of their own (the HTTP server, the UDP control socket) are posted by a timer.
+enum class EventSource : uint8_t {
+    SERIAL_RX,      // Console bytes
+    FC_RX,          // Flight controller UART bytes
+    WIFI,           // Station (dis)connected, scan done
+    FRAME,          // VSYNC edge or raw pipeline output
+    NET,            // Network poll tick
+    COUNT
+};
+
+constexpr size_t EVENT_SOURCE_COUNT = (size_t)EventSource::COUNT;
+
+const char* eventSourceName(EventSource source);
+
+struct EventSourceStats {
+    uint32_t events{0};             // Wake-ups that carried this source
+    uint32_t avg_latency_us{0};     // Post -> handler start
+    uint32_t max_latency_us{0};
+    uint32_t max_handler_us{0};
+    uint64_t handler_us{0};
+};
+
+struct EventTimerStats {
+    const char* name{nullptr};
+    uint32_t interval_ms{0};        // 0 = stopped
+    uint32_t runs{0};
+    uint32_t max_us{0};
+};
+
+// Runs on the Arduino loop task. Sources set bits in the task's notification
+// value (usable from ISRs, no event-group daemon hop); runOnce() sleeps until
+// a bit arrives or the next timer is due and runs only the matching handlers.
+class EventLoop {
+public:
+    typedef std::function<void()> EventHandler;
+
+    EventLoop();
+
+    // Binds the loop to the calling task; call from setup()
+    void begin();
+    TaskHandle_t getTask() const { return task_; }
+    static uint32_t bit(EventSource source) { return 1UL << (uint8_t)source; }
+
+    // Several handlers per source run in registration order
+    bool on(EventSource source, EventHandler handler);
+    // Returns the timer id, or -1 when the table is full
+    int addTimer(const char* name, uint32_t interval_ms, EventHandler handler);
+    // Timer that runs the handlers of `source` (sources nobody posts, e.g. NET)
+    int addTimer(const char* name, uint32_t interval_ms, EventSource source);
+    void setTimerInterval(int id, uint32_t interval_ms);
+
+    // Any task; ISRs notify getTask() with bit() directly
+    void post(EventSource source);
+    // Where a source that posts from an ISR keeps its esp_timer stamp, for
+    // the wake-up latency (e.g. the VSYNC edge time)
+    void setPostTime(EventSource source, const volatile uint32_t* posted_us) {
+        external_posted_us_[(size_t)source] = posted_us;
+    }
+
+    // Sleeps until a source is posted or the next timer is due; returns the bits
+    uint32_t wait();
+    // Runs the handlers of the posted sources, then the due timers
+    void dispatch(uint32_t bits);
+    void runOnce() { dispatch(wait()); }
+
+    // Share of wall time the loop task spent in handlers since the last reset
+    float getBusyPercent() const;
+    const EventSourceStats& getSourceStats(EventSource source) const { return sources_[(size_t)source]; }
+    void resetStats();
+    void printStatus(Print& out = Serial) const;
+
+private:
+    struct Handler {
+        EventSource source;
+        EventHandler handler;
+    };
+
+    struct Timer {
+        EventHandler handler;       // Empty: runs the handlers of `source`
+        EventSource source;
+        unsigned long next_ms;
+        EventTimerStats stats;
+    };
+
+    TaskHandle_t task_;
+    Handler handlers_[EventLoopConfig::MAX_HANDLERS];
+    size_t handler_count_;
+    Timer timers_[EventLoopConfig::MAX_TIMERS];
+    size_t timer_count_;
+
+    volatile uint32_t posted_us_[EVENT_SOURCE_COUNT];
+    const volatile uint32_t* external_posted_us_[EVENT_SOURCE_COUNT];
+
+    EventSourceStats sources_[EVENT_SOURCE_COUNT];
+    uint32_t latency_buckets_[EventLoopConfig::LATENCY_BUCKETS];
+    uint32_t wakeups_;
+    uint32_t timeouts_;             // Wake-ups for timers only
+    uint64_t busy_us_;
+    int64_t stats_start_us_;
+
+    uint32_t nextTimeout(unsigned long now) const;
+    void runSource(EventSource source);
+    Timer* newTimer(const char* name, uint32_t interval_ms);
+    void runTimers();
+    void noteLatency(EventSourceStats& stats, uint32_t latency_us);
+};
@@ -0,0 +1,66 @@
+// include/fc_frame_parser.h - Сборка кадров MSP из потока байт UART контроллера полёта
+#pragma once
+
+#include <Arduino.h>
+
+namespace FcFrameConfig {
+    constexpr size_t MAX_PAYLOAD = 255;     // MSP v1 limit; longer v2 frames are counted and skipped
+}
+
+enum class FcProtocol : uint8_t {
+    MSP_V1,         // $M<dir><size><cmd><payload><xor>
+    MSP_V2,         // $X<dir><flag><cmd16><size16><payload><crc8 dvb-s2>
+    MAVLINK_V2      // Parsed by MavlinkParser; queued as an FcFrame like the others
+};
+
+const char* fcProtocolName(FcProtocol protocol);
+
+struct FcFrame {
+    FcProtocol protocol;
+    char direction;                 // '<' to the FC, '>' from the FC, '!' error reply
+    uint32_t command;               // MSP command or MAVLink message id
+    uint16_t size;
+    uint32_t received_us;           // esp_timer time the checksum byte was parsed
+    uint8_t payload[FcFrameConfig::MAX_PAYLOAD];
+};
+
+struct FcParserStats {
+    uint32_t frames{0};
+    uint32_t checksum_errors{0};
+    uint32_t oversize{0};           // Valid header, payload beyond MAX_PAYLOAD
+    uint32_t garbage_bytes{0};      // Outside any frame (noise, resync)
+};
+
+// Byte-at-a-time state machine; runs on the UART driver task, so it keeps
+// no locks and allocates nothing
+class FcFrameParser {
+public:
+    FcFrameParser();
+
+    // True when `byte` completed a frame; the frame stays valid until the next feed()
+    bool feed(uint8_t byte);
+    const FcFrame& frame() const { return frame_; }
+    void reset();
+
+    const FcParserStats& getStats() const { return stats_; }
+    void resetStats() { stats_ = FcParserStats(); }
+
+    static uint8_t crc8DvbS2(uint8_t crc, uint8_t byte);
+
+private:
+    enum class State : uint8_t {
+        IDLE, PROTOCOL, DIRECTION,
+        V1_SIZE, V1_COMMAND,
+        V2_FLAG, V2_COMMAND_LO, V2_COMMAND_HI, V2_SIZE_LO, V2_SIZE_HI,
+        PAYLOAD, CHECKSUM
+    };
+
+    State state_;
+    uint16_t received_;             // Payload bytes so far
+    uint8_t checksum_;
+    bool oversize_;                 // Payload is skipped, the checksum still ends the frame
+    FcFrame frame_;
+    FcParserStats stats_;
+
+    State afterHeader();
+};
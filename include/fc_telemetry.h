@@ -0,0 +1,75 @@
+// include/fc_telemetry.h - Кэш телеметрии контроллера полёта (ориентация, IMU, RC, батарея)
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Pure C++ so tools/blackbox_decode.cpp names and scales fields the way the
+// firmware does. Both FC protocols decode into the same FcTelemetry.
+
+struct MavlinkFrame;
+
+namespace FcTelemetryConfig {
+    constexpr size_t MAX_RC_CHANNELS = 16;
+    constexpr size_t MAX_FIELD_VALUES = 16;     // Values one field flattens to (RC is the widest)
+}
+
+// One group of values that arrives together (one MSP reply, one or two MAVLink messages)
+enum class FcField : uint8_t {
+    ATTITUDE,       // roll, pitch (0.1 deg), yaw (deg)
+    IMU,            // acc xyz, gyro xyz (raw sensor units)
+    RC,             // channels (us)
+    STATUS,         // armed, flight mode flags
+    ANALOG,         // battery (0.01 V), current (0.01 A), consumed mAh
+    ALTITUDE,       // altitude (cm), vario (cm/s)
+    COUNT
+};
+
+constexpr size_t FC_FIELD_COUNT = (size_t)FcField::COUNT;
+
+const char* fcFieldName(FcField field);
+// Comma-separated value names, for CSV headers
+const char* fcFieldColumns(FcField field);
+
+struct FcTelemetry {
+    int16_t roll_dd{0};
+    int16_t pitch_dd{0};
+    int16_t yaw_deg{0};
+    int16_t acc[3]{0, 0, 0};
+    int16_t gyro[3]{0, 0, 0};
+    uint8_t rc_count{0};
+    uint16_t rc[FcTelemetryConfig::MAX_RC_CHANNELS]{};
+    bool armed{false};
+    uint32_t mode_flags{0};
+    uint16_t battery_cv{0};
+    int16_t current_ca{0};
+    uint16_t consumed_mah{0};
+    int32_t altitude_cm{0};
+    int16_t vario_cms{0};
+    uint32_t updated_us[FC_FIELD_COUNT]{};      // esp_timer time of the last update, 0 = never
+
+    bool has(FcField field) const { return updated_us[(size_t)field] != 0; }
+};
+
+// Flattens one field to integers (the blackbox record); returns the count
+size_t fcFieldValues(FcField field, const FcTelemetry& telemetry, int32_t* values);
+
+// MSP replies this firmware polls for telemetry
+namespace MspCommand {
+    constexpr uint16_t STATUS = 101;
+    constexpr uint16_t RAW_IMU = 102;
+    constexpr uint16_t RC = 105;
+    constexpr uint16_t ATTITUDE = 108;
+    constexpr uint16_t ALTITUDE = 109;
+    constexpr uint16_t ANALOG = 110;
+}
+
+// Decodes an MSP reply payload into `telemetry`; returns the field it
+// updated, or FcField::COUNT for commands that carry no telemetry or a
+// payload too short for the command. Does not touch updated_us.
+FcField decodeMspTelemetry(uint16_t command, const uint8_t* payload, uint16_t size, FcTelemetry& telemetry);
+
+// Same for a MAVLink message from the autopilot: ATTITUDE, RAW_IMU,
+// RC_CHANNELS, HEARTBEAT (status), SYS_STATUS and BATTERY_STATUS (analog),
+// GLOBAL_POSITION_INT (altitude). Values are scaled to the MSP units above.
+FcField decodeMavlinkTelemetry(const MavlinkFrame& frame, FcTelemetry& telemetry);
@@ -2,14 +2,160 @@
 #pragma once
 
 #include <Arduino.h>
+#include <driver/uart.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <functional>
+#include "fc_frame_parser.h"
+#include "fc_telemetry.h"
+#include "mavlink_v2.h"
 
+namespace FlightControllerConfig {
+    constexpr uint32_t DEFAULT_BAUD = 57600;
+    constexpr uart_port_t UART_PORT = UART_NUM_1;
+    constexpr int RX_PIN = 1;
+    constexpr int TX_PIN = 2;
+    constexpr int RX_RING_SIZE = 8192;          // ~190 ms of line time at 420000 baud
+    constexpr int TX_RING_SIZE = 1024;
+    constexpr int EVENT_QUEUE_LENGTH = 32;
+    constexpr uint8_t RX_FIFO_THRESHOLD = 64;   // Of the 128-byte hardware FIFO
+    constexpr uint8_t RX_TIMEOUT_SYMBOLS = 2;   // Idle line for this many characters ends a burst
+    constexpr size_t RX_CHUNK = 128;
+    constexpr UBaseType_t FRAME_QUEUE_LENGTH = 16;
+    constexpr uint32_t TASK_STACK = 4096;
+    constexpr UBaseType_t TASK_PRIORITY = 12;   // Above every app task; below lwIP and Wi-Fi
+    constexpr BaseType_t TASK_CORE = 0;
+    constexpr uint32_t TEST_TIMEOUT_MS = 3000;
+    constexpr uint16_t TELEMETRY_POLL_HZ = 10;      // OSD; the blackbox raises it while logging
+    constexpr uint32_t POLL_REPLY_TIMEOUT_MS = 100; // Unanswered polls stop holding back the next one
+    constexpr uint32_t LINK_TIMEOUT_MS = 1000;      // No frame for this long: link down
+    constexpr size_t MAVLINK_RX_BUFFER = 1024;      // Frames are parsed in place here
+    constexpr uint8_t MAVLINK_COMPONENT_ID = MavlinkEnum::MAV_COMP_ID_CAMERA;
+    constexpr uint32_t MAVLINK_HEARTBEAT_MS = 1000;
+    constexpr uint32_t MAVLINK_STREAM_REFRESH_MS = 5000;   // Re-requested in case the autopilot rebooted
+    constexpr uint16_t MAVLINK_SLOW_STREAM_HZ = 10;        // Status, battery, position; capped by the poll rate
+}
+
+// What the link speaks; selected at run time (`fcproto`)
+enum class FcLinkProtocol : uint8_t {
+    MSP,            // Betaflight / INAV: request-response polls
+    MAVLINK         // ArduPilot / PX4: MAVLink v2 streams at requested intervals
+};
+
+const char* fcLinkProtocolName(FcLinkProtocol protocol);
+
+struct FcLinkStats {
+    uint32_t rx_bytes{0};
+    uint32_t data_events{0};        // UART_DATA: FIFO threshold or RX timeout
+    uint32_t rx_timeouts{0};        // ... of those, ended by an idle line
+    uint32_t overruns{0};           // Hardware FIFO overflow or RX ring full: bytes lost
+    uint32_t line_errors{0};        // Framing, parity, break
+    uint32_t queue_drops{0};        // Complete frames the main loop did not take in time
+    uint32_t max_buffered{0};       // Peak bytes waiting in the RX ring
+    uint32_t avg_delivery_us{0};    // Last byte in the driver task -> update()
+    uint32_t max_delivery_us{0};
+    uint32_t polls{0};              // Telemetry request bursts sent
+    uint32_t poll_skips{0};         // ... held back because replies were still on the line
+    uint32_t stream_requests{0};    // MAVLink SET_MESSAGE_INTERVAL commands sent
+    uint32_t command_acks{0};       // ... accepted
+    uint32_t command_nacks{0};      // ... refused or unsupported
+    uint32_t sequence_gaps{0};      // MAVLink frames from the autopilot lost on the way
+};
+
+// The FC UART runs on the ESP-IDF driver: its ISR moves the hardware FIFO
+// into a large ring, a dedicated task assembles frames and hands complete
+// ones to the main loop through a queue
 class FlightController {
 public:
+    typedef std::function<void(const FcFrame&)> FrameHandler;
+    typedef std::function<void(FcField, const FcTelemetry&)> TelemetryHandler;
+
     FlightController();
-    void initialize();
+    void initialize(uint32_t baud = FlightControllerConfig::DEFAULT_BAUD);
+    // Takes effect on the UART task within one wait; parsers and telemetry start over
+    void setProtocol(FcLinkProtocol protocol) { protocol_ = protocol; }
+    FcLinkProtocol getProtocol() const { return protocol_; }
+    // MAVLink system id of the autopilot, 0 until its first HEARTBEAT
+    uint8_t getMavlinkSystemId() const { return mav_system_id_; }
+    bool setBaud(uint32_t baud);
+    uint32_t getBaud() const { return baud_; }
+    static bool isSupportedBaud(uint32_t baud);
+    // Called from the UART task after it queued frames; update() takes them
+    void onReceive(std::function<void()> callback);
+    // Every frame from the FC, on the task that calls update()
+    void onFrame(FrameHandler handler) { frame_handler_ = handler; }
     void update();
-    void testConnection();
+
+    // Telemetry updates per second (0 = off). MSP: requests from the UART
+    // task, each waiting for the previous replies, so the rate never outruns
+    // the line. MAVLink: the message interval requested from the autopilot.
+    void setPollRate(uint16_t hz) { poll_hz_ = hz; }
+    uint16_t getPollRate() const { return poll_hz_; }
+    // Called on the UART task for every decoded field; must not block
+    void onTelemetry(TelemetryHandler handler) { telemetry_handler_ = handler; }
+    // Copy of the latest values, any task
+    FcTelemetry getTelemetry() const;
+    bool isLinkUp() const;
+
+    size_t write(const uint8_t* data, size_t length);
+    void testConnection(Print& out = Serial);
+
+    bool isRunning() const { return task_ != nullptr; }
+    const FcLinkStats& getStats() const { return stats_; }
+    const FcParserStats& getParserStats() const { return parser_.getStats(); }
+    const MavlinkParserStats& getMavlinkStats() const { return mavlink_.getStats(); }
+    void resetStats();
+    void printStatus(Print& out = Serial) const;
 
 private:
-    HardwareSerial& fcSerial;
+    uint32_t baud_;
+    QueueHandle_t uart_queue_;      // Driver events
+    QueueHandle_t frame_queue_;     // Complete FcFrame copies
+    TaskHandle_t task_;
+    std::function<void()> receive_callback_;
+    FrameHandler frame_handler_;
+    volatile FcLinkProtocol protocol_;
+    FcLinkProtocol active_protocol_;    // What the driver task runs; follows protocol_
+    FcFrameParser parser_;          // Driver task only
+    MavlinkParser mavlink_;         // Driver task only
+    uint8_t mav_rx_[FlightControllerConfig::MAVLINK_RX_BUFFER];
+    size_t mav_rx_length_;          // Bytes of an incomplete frame kept at the front
+    volatile uint8_t mav_system_id_;
+    uint8_t mav_component_id_;
+    uint8_t mav_tx_sequence_;
+    uint8_t mav_rx_sequence_;
+    bool mav_sequence_valid_;
+    uint16_t requested_hz_;         // Rate the current stream requests were made for
+    int64_t next_heartbeat_us_;
+    int64_t next_stream_request_us_;
+    FcTelemetry telemetry_;         // Driver task only
+    FcTelemetry published_;         // Copy under telemetry_lock_
+    mutable portMUX_TYPE telemetry_lock_ = portMUX_INITIALIZER_UNLOCKED;
+    TelemetryHandler telemetry_handler_;
+    volatile uint16_t poll_hz_;
+    int64_t next_poll_us_;
+    int64_t last_poll_us_;
+    uint8_t awaiting_replies_;
+    uint8_t slow_poll_index_;
+    uint32_t poll_count_;
+    volatile uint32_t last_frame_us_;
+    FcLinkStats stats_;
+    uint32_t last_command_;
+    uint16_t last_size_;
+
+    static void uartTask(void* parameter);
+    void switchProtocol();
+    void readAvailable();
+    void readMavlink();
+    void handleFrame(const FcFrame& frame);
+    void handleMavlinkFrame(const MavlinkFrame& frame, uint32_t received_us);
+    void publishTelemetry(FcField field, uint32_t received_us);
+    bool queueFrame(const FcFrame& frame);
+    TickType_t pollIfDue();
+    void sendPoll();
+    TickType_t mavlinkIfDue();
+    void sendMavlink(uint8_t* frame, const MavlinkMessageInfo& message);
+    void requestStreams();
+    void noteDelivered(const FcFrame& frame);
 };
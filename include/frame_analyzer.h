@@ -0,0 +1,80 @@
+// include/frame_analyzer.h - Анализ кадров: DC-декодирование + детектор движения
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include "esp_camera.h"
+#include "jpeg_dc_decoder.h"
+#include "motion_detector.h"
+
+namespace AnalyzerConfig {
+    constexpr uint8_t DEFAULT_INTERVAL = 4;         // Analyze every Nth streamed frame
+    constexpr uint32_t KEEPALIVE_MS = 1000;         // Max gap between sent frames while skipping
+    constexpr uint32_t MOTION_HOLD_MS = 2000;       // Quiet time before motion is reported as ended
+}
+
+struct AnalyzerStats {
+    uint32_t analyzed{0};
+    uint32_t decode_errors{0};
+    uint32_t skipped_frames{0};
+    uint32_t motion_events{0};
+    uint32_t scene_changes{0};
+    uint32_t avg_decode_cycles{0};
+    uint32_t avg_detect_cycles{0};
+    uint32_t max_decode_cycles{0};
+};
+
+// Runs on frames the stream is about to send: a DC-only JPEG decode to a 1/8
+// luma plane, then a cell-grid comparison with the last sent frame. Lets the
+// stream drop near-identical frames while hovering and reports motion onsets.
+class FrameAnalyzer {
+public:
+    typedef std::function<void(bool active, const MotionResult& result)> MotionCallback;
+
+    FrameAnalyzer();
+    ~FrameAnalyzer();
+
+    // Returns false if the frame may be skipped (static scene, skip enabled, keepalive not due)
+    bool shouldSend(const camera_fb_t* fb);
+    void frameSent(unsigned long now_ms) { last_sent_ms_ = now_ms; }
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_; }
+    void setSkipStatic(bool skip) { skip_static_ = skip; }
+    bool isSkipStatic() const { return skip_static_; }
+    void setInterval(uint8_t interval) { interval_ = interval ? interval : 1; }
+    uint8_t getInterval() const { return interval_; }
+    void onMotion(MotionCallback callback) { motion_callback_ = callback; }
+
+    bool isMotionActive() const { return motion_active_; }
+    const MotionResult& getLastResult() const { return last_result_; }
+    // Latest 1/8-scale luma plane (one pixel per 8x8 block) for other analytics
+    const uint8_t* getLumaPlane() const { return plane_; }
+    uint16_t getPlaneWidth() const { return decoder_.planeWidth(); }
+    uint16_t getPlaneHeight() const { return decoder_.planeHeight(); }
+    const AnalyzerStats& getStats() const { return stats_; }
+    MotionThresholds& thresholds() { return detector_.thresholds(); }
+    void resetStats() { stats_ = AnalyzerStats(); }
+
+    void printStatus(Print& out = Serial) const;
+
+private:
+    JpegDcDecoder decoder_;
+    MotionDetector detector_;
+    uint8_t* plane_;
+    MotionResult last_result_;
+    AnalyzerStats stats_;
+    MotionCallback motion_callback_;
+
+    bool enabled_;
+    bool skip_static_;
+    bool last_static_;
+    bool motion_active_;
+    uint8_t interval_;
+    uint8_t frame_counter_;
+    unsigned long last_sent_ms_;
+    unsigned long last_motion_ms_;
+
+    bool analyze(const camera_fb_t* fb);
+    void updateMotionState(unsigned long now_ms);
+};
@@ -0,0 +1,79 @@
+// include/frame_trace.h - Запись/чтение трассы кадров (размеры, время, JPEG) для реплея
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Pure C++ so tools/trace_replay.cpp reads the exact format the firmware writes.
+//
+// Layout, all fields little-endian:
+//   header  16 bytes: magic "FTRC", version u16, flags u16, frame count u32, reserved u32
+//   record  16 bytes: timestamp_us u32, capture_us u32, length u32, width u16, height u16
+//           followed by `length` JPEG bytes
+// Timestamps are relative to the first frame; capture_us is how long the
+// stream loop waited for the frame buffer.
+
+namespace FrameTraceConfig {
+    constexpr uint32_t MAGIC = 0x43525446;          // "FTRC"
+    constexpr uint16_t VERSION = 1;
+    constexpr size_t HEADER_SIZE = 16;
+    constexpr size_t RECORD_HEADER_SIZE = 16;
+    constexpr size_t DEFAULT_CAPACITY = 4 * 1024 * 1024;    // PSRAM; ~180 HD frames
+    constexpr size_t MAX_CAPACITY = 6 * 1024 * 1024;
+}
+
+struct FrameTraceRecord {
+    uint32_t timestamp_us{0};
+    uint32_t capture_us{0};
+    uint32_t length{0};
+    uint16_t width{0};
+    uint16_t height{0};
+    const uint8_t* data{nullptr};
+};
+
+// Appends records to a caller-owned buffer; stops (and reports full) instead
+// of overwriting, so a trace is always a contiguous prefix of the flight.
+class FrameTraceWriter {
+public:
+    FrameTraceWriter() : buffer_(nullptr), capacity_(0), size_(0), frames_(0), first_us_(0) {}
+
+    bool begin(uint8_t* buffer, size_t capacity);
+    // `timestamp_us` is any monotonic clock; it is rebased to the first frame
+    bool append(uint64_t timestamp_us, uint32_t capture_us, uint16_t width, uint16_t height,
+                const uint8_t* data, size_t length);
+    void reset() { begin(buffer_, capacity_); }
+
+    const uint8_t* data() const { return buffer_; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    uint32_t frames() const { return frames_; }
+
+private:
+    uint8_t* buffer_;
+    size_t capacity_;
+    size_t size_;
+    uint32_t frames_;
+    uint64_t first_us_;
+};
+
+class FrameTraceReader {
+public:
+    FrameTraceReader() : data_(nullptr), size_(0), offset_(0), frames_(0), read_(0) {}
+
+    // Checks the header; false for a foreign or newer-version file
+    bool open(const uint8_t* data, size_t size);
+    // False at the end or on a truncated record
+    bool next(FrameTraceRecord& record);
+    void rewind();
+
+    uint32_t frameCount() const { return frames_; }
+    // After next() returned false: fewer records than the header announced
+    bool truncated() const { return read_ < frames_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_;
+    uint32_t frames_;
+    uint32_t read_;
+};
@@ -0,0 +1,98 @@
+// include/jpeg_dc_decoder.h - Декодирование только DC-коэффициентов baseline JPEG
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Partial baseline JPEG decoder: entropy-decodes the scan but keeps only the DC
+// coefficient of each 8x8 block, i.e. the block's mean level. The result is a
+// 1/8-scale plane without any IDCT. Pure C++ so it also builds on the host.
+class JpegDcDecoder {
+public:
+    static constexpr uint8_t MAX_COMPONENTS = 3;
+
+    JpegDcDecoder();
+
+    // Decodes the luma DC plane into `luma` (row-major, one byte per 8x8 block).
+    // Returns false on unsupported or corrupt input; see lastError().
+    bool decodeLuma(const uint8_t* data, size_t length, uint8_t* luma, size_t capacity);
+
+    // Decodes every component whose entry in `planes` is non-null: Y, Cb, Cr in
+    // frame order. Chroma planes are subsampled like the source (see planeWidth).
+    bool decodePlanes(const uint8_t* data, size_t length, uint8_t* const planes[], size_t capacity);
+
+    // Plane size of the last successful decode (in blocks = 1/8 of the image)
+    uint16_t planeWidth(uint8_t component = 0) const { return component < MAX_COMPONENTS ? plane_width_[component] : 0; }
+    uint16_t planeHeight(uint8_t component = 0) const { return component < MAX_COMPONENTS ? plane_height_[component] : 0; }
+    uint8_t componentCount() const { return component_count_; }
+
+    // Interleaves planes from the last decodePlanes() into 24-bit pixels at luma
+    // plane size (nearest-neighbour chroma). Grayscale sources give R=G=B.
+    // `bgr` selects the byte order esp32-camera uses for PIXFORMAT_RGB888.
+    void toRgb888(const uint8_t* const planes[], uint8_t* rgb, bool bgr) const;
+    uint16_t imageWidth() const { return image_width_; }
+    uint16_t imageHeight() const { return image_height_; }
+    const char* lastError() const { return error_; }
+
+private:
+    static constexpr uint8_t MAX_TABLES = 2;    // Baseline allows table ids 0-1
+    static constexpr uint8_t LOOKUP_BITS = 8;
+
+    struct HuffmanTable {
+        bool present;
+        uint8_t lookup_length[1 << LOOKUP_BITS];    // 0 = code longer than LOOKUP_BITS
+        uint8_t lookup_value[1 << LOOKUP_BITS];
+        int32_t max_code[18];                       // Per code length, -1 if unused
+        int32_t value_offset[17];
+        uint8_t values[256];
+    };
+
+    struct Component {
+        uint8_t id;
+        uint8_t h;
+        uint8_t v;
+        uint8_t quant_table;
+        uint8_t dc_table;
+        uint8_t ac_table;
+        int32_t predictor;
+    };
+
+    struct BitReader {
+        const uint8_t* pos;
+        const uint8_t* end;
+        uint32_t bits;
+        int count;
+        bool marker;
+
+        void fill();
+        uint32_t peek(int n) const { return bits >> (32 - n); }
+        void skip(int n) { bits <<= n; count -= n; }
+        int32_t receiveExtend(int size);
+        bool restart();
+    };
+
+    HuffmanTable dc_tables_[MAX_TABLES];
+    HuffmanTable ac_tables_[MAX_TABLES];
+    uint16_t quant_dc_[4];
+    Component components_[MAX_COMPONENTS];
+    uint8_t component_count_;
+    uint8_t max_h_;
+    uint8_t max_v_;
+    uint16_t restart_interval_;
+    uint16_t image_width_;
+    uint16_t image_height_;
+    uint16_t plane_width_[MAX_COMPONENTS];
+    uint16_t plane_height_[MAX_COMPONENTS];
+    const uint8_t* scan_start_;
+    const uint8_t* data_end_;
+    const char* error_;
+
+    bool parseHeaders(const uint8_t* data, size_t length);
+    bool parseQuantTables(const uint8_t* p, size_t length);
+    bool parseHuffmanTables(const uint8_t* p, size_t length);
+    bool parseFrame(const uint8_t* p, size_t length);
+    bool parseScan(const uint8_t* p, size_t length);
+    static bool buildTable(HuffmanTable& table, const uint8_t* counts, const uint8_t* values, size_t value_count);
+    static int decodeSymbol(BitReader& reader, const HuffmanTable& table);
+    bool fail(const char* message) { error_ = message; return false; }
+};
@@ -0,0 +1,33 @@
+// include/jpeg_validator.h - Быстрая структурная проверка JPEG кадров
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace JpegValidatorConfig {
+    constexpr size_t MAX_TRAILING_SCAN = 4096;  // Fast mode: tail of the scan walked for EOI
+    constexpr uint8_t MAX_SEGMENTS = 32;        // Header segments before SOS (OV2640 emits ~8)
+}
+
+enum class JpegValidation : uint8_t {
+    OFF,
+    FAST,       // Header segments + SOS; only the scan's last MAX_TRAILING_SCAN bytes are walked for EOI
+    STRICT      // Also walks the entropy-coded data; EOI is the first marker after the scan
+};
+
+enum class JpegCheck : uint8_t {
+    OK,
+    TOO_SHORT,
+    NO_SOI,
+    BAD_MARKER,         // Expected 0xFF marker prefix not found
+    BAD_LENGTH,         // Segment length < 2 or past the end of the buffer
+    NO_SOS,
+    NO_EOI,             // Truncated: no EOI after the scan
+    BAD_SCAN            // Strict: unexpected marker inside entropy-coded data
+};
+
+const char* jpegCheckName(JpegCheck check);
+
+// Validates the frame structure and sets `frame_end` to the byte after EOI, so
+// `length - frame_end` bytes of trailing garbage can be trimmed. Pure C++.
+JpegCheck validateJpegFrame(const uint8_t* data, size_t length, JpegValidation mode, size_t& frame_end);
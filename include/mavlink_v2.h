@@ -0,0 +1,235 @@
+// include/mavlink_v2.h - MAVLink v2: разбор кадров на месте (без копирования) и сборка исходящих
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Pure C++ so tools/mavlink_bench.cpp runs the parser the firmware runs.
+// Wire fields are little-endian like both the ESP32 and the x86 host, so
+// they are read and written with memcpy.
+
+namespace MavlinkConfig {
+    constexpr uint8_t STX = 0xFD;
+    constexpr size_t HEADER_SIZE = 10;          // STX, len, incompat, compat, seq, sysid, compid, msgid[3]
+    constexpr size_t CHECKSUM_SIZE = 2;
+    constexpr size_t SIGNATURE_SIZE = 13;
+    constexpr size_t MAX_PAYLOAD = 255;
+    constexpr size_t MAX_FRAME = HEADER_SIZE + MAX_PAYLOAD + CHECKSUM_SIZE + SIGNATURE_SIZE;
+    constexpr uint8_t INCOMPAT_SIGNED = 0x01;   // The only incompatibility flag v2 defines
+}
+
+struct MavlinkMessageInfo {
+    uint32_t id;
+    const char* name;
+    uint8_t length;         // Payload without extension fields
+    uint8_t crc_extra;
+};
+
+// CRC_EXTRA and the payload length are computed by the compiler from the
+// message definition, the way mavgen does from the XML: the name, then each
+// field's type and name in wire order (sorted by type size, largest first),
+// then the array length byte for arrays. Extension fields are not part of
+// either, so the definitions below leave them out.
+namespace MavlinkDetail {
+
+constexpr uint16_t x25Mix(uint16_t crc, uint8_t tmp) {
+    return (uint16_t)((crc >> 8) ^ ((uint16_t)tmp << 8) ^ ((uint16_t)tmp << 3) ^ (tmp >> 4));
+}
+
+constexpr uint8_t x25Tmp(uint8_t tmp) {
+    return (uint8_t)(tmp ^ (uint8_t)(tmp << 4));
+}
+
+// CRC-16/MCRF4XX step, as the MAVLink checksum accumulates it
+constexpr uint16_t x25(uint16_t crc, uint8_t data) {
+    return x25Mix(crc, x25Tmp((uint8_t)(data ^ (uint8_t)crc)));
+}
+
+constexpr uint16_t hashArray(uint16_t crc, const char* s, uint8_t count) {
+    return *s == ']' ? x25(crc, count) : hashArray(crc, s + 1, (uint8_t)(count * 10 + (*s - '0')));
+}
+
+// "type name" or "type name[n]": every word followed by a space, then n
+constexpr uint16_t hashField(uint16_t crc, const char* s) {
+    return *s == 0 ? x25(crc, ' ')
+         : *s == '[' ? hashArray(x25(crc, ' '), s + 1, 0)
+         : hashField(x25(crc, (uint8_t)*s), s + 1);
+}
+
+constexpr uint16_t hashFields(uint16_t crc) {
+    return crc;
+}
+
+template <typename... Fields>
+constexpr uint16_t hashFields(uint16_t crc, const char* field, Fields... rest) {
+    return hashFields(hashField(crc, field), rest...);
+}
+
+constexpr bool startsWith(const char* s, const char* prefix) {
+    return *prefix == 0 || (*s == *prefix && startsWith(s + 1, prefix + 1));
+}
+
+// 0 for a type MAVLink does not have, which the length checks then catch
+constexpr size_t typeSize(const char* s) {
+    return startsWith(s, "uint8_t ") || startsWith(s, "int8_t ") || startsWith(s, "char ") ? 1
+         : startsWith(s, "uint16_t ") || startsWith(s, "int16_t ") ? 2
+         : startsWith(s, "uint32_t ") || startsWith(s, "int32_t ") || startsWith(s, "float ") ? 4
+         : startsWith(s, "uint64_t ") || startsWith(s, "int64_t ") || startsWith(s, "double ") ? 8
+         : 0;
+}
+
+constexpr size_t parseCount(const char* s, size_t count) {
+    return *s == ']' ? count : parseCount(s + 1, count * 10 + (size_t)(*s - '0'));
+}
+
+constexpr size_t arrayLength(const char* s) {
+    return *s == 0 ? 1 : *s == '[' ? parseCount(s + 1, 0) : arrayLength(s + 1);
+}
+
+constexpr size_t fieldsLength() {
+    return 0;
+}
+
+template <typename... Fields>
+constexpr size_t fieldsLength(const char* field, Fields... rest) {
+    return typeSize(field) * arrayLength(field) + fieldsLength(rest...);
+}
+
+constexpr uint8_t crcExtra(uint16_t crc) {
+    return (uint8_t)((crc & 0xFF) ^ (crc >> 8));
+}
+
+} // namespace MavlinkDetail
+
+template <typename... Fields>
+constexpr MavlinkMessageInfo mavlinkDefine(uint32_t id, const char* name, Fields... fields) {
+    return MavlinkMessageInfo{
+        id, name, (uint8_t)MavlinkDetail::fieldsLength(fields...),
+        MavlinkDetail::crcExtra(MavlinkDetail::hashFields(MavlinkDetail::hashField(0xFFFF, name), fields...))};
+}
+
+// The subset this firmware parses and sends (common.xml). Anything else on
+// the link is skipped by its length without a checksum check.
+namespace MavlinkMessage {
+    constexpr MavlinkMessageInfo HEARTBEAT = mavlinkDefine(0, "HEARTBEAT",
+        "uint32_t custom_mode", "uint8_t type", "uint8_t autopilot", "uint8_t base_mode", "uint8_t system_status",
+        "uint8_t mavlink_version");
+    constexpr MavlinkMessageInfo SYS_STATUS = mavlinkDefine(1, "SYS_STATUS",
+        "uint32_t onboard_control_sensors_present", "uint32_t onboard_control_sensors_enabled",
+        "uint32_t onboard_control_sensors_health", "uint16_t load", "uint16_t voltage_battery",
+        "int16_t current_battery", "uint16_t drop_rate_comm", "uint16_t errors_comm", "uint16_t errors_count1",
+        "uint16_t errors_count2", "uint16_t errors_count3", "uint16_t errors_count4", "int8_t battery_remaining");
+    constexpr MavlinkMessageInfo RAW_IMU = mavlinkDefine(27, "RAW_IMU",
+        "uint64_t time_usec", "int16_t xacc", "int16_t yacc", "int16_t zacc", "int16_t xgyro", "int16_t ygyro",
+        "int16_t zgyro", "int16_t xmag", "int16_t ymag", "int16_t zmag");
+    constexpr MavlinkMessageInfo ATTITUDE = mavlinkDefine(30, "ATTITUDE",
+        "uint32_t time_boot_ms", "float roll", "float pitch", "float yaw", "float rollspeed", "float pitchspeed",
+        "float yawspeed");
+    constexpr MavlinkMessageInfo GLOBAL_POSITION_INT = mavlinkDefine(33, "GLOBAL_POSITION_INT",
+        "uint32_t time_boot_ms", "int32_t lat", "int32_t lon", "int32_t alt", "int32_t relative_alt", "int16_t vx",
+        "int16_t vy", "int16_t vz", "uint16_t hdg");
+    constexpr MavlinkMessageInfo RC_CHANNELS = mavlinkDefine(65, "RC_CHANNELS",
+        "uint32_t time_boot_ms", "uint16_t chan1_raw", "uint16_t chan2_raw", "uint16_t chan3_raw",
+        "uint16_t chan4_raw", "uint16_t chan5_raw", "uint16_t chan6_raw", "uint16_t chan7_raw", "uint16_t chan8_raw",
+        "uint16_t chan9_raw", "uint16_t chan10_raw", "uint16_t chan11_raw", "uint16_t chan12_raw",
+        "uint16_t chan13_raw", "uint16_t chan14_raw", "uint16_t chan15_raw", "uint16_t chan16_raw",
+        "uint16_t chan17_raw", "uint16_t chan18_raw", "uint8_t chancount", "uint8_t rssi");
+    constexpr MavlinkMessageInfo COMMAND_LONG = mavlinkDefine(76, "COMMAND_LONG",
+        "float param1", "float param2", "float param3", "float param4", "float param5", "float param6",
+        "float param7", "uint16_t command", "uint8_t target_system", "uint8_t target_component",
+        "uint8_t confirmation");
+    constexpr MavlinkMessageInfo COMMAND_ACK = mavlinkDefine(77, "COMMAND_ACK",
+        "uint16_t command", "uint8_t result");
+    constexpr MavlinkMessageInfo BATTERY_STATUS = mavlinkDefine(147, "BATTERY_STATUS",
+        "int32_t current_consumed", "int32_t energy_consumed", "int16_t temperature", "uint16_t voltages[10]",
+        "int16_t current_battery", "uint8_t id", "uint8_t battery_function", "uint8_t type",
+        "int8_t battery_remaining");
+}
+
+// Enum values used from common.xml / minimal.xml
+namespace MavlinkEnum {
+    constexpr uint8_t MAV_TYPE_GCS = 6;
+    constexpr uint8_t MAV_TYPE_CAMERA = 30;
+    constexpr uint8_t MAV_AUTOPILOT_INVALID = 8;        // Not a flight controller
+    constexpr uint8_t MAV_MODE_FLAG_SAFETY_ARMED = 0x80;
+    constexpr uint8_t MAV_STATE_ACTIVE = 4;
+    constexpr uint8_t MAV_COMP_ID_CAMERA = 100;
+    constexpr uint16_t MAV_CMD_SET_MESSAGE_INTERVAL = 511;
+    constexpr uint8_t MAV_RESULT_ACCEPTED = 0;
+}
+
+// Known message by id, nullptr otherwise
+const MavlinkMessageInfo* mavlinkFindMessage(uint32_t id);
+
+uint16_t mavlinkCrc(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF);
+
+// A frame where it lies in the caller's buffer; valid until that buffer changes
+struct MavlinkFrame {
+    const uint8_t* data;                // STX
+    const MavlinkMessageInfo* info;
+    uint32_t msgid;
+    uint8_t length;                     // Payload bytes on the wire (trailing zeros trimmed)
+    uint8_t sequence;
+    uint8_t system_id;
+    uint8_t component_id;
+    bool is_signed;
+
+    const uint8_t* payload() const { return data + MavlinkConfig::HEADER_SIZE; }
+    size_t size() const {
+        return MavlinkConfig::HEADER_SIZE + length + MavlinkConfig::CHECKSUM_SIZE +
+               (is_signed ? MavlinkConfig::SIGNATURE_SIZE : 0);
+    }
+
+    // Field at a payload byte offset; bytes the sender trimmed read as 0
+    template <typename T>
+    T get(size_t offset) const {
+        uint8_t bytes[sizeof(T)] = {};
+        if (offset < length) {
+            memcpy(bytes, payload() + offset, length - offset < sizeof(T) ? length - offset : sizeof(T));
+        }
+        T value;
+        memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+};
+
+struct MavlinkParserStats {
+    uint32_t frames{0};
+    uint32_t crc_errors{0};
+    uint32_t unknown{0};            // Not in the subset: skipped whole when an STX follows, checksum unchecked
+    uint32_t signed_frames{0};      // Accepted; signatures are not verified
+    uint32_t bad_headers{0};        // STX followed by incompatibility flags v2 does not define
+    uint32_t garbage_bytes{0};      // Outside any frame (noise, resync, tlog timestamps)
+};
+
+// Scans a contiguous buffer instead of a byte at a time: memchr to the next
+// STX, header and length checked in place, one checksum pass over the
+// frame. Nothing is copied; a frame that fails its checksum, or one outside
+// the subset that no STX follows, is rescanned from the byte after its STX,
+// so a real frame hidden behind a false start is still found.
+class MavlinkParser {
+public:
+    // Next valid frame in data[offset, length); advances `offset` past it.
+    // False when no complete frame is left: `offset` then points at the
+    // bytes to keep (the start of a partial frame) for the next call.
+    bool next(const uint8_t* data, size_t length, size_t& offset, MavlinkFrame& frame);
+
+    const MavlinkParserStats& getStats() const { return stats_; }
+    void resetStats() { stats_ = MavlinkParserStats(); }
+
+private:
+    MavlinkParserStats stats_;
+};
+
+template <typename T>
+inline void mavlinkPut(uint8_t* payload, size_t offset, T value) {
+    memcpy(payload + offset, &value, sizeof(T));
+}
+
+// Serializes in place: the caller zeroes and writes info.length payload
+// bytes at frame + HEADER_SIZE (extensions are never sent). This trims
+// trailing zeros as v2 allows, fills the header and appends the checksum.
+// `frame` must hold MAX_FRAME bytes; returns the frame size.
+size_t mavlinkFinishFrame(uint8_t* frame, const MavlinkMessageInfo& info, uint8_t sequence, uint8_t system_id,
+                          uint8_t component_id);
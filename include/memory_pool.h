@@ -0,0 +1,180 @@
+// include/memory_pool.h - Арены, пулы блоков и монитор фрагментации кучи
+#pragma once
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <stdarg.h>
+#include <string.h>
+
+namespace MemoryConfig {
+    constexpr size_t HTTP_ARENA_SIZE = 2048;        // HTTP headers, internal RAM
+    constexpr size_t LOG_ARENA_SIZE = 1024;         // Log line formatting, internal RAM
+    constexpr size_t SOCKET_BLOCK_SIZE = 1460;      // One TCP MSS
+    constexpr size_t SOCKET_BLOCK_COUNT = 4;        // PSRAM, internal RAM fallback
+    constexpr uint32_t MONITOR_INTERVAL_MS = 10000;
+    constexpr uint8_t FRAGMENTATION_WARN_PERCENT = 50;
+    constexpr size_t HEAP_REGIONS = 3;              // Internal, DMA, PSRAM
+}
+
+// Fixed-capacity string for long-lived members; never touches the heap
+template <size_t N>
+class FixedString {
+public:
+    FixedString() { buffer_[0] = '\0'; }
+    FixedString(const char* text) { assign(text); }
+    FixedString& operator=(const char* text) { assign(text); return *this; }
+
+    void assign(const char* text) {
+        strncpy(buffer_, text ? text : "", N - 1);
+        buffer_[N - 1] = '\0';
+    }
+
+    void format(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(buffer_, N, fmt, args);
+        va_end(args);
+    }
+
+    const char* c_str() const { return buffer_; }
+    size_t length() const { return strlen(buffer_); }
+    bool empty() const { return buffer_[0] == '\0'; }
+    static constexpr size_t capacity() { return N - 1; }
+
+private:
+    char buffer_[N];
+};
+
+// Bump allocator over one block taken at boot. Nothing is freed individually:
+// callers rewind to a mark (see ArenaScope). Not thread-safe; owned by one task.
+class Arena {
+public:
+    Arena(const char* name, size_t capacity, uint32_t caps);
+
+    bool begin();
+    void* allocate(size_t size, size_t align = 4);
+    char* vformat(const char* fmt, va_list args);
+    char* format(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    size_t mark() const { return used_; }
+    void rewind(size_t mark) { if (mark <= used_) used_ = mark; }
+    void reset() { used_ = 0; }
+
+    const char* getName() const { return name_; }
+    size_t getCapacity() const { return base_ ? capacity_ : 0; }
+    size_t getUsed() const { return used_; }
+    size_t getHighWater() const { return high_water_; }
+    uint32_t getFailures() const { return failures_; }
+    bool isInternal() const { return internal_; }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+private:
+    const char* name_;
+    uint8_t* base_;
+    size_t capacity_;
+    size_t used_;
+    size_t high_water_;
+    uint32_t failures_;
+    uint32_t caps_;
+    bool internal_;
+};
+
+// Releases everything allocated from the arena during the scope
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena& arena) : arena_(arena), mark_(arena.mark()) {}
+    ~ArenaScope() { arena_.rewind(mark_); }
+
+    Arena& arena() { return arena_; }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    Arena& arena_;
+    size_t mark_;
+};
+
+// Equal-size blocks carved from one allocation with an intrusive free list
+class BlockPool {
+public:
+    BlockPool(const char* name, size_t block_size, size_t block_count, uint32_t caps);
+
+    bool begin();
+    uint8_t* acquire();
+    void release(uint8_t* block);
+
+    const char* getName() const { return name_; }
+    size_t getBlockSize() const { return block_size_; }
+    size_t getBlockCount() const { return storage_ ? block_count_ : 0; }
+    size_t getAvailable() const { return available_; }
+    size_t getMinAvailable() const { return min_available_; }
+    uint32_t getFailures() const { return failures_; }
+    bool isInternal() const { return internal_; }
+
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    const char* name_;
+    uint8_t* storage_;
+    FreeBlock* free_list_;
+    size_t block_size_;
+    size_t block_count_;
+    size_t available_;
+    size_t min_available_;
+    uint32_t failures_;
+    uint32_t caps_;
+    bool internal_;
+    portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+};
+
+// Free space vs. largest free block per heap capability, sampled periodically
+struct HeapRegionInfo {
+    const char* name{""};
+    uint32_t caps{0};
+    size_t total{0};
+    size_t free_bytes{0};
+    size_t largest_block{0};
+    size_t minimum_free{0};             // Low-water mark since boot (from the allocator)
+    size_t worst_largest_block{0};      // Smallest largest-block seen by the monitor
+    uint8_t fragmentation_percent{0};   // 100 - largest block / free space
+    uint8_t peak_fragmentation{0};
+};
+
+class MemoryMonitor {
+public:
+    MemoryMonitor();
+
+    void update();      // Samples every MONITOR_INTERVAL_MS; call from the main loop
+    void sample();
+    void printReport(Print& out) const;
+
+    const HeapRegionInfo& getRegion(size_t index) const { return regions_[index]; }
+
+private:
+    HeapRegionInfo regions_[MemoryConfig::HEAP_REGIONS];
+    unsigned long last_sample_ms_;
+    bool warned_[MemoryConfig::HEAP_REGIONS];
+};
+
+// Per-subsystem arenas and pools, preallocated at boot
+namespace MemoryPools {
+    bool begin();
+    Arena& http();
+    Arena& log();
+    BlockPool& socketBuffers();
+    MemoryMonitor& monitor();
+
+    // printf through the log arena: Print::printf falls back to the heap for
+    // lines over 64 bytes. Main loop only.
+    size_t logf(Print& out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    void printStatus(Print& out);
+}
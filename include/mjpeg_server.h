@@ -3,17 +3,146 @@
 
 #include <WebServer.h>
 #include "ov2640.h"
+#include "profiler.h"
+#include "raw_pipeline.h"
+#include "frame_analyzer.h"
+#include "blackbox.h"
+#include "frame_trace.h"
+#include "thumbnailer.h"
+#include "viewer_policy.h"
+
+struct WebAsset;
+
+// Latency: newest frame only (GRAB_LATEST, 2 buffers), a backlog is skipped
+// and every write leaves at once (TCP_NODELAY). Throughput: every captured
+// frame (GRAB_WHEN_EMPTY, 3 buffers, the boot config), a backlog is drained
+// oldest first and TCP coalesces the small multipart writes (Nagle).
+enum class PipelineMode : uint8_t {
+    LATENCY,
+    THROUGHPUT
+};
+
+const char* pipelineModeName(PipelineMode mode);
+
+// What a viewer slot is sent: the frame itself, or its 1/8-scale preview
+// (/thumb?stream spectators)
+enum class ViewerFeed : uint8_t {
+    FRAME,
+    THUMB_COLOR,
+    THUMB_GRAY
+};
+
+// Large GET bodies (/trace, /blackbox) served from a cursor, a bounded
+// amount per network tick, so the loop never waits on the client
+enum class DownloadSource : uint8_t {
+    NONE,
+    TRACE,
+    BLACKBOX
+};
+
+namespace DownloadConfig {
+    constexpr size_t TICK_BYTES = 4096;             // Per network tick (5 ms with stations on)
+    constexpr uint32_t STALL_TIMEOUT_MS = 10000;    // No progress for this long drops the download
+}
+
+namespace PipelineConfig {
+    constexpr uint8_t LATENCY_FB_COUNT = 2;         // One filling, one ready
+    constexpr uint8_t THROUGHPUT_FB_COUNT = 3;
+    constexpr size_t AGE_BUCKETS = 5;               // Frame age: <10, <20, <40, <80, >=80 ms
+}
+
+// Cadence of frames that reached at least one viewer, next to the sensor's
+// VSYNC cadence. Jitter is the mean absolute deviation from the average.
+struct StreamPacingStats {
+    uint32_t frames{0};
+    uint32_t avg_interval_us{0};
+    uint32_t jitter_us{0};
+    uint32_t max_interval_us{0};
+    uint32_t vsync_interval_us{0};
+    uint32_t vsync_jitter_us{0};
+    uint32_t missed_signals{0};     // VSYNC edges passed while the loop was busy
+    uint32_t avg_age_us{0};         // Capture -> send of delivered frames
+    uint32_t max_age_us{0};
+    uint32_t age_buckets[PipelineConfig::AGE_BUCKETS]{};
+};
 
 class MJPEGServer {
 public:
     MJPEGServer(int port = 80);
     void start(OV2640Camera* cam);
-    void handleClients();
+    void attachProfiler(Profiler* prof) { profiler = prof; }
+    void attachAnalyzer(FrameAnalyzer* fa) { analyzer = fa; }
+    // While the pipeline runs, viewers get its encoded frames instead of the sensor's
+    void attachRawPipeline(RawPipeline* pipeline) { rawPipeline = pipeline; }
+    void attachBlackbox(Blackbox* log) { blackbox = log; }
+    // HTTP requests (pages, new /stream viewers); run on the network poll tick
+    void handleRequests();
+    // One frame to the connected viewers; run when a frame event arrives.
+    // Returns true once the frame went out to at least one viewer
+    bool streamToViewers();
+    // Another frame is already waiting (throughput backlog, raw frame published
+    // meanwhile); the frame event will not repeat for it
+    bool hasQueuedFrame() const;
+    Thumbnailer& getThumbnailer() { return thumbnailer; }
+    ViewerPolicy& getViewerPolicy() { return viewerPolicy; }
+    void printViewers(Print& out = Serial) const;
+    // Reconfigures the camera driver and the viewer sockets; refused while
+    // the raw pipeline owns the driver
+    bool setPipelineMode(PipelineMode mode);
+    PipelineMode getPipelineMode() const { return pipeline_mode; }
+    const StreamPacingStats& getPacing() const { return pacing; }
+    void resetPacing();
+    void printPacing(Print& out = Serial) const;
+
+    // Records streamed frames into a PSRAM buffer for offline replay (GET /trace)
+    bool startTrace(size_t capacity = FrameTraceConfig::DEFAULT_CAPACITY);
+    void stopTrace();
+    void clearTrace();
+    bool isTracing() const { return tracing; }
+    void printTrace(Print& out = Serial) const;
 
 private:
-    void handleRoot();
+    void handleAsset(const WebAsset& asset);
     void handleStream();
+    void handleTasks();
+    void handleBench();
+    void handleThumb();
+    void handleTrace();
+    void handleBlackbox();
+    bool beginDownload(DownloadSource source, size_t size, const char* filename);
+    void continueDownload();
+    void finishDownload(const char* reason);
+    void recordTraceFrame(const camera_fb_t* fb, uint32_t capture_us);
+    bool frameReady() const;
+    camera_fb_t* nextFrame();
+    void noteFrameSignal();
+    void noteFrameSent(const camera_fb_t* fb, int64_t now_us);
+    void returnFrame(camera_fb_t* fb);
+    void dropViewer(int slot, const char* reason);
+    bool encodeThumbnail(camera_fb_t* fb, ViewerFeed feed, uint8_t* jpg[2], size_t len[2]);
 
     WebServer server;
     OV2640Camera* camera;
+    Profiler* profiler;
+    FrameAnalyzer* analyzer;
+    RawPipeline* rawPipeline;
+    Blackbox* blackbox;
+    Thumbnailer thumbnailer;
+    ViewerPolicy viewerPolicy;
+    FrameTraceWriter trace;
+    uint8_t* trace_buffer;
+    bool tracing;
+    WiFiClient download_client;
+    DownloadSource download;
+    size_t download_offset;
+    size_t download_size;
+    unsigned long download_progress_ms;
+    WiFiClient viewers[ViewerConfig::MAX_VIEWERS];
+    ViewerFeed feeds[ViewerConfig::MAX_VIEWERS]{};
+    uint32_t raw_seq;
+    PipelineMode pipeline_mode;
+    uint32_t frame_signal_seq;      // VSYNC count of the last frame taken
+    uint32_t frame_signal_us;
+    int64_t last_send_us;
+    StreamPacingStats pacing;
 };
@@ -0,0 +1,63 @@
+// include/motion_detector.h - Детектор движения/смены сцены по плоскости яркости 1/8
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace MotionConfig {
+    constexpr uint16_t MAX_PLANE_WIDTH = 240;       // FHD / 8
+    constexpr uint16_t MAX_PLANE_HEIGHT = 150;      // UXGA / 8
+    constexpr size_t MAX_PLANE_BYTES = (size_t)MAX_PLANE_WIDTH * MAX_PLANE_HEIGHT;
+    constexpr uint8_t CELL_SIZE = 8;                // Plane pixels per cell side (64x64 image pixels)
+    constexpr size_t MAX_CELLS =
+        ((MAX_PLANE_WIDTH + CELL_SIZE - 1) / CELL_SIZE) * ((MAX_PLANE_HEIGHT + CELL_SIZE - 1) / CELL_SIZE);
+}
+
+struct MotionThresholds {
+    uint8_t cell_diff{8};               // Mean |diff| (0-255 levels) that marks a cell as changed
+    uint16_t min_changed_cells{2};      // Changed cells needed to report motion
+    uint8_t scene_diff{28};             // Global mean |diff| that counts as a scene change
+    uint8_t scene_cell_percent{60};     // ...or this share of changed cells
+    float static_diff{1.5f};            // Below this (and no changed cell) the scene is static
+};
+
+struct MotionResult {
+    float mean_abs_diff{0.0f};          // 0-255 levels, against the reference plane
+    uint16_t changed_cells{0};
+    uint16_t total_cells{0};
+    bool motion{false};
+    bool scene_change{false};
+    bool is_static{false};
+};
+
+// Compares a luma plane with a reference plane cell by cell. Differences are
+// computed on 7-bit luma, four pixels per 32-bit word (SWAR) when rows are
+// word-aligned, with a scalar path giving identical results otherwise.
+class MotionDetector {
+public:
+    MotionDetector();
+    ~MotionDetector();
+
+    bool analyze(const uint8_t* luma, uint16_t width, uint16_t height, MotionResult& result);
+    void setReference(const uint8_t* luma, uint16_t width, uint16_t height);
+    void reset() { has_reference_ = false; }
+
+    MotionThresholds& thresholds() { return thresholds_; }
+    const MotionThresholds& thresholds() const { return thresholds_; }
+
+    // Row kernels: add each cell's sum of |a/2 - b/2| to cells[] and return the
+    // row total. Public so the host test can hold the SWAR path to the scalar one
+    static uint32_t rowDiffSwar(const uint32_t* a, const uint32_t* b, uint16_t words, uint32_t* cells);
+    static uint32_t rowDiffScalar(const uint8_t* a, const uint8_t* b, uint16_t width, uint32_t* cells);
+
+    MotionDetector(const MotionDetector&) = delete;
+    MotionDetector& operator=(const MotionDetector&) = delete;
+
+private:
+    MotionThresholds thresholds_;
+    uint8_t* reference_;
+    uint16_t width_;
+    uint16_t height_;
+    bool has_reference_;
+    uint32_t cell_sums_[MotionConfig::MAX_CELLS];
+};
@@ -0,0 +1,44 @@
+// include/osd_renderer.h - Наложение OSD (телеметрия) на 24-битный кадр
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace OsdConfig {
+    constexpr uint8_t GLYPH_WIDTH = 5;      // 5x7 font, one column per byte
+    constexpr uint8_t GLYPH_HEIGHT = 7;
+    constexpr uint8_t GLYPH_ADVANCE = 6;
+    constexpr uint8_t MARGIN = 4;           // Pixels from the frame edge, before scaling
+    constexpr size_t MAX_TEXT = 32;
+}
+
+// What the overlay shows. FC fields are drawn only while the link is up.
+struct OsdTelemetry {
+    bool fc_link{false};
+    bool armed{false};
+    float battery_v{0.0f};
+    float altitude_m{0.0f};
+    uint16_t heading_deg{0};
+    int8_t rssi_dbm{0};
+    float fps{0.0f};
+    uint32_t uptime_s{0};
+    uint8_t viewers{0};
+};
+
+// Draws text into B,G,R frames (esp32-camera RGB888 layout). The area behind
+// each string is darkened so it stays readable over bright scenes.
+class OsdRenderer {
+public:
+    // Scale 0 picks one from the frame height (1 up to 240 lines, 2 up to 480...)
+    explicit OsdRenderer(uint8_t scale = 0) : scale_(scale) {}
+
+    void render(uint8_t* bgr, uint16_t width, uint16_t height, const OsdTelemetry& telemetry) const;
+
+    // Text is upper-cased; characters outside the font are drawn as '?'
+    static void drawText(uint8_t* bgr, uint16_t width, uint16_t height, int x, int y,
+                         const char* text, uint8_t scale, uint8_t r, uint8_t g, uint8_t b);
+    static int textWidth(const char* text, uint8_t scale);
+
+private:
+    uint8_t scale_;
+};
@@ -6,11 +6,14 @@
 #include <memory>
 #include <functional>
 #include <atomic>
-#include <string>
 #include "esp_camera.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "jpeg_validator.h"
+#include "memory_pool.h"
+#include "sensor_profile.h"
 
 // Camera pin definitions for ESP32-S3
 namespace CameraPins {
@@ -42,10 +45,102 @@ namespace CameraConfig {
     constexpr size_t MIN_FREE_HEAP = 50000;  // Minimum heap threshold
 }
 
+// Capture watchdog: in-place driver restart on failure streaks or stalls
+namespace CameraWatchdogConfig {
+    constexpr uint8_t FAILURE_STREAK = 5;           // Consecutive failed or corrupt captures
+    constexpr uint32_t STALL_MS = 1000;             // No good frame for this long while frames are requested
+    constexpr uint32_t RECOVERY_BACKOFF_MS = 2000;  // Minimum gap between automatic recoveries
+    constexpr uint32_t RECOVERY_TARGET_MS = 500;
+    constexpr uint32_t SERVICE_INTERVAL_MS = 100;   // Loop-task check for a recovery the capture path asked for
+    constexpr uint32_t DRAIN_TIMEOUT_MS = 200;      // Recovery waits this long for frames still held
+}
+
+// Sensor profile switches: diff against the shadow, written at VSYNC
+namespace SensorProfileConfig {
+    constexpr int VSYNC_ACTIVE_LEVEL = 1;           // OV2640 default: VSYNC high during the sync pulse
+    constexpr uint32_t VBLANK_TIMEOUT_US = 120000;  // > 2 frame periods; apply anyway after this
+}
+
+// Sensor frame boundaries counted by a VSYNC pin interrupt. The stream path
+// takes a frame only after the count moved instead of polling on a timer.
+struct FrameSignal {
+    volatile uint32_t count{0};
+    volatile uint32_t last_us{0};   // esp_timer time of the last edge (wraps, use differences)
+    bool armed{false};              // False: driver owns the pin, callers fall back to blocking gets
+    TaskHandle_t notify_task{nullptr};  // Woken from the ISR with notify_bits (eSetBits)
+    uint32_t notify_bits{0};
+};
+
+struct SensorSwitchStats {
+    uint32_t switches{0};
+    uint32_t writes{0};             // Setter calls issued
+    uint32_t skipped_writes{0};     // Values already in the shadow
+    uint32_t failed_writes{0};
+    uint32_t vblank_timeouts{0};
+    uint8_t last_writes{0};
+    uint32_t last_wait_us{0};       // Waiting for VSYNC
+    uint32_t last_apply_us{0};      // SCCB batch
+    uint32_t max_apply_us{0};
+    const char* last_profile{"none"};
+};
+
+struct CameraRecoveryStats {
+    uint32_t recoveries{0};
+    uint32_t failed{0};
+    uint32_t last_ms{0};
+    uint32_t max_ms{0};
+    unsigned long last_at_ms{0};
+    const char* last_reason{"none"};
+};
+
+// OV2640 windowing: the sensor is read out in one of three modes, then the DSP
+// crops a window and scales it down to the output size (set_res_raw)
+namespace SensorWindow {
+    constexpr uint16_t SENSOR_WIDTH = 1600;     // UXGA readout
+    constexpr uint16_t SENSOR_HEIGHT = 1200;
+    constexpr int MODE_UXGA = 0;                // Full resolution
+    constexpr int MODE_SVGA = 1;                // 2x subsampled, faster readout
+    constexpr int MODE_CIF = 2;                 // 4x subsampled
+    constexpr uint16_t CIF_MAX_HEIGHT = 296;
+    constexpr float MAX_ZOOM = 8.0f;
+}
+
+// Active sensor window in full-sensor (UXGA) coordinates
+struct RegionOfInterest {
+    bool active{false};
+    uint16_t x{0};
+    uint16_t y{0};
+    uint16_t width{0};
+    uint16_t height{0};
+    uint16_t output_width{0};
+    uint16_t output_height{0};
+    int mode{SensorWindow::MODE_UXGA};
+    float zoom{1.0f};
+    uint32_t apply_us{0};       // Time spent programming the sensor
+};
+
+// Parameters fixed at esp_camera_init; changing any of them restarts the driver
+namespace DriverLimits {
+    constexpr uint32_t MIN_XCLK_HZ = 6000000;
+    constexpr uint32_t MAX_XCLK_HZ = 24000000;     // OV2640 datasheet maximum input clock
+}
+
+struct DriverSettings {
+    pixformat_t pixel_format{PIXFORMAT_JPEG};
+    framesize_t frame_size{FRAMESIZE_HD};
+    uint8_t jpeg_quality{25};
+    uint8_t fb_count{3};
+    camera_grab_mode_t grab_mode{CAMERA_GRAB_WHEN_EMPTY};
+    uint32_t xclk_freq_hz{20000000};
+};
+
 // Frame statistics structure
 struct FrameStats {
     uint32_t total_frames{0};
     uint32_t dropped_frames{0};
+    uint32_t corrupt_frames{0};     // Failed JPEG validation (also counted as dropped)
+    uint32_t trimmed_frames{0};     // Trailing bytes after EOI cut off
+    uint32_t avg_validate_cycles{0};
     uint32_t avg_frame_size{0};
     float current_fps{0.0f};
     uint32_t min_heap{UINT32_MAX};
@@ -55,6 +150,9 @@ struct FrameStats {
     void reset() {
         total_frames = 0;
         dropped_frames = 0;
+        corrupt_frames = 0;
+        trimmed_frames = 0;
+        avg_validate_cycles = 0;
         avg_frame_size = 0;
         current_fps = 0.0f;
         min_heap = UINT32_MAX;
@@ -95,14 +193,48 @@ private:
     unsigned long frame_start_time_{0};
     uint32_t frame_size_accumulator_{0};
     
+    // JPEG structure validation
+    JpegValidation jpeg_validation_{JpegValidation::FAST};
+    JpegCheck last_jpeg_reject_{JpegCheck::OK};
+    
+    // Sensor windowing (ROI / digital zoom)
+    RegionOfInterest roi_;
+    
+    // Shadow of the sensor settings; profile switches write only the diff
+    SensorShadow shadow_;
+    SensorSwitchStats profile_stats_;
+    
+    // Capture watchdog
+    bool watchdog_enabled_{true};
+    uint8_t failure_streak_{0};
+    unsigned long last_good_frame_ms_{0};       // Or the first request after an idle gap
+    unsigned long last_request_ms_{0};          // End of the last capture request
+    unsigned long last_recovery_ms_{0};
+    CameraRecoveryStats recovery_;
+    std::atomic<const char*> recovery_request_{nullptr};    // Reason, set by the capture path
+    
+    // The driver is restarted only by the loop task, and never under a task
+    // that is inside fb_get or still holds a frame buffer
+    SemaphoreHandle_t driver_mutex_;
+    std::atomic<uint8_t> frames_out_{0};
+    
+    FrameSignal frame_signal_;
+    
     // Error handling
     CameraError last_error_{CameraError::NONE};
-    std::string last_error_message_;
+    FixedString<64> last_error_message_;
     
     // Private methods
     void initializeConfig();
     bool configureSensor();
+    bool startDriver();
+    void storeDriverSettings(const DriverSettings& settings);
+    bool waitForVerticalBlank(uint32_t& waited_us) const;
+    void armFrameSignal();
+    static void IRAM_ATTR frameSignalIsr(void* arg);
+    void noteCaptureResult(bool success, unsigned long requested_ms);
     void updateStats(camera_fb_t* fb, unsigned long capture_time);
+    bool validateFrame(camera_fb_t* fb);
     bool checkMemoryConstraints() const;
     void logPerformanceWarning(const char* message) const;
 
@@ -114,6 +246,25 @@ public:
     bool initialize();
     void deinitialize();
     
+    // Restarts the driver in place and re-applies the current sensor profile
+    // and ROI; WiFi and client sockets are untouched
+    bool recover(const char* reason);
+    // Runs the recovery the watchdog requested, if any; called on the loop
+    // task, since captures may run on another core (raw pipeline)
+    void serviceWatchdog();
+    bool isRecoveryPending() const { return recovery_request_.load() != nullptr; }
+    void setWatchdogEnabled(bool enabled) { watchdog_enabled_ = enabled; }
+    bool isWatchdogEnabled() const { return watchdog_enabled_; }
+    const CameraRecoveryStats& getRecoveryStats() const { return recovery_; }
+    
+    // VSYNC edges since boot; a new value means a new frame is (about to be) queued
+    const FrameSignal& getFrameSignal() const { return frame_signal_; }
+    // Sets `bits` in the task's notification value on every edge; survives driver restarts
+    void setFrameNotify(TaskHandle_t task, uint32_t bits) {
+        frame_signal_.notify_bits = bits;
+        frame_signal_.notify_task = task;
+    }
+    
     // Frame operations
     std::unique_ptr<camera_fb_t, std::function<void(camera_fb_t*)>> captureFrame();
     bool captureFrameAsync(FrameCallback callback);
@@ -121,14 +272,43 @@ public:
     // Configuration
     bool setFrameSize(framesize_t size);
     bool setJpegQuality(uint8_t quality);
+    
+    // Region of interest in full-sensor coordinates, encoded at output size.
+    // Reprograms the sensor window only; the driver and frame buffers stay.
+    // The output may not exceed the configured frame size (buffer capacity).
+    bool setRegionOfInterest(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+                             uint16_t output_width, uint16_t output_height);
+    // Zoom 1-8x around a centre (0-1 of the frame). Past the sensor's native
+    // detail the frame gets smaller instead of being upscaled.
+    bool setDigitalZoom(float zoom, float center_x = 0.5f, float center_y = 0.5f);
+    bool clearRegionOfInterest();
+    const RegionOfInterest& getRegionOfInterest() const { return roi_; }
     bool setPixelFormat(pixformat_t format);
+    // Restarts the driver with a new pixel format and frame size (frame
+    // buffers are sized at init); sensor settings are carried over, ROI is reset
+    bool reconfigure(pixformat_t format, framesize_t size);
+    // Same restart for any driver parameter; falls back to the old ones on failure
+    bool applyDriverSettings(const DriverSettings& settings);
+    DriverSettings getDriverSettings() const;
+    pixformat_t getPixelFormat() const { return config_.pixel_format; }
+    framesize_t getFrameSize() const { return config_.frame_size; }
     bool setGrayscaleMode(bool enable);  // НОВЫЙ МЕТОД: черно-белый режим
     
+    // Writes only the settings that differ from the shadow, as one batch
+    // starting at the next VSYNC so the switch lands between frames
+    bool applyProfile(const SensorProfile& profile, bool wait_vblank = true);
+    void resyncSensorShadow();
+    const SensorShadow& getSensorShadow() const { return shadow_; }
+    const SensorSwitchStats& getProfileStats() const { return profile_stats_; }
+    void setJpegValidation(JpegValidation mode) { jpeg_validation_ = mode; }
+    JpegValidation getJpegValidation() const { return jpeg_validation_; }
+    JpegCheck getLastJpegReject() const { return last_jpeg_reject_; }
+    
     // Status and diagnostics
     bool isInitialized() const noexcept { return initialized_.load(); }
     bool isStreaming() const noexcept { return streaming_.load(); }
     CameraError getLastError() const noexcept { return last_error_; }
-    const std::string& getLastErrorMessage() const noexcept { return last_error_message_; }
+    const FixedString<64>& getLastErrorMessage() const noexcept { return last_error_message_; }
     
     // Statistics
     FrameStats getStatistics() const;
@@ -0,0 +1,22 @@
+// include/pixel_convert.h - Преобразование RGB565/YUV422 в 24-битный цвет
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Raw camera formats to 24-bit pixels in the byte order esp32-camera uses for
+// PIXFORMAT_RGB888 (B, G, R). The fast paths read whole 32-bit words and use
+// per-byte lookup tables, writing four pixels as three words where the
+// buffers are word-aligned. They give bit-identical results to the scalar
+// reference versions. Pure C++ so the host benchmark runs the same code.
+namespace PixelConvert {
+
+// RGB565 as the camera sends it: big-endian, high byte first
+void rgb565ToBgr888(const uint8_t* src, uint8_t* dst, size_t pixels);
+void rgb565ToBgr888Scalar(const uint8_t* src, uint8_t* dst, size_t pixels);
+
+// YUV422 in Y0 U Y1 V order, BT.601 full range; `pixels` must be even
+void yuyvToBgr888(const uint8_t* src, uint8_t* dst, size_t pixels);
+void yuyvToBgr888Scalar(const uint8_t* src, uint8_t* dst, size_t pixels);
+
+} // namespace PixelConvert
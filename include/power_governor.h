@@ -0,0 +1,104 @@
+// include/power_governor.h - Частота CPU и мощность TX по нагрузке (DVFS)
+#pragma once
+
+#include <Arduino.h>
+
+namespace PowerConfig {
+    constexpr uint32_t UPDATE_INTERVAL_MS = 1000;
+    constexpr uint16_t IDLE_MHZ = 80;               // Lowest clock that keeps APB (Wi-Fi, UART, camera) at 80 MHz
+    constexpr uint16_t CONNECTED_MHZ = 160;
+    constexpr uint16_t MAX_MHZ = 240;
+    constexpr uint8_t BOOST_LOAD_PERCENT = 70;      // Busiest core above this: one level up
+    constexpr uint8_t RELAX_LOAD_PERCENT = 35;      // ... below this for RELAX_MS: back to the base level
+    constexpr uint32_t RELAX_MS = 5000;
+    constexpr uint32_t STREAM_HOLD_MS = 3000;       // Viewer reconnects keep the streaming clock
+
+    // TX power (0.25 dBm units) once no stream runs and every station is close
+    constexpr int8_t TX_MAX_QDBM = 84;              // 21 dBm, what optimizeForFPV() sets
+    constexpr int8_t TX_NEAR_QDBM = 52;             // 13 dBm
+    constexpr int8_t NEAR_RSSI_DBM = -50;           // Weakest station at least this strong
+    constexpr int8_t FAR_RSSI_DBM = -58;            // Back to max below this (hysteresis)
+
+    // Estimates only: ESP32-S3 datasheet modem-sleep currents (3.3 V, typ.),
+    // CPU part with RF off. Radio RX/TX current comes on top.
+    constexpr uint16_t MA_IDLE_80 = 22, MA_BUSY_80 = 42;
+    constexpr uint16_t MA_IDLE_160 = 28, MA_BUSY_160 = 62;
+    constexpr uint16_t MA_IDLE_240 = 33, MA_BUSY_240 = 88;
+    constexpr uint16_t MA_TX_MAX = 355, MA_TX_NEAR = 250;   // While transmitting
+}
+
+enum class PowerState : uint8_t {
+    IDLE,           // No station on the AP
+    CONNECTED,      // Stations, no stream
+    BOOST,          // CONNECTED with a busy core
+    STREAMING,      // Viewers or the raw pipeline
+    COUNT
+};
+
+constexpr size_t POWER_STATE_COUNT = (size_t)PowerState::COUNT;
+
+const char* powerStateName(PowerState state);
+
+// What the governor decides on; SystemManager fills it every UPDATE_INTERVAL_MS
+struct PowerInputs {
+    uint8_t stations{0};
+    bool streaming{false};
+    float load_percent{0.0f};       // Busiest core
+    float avg_load_percent{0.0f};   // Both cores, for the current estimate
+    int8_t weakest_rssi{0};         // Of the connected stations, 0 = none
+    uint32_t wake_latency_us{0};    // Event loop frame wake-up (VSYNC -> handler)
+};
+
+struct PowerStateStats {
+    uint64_t time_ms{0};
+    uint32_t entries{0};
+    uint32_t switch_us{0};          // Last clock switch into this state
+    uint32_t max_switch_us{0};
+    uint32_t wake_latency_us{0};    // EMA while in this state
+    float avg_ma{0.0f};             // EMA of the CPU current estimate
+};
+
+// Picks a clock per state and applies it with ESP-IDF power management when
+// the SDK has it (esp_pm_configure caps the clock, a CPU_FREQ_MAX lock holds
+// it while streaming), otherwise with setCpuFrequencyMhz().
+class PowerGovernor {
+public:
+    PowerGovernor();
+
+    void begin();
+    void update(const PowerInputs& inputs);
+
+    // 0 = governed; otherwise the clock stays at `mhz` (80, 160 or 240)
+    bool setFixedMhz(uint16_t mhz);
+    uint16_t getFixedMhz() const { return fixed_mhz_; }
+    PowerState getState() const { return state_; }
+    uint16_t getMhz() const { return mhz_; }
+    bool usesPmLocks() const { return pm_enabled_; }
+
+    static uint16_t mhzFor(PowerState state);
+    // CPU current estimate (mA) at `mhz` with both cores `load_percent` busy
+    static float estimateMa(uint16_t mhz, float load_percent);
+
+    void printStatus(Print& out = Serial) const;
+
+private:
+    PowerState state_;
+    uint16_t mhz_;
+    uint16_t fixed_mhz_;
+    bool pm_enabled_;
+    bool max_lock_held_;
+    void* max_lock_;                // esp_pm_lock_handle_t
+    int8_t tx_qdbm_;
+    unsigned long state_since_;
+    unsigned long last_busy_;       // Last update with a core above RELAX_LOAD_PERCENT
+    unsigned long last_stream_;
+    unsigned long last_update_;
+    PowerInputs last_inputs_;
+    float saved_mah_;               // Against a fixed 240 MHz clock
+    PowerStateStats stats_[POWER_STATE_COUNT];
+
+    PowerState choose(const PowerInputs& inputs, unsigned long now) const;
+    void enter(PowerState state, unsigned long now);
+    uint32_t applyMhz(uint16_t mhz, bool hold_max);
+    void updateTxPower(const PowerInputs& inputs);
+};
@@ -0,0 +1,85 @@
+// include/profiler.h - Профилирование задач FreeRTOS и джиттера loop()
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace ProfilerConfig {
+    constexpr uint32_t SAMPLE_INTERVAL_MS = 1000;
+    constexpr size_t MAX_TASKS = 24;            // Shown in the report; the rest are only counted
+    constexpr size_t TASK_HEADROOM = 4;         // Tasks created between counting and the snapshot
+    constexpr size_t TASK_NAME_LENGTH = 16;     // configMAX_TASK_NAME_LEN in ESP-IDF
+    constexpr size_t JITTER_BUCKETS = 10;
+}
+
+// One task as seen by the last sample
+struct TaskSample {
+    TaskHandle_t handle{nullptr};
+    char name[ProfilerConfig::TASK_NAME_LENGTH]{};
+    uint32_t runtime{0};         // Cumulative run time counter at the last sample
+    float cpu_percent{0.0f};     // Share of one core over the last interval
+    uint32_t stack_free{0};      // Stack high-water mark (bytes never used)
+    uint8_t priority{0};
+    int8_t core{-1};             // -1 = not pinned / unknown
+};
+
+// Histogram of loop() start-to-start periods plus iteration durations
+struct LoopJitter {
+    uint32_t buckets[ProfilerConfig::JITTER_BUCKETS]{};
+    uint32_t iterations{0};
+    uint32_t max_period_us{0};
+    uint32_t max_duration_us{0};
+    uint64_t total_duration_us{0};
+
+    void reset() {
+        for (size_t i = 0; i < ProfilerConfig::JITTER_BUCKETS; i++) buckets[i] = 0;
+        iterations = 0;
+        max_period_us = 0;
+        max_duration_us = 0;
+        total_duration_us = 0;
+    }
+};
+
+class Profiler {
+public:
+    Profiler();
+
+    // loop() instrumentation: a cycle-counter read each, no locking
+    void loopBegin();
+    void loopEnd();
+
+    // Takes a task sample every SAMPLE_INTERVAL_MS; call from the main loop
+    void update();
+    void resetLoopJitter() { jitter_.reset(); }
+
+    void printReport(Print& out) const;
+
+    float getCoreLoad(uint8_t core) const { return core < portNUM_PROCESSORS ? core_load_[core] : 0.0f; }
+    float getOverheadPercent() const { return overhead_percent_; }
+    bool hasRuntimeStats() const { return runtime_stats_available_; }
+    const LoopJitter& getLoopJitter() const { return jitter_; }
+
+private:
+    TaskSample tasks_[ProfilerConfig::MAX_TASKS];
+    size_t task_count_;
+    size_t hidden_tasks_;           // Past MAX_TASKS in the last sample
+    TaskStatus_t* status_;          // Snapshot buffer, grown to the task count
+    size_t status_capacity_;
+    float core_load_[portNUM_PROCESSORS];
+    uint32_t idle_runtime_[portNUM_PROCESSORS];
+    uint32_t last_total_runtime_;
+    unsigned long last_sample_ms_;
+    uint32_t sample_cost_us_;
+    float overhead_percent_;
+    bool runtime_stats_available_;
+
+    LoopJitter jitter_;
+    uint32_t loop_start_cycles_;
+    uint32_t last_loop_start_cycles_;
+    uint32_t cycles_per_us_;
+
+    void sample();
+    static size_t bucketFor(uint32_t period_us);
+    static const char* bucketLabel(size_t bucket);
+};
@@ -0,0 +1,131 @@
+// include/raw_pipeline.h - Конвейер RAW кадров: захват на ядре 1, OSD и JPEG на ядре 0
+#pragma once
+
+#include <Arduino.h>
+#include "esp_camera.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "ov2640.h"
+#include "osd_renderer.h"
+
+namespace RawPipelineConfig {
+    constexpr framesize_t DEFAULT_FRAME_SIZE = FRAMESIZE_QVGA;  // Software JPEG is the limit
+    constexpr pixformat_t DEFAULT_FORMAT = PIXFORMAT_YUV422;
+    constexpr uint8_t SLOT_COUNT = 2;                           // Raw frames in flight between the cores
+    constexpr uint8_t JPEG_QUALITY = 70;                        // fmt2jpg scale: 0-100, higher = better
+    constexpr uint32_t CAPTURE_STACK = 4096;
+    constexpr uint32_t ENCODE_STACK = 8192;
+    constexpr UBaseType_t CAPTURE_PRIORITY = 3;
+    constexpr UBaseType_t ENCODE_PRIORITY = 2;
+    constexpr BaseType_t CAPTURE_CORE = 1;
+    constexpr BaseType_t ENCODE_CORE = 0;
+    constexpr uint32_t STOP_TIMEOUT_MS = 1000;
+}
+
+struct RawPipelineStats {
+    uint32_t captured{0};
+    uint32_t capture_failed{0};
+    uint32_t encoded{0};
+    uint32_t encode_failed{0};      // Encoder error or output buffer too small
+    uint32_t avg_copy_us{0};        // Camera buffer -> slot (core 1)
+    uint32_t avg_convert_us{0};     // Slot -> BGR888 (core 0)
+    uint32_t avg_osd_us{0};
+    uint32_t avg_encode_us{0};
+    uint32_t last_jpeg_size{0};
+    float output_fps{0.0f};
+};
+
+// Second video path for raw sensor formats. Core 1 captures RGB565/YUV422
+// frames into two slots; core 0 converts the oldest to BGR888, draws the OSD
+// and encodes it to JPEG. Encoded frames are published through two output
+// buffers and streamed like sensor JPEG frames.
+class RawPipeline {
+public:
+    RawPipeline();
+    ~RawPipeline();
+
+    // Switches the camera to the raw format, starts both tasks
+    bool start(OV2640Camera* camera, pixformat_t format = RawPipelineConfig::DEFAULT_FORMAT,
+               framesize_t size = RawPipelineConfig::DEFAULT_FRAME_SIZE);
+    // Stops the tasks and restores the camera's previous format and frame size
+    void stop();
+    bool isRunning() const { return running_; }
+
+    // Newest encoded frame as a JPEG frame buffer, or nullptr if none newer
+    // than `last_seq`. Hold it until releaseFrame(); the encoder skips it.
+    camera_fb_t* acquireFrame(uint32_t& last_seq);
+    void releaseFrame();
+
+    void setOsdEnabled(bool enabled) { osd_enabled_ = enabled; }
+    bool isOsdEnabled() const { return osd_enabled_; }
+    void setTelemetry(const OsdTelemetry& telemetry);
+    void setQuality(uint8_t quality) { quality_ = quality; }
+    uint8_t getQuality() const { return quality_; }
+
+    const RawPipelineStats& getStats() const { return stats_; }
+    uint32_t getSequence() const { return sequence_; }
+    // Sets `bits` in the task's notification value after each published frame
+    void setFrameNotify(TaskHandle_t task, uint32_t bits) {
+        notify_bits_ = bits;
+        notify_task_ = task;
+    }
+    void printStatus(Print& out = Serial) const;
+
+    RawPipeline(const RawPipeline&) = delete;
+    RawPipeline& operator=(const RawPipeline&) = delete;
+
+private:
+    struct Slot {
+        uint8_t* data;
+        size_t length;
+        uint16_t width;
+        uint16_t height;
+        pixformat_t format;
+        struct timeval timestamp;   // Sensor capture time, carried to the JPEG output
+    };
+
+    struct Output {
+        uint8_t* data;
+        size_t capacity;
+        camera_fb_t frame;
+    };
+
+    OV2640Camera* camera_;
+    pixformat_t previous_format_;
+    framesize_t previous_size_;
+
+    Slot slots_[RawPipelineConfig::SLOT_COUNT];
+    size_t slot_capacity_;
+    uint8_t* bgr_;
+    Output outputs_[2];
+    QueueHandle_t free_slots_;
+    QueueHandle_t ready_slots_;
+    TaskHandle_t capture_task_;
+    TaskHandle_t encode_task_;
+    TaskHandle_t notify_task_;
+    uint32_t notify_bits_;
+
+    volatile bool running_;
+    volatile bool stop_requested_;
+    volatile int published_;        // Output index readers get, -1 before the first frame
+    volatile int reading_;          // Output index held by a reader, -1 if none
+    volatile uint32_t sequence_;
+    portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+
+    bool osd_enabled_;
+    uint8_t quality_;
+    OsdTelemetry telemetry_;
+    OsdRenderer osd_;
+    RawPipelineStats stats_;
+    uint32_t fps_window_start_;
+    uint32_t fps_window_frames_;
+
+    bool allocate(uint16_t width, uint16_t height);
+    void release();
+    void captureLoop();
+    void encodeLoop();
+    bool encode(const Slot& slot, Output& output, size_t& length);
+    static void captureTask(void* parameter);
+    static void encodeTask(void* parameter);
+};
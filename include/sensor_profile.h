@@ -0,0 +1,96 @@
+// include/sensor_profile.h - Профили сенсора: теневые регистры и запись только изменений
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sensor.h"
+
+// Driver-level sensor settings. Order is the order a full profile is written
+// in (mirroring first, then image, exposure and gain, then the ISP blocks).
+enum class SensorSetting : uint8_t {
+    VFLIP,
+    HMIRROR,
+    BRIGHTNESS,
+    CONTRAST,
+    SATURATION,
+    SPECIAL_EFFECT,
+    AWB,
+    AWB_GAIN,
+    WB_MODE,
+    AEC,
+    AEC2,
+    AE_LEVEL,
+    AEC_VALUE,
+    AGC,
+    AGC_GAIN,
+    GAINCEILING,
+    BPC,
+    WPC,
+    RAW_GMA,
+    LENC,
+    DCW,
+    QUALITY,
+    COUNT
+};
+
+constexpr size_t SENSOR_SETTING_COUNT = (size_t)SensorSetting::COUNT;
+
+const char* sensorSettingName(SensorSetting setting);
+
+struct SensorValue {
+    SensorSetting setting;
+    int16_t value;
+};
+
+// A named, possibly partial set of values; settings it leaves out keep their
+// current state, so e.g. "grayscale" doesn't touch exposure
+struct SensorProfile {
+    const char* name;
+    const char* description;
+    const SensorValue* values;
+    uint8_t count;
+};
+
+// Settings that differ from the shadow, in profile order
+struct SensorDiff {
+    SensorValue values[SENSOR_SETTING_COUNT];
+    uint8_t count{0};
+};
+
+// Last value written for each setting. Loaded from the driver's status after
+// init, then updated only by writes that succeeded.
+class SensorShadow {
+public:
+    SensorShadow();
+
+    void load(const camera_status_t& status);
+    void invalidate() { valid_ = false; }
+    bool isValid() const { return valid_; }
+    int16_t get(SensorSetting setting) const { return values_[(size_t)setting]; }
+    void note(SensorSetting setting, int16_t value) { values_[(size_t)setting] = value; }
+
+    // Without a valid shadow every value of the profile is written
+    void compile(const SensorProfile& profile, SensorDiff& diff) const;
+    // Full profile of the current state (for re-applying after a driver restart)
+    size_t snapshot(SensorValue* out, size_t capacity) const;
+
+private:
+    int16_t values_[SENSOR_SETTING_COUNT];
+    bool valid_;
+};
+
+// Single setting through the driver's setter; returns the setter's result (0 = OK)
+int writeSensorSetting(sensor_t* sensor, SensorSetting setting, int value);
+
+namespace SensorProfiles {
+    extern const SensorProfile BASE;        // Boot defaults (configureSensor)
+    extern const SensorProfile COLOR;
+    extern const SensorProfile GRAYSCALE;
+    extern const SensorProfile DAY;
+    extern const SensorProfile NIGHT;
+    extern const SensorProfile SPORT;
+
+    const SensorProfile* find(const char* name, size_t length);
+    size_t count();
+    const SensorProfile& at(size_t index);
+}
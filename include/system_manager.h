@@ -7,6 +7,14 @@
 #include "ov2640.h"
 #include "mjpeg_server.h"
 #include "flight_controller.h"
+#include "blackbox.h"
+#include "profiler.h"
+#include "frame_analyzer.h"
+#include "memory_pool.h"
+#include "raw_pipeline.h"
+#include "warm_start.h"
+#include "event_loop.h"
+#include "power_governor.h"
 
 class SystemManager {
 private:
@@ -15,11 +23,30 @@ private:
     OV2640Camera camera;
     MJPEGServer mjpegServer;
     FlightController flightController;
+    Blackbox blackbox;
+    Profiler profiler;
+    FrameAnalyzer frameAnalyzer;
+    RawPipeline rawPipeline;
+    WarmStart warmStart;
+    EventLoop eventLoop;
+    PowerGovernor powerGovernor;
     
     bool system_initialized;
-    unsigned long last_stats_log;
+    int net_timer;
     
     static const unsigned long STATS_LOG_INTERVAL = 5000; // 5 seconds
+    static const unsigned long OSD_UPDATE_INTERVAL = 250;
+    static const unsigned long WIFI_CHECK_INTERVAL = 5000;
+    static const unsigned long SURVEY_STEP_INTERVAL = 250;  // Starts survey steps; results arrive as events
+    static const unsigned long TASK_STATUS_INTERVAL = 10000;
+    static const unsigned long FRAME_POLL_INTERVAL = 5;     // Only without a VSYNC interrupt
+    
+    void registerEvents();
+    void updateNetPollRate();
+    void updatePower();
+    void logStatistics();
+    void updateOsdTelemetry();
+    void applyWarmState(const WarmState& state);
 
 public:
     SystemManager();
@@ -27,17 +54,31 @@ public:
     
     // System lifecycle
     bool initialize();
-    void update();
     void shutdown();
     
     // Status and monitoring
     bool isInitialized() const { return system_initialized; }
-    void printSystemStatus();
+    void printSystemStatus(Print& out = Serial);
     
     // Component access
     WiFiModule& getWiFi() { return wifi; }
     OV2640Camera& getCamera() { return camera; }
     MJPEGServer& getMJPEGServer() { return mjpegServer; }
     FlightController& getFlightController() { return flightController; }
+    Blackbox& getBlackbox() { return blackbox; }
     TaskManager& getTaskManager() { return taskManager; }
+    Profiler& getProfiler() { return profiler; }
+    FrameAnalyzer& getFrameAnalyzer() { return frameAnalyzer; }
+    RawPipeline& getRawPipeline() { return rawPipeline; }
+    WarmStart& getWarmStart() { return warmStart; }
+    // Everything after setup() runs from here, on the Arduino loop task
+    EventLoop& getEventLoop() { return eventLoop; }
+    PowerGovernor& getPowerGovernor() { return powerGovernor; }
+    
+    // Blackbox logging with the FC telemetry poll at the log rate
+    bool startBlackbox(uint16_t rate_hz);
+    void stopBlackbox();
+    
+    // Live values of every warm-start field
+    WarmState captureWarmState() const;
 };
\ No newline at end of file
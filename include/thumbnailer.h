@@ -0,0 +1,51 @@
+// include/thumbnailer.h - Миниатюры 1/8 из DC-коэффициентов JPEG
+#pragma once
+
+#include <Arduino.h>
+#include "esp_camera.h"
+#include "jpeg_dc_decoder.h"
+#include "motion_detector.h"
+
+namespace ThumbnailConfig {
+    constexpr uint8_t JPEG_QUALITY = 80;                            // fmt2jpg scale: 0-100, higher = better
+    constexpr size_t PLANE_CAPACITY = MotionConfig::MAX_PLANE_BYTES; // Per component, up to FHD/UXGA
+    constexpr uint32_t STREAM_INTERVAL_MS = 100;                    // Spectator stream: 10 FPS
+}
+
+struct ThumbnailStats {
+    uint32_t encoded{0};
+    uint32_t failed{0};
+    uint32_t last_size{0};
+    uint32_t avg_decode_us{0};
+    uint32_t avg_encode_us{0};
+};
+
+// Builds a 1/8-scale preview from a camera JPEG without a full decode: DC
+// coefficients give one pixel per 8x8 block, which is then re-encoded small.
+class Thumbnailer {
+public:
+    Thumbnailer();
+    ~Thumbnailer();
+
+    // On success *out is a malloc'd JPEG owned by the caller (free())
+    bool encode(const camera_fb_t* fb, bool color, uint8_t** out, size_t* out_len);
+
+    uint16_t getWidth() const { return decoder_.planeWidth(); }
+    uint16_t getHeight() const { return decoder_.planeHeight(); }
+    const char* getLastError() const { return error_; }
+    const ThumbnailStats& getStats() const { return stats_; }
+
+    void printStatus(Print& out = Serial) const;
+
+    Thumbnailer(const Thumbnailer&) = delete;
+    Thumbnailer& operator=(const Thumbnailer&) = delete;
+
+private:
+    JpegDcDecoder decoder_;
+    uint8_t* planes_[JpegDcDecoder::MAX_COMPONENTS];
+    uint8_t* rgb_;
+    ThumbnailStats stats_;
+    const char* error_;
+
+    bool allocate();
+};
@@ -0,0 +1,105 @@
+// include/viewer_policy.h - Роли зрителей (пилот/наблюдатель) и лимиты видеопотока
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Pure C++ (no Arduino dependencies) so the host fairness simulation in
+// tools/viewer_fairness_sim.cpp runs the same policy as the firmware.
+
+enum class ViewerRole : uint8_t {
+    PILOT,          // Every frame (or its own target fps), written first
+    OBSERVER        // Capped frame rate and byte rate, written after pilots
+};
+
+const char* viewerRoleName(ViewerRole role);
+
+namespace ViewerConfig {
+    constexpr size_t MAX_VIEWERS = 4;                       // Same as the AP station limit
+    constexpr uint32_t PACING_EARLY_MS = 5;                 // A frame this close to a viewer's deadline counts as due
+    constexpr size_t MAX_PILOT_MACS = 4;
+    constexpr size_t TOKEN_MAX_LENGTH = 32;
+    constexpr uint32_t OBSERVER_FRAME_INTERVAL_MS = 100;    // 10 FPS
+    constexpr uint32_t OBSERVER_BYTES_PER_SEC = 200 * 1024; // ~1.6 Mbit/s per observer
+    constexpr uint32_t OBSERVER_BURST_BYTES = 64 * 1024;    // Budget carried over while idle
+    constexpr size_t OBSERVERS_PER_FRAME = 1;               // Bounds the airtime queued behind each pilot frame
+    constexpr uint8_t VIDEO_IP_TOS = 0xA0;                  // Precedence 5 -> 802.11 UP 5 -> WMM AC_VI
+    constexpr uint32_t WRITE_DEADLINE_MS = 60;              // A part still unsent by then drops the viewer
+}
+
+struct ViewerStats {
+    uint32_t frames_sent{0};
+    uint32_t frames_skipped{0};
+    uint64_t bytes_sent{0};
+};
+
+struct ViewerSlot {
+    bool active{false};
+    ViewerRole role{ViewerRole::OBSERVER};
+    uint8_t mac[6]{};
+    uint32_t joined_ms{0};
+    uint32_t interval_ms{0};        // Own target rate (?fps=), 0 = role default
+    uint32_t next_due_ms{0};        // Frame deadline (paced viewers)
+    uint32_t refill_ms{0};          // Last byte budget refill
+    int32_t credit_bytes{0};
+    uint32_t charged_bytes{0};      // Taken from the budget by planFrame
+    ViewerStats stats;
+};
+
+// Decides who gets each frame. Roles come from a shared token (?token=) or a
+// list of pilot station MACs; everyone else is an observer.
+class ViewerPolicy {
+public:
+    ViewerPolicy();
+
+    void setPilotToken(const char* token, size_t length);
+    void clearPilotToken() { token_[0] = '\0'; }
+    bool hasPilotToken() const { return token_[0] != '\0'; }
+    bool addPilotMac(const uint8_t mac[6]);
+    bool removePilotMac(const uint8_t mac[6]);
+    size_t getPilotMacCount() const { return pilot_mac_count_; }
+    const uint8_t* getPilotMac(size_t index) const { return pilot_macs_[index]; }
+
+    // token may be nullptr, mac may be nullptr if the station is unknown
+    ViewerRole classify(const char* token, const uint8_t* mac) const;
+
+    // Returns the slot or -1 if full. A pilot joining a full house takes the
+    // slot of the longest-connected observer; *evicted is then set to that
+    // slot (else -1) and the caller must close its connection.
+    int admit(ViewerRole role, const uint8_t* mac, uint32_t now_ms, int* evicted);
+    void release(int slot);
+
+    // Per-viewer target rate, paced by deadlines so the average holds when
+    // frames arrive early or late. Observers stay within the observer cap.
+    void setTargetFps(int slot, uint32_t fps, uint32_t now_ms);
+
+    // Slots that should receive this frame: all due pilots, then at most
+    // OBSERVERS_PER_FRAME observers in round-robin. Returns the number of slots.
+    size_t planFrame(uint32_t now_ms, size_t frame_len, int* order, size_t capacity);
+    // frame_len is what was actually written; an observer sent less than the
+    // planned frame (a thumbnail) gets the difference back in its budget
+    void frameWritten(int slot, size_t frame_len);
+    // Planned, but the socket had no room: nothing was written
+    void frameSkipped(int slot);
+
+    void setObserverLimits(uint32_t interval_ms, uint32_t bytes_per_sec);
+    uint32_t getObserverInterval() const { return observer_interval_ms_; }
+    uint32_t getObserverByteRate() const { return observer_bytes_per_sec_; }
+
+    const ViewerSlot& getSlot(size_t index) const { return slots_[index]; }
+    size_t getActiveCount() const;
+    size_t getPilotCount() const;
+
+private:
+    ViewerSlot slots_[ViewerConfig::MAX_VIEWERS];
+    uint8_t pilot_macs_[ViewerConfig::MAX_PILOT_MACS][6];
+    size_t pilot_mac_count_;
+    char token_[ViewerConfig::TOKEN_MAX_LENGTH + 1];
+    uint32_t observer_interval_ms_;
+    uint32_t observer_bytes_per_sec_;
+    uint8_t rotation_;
+
+    bool observerReady(ViewerSlot& slot, uint32_t now_ms, size_t frame_len);
+    static bool takeDeadline(ViewerSlot& slot, uint32_t now_ms, uint32_t interval_ms);
+    int findPilotMac(const uint8_t mac[6]) const;
+};
@@ -0,0 +1,97 @@
+// include/warm_start.h - Тёплый старт: последнее рабочее состояние в NVS
+#pragma once
+
+#include <Arduino.h>
+
+namespace WarmStartConfig {
+    constexpr const char* NVS_NAMESPACE = "warmstart";
+    constexpr const char* NVS_KEY = "state";
+    constexpr uint16_t SCHEMA_VERSION = 2;          // Bump when WarmField changes
+    constexpr uint32_t CHECK_INTERVAL_MS = 1000;    // Period of the "warm" event-loop timer
+    constexpr uint32_t STABLE_MS = 30000;           // Unchanged and healthy this long = known-good
+    constexpr uint32_t MIN_WRITE_INTERVAL_MS = 10 * 60 * 1000;
+    constexpr uint8_t MAX_WRITES_PER_BOOT = 12;     // Flash wear cap for a long session
+}
+
+// Every persisted value, in blob order. Append only; a reorder or a new
+// field needs a SCHEMA_VERSION bump, which discards the old blob.
+enum class WarmField : uint8_t {
+    JPEG_QUALITY,
+    WIFI_CHANNEL,
+    FC_BAUD,
+    AEC,
+    AEC2,
+    AE_LEVEL,
+    AEC_VALUE,
+    AGC,
+    AGC_GAIN,
+    GAINCEILING,
+    FC_PROTOCOL,
+    COUNT
+};
+
+constexpr size_t WARM_FIELD_COUNT = (size_t)WarmField::COUNT;
+
+struct WarmFieldSpec {
+    const char* name;
+    int32_t min;
+    int32_t max;
+};
+
+// Range per field; a stored value outside it rejects the whole blob
+constexpr WarmFieldSpec WARM_SCHEMA[WARM_FIELD_COUNT] = {
+    {"quality",     0,    63},
+    {"channel",     1,    13},
+    {"fc_baud",     9600, 921600},
+    {"aec",         0,    1},
+    {"aec2",        0,    1},
+    {"ae_level",    -2,   2},
+    {"aec_value",   0,    1200},
+    {"agc",         0,    1},
+    {"agc_gain",    0,    30},
+    {"gainceiling", 0,    6},
+    {"fc_proto",    0,    1},
+};
+
+struct WarmState {
+    int32_t values[WARM_FIELD_COUNT];
+
+    int32_t get(WarmField field) const { return values[(size_t)field]; }
+    void set(WarmField field, int32_t value) { values[(size_t)field] = value; }
+    bool equals(const WarmState& other) const;
+    bool isValid() const;
+};
+
+// Stored as one NVS blob: header + WarmState. NVS already checksums its
+// entries, so the header only identifies the schema.
+class WarmStart {
+public:
+    WarmStart();
+
+    // NVS -> stored state; false when missing, from another schema or out of range
+    bool load();
+    bool hasStored() const { return stored_valid_; }
+    const WarmState& stored() const { return stored_; }
+
+    // Feed the live state every CHECK_INTERVAL_MS; writes once it has been
+    // stable and healthy for STABLE_MS, differs from the stored copy and
+    // the rate limit allows
+    void update(const WarmState& live, bool healthy);
+    // Immediate write (command); ignores the rate limit
+    bool save(const WarmState& live);
+    bool clear();
+
+    void printStatus(const WarmState& live, Print& out = Serial) const;
+
+private:
+    WarmState stored_;
+    WarmState candidate_;
+    bool stored_valid_;
+    bool candidate_valid_;
+    unsigned long candidate_since_;
+    unsigned long last_write_;
+    uint8_t writes_;
+    const char* load_result_;   // What load() found, for the status
+
+    bool write(const WarmState& state);
+};
@@ -3,26 +3,97 @@
 
 #include <WiFi.h>
 #include <esp_wifi.h>
+#include "memory_pool.h"
+
+// Channel survey tuning
+namespace ChannelSurveyConfig {
+    constexpr uint8_t FIRST_CHANNEL = 1;
+    constexpr uint8_t LAST_CHANNEL = 13;
+    constexpr uint8_t CHANNEL_COUNT = LAST_CHANNEL - FIRST_CHANNEL + 1;
+    constexpr uint8_t DEFAULT_CHANNEL = 1;
+    constexpr uint32_t DWELL_MS = 110;              // Passive dwell, ~1 beacon interval
+    constexpr uint32_t ACTIVE_DWELL_MS = 12;        // Probe dwell with stations on, well under a frame
+    constexpr uint32_t STEP_INTERVAL_MS = 2000;     // Pause between single-channel steps
+    constexpr uint32_t SWEEP_INTERVAL_MS = 60000;   // Pause between background sweeps
+    constexpr uint8_t SWITCH_MARGIN_PERCENT = 25;   // Minimum gain for a planned switch
+}
+
+// Per-channel congestion observed by the survey
+struct ChannelStats {
+    uint16_t networks{0};
+    int8_t strongest_rssi{-127};
+    uint32_t load{0};
+
+    void reset() {
+        networks = 0;
+        strongest_rssi = -127;
+        load = 0;
+    }
+};
 
 class WiFiModule {
 public:
     WiFiModule();
-    void init(const char* ssid, const char* password);
+    // A valid preferred channel (warm start) skips the boot survey; the
+    // background survey still moves the AP if that channel turns out busy
+    void init(const char* ssid, const char* password, uint8_t preferred_channel = 0);
     void start();
     void stop();
     bool isConnected() const;
     void checkStability();
     void optimizeForFPV();
-    void scanNetworks();
+    // Starts a full-band scan; results go to Serial once it is done.
+    // Refused while viewers are streaming
+    void scanNetworks(Print& out = Serial);
     void showStatus() const;
 
+    // Channel survey (AP+STA, does not drop connected stations)
+    void updateChannelSurvey();
+    // While viewers stream, survey steps start only right after a sent frame
+    void setStreaming(bool streaming) { streaming_ = streaming; }
+    void surveyAfterFrame();
+    void setSurveyEnabled(bool enable) { surveyEnabled_ = enable; }
+    bool isSurveyEnabled() const { return surveyEnabled_; }
+    uint8_t getChannel() const { return channel_; }
+    uint8_t getPendingChannel() const { return pendingChannel_; }
+    uint32_t channelScore(uint8_t channel) const;
+    uint8_t recommendChannel() const;
+    bool requestChannelSwitch(uint8_t channel);
+    void printChannelSurvey(Print& out = Serial) const;
+    void showConnectedClients(Print& out = Serial) const;
+
 private:
-    String ssid_;
-    String password_;
+    FixedString<33> ssid_;      // 802.11 limits: 32-byte SSID, 64-byte passphrase
+    FixedString<65> password_;
     unsigned long lastStabilityCheck_;
-    
+
+    // Survey state
+    uint8_t channel_;
+    uint8_t pendingChannel_;
+    bool surveyEnabled_;
+    uint8_t scanningChannel_;       // Channel of the step in flight, 0 = idle
+    uint8_t nextSurveyChannel_;     // Next step of the current sweep, 0 = no sweep
+    bool streaming_;
+    bool fullScanRequested_;        // wifiscan waits for the step in flight
+    bool fullScanRunning_;
+    unsigned long lastSurveyStep_;
+    unsigned long lastSweepEnd_;
+    uint32_t sweepsCompleted_;
+    ChannelStats stats_[ChannelSurveyConfig::CHANNEL_COUNT];
+    ChannelStats sweep_[ChannelSurveyConfig::CHANNEL_COUNT];
+
+    void surveyAllChannels();
+    void startSurveyStep();
+    void startFullScan();
+    void finishFullScan(int16_t result);
+    void resetSweep();
+    void accumulateNetwork(int32_t channel, int32_t rssi);
+    void commitSweep(bool smooth);
+    void planAutoSwitch();
+    void applyPendingChannelSwitch();
+    static bool isValidChannel(int32_t channel);
+
     static void wifiEventHandler(arduino_event_id_t event, arduino_event_info_t info);
-    void showConnectedClients() const;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,238 @@
+// src/camera/camera_bench.cpp - Перебор настроек драйвера с выводом CSV
+#include "camera_bench.h"
+#include <algorithm>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <string.h>
+
+namespace {
+
+struct FrameSizeName {
+    const char* name;
+    framesize_t size;
+};
+
+const FrameSizeName FRAME_SIZES[] = {
+    {"qqvga", FRAMESIZE_QQVGA}, {"qvga", FRAMESIZE_QVGA}, {"cif", FRAMESIZE_CIF},
+    {"hvga", FRAMESIZE_HVGA},   {"vga", FRAMESIZE_VGA},   {"svga", FRAMESIZE_SVGA},
+    {"xga", FRAMESIZE_XGA},     {"hd", FRAMESIZE_HD},     {"sxga", FRAMESIZE_SXGA},
+    {"uxga", FRAMESIZE_UXGA},
+};
+
+bool tokenEquals(const char* token, size_t length, const char* name) {
+    return strlen(name) == length && strncasecmp(token, name, length) == 0;
+}
+
+bool parseNumber(const char* token, size_t length, long min, long max, long& value) {
+    if (length == 0 || length > 6) return false;
+    value = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (token[i] < '0' || token[i] > '9') return false;
+        value = value * 10 + (token[i] - '0');
+    }
+    return value >= min && value <= max;
+}
+
+// Calls `parse` for each comma-separated item; false on an empty list,
+// too many items or an item `parse` rejects
+template <typename Parse>
+bool forEachItem(const char* values, size_t length, uint8_t& count, Parse parse) {
+    count = 0;
+    size_t start = 0;
+    while (start <= length) {
+        size_t end = start;
+        while (end < length && values[end] != ',') end++;
+        if (count >= CameraBenchConfig::MAX_VALUES || !parse(values + start, end - start, count)) {
+            count = 0;
+            return false;
+        }
+        count++;
+        start = end + 1;
+    }
+    return count > 0;
+}
+
+uint32_t percentile(const uint32_t* sorted, size_t count, uint8_t percent) {
+    return count ? sorted[std::min(count - 1, count * percent / 100)] : 0;
+}
+
+const char* grabModeName(camera_grab_mode_t mode) {
+    return mode == CAMERA_GRAB_LATEST ? "latest" : "empty";
+}
+
+uint32_t frame_lengths[CameraBenchConfig::MAX_FRAMES];
+
+} // namespace
+
+const char* frameSizeName(framesize_t size) {
+    for (const FrameSizeName& entry : FRAME_SIZES) {
+        if (entry.size == size) return entry.name;
+    }
+    return "other";
+}
+
+void CameraBenchMatrix::reset(const DriverSettings& current) {
+    sizes[0] = current.frame_size;
+    qualities[0] = current.jpeg_quality;
+    fb_counts[0] = current.fb_count;
+    grab_modes[0] = current.grab_mode;
+    xclk_mhz[0] = (uint8_t)(current.xclk_freq_hz / 1000000);
+    size_count = quality_count = fb_count_count = grab_mode_count = xclk_count = 1;
+    frames = CameraBenchConfig::DEFAULT_FRAMES;
+}
+
+bool CameraBenchMatrix::set(const char* key, const char* values, size_t values_length) {
+    if (!strcmp(key, "size")) {
+        return forEachItem(values, values_length, size_count, [this](const char* item, size_t length, uint8_t i) {
+            for (const FrameSizeName& entry : FRAME_SIZES) {
+                if (tokenEquals(item, length, entry.name)) {
+                    sizes[i] = entry.size;
+                    return true;
+                }
+            }
+            return false;
+        });
+    }
+    if (!strcmp(key, "q")) {
+        return forEachItem(values, values_length, quality_count, [this](const char* item, size_t length, uint8_t i) {
+            long value;
+            if (!parseNumber(item, length, 0, 63, value)) return false;
+            qualities[i] = (uint8_t)value;
+            return true;
+        });
+    }
+    if (!strcmp(key, "fb")) {
+        return forEachItem(values, values_length, fb_count_count, [this](const char* item, size_t length, uint8_t i) {
+            long value;
+            if (!parseNumber(item, length, 1, 4, value)) return false;
+            fb_counts[i] = (uint8_t)value;
+            return true;
+        });
+    }
+    if (!strcmp(key, "grab")) {
+        return forEachItem(values, values_length, grab_mode_count, [this](const char* item, size_t length, uint8_t i) {
+            if (tokenEquals(item, length, "empty")) grab_modes[i] = CAMERA_GRAB_WHEN_EMPTY;
+            else if (tokenEquals(item, length, "latest")) grab_modes[i] = CAMERA_GRAB_LATEST;
+            else return false;
+            return true;
+        });
+    }
+    if (!strcmp(key, "xclk")) {
+        return forEachItem(values, values_length, xclk_count, [this](const char* item, size_t length, uint8_t i) {
+            long value;
+            if (!parseNumber(item, length, DriverLimits::MIN_XCLK_HZ / 1000000,
+                             DriverLimits::MAX_XCLK_HZ / 1000000, value)) return false;
+            xclk_mhz[i] = (uint8_t)value;
+            return true;
+        });
+    }
+    if (!strcmp(key, "n")) {
+        long value;
+        if (!parseNumber(values, values_length, 1, CameraBenchConfig::MAX_FRAMES, value)) return false;
+        frames = (uint16_t)value;
+        return true;
+    }
+    return false;
+}
+
+size_t CameraBenchMatrix::combinations() const {
+    return (size_t)size_count * quality_count * fb_count_count * grab_mode_count * xclk_count;
+}
+
+// Frame size varies slowest, so consecutive rows differ in one parameter
+DriverSettings CameraBenchMatrix::at(size_t index, const DriverSettings& base) const {
+    DriverSettings settings = base;
+    settings.pixel_format = PIXFORMAT_JPEG;
+    settings.xclk_freq_hz = (uint32_t)xclk_mhz[index % xclk_count] * 1000000;
+    index /= xclk_count;
+    settings.grab_mode = grab_modes[index % grab_mode_count];
+    index /= grab_mode_count;
+    settings.fb_count = fb_counts[index % fb_count_count];
+    index /= fb_count_count;
+    settings.jpeg_quality = qualities[index % quality_count];
+    index /= quality_count;
+    settings.frame_size = sizes[index];
+    return settings;
+}
+
+void CameraBench::printHeader(Print& out) {
+    out.println("size,width,height,quality,fb_count,grab,xclk_mhz,frames,failed,fps,"
+                "len_min,len_p50,len_p95,len_max,capture_avg_us,capture_max_us,"
+                "internal_delta_kb,psram_delta_kb,status");
+}
+
+bool CameraBench::run(OV2640Camera& camera, const CameraBenchMatrix& matrix, Print& out) {
+    size_t combinations = matrix.combinations();
+    if (combinations == 0 || combinations > CameraBenchConfig::MAX_COMBINATIONS || !camera.isInitialized()) {
+        return false;
+    }
+
+    DriverSettings original = camera.getDriverSettings();
+    bool watchdog = camera.isWatchdogEnabled();
+    // A combination that fails to capture must not trigger recoveries mid-sweep
+    camera.setWatchdogEnabled(false);
+    // Heap deltas are against the configuration running before the sweep
+    size_t free_internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    size_t free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+
+    printHeader(out);
+    for (size_t i = 0; i < combinations; i++) {
+        measure(camera, matrix.at(i, original), matrix.frames, free_internal, free_psram, out);
+    }
+
+    if (!camera.applyDriverSettings(original)) {
+        out.printf("# restoring the previous settings failed: %s\n", camera.getLastErrorMessage().c_str());
+    }
+    camera.setWatchdogEnabled(watchdog);
+    camera.resetStatistics();
+    return true;
+}
+
+void CameraBench::measure(OV2640Camera& camera, const DriverSettings& settings, uint16_t frames,
+                          size_t free_internal, size_t free_psram, Print& out) {
+    const resolution_info_t& res = resolution[settings.frame_size];
+    out.printf("%s,%u,%u,%u,%u,%s,%lu,", frameSizeName(settings.frame_size), res.width, res.height,
+               settings.jpeg_quality, settings.fb_count, grabModeName(settings.grab_mode),
+               settings.xclk_freq_hz / 1000000);
+
+    if (!camera.applyDriverSettings(settings)) {
+        out.println("0,0,0,0,0,0,0,0,0,0,0,init_failed");
+        return;
+    }
+    long internal_delta_kb = ((long)free_internal - (long)heap_caps_get_free_size(MALLOC_CAP_INTERNAL)) / 1024;
+    long psram_delta_kb = ((long)free_psram - (long)heap_caps_get_free_size(MALLOC_CAP_SPIRAM)) / 1024;
+
+    uint32_t deadline = millis() + CameraBenchConfig::COMBINATION_TIMEOUT_MS;
+    for (uint8_t i = 0; i < CameraBenchConfig::WARMUP_FRAMES && (int32_t)(deadline - millis()) > 0; i++) {
+        camera.returnFrameBuffer(camera.getFrameBuffer());
+    }
+
+    uint16_t captured = 0;
+    uint16_t failed = 0;
+    uint64_t capture_total_us = 0;
+    uint32_t capture_max_us = 0;
+    int64_t start = esp_timer_get_time();
+    while (captured < frames && (int32_t)(deadline - millis()) > 0) {
+        int64_t request = esp_timer_get_time();
+        camera_fb_t* fb = camera.getFrameBuffer();
+        uint32_t waited = (uint32_t)(esp_timer_get_time() - request);
+        if (!fb) {
+            failed++;
+            continue;
+        }
+        frame_lengths[captured++] = fb->len;
+        camera.returnFrameBuffer(fb);
+        capture_total_us += waited;
+        capture_max_us = std::max(capture_max_us, waited);
+    }
+    float elapsed_s = (esp_timer_get_time() - start) / 1000000.0f;
+
+    std::sort(frame_lengths, frame_lengths + captured);
+    const char* status = captured == frames ? "ok" : (captured == 0 ? "no_frames" : "timeout");
+    out.printf("%u,%u,%.2f,%lu,%lu,%lu,%lu,%lu,%lu,%ld,%ld,%s\n", captured, failed,
+               elapsed_s > 0 ? captured / elapsed_s : 0.0f,
+               percentile(frame_lengths, captured, 0), percentile(frame_lengths, captured, 50),
+               percentile(frame_lengths, captured, 95), captured ? frame_lengths[captured - 1] : 0,
+               captured ? (uint32_t)(capture_total_us / captured) : 0, capture_max_us,
+               internal_delta_kb, psram_delta_kb, status);
+}
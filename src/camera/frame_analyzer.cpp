@@ -0,0 +1,126 @@
+// src/camera/frame_analyzer.cpp - Анализ кадров: DC-декодирование + детектор движения
+#include "frame_analyzer.h"
+#include <esp_heap_caps.h>
+
+FrameAnalyzer::FrameAnalyzer()
+    : plane_(nullptr), enabled_(true), skip_static_(false), last_static_(false),
+      motion_active_(false), interval_(AnalyzerConfig::DEFAULT_INTERVAL), frame_counter_(0),
+      last_sent_ms_(0), last_motion_ms_(0) {
+}
+
+FrameAnalyzer::~FrameAnalyzer() {
+    free(plane_);
+}
+
+void FrameAnalyzer::setEnabled(bool enabled) {
+    enabled_ = enabled;
+    if (!enabled) {
+        detector_.reset();
+        last_static_ = false;
+        motion_active_ = false;
+    }
+}
+
+bool FrameAnalyzer::shouldSend(const camera_fb_t* fb) {
+    if (!enabled_ || !fb || fb->format != PIXFORMAT_JPEG) {
+        return true;
+    }
+
+    unsigned long now = millis();
+    bool keepalive_due = now - last_sent_ms_ >= AnalyzerConfig::KEEPALIVE_MS;
+
+    if (++frame_counter_ >= interval_) {
+        frame_counter_ = 0;
+        if (!analyze(fb)) {
+            return true;
+        }
+        updateMotionState(now);
+        // Anchor on the frame that actually goes out so slow drift accumulates
+        // against it instead of disappearing frame to frame
+        if (!(skip_static_ && last_static_ && !keepalive_due)) {
+            detector_.setReference(plane_, decoder_.planeWidth(), decoder_.planeHeight());
+            return true;
+        }
+    }
+
+    // Frames between analyses follow the last verdict
+    if (skip_static_ && last_static_ && !keepalive_due) {
+        stats_.skipped_frames++;
+        return false;
+    }
+    return true;
+}
+
+bool FrameAnalyzer::analyze(const camera_fb_t* fb) {
+    if (!plane_) {
+        plane_ = (uint8_t*)heap_caps_malloc(MotionConfig::MAX_PLANE_BYTES, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!plane_) {
+            Serial.println("❌ [MOTION] Failed to allocate luma plane, analysis disabled");
+            enabled_ = false;
+            return false;
+        }
+    }
+
+    uint32_t start = ESP.getCycleCount();
+    if (!decoder_.decodeLuma(fb->buf, fb->len, plane_, MotionConfig::MAX_PLANE_BYTES)) {
+        stats_.decode_errors++;
+        return false;
+    }
+    uint32_t decoded = ESP.getCycleCount();
+    detector_.analyze(plane_, decoder_.planeWidth(), decoder_.planeHeight(), last_result_);
+    uint32_t detected = ESP.getCycleCount();
+
+    uint32_t decode_cycles = decoded - start;
+    uint32_t detect_cycles = detected - decoded;
+    stats_.analyzed++;
+    // Exponential moving average, 1/8 weight
+    if (stats_.analyzed == 1) {
+        stats_.avg_decode_cycles = decode_cycles;
+        stats_.avg_detect_cycles = detect_cycles;
+    } else {
+        stats_.avg_decode_cycles = stats_.avg_decode_cycles - stats_.avg_decode_cycles / 8 + decode_cycles / 8;
+        stats_.avg_detect_cycles = stats_.avg_detect_cycles - stats_.avg_detect_cycles / 8 + detect_cycles / 8;
+    }
+    if (decode_cycles > stats_.max_decode_cycles) stats_.max_decode_cycles = decode_cycles;
+
+    if (last_result_.scene_change && stats_.analyzed > 1) stats_.scene_changes++;
+    last_static_ = last_result_.is_static;
+    return true;
+}
+
+void FrameAnalyzer::updateMotionState(unsigned long now_ms) {
+    if (last_result_.motion) {
+        last_motion_ms_ = now_ms;
+        if (!motion_active_) {
+            motion_active_ = true;
+            stats_.motion_events++;
+            if (motion_callback_) motion_callback_(true, last_result_);
+        }
+    } else if (motion_active_ && now_ms - last_motion_ms_ >= AnalyzerConfig::MOTION_HOLD_MS) {
+        motion_active_ = false;
+        if (motion_callback_) motion_callback_(false, last_result_);
+    }
+}
+
+void FrameAnalyzer::printStatus(Print& out) const {
+    uint32_t mhz = ESP.getCpuFreqMHz();
+    out.println("\n🎯 === MOTION ANALYSIS ===");
+    out.printf("Analysis: %s (every %u frame%s), skip static: %s\n",
+               enabled_ ? "ON" : "OFF", interval_, interval_ == 1 ? "" : "s", skip_static_ ? "ON" : "OFF");
+    out.printf("Plane: %ux%u from %ux%u JPEG\n",
+               decoder_.planeWidth(), decoder_.planeHeight(), decoder_.imageWidth(), decoder_.imageHeight());
+    out.printf("Last: mean diff %.2f, cells %u/%u, motion %s, scene change %s, static %s\n",
+               last_result_.mean_abs_diff, last_result_.changed_cells, last_result_.total_cells,
+               last_result_.motion ? "yes" : "no", last_result_.scene_change ? "yes" : "no",
+               last_result_.is_static ? "yes" : "no");
+    out.printf("Motion: %s, events %lu, scene changes %lu\n",
+               motion_active_ ? "ACTIVE" : "idle", stats_.motion_events, stats_.scene_changes);
+    out.printf("Frames: analyzed %lu, skipped %lu, decode errors %lu\n",
+               stats_.analyzed, stats_.skipped_frames, stats_.decode_errors);
+    out.printf("Cost: decode %lu cycles (%lu us, max %lu us), detect %lu cycles (%lu us)\n",
+               stats_.avg_decode_cycles, stats_.avg_decode_cycles / mhz, stats_.max_decode_cycles / mhz,
+               stats_.avg_detect_cycles, stats_.avg_detect_cycles / mhz);
+    if (stats_.decode_errors > 0) {
+        out.printf("Last decode error: %s\n", decoder_.lastError());
+    }
+}
@@ -0,0 +1,107 @@
+// src/camera/frame_trace.cpp - Формат трассы кадров
+#include "frame_trace.h"
+#include <string.h>
+
+namespace {
+
+void put16(uint8_t* p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+void put32(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+uint16_t get16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+uint32_t get32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+} // namespace
+
+bool FrameTraceWriter::begin(uint8_t* buffer, size_t capacity) {
+    buffer_ = buffer;
+    capacity_ = capacity;
+    size_ = 0;
+    frames_ = 0;
+    first_us_ = 0;
+    if (!buffer_ || capacity_ < FrameTraceConfig::HEADER_SIZE) {
+        return false;
+    }
+    memset(buffer_, 0, FrameTraceConfig::HEADER_SIZE);
+    put32(buffer_, FrameTraceConfig::MAGIC);
+    put16(buffer_ + 4, FrameTraceConfig::VERSION);
+    size_ = FrameTraceConfig::HEADER_SIZE;
+    return true;
+}
+
+bool FrameTraceWriter::append(uint64_t timestamp_us, uint32_t capture_us, uint16_t width, uint16_t height,
+                              const uint8_t* data, size_t length) {
+    if (!buffer_ || size_ + FrameTraceConfig::RECORD_HEADER_SIZE + length > capacity_) {
+        return false;
+    }
+    if (frames_ == 0) {
+        first_us_ = timestamp_us;
+    }
+
+    uint8_t* record = buffer_ + size_;
+    put32(record, (uint32_t)(timestamp_us - first_us_));
+    put32(record + 4, capture_us);
+    put32(record + 8, (uint32_t)length);
+    put16(record + 12, width);
+    put16(record + 14, height);
+    memcpy(record + FrameTraceConfig::RECORD_HEADER_SIZE, data, length);
+    size_ += FrameTraceConfig::RECORD_HEADER_SIZE + length;
+
+    // The count is kept current so a partially downloaded trace stays readable
+    frames_++;
+    put32(buffer_ + 8, frames_);
+    return true;
+}
+
+bool FrameTraceReader::open(const uint8_t* data, size_t size) {
+    data_ = data;
+    size_ = size;
+    frames_ = 0;
+    rewind();
+    if (!data_ || size_ < FrameTraceConfig::HEADER_SIZE || get32(data_) != FrameTraceConfig::MAGIC ||
+        get16(data_ + 4) > FrameTraceConfig::VERSION) {
+        return false;
+    }
+    frames_ = get32(data_ + 8);
+    return true;
+}
+
+void FrameTraceReader::rewind() {
+    offset_ = FrameTraceConfig::HEADER_SIZE;
+    read_ = 0;
+}
+
+bool FrameTraceReader::next(FrameTraceRecord& record) {
+    if (read_ >= frames_ || offset_ + FrameTraceConfig::RECORD_HEADER_SIZE > size_) {
+        return false;
+    }
+    const uint8_t* p = data_ + offset_;
+    uint32_t length = get32(p + 8);
+    if (length > size_ - offset_ - FrameTraceConfig::RECORD_HEADER_SIZE) {
+        offset_ = size_;
+        return false;
+    }
+
+    record.timestamp_us = get32(p);
+    record.capture_us = get32(p + 4);
+    record.length = length;
+    record.width = get16(p + 12);
+    record.height = get16(p + 14);
+    record.data = p + FrameTraceConfig::RECORD_HEADER_SIZE;
+    offset_ += FrameTraceConfig::RECORD_HEADER_SIZE + length;
+    read_++;
+    return true;
+}
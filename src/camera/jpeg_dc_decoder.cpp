@@ -0,0 +1,418 @@
+// src/camera/jpeg_dc_decoder.cpp - Декодирование только DC-коэффициентов baseline JPEG
+#include "jpeg_dc_decoder.h"
+#include <string.h>
+
+namespace {
+
+inline uint16_t readU16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+inline uint8_t clampLevel(int32_t value) {
+    return value < 0 ? 0 : (value > 255 ? 255 : (uint8_t)value);
+}
+
+} // namespace
+
+JpegDcDecoder::JpegDcDecoder()
+    : component_count_(0), max_h_(1), max_v_(1), restart_interval_(0),
+      image_width_(0), image_height_(0),
+      scan_start_(nullptr), data_end_(nullptr), error_("") {
+    memset(dc_tables_, 0, sizeof(dc_tables_));
+    memset(ac_tables_, 0, sizeof(ac_tables_));
+    memset(quant_dc_, 0, sizeof(quant_dc_));
+    memset(components_, 0, sizeof(components_));
+    memset(plane_width_, 0, sizeof(plane_width_));
+    memset(plane_height_, 0, sizeof(plane_height_));
+}
+
+// --- Bit reader ---
+
+void JpegDcDecoder::BitReader::fill() {
+    while (count <= 24) {
+        uint32_t byte = 0;
+        if (!marker && pos < end) {
+            byte = *pos;
+            if (byte == 0xFF) {
+                uint8_t next = (pos + 1 < end) ? pos[1] : 0xD9;
+                if (next == 0x00) {
+                    pos += 2;           // Stuffed zero byte
+                } else {
+                    marker = true;      // RSTn/EOI: feed zeros until the caller handles it
+                    byte = 0;
+                }
+            } else {
+                pos++;
+            }
+        }
+        bits |= byte << (24 - count);
+        count += 8;
+    }
+}
+
+int32_t JpegDcDecoder::BitReader::receiveExtend(int size) {
+    if (size == 0) {
+        return 0;
+    }
+    fill();
+    int32_t value = (int32_t)peek(size);
+    skip(size);
+    // Values with a leading 0 bit are negative
+    if (value < (1 << (size - 1))) {
+        value += -(1 << size) + 1;
+    }
+    return value;
+}
+
+bool JpegDcDecoder::BitReader::restart() {
+    bits = 0;
+    count = 0;
+    if (pos + 1 < end && pos[0] == 0xFF && pos[1] >= 0xD0 && pos[1] <= 0xD7) {
+        pos += 2;
+        marker = false;
+        return true;
+    }
+    return false;
+}
+
+// --- Huffman tables ---
+
+// False when the counts claim more codes of some length than that length
+// has (an over-subscribed table), which would index past the lookup table
+bool JpegDcDecoder::buildTable(HuffmanTable& table, const uint8_t* counts,
+                               const uint8_t* values, size_t value_count) {
+    memset(&table, 0, sizeof(table));
+    memcpy(table.values, values, value_count);
+
+    int32_t code = 0;
+    int32_t index = 0;
+    for (int length = 1; length <= 16; length++) {
+        uint8_t n = counts[length - 1];
+        if (code + n > (1 << length)) {
+            memset(&table, 0, sizeof(table));
+            return false;
+        }
+        table.value_offset[length] = index - code;
+        if (n == 0) {
+            table.max_code[length] = -1;
+        } else {
+            // Short codes are expanded into the direct lookup table
+            for (uint8_t i = 0; i < n; i++) {
+                if (length <= LOOKUP_BITS) {
+                    int shift = LOOKUP_BITS - length;
+                    for (int fill = 0; fill < (1 << shift); fill++) {
+                        int slot = ((code + i) << shift) | fill;
+                        table.lookup_length[slot] = (uint8_t)length;
+                        table.lookup_value[slot] = values[index + i];
+                    }
+                }
+            }
+            index += n;
+            code += n;
+            table.max_code[length] = code - 1;
+        }
+        code <<= 1;
+    }
+    table.max_code[17] = 0x7FFFFFFF;    // Sentinel
+    table.present = true;
+    return true;
+}
+
+int JpegDcDecoder::decodeSymbol(BitReader& reader, const HuffmanTable& table) {
+    reader.fill();
+    uint32_t look = reader.peek(LOOKUP_BITS);
+    uint8_t length = table.lookup_length[look];
+    if (length != 0) {
+        reader.skip(length);
+        return table.lookup_value[look];
+    }
+
+    for (int l = LOOKUP_BITS + 1; l <= 16; l++) {
+        int32_t code = (int32_t)reader.peek(l);
+        if (code <= table.max_code[l]) {
+            reader.skip(l);
+            return table.values[table.value_offset[l] + code];
+        }
+    }
+    return -1;
+}
+
+// --- Header parsing ---
+
+bool JpegDcDecoder::parseQuantTables(const uint8_t* p, size_t length) {
+    while (length > 0) {
+        uint8_t precision = p[0] >> 4;
+        uint8_t id = p[0] & 0x0F;
+        size_t table_size = precision ? 128 : 64;
+        if (id > 3 || length < 1 + table_size) {
+            return fail("bad DQT");
+        }
+        // Only the DC entry (first in zigzag order) is needed
+        quant_dc_[id] = precision ? readU16(p + 1) : p[1];
+        p += 1 + table_size;
+        length -= 1 + table_size;
+    }
+    return true;
+}
+
+bool JpegDcDecoder::parseHuffmanTables(const uint8_t* p, size_t length) {
+    while (length > 0) {
+        if (length < 17) {
+            return fail("bad DHT");
+        }
+        uint8_t table_class = p[0] >> 4;
+        uint8_t id = p[0] & 0x0F;
+        size_t value_count = 0;
+        for (int i = 0; i < 16; i++) {
+            value_count += p[1 + i];
+        }
+        if (table_class > 1 || id >= MAX_TABLES || value_count > 256 || length < 17 + value_count) {
+            return fail("bad DHT");
+        }
+        HuffmanTable& table = table_class == 0 ? dc_tables_[id] : ac_tables_[id];
+        if (!buildTable(table, p + 1, p + 17, value_count)) {
+            return fail("bad DHT");
+        }
+        p += 17 + value_count;
+        length -= 17 + value_count;
+    }
+    return true;
+}
+
+bool JpegDcDecoder::parseFrame(const uint8_t* p, size_t length) {
+    if (length < 6 || p[0] != 8) {
+        return fail("unsupported precision");
+    }
+    image_height_ = readU16(p + 1);
+    image_width_ = readU16(p + 3);
+    component_count_ = p[5];
+    if (image_width_ == 0 || image_height_ == 0 ||
+        (component_count_ != 1 && component_count_ != 3) || length < 6 + 3u * component_count_) {
+        return fail("bad SOF");
+    }
+
+    max_h_ = 1;
+    max_v_ = 1;
+    for (uint8_t i = 0; i < component_count_; i++) {
+        Component& c = components_[i];
+        c.id = p[6 + i * 3];
+        c.h = p[7 + i * 3] >> 4;
+        c.v = p[7 + i * 3] & 0x0F;
+        c.quant_table = p[8 + i * 3] & 0x03;
+        if (c.h < 1 || c.h > 2 || c.v < 1 || c.v > 2) {
+            return fail("unsupported sampling");
+        }
+        if (c.h > max_h_) max_h_ = c.h;
+        if (c.v > max_v_) max_v_ = c.v;
+    }
+    return true;
+}
+
+bool JpegDcDecoder::parseScan(const uint8_t* p, size_t length) {
+    if (length < 1 || p[0] != component_count_ || length < 1 + 2u * component_count_ + 3) {
+        return fail("non-interleaved scans are not supported");
+    }
+    for (uint8_t i = 0; i < component_count_; i++) {
+        uint8_t id = p[1 + i * 2];
+        uint8_t tables = p[2 + i * 2];
+        if (components_[i].id != id) {
+            return fail("scan component order differs from frame");
+        }
+        components_[i].dc_table = tables >> 4;
+        components_[i].ac_table = tables & 0x0F;
+        if (components_[i].dc_table >= MAX_TABLES || components_[i].ac_table >= MAX_TABLES ||
+            !dc_tables_[components_[i].dc_table].present || !ac_tables_[components_[i].ac_table].present) {
+            return fail("missing Huffman table");
+        }
+    }
+    return true;
+}
+
+bool JpegDcDecoder::parseHeaders(const uint8_t* data, size_t length) {
+    if (length < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+        return fail("missing SOI");
+    }
+
+    bool have_frame = false;
+    size_t offset = 2;
+    while (offset + 4 <= length) {
+        if (data[offset] != 0xFF) {
+            return fail("bad marker");
+        }
+        uint8_t marker = data[offset + 1];
+        if (marker == 0xFF) {           // Fill byte
+            offset++;
+            continue;
+        }
+        uint16_t segment = readU16(data + offset + 2);
+        if (segment < 2 || offset + 2 + segment > length) {
+            return fail("truncated segment");
+        }
+        const uint8_t* payload = data + offset + 4;
+        size_t payload_length = segment - 2;
+
+        bool ok = true;
+        switch (marker) {
+            case 0xDB: ok = parseQuantTables(payload, payload_length); break;
+            case 0xC4: ok = parseHuffmanTables(payload, payload_length); break;
+            case 0xC0:
+            case 0xC1: ok = parseFrame(payload, payload_length); have_frame = ok; break;
+            case 0xDD:
+                restart_interval_ = payload_length >= 2 ? readU16(payload) : 0;
+                break;
+            case 0xDA:
+                if (!have_frame) return fail("SOS before SOF");
+                if (!parseScan(payload, payload_length)) return false;
+                scan_start_ = payload + payload_length;
+                data_end_ = data + length;
+                return true;
+            default:
+                if ((marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)) {
+                    return fail("progressive/lossless JPEG not supported");
+                }
+                break;      // APPn, COM etc.
+        }
+        if (!ok) return false;
+        offset += 2 + segment;
+    }
+    return fail("missing SOS");
+}
+
+// --- Scan decoding ---
+
+bool JpegDcDecoder::decodeLuma(const uint8_t* data, size_t length, uint8_t* luma, size_t capacity) {
+    uint8_t* planes[MAX_COMPONENTS] = {luma, nullptr, nullptr};
+    return decodePlanes(data, length, planes, capacity);
+}
+
+bool JpegDcDecoder::decodePlanes(const uint8_t* data, size_t length, uint8_t* const planes[], size_t capacity) {
+    restart_interval_ = 0;
+    dc_tables_[0].present = dc_tables_[1].present = false;
+    ac_tables_[0].present = ac_tables_[1].present = false;
+    if (!parseHeaders(data, length)) {
+        return false;
+    }
+
+    // Chroma planes are smaller than luma when subsampled (80x45 for 720p 4:2:0)
+    uint16_t plane_width[MAX_COMPONENTS] = {0, 0, 0};
+    uint16_t plane_height[MAX_COMPONENTS] = {0, 0, 0};
+    for (uint8_t ci = 0; ci < component_count_; ci++) {
+        const Component& c = components_[ci];
+        plane_width[ci] = (uint16_t)((image_width_ * c.h / max_h_ + 7) / 8);
+        plane_height[ci] = (uint16_t)((image_height_ * c.v / max_v_ + 7) / 8);
+        if (planes[ci] && (size_t)plane_width[ci] * plane_height[ci] > capacity) {
+            return fail("plane buffer too small");
+        }
+    }
+    // A single-component scan is not interleaved: one block per MCU
+    bool interleaved = component_count_ > 1;
+    uint8_t mcu_w = interleaved ? max_h_ * 8 : 8;
+    uint8_t mcu_h = interleaved ? max_v_ * 8 : 8;
+    uint16_t mcus_x = (uint16_t)((image_width_ + mcu_w - 1) / mcu_w);
+    uint16_t mcus_y = (uint16_t)((image_height_ + mcu_h - 1) / mcu_h);
+
+    BitReader reader;
+    reader.pos = scan_start_;
+    reader.end = data_end_;
+    reader.bits = 0;
+    reader.count = 0;
+    reader.marker = false;
+
+    for (uint8_t i = 0; i < component_count_; i++) {
+        components_[i].predictor = 0;
+    }
+
+    uint32_t mcus_left = restart_interval_;
+    for (uint16_t my = 0; my < mcus_y; my++) {
+        for (uint16_t mx = 0; mx < mcus_x; mx++) {
+            if (restart_interval_ != 0) {
+                if (mcus_left == 0) {
+                    if (!reader.restart()) return fail("missing restart marker");
+                    for (uint8_t i = 0; i < component_count_; i++) components_[i].predictor = 0;
+                    mcus_left = restart_interval_;
+                }
+                mcus_left--;
+            }
+
+            for (uint8_t ci = 0; ci < component_count_; ci++) {
+                Component& c = components_[ci];
+                const HuffmanTable& dc = dc_tables_[c.dc_table];
+                const HuffmanTable& ac = ac_tables_[c.ac_table];
+                uint8_t blocks_v = interleaved ? c.v : 1;
+                uint8_t blocks_h = interleaved ? c.h : 1;
+
+                for (uint8_t bv = 0; bv < blocks_v; bv++) {
+                    for (uint8_t bh = 0; bh < blocks_h; bh++) {
+                        int size = decodeSymbol(reader, dc);
+                        if (size < 0 || size > 11) return fail("corrupt DC code");
+                        c.predictor += reader.receiveExtend(size);
+
+                        // AC coefficients are decoded only to find the next block
+                        for (int k = 1; k < 64;) {
+                            int rs = decodeSymbol(reader, ac);
+                            if (rs < 0) return fail("corrupt AC code");
+                            int run = rs >> 4;
+                            int bits = rs & 0x0F;
+                            if (bits == 0) {
+                                if (run != 15) break;   // End of block
+                                k += 16;
+                                continue;
+                            }
+                            k += run + 1;
+                            reader.fill();
+                            reader.skip(bits);
+                        }
+
+                        if (planes[ci]) {
+                            uint16_t bx = (uint16_t)(mx * blocks_h + bh);
+                            uint16_t by = (uint16_t)(my * blocks_v + bv);
+                            if (bx < plane_width[ci] && by < plane_height[ci]) {
+                                // DC = 8 x block mean (level-shifted by 128)
+                                planes[ci][by * plane_width[ci] + bx] =
+                                    clampLevel(c.predictor * quant_dc_[c.quant_table] / 8 + 128);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    for (uint8_t ci = 0; ci < MAX_COMPONENTS; ci++) {
+        plane_width_[ci] = plane_width[ci];
+        plane_height_[ci] = plane_height[ci];
+    }
+    return true;
+}
+
+void JpegDcDecoder::toRgb888(const uint8_t* const planes[], uint8_t* rgb, bool bgr) const {
+    uint16_t width = plane_width_[0];
+    uint16_t height = plane_height_[0];
+    bool color = component_count_ == 3 && planes[1] && planes[2];
+    uint8_t r_index = bgr ? 2 : 0;
+    uint8_t b_index = bgr ? 0 : 2;
+
+    for (uint16_t y = 0; y < height; y++) {
+        const uint8_t* luma = planes[0] + (size_t)y * width;
+        const uint8_t* cb = nullptr;
+        const uint8_t* cr = nullptr;
+        if (color) {
+            // Chroma row/column = luma position scaled by relative sampling factors
+            cb = planes[1] + (size_t)(y * components_[1].v / components_[0].v) * plane_width_[1];
+            cr = planes[2] + (size_t)(y * components_[2].v / components_[0].v) * plane_width_[2];
+        }
+        for (uint16_t x = 0; x < width; x++, rgb += 3) {
+            int32_t l = luma[x];
+            if (!color) {
+                rgb[0] = rgb[1] = rgb[2] = (uint8_t)l;
+                continue;
+            }
+            // JFIF YCbCr -> RGB, 16.16 fixed point
+            int32_t u = cb[x * components_[1].h / components_[0].h] - 128;
+            int32_t v = cr[x * components_[2].h / components_[0].h] - 128;
+            rgb[r_index] = clampLevel(l + ((91881 * v + 32768) >> 16));
+            rgb[1] = clampLevel(l - ((22554 * u + 46802 * v + 32768) >> 16));
+            rgb[b_index] = clampLevel(l + ((116130 * u + 32768) >> 16));
+        }
+    }
+}
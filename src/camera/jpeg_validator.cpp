@@ -0,0 +1,118 @@
+// src/camera/jpeg_validator.cpp - Быстрая структурная проверка JPEG кадров
+#include "jpeg_validator.h"
+#include <string.h>
+
+namespace {
+
+const uint8_t MARKER_SOI = 0xD8;
+const uint8_t MARKER_EOI = 0xD9;
+const uint8_t MARKER_SOS = 0xDA;
+const uint8_t MARKER_TEM = 0x01;
+
+bool isRestartMarker(uint8_t marker) {
+    return marker >= 0xD0 && marker <= 0xD7;
+}
+
+// Forward walk through entropy-coded data; stops at the first real marker.
+// Scans a word at a time and only looks closer at words holding a 0xFF byte.
+size_t findScanEnd(const uint8_t* data, size_t pos, size_t length) {
+    while (pos < length && ((uintptr_t)(data + pos) & 3) != 0) {
+        if (data[pos] == 0xFF) return pos;
+        pos++;
+    }
+    while (pos + 4 <= length) {
+        uint32_t word;
+        memcpy(&word, data + pos, 4);
+        uint32_t inverted = ~word;
+        if (((inverted - 0x01010101) & ~inverted & 0x80808080) != 0) {
+            break;
+        }
+        pos += 4;
+    }
+    while (pos < length && data[pos] != 0xFF) {
+        pos++;
+    }
+    return pos;
+}
+
+// Stuffed 0xFF00 and RSTn are data, EOI ends the frame; any other marker is
+// not part of a scan. The first EOI wins: trailing bytes of an earlier,
+// longer frame may hold another one further on.
+JpegCheck walkScan(const uint8_t* data, size_t pos, size_t length, size_t& frame_end) {
+    while (true) {
+        pos = findScanEnd(data, pos, length);
+        if (pos + 1 >= length) return JpegCheck::NO_EOI;
+        uint8_t next = data[pos + 1];
+        if (next == 0x00 || isRestartMarker(next) || next == 0xFF) {
+            pos += next == 0xFF ? 1 : 2;
+            continue;
+        }
+        if (next == MARKER_EOI) {
+            frame_end = pos + 2;
+            return JpegCheck::OK;
+        }
+        return JpegCheck::BAD_SCAN;
+    }
+}
+
+} // namespace
+
+const char* jpegCheckName(JpegCheck check) {
+    switch (check) {
+        case JpegCheck::OK:         return "OK";
+        case JpegCheck::TOO_SHORT:  return "TOO_SHORT";
+        case JpegCheck::NO_SOI:     return "NO_SOI";
+        case JpegCheck::BAD_MARKER: return "BAD_MARKER";
+        case JpegCheck::BAD_LENGTH: return "BAD_LENGTH";
+        case JpegCheck::NO_SOS:     return "NO_SOS";
+        case JpegCheck::NO_EOI:     return "NO_EOI";
+        case JpegCheck::BAD_SCAN:   return "BAD_SCAN";
+    }
+    return "UNKNOWN";
+}
+
+JpegCheck validateJpegFrame(const uint8_t* data, size_t length, JpegValidation mode, size_t& frame_end) {
+    frame_end = length;
+    if (mode == JpegValidation::OFF) {
+        return JpegCheck::OK;
+    }
+    if (!data || length < 4) {
+        return JpegCheck::TOO_SHORT;
+    }
+    if (data[0] != 0xFF || data[1] != MARKER_SOI) {
+        return JpegCheck::NO_SOI;
+    }
+
+    size_t pos = 2;
+    uint8_t segments = 0;
+    while (true) {
+        if (pos + 2 > length) return JpegCheck::BAD_LENGTH;
+        if (data[pos] != 0xFF) return JpegCheck::BAD_MARKER;
+        while (pos + 1 < length && data[pos + 1] == 0xFF) pos++;     // Fill bytes
+        if (pos + 2 > length) return JpegCheck::BAD_LENGTH;
+
+        uint8_t marker = data[pos + 1];
+        if (marker == 0x00 || marker == MARKER_SOI) return JpegCheck::BAD_MARKER;
+        if (marker == MARKER_EOI) return JpegCheck::NO_SOS;
+        if (marker == MARKER_TEM || isRestartMarker(marker)) {
+            pos += 2;
+            continue;
+        }
+
+        if (pos + 4 > length) return JpegCheck::BAD_LENGTH;
+        size_t segment_length = ((size_t)data[pos + 2] << 8) | data[pos + 3];
+        if (segment_length < 2 || pos + 2 + segment_length > length) return JpegCheck::BAD_LENGTH;
+        pos += 2 + segment_length;
+
+        if (marker == MARKER_SOS) break;
+        if (++segments > JpegValidatorConfig::MAX_SEGMENTS) return JpegCheck::NO_SOS;
+    }
+
+    // Fast: only the tail of a long scan. A start just after 0xFF steps back
+    // one byte so the marker pair is read whole.
+    if (mode == JpegValidation::FAST && length > pos + JpegValidatorConfig::MAX_TRAILING_SCAN) {
+        pos = length - JpegValidatorConfig::MAX_TRAILING_SCAN;
+        if (data[pos - 1] == 0xFF) pos--;
+    }
+    return walkScan(data, pos, length, frame_end);
+}
@@ -0,0 +1,123 @@
+// src/camera/motion_detector.cpp - Детектор движения/смены сцены по плоскости яркости 1/8
+#include "motion_detector.h"
+#include <stdlib.h>
+#include <string.h>
+
+MotionDetector::MotionDetector()
+    : reference_(nullptr), width_(0), height_(0), has_reference_(false) {
+    memset(cell_sums_, 0, sizeof(cell_sums_));
+}
+
+MotionDetector::~MotionDetector() {
+    free(reference_);
+}
+
+void MotionDetector::setReference(const uint8_t* luma, uint16_t width, uint16_t height) {
+    size_t bytes = (size_t)width * height;
+    if (bytes == 0 || width > MotionConfig::MAX_PLANE_WIDTH || height > MotionConfig::MAX_PLANE_HEIGHT) {
+        has_reference_ = false;
+        return;
+    }
+    if (!reference_) {
+        // Allocated once at the largest plane size so frame size changes never reallocate
+        reference_ = (uint8_t*)malloc(MotionConfig::MAX_PLANE_BYTES);
+        if (!reference_) {
+            has_reference_ = false;
+            return;
+        }
+    }
+    memcpy(reference_, luma, bytes);
+    width_ = width;
+    height_ = height;
+    has_reference_ = true;
+}
+
+// Sum of |a/2 - b/2| over one row, four pixels per word; each cell spans 2 words
+uint32_t MotionDetector::rowDiffSwar(const uint32_t* a, const uint32_t* b, uint16_t words, uint32_t* cells) {
+    const uint32_t low7 = 0x7F7F7F7F;
+    const uint32_t high = 0x80808080;
+    uint32_t row_total = 0;
+
+    for (uint16_t w = 0; w < words; w++) {
+        uint32_t x = (a[w] >> 1) & low7;
+        uint32_t y = (b[w] >> 1) & low7;
+
+        // Per byte: 128 + x - y in [1, 255], no borrow between lanes
+        uint32_t d = (x | high) - y;
+        uint32_t negative = ((~d & high) >> 7) * 0xFF;
+        uint32_t magnitude = d & low7;
+        uint32_t abs_diff = (magnitude & ~negative) | ((high - magnitude) & negative);
+
+        // Horizontal add through two 16-bit lanes
+        uint32_t pairs = (abs_diff & 0x00FF00FF) + ((abs_diff >> 8) & 0x00FF00FF);
+        uint32_t sum = (pairs & 0xFFFF) + (pairs >> 16);
+
+        cells[w / (MotionConfig::CELL_SIZE / 4)] += sum;
+        row_total += sum;
+    }
+    return row_total;
+}
+
+uint32_t MotionDetector::rowDiffScalar(const uint8_t* a, const uint8_t* b, uint16_t width, uint32_t* cells) {
+    uint32_t row_total = 0;
+    for (uint16_t x = 0; x < width; x++) {
+        int diff = (a[x] >> 1) - (b[x] >> 1);
+        uint32_t abs_diff = (uint32_t)(diff < 0 ? -diff : diff);
+        cells[x / MotionConfig::CELL_SIZE] += abs_diff;
+        row_total += abs_diff;
+    }
+    return row_total;
+}
+
+bool MotionDetector::analyze(const uint8_t* luma, uint16_t width, uint16_t height, MotionResult& result) {
+    result = MotionResult();
+
+    uint16_t cells_x = (uint16_t)((width + MotionConfig::CELL_SIZE - 1) / MotionConfig::CELL_SIZE);
+    uint16_t cells_y = (uint16_t)((height + MotionConfig::CELL_SIZE - 1) / MotionConfig::CELL_SIZE);
+    result.total_cells = (uint16_t)(cells_x * cells_y);
+
+    // No comparable reference: treat as a scene change so the caller re-anchors
+    if (!has_reference_ || width != width_ || height != height_) {
+        result.scene_change = true;
+        result.motion = true;
+        result.changed_cells = result.total_cells;
+        return false;
+    }
+
+    memset(cell_sums_, 0, sizeof(uint32_t) * result.total_cells);
+
+    bool aligned = (width % 4) == 0 &&
+                   ((uintptr_t)luma & 3) == 0 && ((uintptr_t)reference_ & 3) == 0;
+    uint64_t total = 0;
+
+    for (uint16_t y = 0; y < height; y++) {
+        const uint8_t* row = luma + (size_t)y * width;
+        const uint8_t* ref = reference_ + (size_t)y * width;
+        uint32_t* cells = cell_sums_ + (y / MotionConfig::CELL_SIZE) * cells_x;
+        if (aligned) {
+            total += rowDiffSwar((const uint32_t*)row, (const uint32_t*)ref, width / 4, cells);
+        } else {
+            total += rowDiffScalar(row, ref, width, cells);
+        }
+    }
+
+    // Sums are on 7-bit luma; report in 8-bit levels
+    result.mean_abs_diff = total * 2.0f / ((uint32_t)width * height);
+
+    for (uint16_t cy = 0; cy < cells_y; cy++) {
+        uint16_t cell_h = (uint16_t)(cy == cells_y - 1 ? height - cy * MotionConfig::CELL_SIZE : MotionConfig::CELL_SIZE);
+        for (uint16_t cx = 0; cx < cells_x; cx++) {
+            uint16_t cell_w = (uint16_t)(cx == cells_x - 1 ? width - cx * MotionConfig::CELL_SIZE : MotionConfig::CELL_SIZE);
+            uint32_t sum = cell_sums_[cy * cells_x + cx] * 2;
+            if (sum > (uint32_t)thresholds_.cell_diff * cell_w * cell_h) {
+                result.changed_cells++;
+            }
+        }
+    }
+
+    result.scene_change = result.mean_abs_diff >= thresholds_.scene_diff ||
+        (uint32_t)result.changed_cells * 100 >= (uint32_t)thresholds_.scene_cell_percent * result.total_cells;
+    result.motion = result.scene_change || result.changed_cells >= thresholds_.min_changed_cells;
+    result.is_static = result.changed_cells == 0 && result.mean_abs_diff < thresholds_.static_diff;
+    return true;
+}
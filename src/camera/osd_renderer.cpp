@@ -0,0 +1,134 @@
+// src/camera/osd_renderer.cpp - Шрифт 5x7 и раскладка OSD
+#include "osd_renderer.h"
+#include <stdio.h>
+
+namespace {
+
+const char FIRST_GLYPH = ' ';
+const char LAST_GLYPH = '_';
+
+// Classic 5x7 font, ASCII 0x20-0x5F; one byte per column, bit 0 = top row
+const uint8_t FONT[][OsdConfig::GLYPH_WIDTH] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00},  //   ! "
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},  // # $ %
+    {0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00},  // & ' (
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x08, 0x2A, 0x1C, 0x2A, 0x08}, {0x08, 0x08, 0x3E, 0x08, 0x08},  // ) * +
+    {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x60, 0x60, 0x00, 0x00},  // , - .
+    {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00},  // / 0 1
+    {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4B, 0x31}, {0x18, 0x14, 0x12, 0x7F, 0x10},  // 2 3 4
+    {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03},  // 5 6 7
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x36, 0x36, 0x00, 0x00},  // 8 9 :
+    {0x00, 0x56, 0x36, 0x00, 0x00}, {0x00, 0x08, 0x14, 0x22, 0x41}, {0x14, 0x14, 0x14, 0x14, 0x14},  // ; < =
+    {0x41, 0x22, 0x14, 0x08, 0x00}, {0x02, 0x01, 0x51, 0x09, 0x06}, {0x32, 0x49, 0x79, 0x41, 0x3E},  // > ? @
+    {0x7E, 0x11, 0x11, 0x11, 0x7E}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},  // A B C
+    {0x7F, 0x41, 0x41, 0x22, 0x1C}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x01, 0x01},  // D E F
+    {0x3E, 0x41, 0x41, 0x51, 0x32}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00},  // G H I
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40},  // J K L
+    {0x7F, 0x02, 0x04, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},  // M N O
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46},  // P Q R
+    {0x46, 0x49, 0x49, 0x49, 0x31}, {0x01, 0x01, 0x7F, 0x01, 0x01}, {0x3F, 0x40, 0x40, 0x40, 0x3F},  // S T U
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x7F, 0x20, 0x18, 0x20, 0x7F}, {0x63, 0x14, 0x08, 0x14, 0x63},  // V W X
+    {0x03, 0x04, 0x78, 0x04, 0x03}, {0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x00, 0x7F, 0x41, 0x41},  // Y Z [
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x41, 0x41, 0x7F, 0x00, 0x00}, {0x04, 0x02, 0x01, 0x02, 0x04},  // \ ] ^
+    {0x40, 0x40, 0x40, 0x40, 0x40},                                                                  // _
+};
+
+const uint8_t* glyphFor(char c) {
+    if (c >= 'a' && c <= 'z') {
+        c = (char)(c - 'a' + 'A');
+    }
+    if (c < FIRST_GLYPH || c > LAST_GLYPH) {
+        c = '?';
+    }
+    return FONT[c - FIRST_GLYPH];
+}
+
+// Halves the brightness of a clipped rectangle
+void darken(uint8_t* bgr, uint16_t width, uint16_t height, int x0, int y0, int w, int h) {
+    int x1 = x0 + w;
+    int y1 = y0 + h;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > width) x1 = width;
+    if (y1 > height) y1 = height;
+    for (int y = y0; y < y1; y++) {
+        uint8_t* p = bgr + ((size_t)y * width + x0) * 3;
+        for (int n = (x1 - x0) * 3; n > 0; n--, p++) {
+            *p >>= 1;
+        }
+    }
+}
+
+} // namespace
+
+int OsdRenderer::textWidth(const char* text, uint8_t scale) {
+    int count = 0;
+    while (text[count] != '\0') {
+        count++;
+    }
+    return count > 0 ? (count * OsdConfig::GLYPH_ADVANCE - 1) * scale : 0;
+}
+
+void OsdRenderer::drawText(uint8_t* bgr, uint16_t width, uint16_t height, int x, int y,
+                           const char* text, uint8_t scale, uint8_t r, uint8_t g, uint8_t b) {
+    int text_width = textWidth(text, scale);
+    if (text_width == 0) {
+        return;
+    }
+    darken(bgr, width, height, x - scale, y - scale, text_width + 2 * scale,
+           (OsdConfig::GLYPH_HEIGHT + 2) * scale);
+
+    for (const char* c = text; *c != '\0'; c++, x += OsdConfig::GLYPH_ADVANCE * scale) {
+        const uint8_t* glyph = glyphFor(*c);
+        for (int col = 0; col < OsdConfig::GLYPH_WIDTH; col++) {
+            uint8_t bits = glyph[col];
+            for (int row = 0; bits != 0; row++, bits >>= 1) {
+                if (!(bits & 1)) {
+                    continue;
+                }
+                for (int dy = 0; dy < scale; dy++) {
+                    int py = y + row * scale + dy;
+                    if (py < 0 || py >= height) continue;
+                    for (int dx = 0; dx < scale; dx++) {
+                        int px = x + col * scale + dx;
+                        if (px < 0 || px >= width) continue;
+                        uint8_t* p = bgr + ((size_t)py * width + px) * 3;
+                        p[0] = b;
+                        p[1] = g;
+                        p[2] = r;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void OsdRenderer::render(uint8_t* bgr, uint16_t width, uint16_t height, const OsdTelemetry& t) const {
+    uint8_t scale = scale_ ? scale_ : (uint8_t)(height / 240 > 0 ? height / 240 : 1);
+    int margin = OsdConfig::MARGIN * scale;
+    int line = OsdConfig::GLYPH_HEIGHT * scale;
+    int top = margin;
+    int bottom = height - margin - line;
+    char text[OsdConfig::MAX_TEXT];
+
+    // Top: pipeline state
+    snprintf(text, sizeof(text), "FPS %.1f  V%u", t.fps, (unsigned)t.viewers);
+    drawText(bgr, width, height, margin, top, text, scale, 255, 255, 255);
+    snprintf(text, sizeof(text), "T+%02lu:%02lu", (unsigned long)(t.uptime_s / 60), (unsigned long)(t.uptime_s % 60));
+    drawText(bgr, width, height, width - margin - textWidth(text, scale), top, text, scale, 255, 255, 255);
+
+    // Bottom: flight controller telemetry
+    if (!t.fc_link) {
+        drawText(bgr, width, height, margin, bottom, "FC --", scale, 255, 64, 64);
+        return;
+    }
+    snprintf(text, sizeof(text), "ALT %.1f  HDG %03u", t.altitude_m, (unsigned)t.heading_deg);
+    drawText(bgr, width, height, margin, bottom, text, scale, 255, 255, 255);
+    if (t.rssi_dbm != 0) {
+        snprintf(text, sizeof(text), "RSSI %d", (int)t.rssi_dbm);
+        drawText(bgr, width, height, margin, bottom - line - 3 * scale, text, scale, 255, 255, 255);
+    }
+    snprintf(text, sizeof(text), "%.1fV %s", t.battery_v, t.armed ? "ARMED" : "DISARMED");
+    drawText(bgr, width, height, width - margin - textWidth(text, scale), bottom, text, scale,
+             t.armed ? 255 : 64, t.armed ? 64 : 255, 64);
+}
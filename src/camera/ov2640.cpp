@@ -1,14 +1,35 @@
 // src/camera/ov2640.cpp
 #include "ov2640.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
 #include <algorithm>
 
 static const char* TAG = "OV2640";
 
+// Holds the driver mutex for one scope; check locked() before touching the driver
+class DriverLock {
+public:
+    DriverLock(SemaphoreHandle_t mutex, uint32_t timeout_ms)
+        : mutex_(mutex), locked_(mutex && xSemaphoreTake(mutex, pdMS_TO_TICKS(timeout_ms)) == pdTRUE) {}
+    ~DriverLock() {
+        if (locked_) xSemaphoreGive(mutex_);
+    }
+    bool locked() const { return locked_; }
+
+private:
+    SemaphoreHandle_t mutex_;
+    bool locked_;
+};
+
 OV2640Camera::OV2640Camera() {
     stats_mutex_ = xSemaphoreCreateMutex();
     if (stats_mutex_ == nullptr) {
         ESP_LOGE(TAG, "Failed to create statistics mutex");
     }
+    driver_mutex_ = xSemaphoreCreateMutex();
+    if (driver_mutex_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to create driver mutex");
+    }
     initializeConfig();
     stats_.reset();
 }
@@ -18,6 +39,9 @@ OV2640Camera::~OV2640Camera() {
     if (stats_mutex_ != nullptr) {
         vSemaphoreDelete(stats_mutex_);
     }
+    if (driver_mutex_ != nullptr) {
+        vSemaphoreDelete(driver_mutex_);
+    }
 }
 
 void OV2640Camera::initializeConfig() {
@@ -74,11 +98,24 @@ bool OV2640Camera::initialize() {
         return false;
     }
 
-    // Initialize the camera
+    if (!startDriver()) {
+        return false;
+    }
+    
+    stats_.reset();
+    
+    ESP_LOGI(TAG, "Camera initialized successfully for stable 20fps operation!");
+    printCameraInfo();
+    
+    return true;
+}
+
+// Driver + sensor bring-up shared by initialize() and recover()
+bool OV2640Camera::startDriver() {
     esp_err_t err = esp_camera_init(&config_);
     if (err != ESP_OK) {
         last_error_ = CameraError::INIT_FAILED;
-        last_error_message_ = "esp_camera_init failed with error: " + std::to_string(err);
+        last_error_message_.format("esp_camera_init failed with error: 0x%x", err);
         ESP_LOGE(TAG, "Camera init failed with error 0x%x", err);
         return false;
     }
@@ -89,15 +126,226 @@ bool OV2640Camera::initialize() {
     }
     
     initialized_.store(true);
-    stats_.reset();
+    failure_streak_ = 0;
     last_frame_time_ = millis();
+    last_good_frame_ms_ = last_frame_time_;
+    last_request_ms_ = last_frame_time_;
+    armFrameSignal();
+    return true;
+}
+
+// Re-armed after every driver start: esp_camera_init reconfigures the pin
+void OV2640Camera::armFrameSignal() {
+#if CONFIG_IDF_TARGET_ESP32
+    // The ESP32 (non-S3) driver takes the VSYNC GPIO interrupt for itself
+    frame_signal_.armed = false;
+#else
+    // The S3 driver gets VSYNC through LCD_CAM; the GPIO interrupt is free.
+    // A sync pulse opens the next frame, so the one just read out is complete.
+    attachInterruptArg((uint8_t)CameraPins::VSYNC, frameSignalIsr, &frame_signal_,
+                       SensorProfileConfig::VSYNC_ACTIVE_LEVEL ? RISING : FALLING);
+    frame_signal_.armed = true;
+#endif
+}
+
+void IRAM_ATTR OV2640Camera::frameSignalIsr(void* arg) {
+    FrameSignal* signal = static_cast<FrameSignal*>(arg);
+    signal->last_us = (uint32_t)esp_timer_get_time();
+    signal->count = signal->count + 1;
+    if (signal->notify_task) {
+        BaseType_t woken = pdFALSE;
+        xTaskNotifyFromISR(signal->notify_task, signal->notify_bits, eSetBits, &woken);
+        if (woken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
+bool OV2640Camera::recover(const char* reason) {
+    int64_t start = esp_timer_get_time();
+    
+    // No new fb_get starts while the lock is held; frames already out go back
+    // on their own task (the raw pipeline's copy takes a few ms)
+    DriverLock lock(driver_mutex_, CameraWatchdogConfig::DRAIN_TIMEOUT_MS);
+    unsigned long drain_start = millis();
+    while (lock.locked() && frames_out_.load() > 0 &&
+           millis() - drain_start < CameraWatchdogConfig::DRAIN_TIMEOUT_MS) {
+        vTaskDelay(1);
+    }
+    if (!lock.locked() || frames_out_.load() > 0) {
+        Serial.printf("❌ [CAMERA] Recovery (%s) postponed: driver busy, %u frame(s) held\n",
+                      reason, (unsigned)frames_out_.load());
+        // Retried from the next serviceWatchdog()
+        recovery_request_.store(reason);
+        return false;
+    }
     
-    ESP_LOGI(TAG, "Camera initialized successfully for stable 20fps operation!");
-    printCameraInfo();
+    // The shadow holds every setting as last written
+    SensorValue snapshot[SENSOR_SETTING_COUNT];
+    size_t snapshot_count = shadow_.isValid() ? shadow_.snapshot(snapshot, SENSOR_SETTING_COUNT) : 0;
+    RegionOfInterest roi = roi_;
+    bool was_streaming = streaming_.load();
+    
+    deinitialize();
+    bool ok = startDriver();
+    if (ok) {
+        // Only the settings that differ from the boot profile are rewritten
+        if (snapshot_count > 0) {
+            SensorProfile restore = {"restore", "Settings before recovery", snapshot, (uint8_t)snapshot_count};
+            applyProfile(restore, false);
+        }
+        if (roi.active && setRegionOfInterest(roi.x, roi.y, roi.width, roi.height,
+                                              roi.output_width, roi.output_height)) {
+            roi_.zoom = roi.zoom;
+        }
+        streaming_.store(was_streaming);
+    }
+    
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start) / 1000);
+    last_recovery_ms_ = millis();
+    recovery_.last_at_ms = last_recovery_ms_;
+    recovery_.last_reason = reason;
+    recovery_.last_ms = elapsed_ms;
+    if (elapsed_ms > recovery_.max_ms) recovery_.max_ms = elapsed_ms;
+    if (ok) {
+        recovery_.recoveries++;
+    } else {
+        recovery_.failed++;
+    }
+    
+    Serial.printf("%s [CAMERA] Recovery (%s) %s in %lu ms%s\n", ok ? "♻️ " : "❌",
+                  reason, ok ? "done" : "FAILED", elapsed_ms,
+                  elapsed_ms > CameraWatchdogConfig::RECOVERY_TARGET_MS ? " (over target)" : "");
+    return ok;
+}
+
+bool OV2640Camera::applyProfile(const SensorProfile& profile, bool wait_vblank) {
+    sensor_t* s = esp_camera_sensor_get();
+    if (!s) {
+        last_error_ = CameraError::SENSOR_NOT_FOUND;
+        last_error_message_ = "Failed to get camera sensor";
+        return false;
+    }
+    
+    SensorDiff diff;
+    shadow_.compile(profile, diff);
+    profile_stats_.last_profile = profile.name;
+    profile_stats_.last_writes = diff.count;
+    profile_stats_.skipped_writes += profile.count - diff.count;
+    profile_stats_.last_wait_us = 0;
+    profile_stats_.last_apply_us = 0;
+    if (diff.count == 0) {
+        return true;
+    }
+    
+    // Only worth waiting for while frames are being read out
+    if (wait_vblank && initialized_.load()) {
+        uint32_t waited_us = 0;
+        if (!waitForVerticalBlank(waited_us)) {
+            profile_stats_.vblank_timeouts++;
+        }
+        profile_stats_.last_wait_us = waited_us;
+    }
+    
+    int64_t start = esp_timer_get_time();
+    uint8_t failed = 0;
+    for (uint8_t i = 0; i < diff.count; i++) {
+        const SensorValue& v = diff.values[i];
+        if (writeSensorSetting(s, v.setting, v.value) == 0) {
+            shadow_.note(v.setting, v.value);
+        } else {
+            failed++;
+            ESP_LOGW(TAG, "Sensor write failed: %s=%d", sensorSettingName(v.setting), v.value);
+        }
+    }
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start);
     
+    profile_stats_.switches++;
+    profile_stats_.writes += diff.count;
+    profile_stats_.failed_writes += failed;
+    profile_stats_.last_apply_us = elapsed_us;
+    if (elapsed_us > profile_stats_.max_apply_us) profile_stats_.max_apply_us = elapsed_us;
+    
+    ESP_LOGI(TAG, "Profile %s: %u write(s), %u unchanged, applied in %lu us",
+             profile.name, (unsigned)diff.count, (unsigned)(profile.count - diff.count), elapsed_us);
+    if (failed > 0) {
+        last_error_ = CameraError::HARDWARE_ERROR;
+        last_error_message_ = "Sensor register write failed";
+        return false;
+    }
     return true;
 }
 
+void OV2640Camera::resyncSensorShadow() {
+    sensor_t* s = esp_camera_sensor_get();
+    if (s) {
+        shadow_.load(s->status);
+    } else {
+        shadow_.invalidate();
+    }
+}
+
+// VSYNC pulses at the start of every frame and the sensor is in vertical
+// blanking right after the leading edge. A pulse already in progress is
+// skipped so the batch gets the whole blanking interval.
+bool OV2640Camera::waitForVerticalBlank(uint32_t& waited_us) const {
+    const gpio_num_t pin = (gpio_num_t)CameraPins::VSYNC;
+    const int active = SensorProfileConfig::VSYNC_ACTIVE_LEVEL;
+    int64_t start = esp_timer_get_time();
+    int64_t deadline = start + SensorProfileConfig::VBLANK_TIMEOUT_US;
+    
+    while (gpio_get_level(pin) == active) {
+        if (esp_timer_get_time() > deadline) {
+            waited_us = SensorProfileConfig::VBLANK_TIMEOUT_US;
+            return false;
+        }
+    }
+    while (gpio_get_level(pin) != active) {
+        if (esp_timer_get_time() > deadline) {
+            waited_us = SensorProfileConfig::VBLANK_TIMEOUT_US;
+            return false;
+        }
+    }
+    waited_us = (uint32_t)(esp_timer_get_time() - start);
+    return true;
+}
+
+// requested_ms: when this capture was asked for, so a get that blocked until
+// the driver timeout still counts its wait
+void OV2640Camera::noteCaptureResult(bool success, unsigned long requested_ms) {
+    unsigned long now = millis();
+    // Time nobody asked for frames is not a stall: after an idle gap the
+    // window starts again at this request
+    if (requested_ms - last_request_ms_ >= CameraWatchdogConfig::STALL_MS) {
+        last_good_frame_ms_ = requested_ms;
+    }
+    last_request_ms_ = now;
+    if (success) {
+        failure_streak_ = 0;
+        last_good_frame_ms_ = now;
+        return;
+    }
+    
+    if (failure_streak_ < UINT8_MAX) failure_streak_++;
+    if (!watchdog_enabled_ || now - last_recovery_ms_ < CameraWatchdogConfig::RECOVERY_BACKOFF_MS) {
+        return;
+    }
+    // A single fb_get that blocked until the driver timeout also counts as a stall.
+    // This may run on the raw pipeline's capture task: only flag it here
+    if (failure_streak_ >= CameraWatchdogConfig::FAILURE_STREAK) {
+        recovery_request_.store("failure streak");
+    } else if (now - last_good_frame_ms_ >= CameraWatchdogConfig::STALL_MS) {
+        recovery_request_.store("capture stall");
+    }
+}
+
+void OV2640Camera::serviceWatchdog() {
+    const char* reason = recovery_request_.exchange(nullptr);
+    if (reason && watchdog_enabled_) {
+        recover(reason);
+    }
+}
+
 bool OV2640Camera::configureSensor() {
     sensor_t * s = esp_camera_sensor_get();
     if (s == nullptr) {
@@ -106,40 +354,35 @@ bool OV2640Camera::configureSensor() {
         ESP_LOGE(TAG, "Failed to get sensor");
         return false;
     }
-    // Set sensor settings
-    s->set_vflip(s, 1);       // Flip vertically
-    s->set_hmirror(s, 0);     // No horizontal mirror
-    s->set_brightness(s, 1);  //-2 to 2
-    s->set_contrast(s, 1);    //-2 to 2
-    s->set_saturation(s, 0);  //-2 to 2
-    s->set_special_effect(s, 0); // 0 to 6 (0 - no effect)
-    s->set_whitebal(s, 1);    // 0 = disable, 1 = enable
-    s->set_awb_gain(s, 1);    // 0 = disable, 1 = enable
-    s->set_wb_mode(s, 0);     // 0 to 4 (0 - auto)
-    s->set_exposure_ctrl(s, 1); // 0 = disable, 1 = enable
-    s->set_aec2(s, 0);        // 0 = disable, 1 = enable
-    s->set_ae_level(s, 0);    // -2 to 2
-    s->set_aec_value(s, 300); // 0 to 1200
-    s->set_gain_ctrl(s, 1);   // 0 = disable, 1 = enable
-    s->set_agc_gain(s, 0);    // 0 to 30
-    s->set_gainceiling(s, (gainceiling_t)0); // 0 to 6
-    s->set_bpc(s, 0);         // 0 = disable, 1 = enable
-    s->set_wpc(s, 1);         // 0 = disable, 1 = enable
-    s->set_raw_gma(s, 1);     // 0 = disable, 1 = enable
-    s->set_lenc(s, 1);        // 0 = disable, 1 = enable
+    // Driver defaults after init_status, then only what differs from them
+    shadow_.load(s->status);
+    applyProfile(SensorProfiles::BASE, false);
     return true;
 }
 
 camera_fb_t* OV2640Camera::getFrameBuffer() {
-    if (!initialized_.load()) {
+    // Waits out a recovery in progress on the loop task
+    DriverLock lock(driver_mutex_, CameraWatchdogConfig::STALL_MS);
+    if (!lock.locked() || !initialized_.load()) {
         return nullptr;
     }
-    return esp_camera_fb_get();
+    unsigned long requested_ms = millis();
+    camera_fb_t* fb = esp_camera_fb_get();
+    if (fb && !validateFrame(fb)) {
+        esp_camera_fb_return(fb);
+        fb = nullptr;
+    }
+    noteCaptureResult(fb != nullptr, requested_ms);
+    if (fb) {
+        frames_out_++;
+    }
+    return fb;
 }
 
 void OV2640Camera::returnFrameBuffer(camera_fb_t* fb) {
     if (fb) {
         esp_camera_fb_return(fb);
+        frames_out_--;
     }
 }
 
@@ -149,6 +392,10 @@ void OV2640Camera::deinitialize() {
     }
     
     streaming_.store(false);
+    if (frame_signal_.armed) {
+        detachInterrupt((uint8_t)CameraPins::VSYNC);
+        frame_signal_.armed = false;
+    }
     esp_camera_deinit();
     initialized_.store(false);
     
@@ -163,6 +410,10 @@ std::unique_ptr<camera_fb_t, std::function<void(camera_fb_t*)>> OV2640Camera::ca
         return nullptr;
     }
     
+    DriverLock lock(driver_mutex_, CameraWatchdogConfig::STALL_MS);
+    if (!lock.locked()) {
+        return nullptr;
+    }
     frame_start_time_ = millis();
     
     // СТРОГОЕ ОГРАНИЧЕНИЕ 20 FPS на уровне камеры
@@ -184,6 +435,7 @@ std::unique_ptr<camera_fb_t, std::function<void(camera_fb_t*)>> OV2640Camera::ca
         }
         
         ESP_LOGW(TAG, "Frame capture failed");
+        noteCaptureResult(false, frame_start_time_);
         return nullptr;
     }
     
@@ -201,7 +453,9 @@ std::unique_ptr<camera_fb_t, std::function<void(camera_fb_t*)>> OV2640Camera::ca
         if (sensor) {
             int current_quality = sensor->status.quality;
             if (current_quality < 20) { // Увеличиваем сжатие
-                sensor->set_quality(sensor, current_quality + 3);
+                if (sensor->set_quality(sensor, current_quality + 3) == 0) {
+                    shadow_.note(SensorSetting::QUALITY, current_quality + 3);
+                }
                 ESP_LOGI(TAG, "Increased JPEG compression to quality %d for 20fps stability", current_quality + 3);
             }
         }
@@ -211,22 +465,31 @@ std::unique_ptr<camera_fb_t, std::function<void(camera_fb_t*)>> OV2640Camera::ca
         if (!fb) {
             last_error_ = CameraError::CAPTURE_FAILED;
             last_error_message_ = "Retry frame capture failed";
+            noteCaptureResult(false, frame_start_time_);
             return nullptr;
         }
         
         ESP_LOGI(TAG, "Recompressed frame size: %zu bytes", fb->len);
     }
     
+    if (!validateFrame(fb)) {
+        last_error_ = CameraError::CAPTURE_FAILED;
+        last_error_message_ = "Corrupt JPEG frame";
+        esp_camera_fb_return(fb);
+        noteCaptureResult(false, frame_start_time_);
+        return nullptr;
+    }
+    
+    noteCaptureResult(true, frame_start_time_);
     unsigned long capture_time = millis() - frame_start_time_;
     updateStats(fb, capture_time);
     last_frame_time_ = frame_start_time_;
     
     // Return smart pointer with custom deleter
+    frames_out_++;
     return std::unique_ptr<camera_fb_t, std::function<void(camera_fb_t*)>>(
-        fb, [](camera_fb_t* frame) {
-            if (frame) {
-                esp_camera_fb_return(frame);
-            }
+        fb, [this](camera_fb_t* frame) {
+            returnFrameBuffer(frame);
         }
     );
 }
@@ -262,6 +525,7 @@ bool OV2640Camera::setFrameSize(framesize_t size) {
     int result = sensor->set_framesize(sensor, size);
     if (result == 0) {
         config_.frame_size = size;
+        roi_ = RegionOfInterest();  // set_framesize rewrites the window
         ESP_LOGI(TAG, "Frame size changed to %d", size);
         return true;
     }
@@ -271,6 +535,128 @@ bool OV2640Camera::setFrameSize(framesize_t size) {
     return false;
 }
 
+bool OV2640Camera::setRegionOfInterest(uint16_t x, uint16_t y, uint16_t width, uint16_t height,
+                                       uint16_t output_width, uint16_t output_height) {
+    // JPEG output in whole MCUs (16x8 for 4:2:2)
+    output_width &= ~15;
+    output_height &= ~7;
+    
+    const resolution_info_t& frame = resolution[config_.frame_size];
+    if (width == 0 || height == 0 ||
+        (uint32_t)x + width > SensorWindow::SENSOR_WIDTH || (uint32_t)y + height > SensorWindow::SENSOR_HEIGHT ||
+        output_width == 0 || output_height == 0 || output_width > width || output_height > height ||
+        (uint32_t)output_width * output_height > (uint32_t)frame.width * frame.height) {
+        last_error_ = CameraError::INVALID_CONFIG;
+        last_error_message_ = "ROI outside sensor, or output larger than window or frame buffer";
+        return false;
+    }
+    
+    sensor_t* sensor = esp_camera_sensor_get();
+    if (!sensor) {
+        last_error_ = CameraError::SENSOR_NOT_FOUND;
+        return false;
+    }
+    if (!sensor->set_res_raw) {
+        last_error_ = CameraError::INVALID_CONFIG;
+        last_error_message_ = "Sensor does not support raw windowing";
+        return false;
+    }
+    
+    // Cheapest readout mode that still has at least one sensor pixel per output pixel
+    int mode = SensorWindow::MODE_UXGA;
+    uint16_t divider = 1;
+    if (width / 4 >= output_width && height / 4 >= output_height &&
+        (y + height) / 4 <= SensorWindow::CIF_MAX_HEIGHT) {
+        mode = SensorWindow::MODE_CIF;
+        divider = 4;
+    } else if (width / 2 >= output_width && height / 2 >= output_height) {
+        mode = SensorWindow::MODE_SVGA;
+        divider = 2;
+    }
+    
+    // Window registers hold sizes in 4-pixel units of the readout mode
+    uint16_t window_x = x / divider;
+    uint16_t window_y = y / divider;
+    uint16_t window_width = (width / divider) & ~3;
+    uint16_t window_height = (height / divider) & ~3;
+    
+    int64_t start = esp_timer_get_time();
+    int result = sensor->set_res_raw(sensor, mode, 0, 0, 0, window_x, window_y,
+                                     window_width, window_height, output_width, output_height, false, false);
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    if (result != 0) {
+        last_error_ = CameraError::HARDWARE_ERROR;
+        last_error_message_ = "Failed to program sensor window";
+        return false;
+    }
+    
+    roi_.active = true;
+    roi_.x = window_x * divider;
+    roi_.y = window_y * divider;
+    roi_.width = window_width * divider;
+    roi_.height = window_height * divider;
+    roi_.output_width = output_width;
+    roi_.output_height = output_height;
+    roi_.mode = mode;
+    roi_.zoom = 1.0f;
+    roi_.apply_us = elapsed;
+    ESP_LOGI(TAG, "ROI %ux%u@%u,%u -> %ux%u (mode %d) in %lu us",
+             roi_.width, roi_.height, roi_.x, roi_.y, output_width, output_height, mode, elapsed);
+    return true;
+}
+
+bool OV2640Camera::setDigitalZoom(float zoom, float center_x, float center_y) {
+    if (zoom < 1.0f || zoom > SensorWindow::MAX_ZOOM ||
+        center_x < 0.0f || center_x > 1.0f || center_y < 0.0f || center_y > 1.0f) {
+        last_error_ = CameraError::INVALID_CONFIG;
+        last_error_message_ = "Zoom must be 1-8x, centre 0-1";
+        return false;
+    }
+    
+    // Full field of view at the frame's aspect ratio (1600x900 for 16:9)
+    const resolution_info_t& frame = resolution[config_.frame_size];
+    uint32_t base_width = SensorWindow::SENSOR_WIDTH;
+    uint32_t base_height = base_width * frame.height / frame.width;
+    if (base_height > SensorWindow::SENSOR_HEIGHT) {
+        base_height = SensorWindow::SENSOR_HEIGHT;
+        base_width = base_height * frame.width / frame.height;
+    }
+    
+    uint16_t width = (uint16_t)(base_width / zoom) & ~3;
+    uint16_t height = (uint16_t)(base_height / zoom) & ~3;
+    int32_t x = (int32_t)(center_x * SensorWindow::SENSOR_WIDTH) - width / 2;
+    int32_t y = (int32_t)(center_y * SensorWindow::SENSOR_HEIGHT) - height / 2;
+    x = std::max<int32_t>(0, std::min<int32_t>(x, SensorWindow::SENSOR_WIDTH - width)) & ~3;
+    y = std::max<int32_t>(0, std::min<int32_t>(y, SensorWindow::SENSOR_HEIGHT - height)) & ~3;
+    
+    // The DSP only scales down: beyond 1:1 keep full detail and shrink the frame
+    float scale = std::min(1.0f, std::min((float)width / frame.width, (float)height / frame.height));
+    uint16_t output_width = (uint16_t)(frame.width * scale);
+    uint16_t output_height = (uint16_t)(frame.height * scale);
+    
+    if (!setRegionOfInterest((uint16_t)x, (uint16_t)y, width, height, output_width, output_height)) {
+        return false;
+    }
+    roi_.zoom = zoom;
+    return true;
+}
+
+bool OV2640Camera::clearRegionOfInterest() {
+    roi_ = RegionOfInterest();
+    sensor_t* sensor = esp_camera_sensor_get();
+    if (!sensor) {
+        last_error_ = CameraError::SENSOR_NOT_FOUND;
+        return false;
+    }
+    // Restores the driver's own window for the configured frame size
+    if (sensor->set_framesize(sensor, config_.frame_size) != 0) {
+        last_error_ = CameraError::INVALID_CONFIG;
+        last_error_message_ = "Failed to restore frame size";
+        return false;
+    }
+    return true;
+}
+
 bool OV2640Camera::setJpegQuality(uint8_t quality) {
     if (quality > 63) {
         last_error_ = CameraError::INVALID_CONFIG;
@@ -287,6 +673,7 @@ bool OV2640Camera::setJpegQuality(uint8_t quality) {
     int result = sensor->set_quality(sensor, quality);
     if (result == 0) {
         config_.jpeg_quality = quality;
+        shadow_.note(SensorSetting::QUALITY, quality);
         ESP_LOGI(TAG, "JPEG quality changed to %d", quality);
         return true;
     }
@@ -297,28 +684,86 @@ bool OV2640Camera::setJpegQuality(uint8_t quality) {
 }
 
 bool OV2640Camera::setPixelFormat(pixformat_t format) {
-    if (format != PIXFORMAT_JPEG && format != PIXFORMAT_RGB565) {
+    return reconfigure(format, config_.frame_size);
+}
+
+bool OV2640Camera::reconfigure(pixformat_t format, framesize_t size) {
+    DriverSettings settings = getDriverSettings();
+    settings.pixel_format = format;
+    settings.frame_size = size;
+    // Raw frames are converted as they come; buffered stale frames would only add latency
+    settings.grab_mode = format == PIXFORMAT_JPEG ? CAMERA_GRAB_WHEN_EMPTY : CAMERA_GRAB_LATEST;
+    return applyDriverSettings(settings);
+}
+
+DriverSettings OV2640Camera::getDriverSettings() const {
+    DriverSettings settings;
+    settings.pixel_format = config_.pixel_format;
+    settings.frame_size = config_.frame_size;
+    settings.jpeg_quality = (uint8_t)config_.jpeg_quality;
+    settings.fb_count = (uint8_t)config_.fb_count;
+    settings.grab_mode = config_.grab_mode;
+    settings.xclk_freq_hz = (uint32_t)config_.xclk_freq_hz;
+    return settings;
+}
+
+bool OV2640Camera::applyDriverSettings(const DriverSettings& settings) {
+    if (settings.pixel_format != PIXFORMAT_JPEG && settings.pixel_format != PIXFORMAT_RGB565 &&
+        settings.pixel_format != PIXFORMAT_YUV422) {
         last_error_ = CameraError::INVALID_CONFIG;
         last_error_message_ = "Unsupported pixel format";
         return false;
     }
-    
-    sensor_t* sensor = esp_camera_sensor_get();
-    if (!sensor) {
-        last_error_ = CameraError::SENSOR_NOT_FOUND;
+    if (!isValidFrameSize(settings.frame_size) || settings.jpeg_quality > 63 || settings.fb_count == 0 ||
+        settings.xclk_freq_hz < DriverLimits::MIN_XCLK_HZ || settings.xclk_freq_hz > DriverLimits::MAX_XCLK_HZ) {
+        last_error_ = CameraError::INVALID_CONFIG;
+        last_error_message_ = "Invalid driver settings";
         return false;
     }
     
-    int result = sensor->set_pixformat(sensor, format);
-    if (result == 0) {
-        config_.pixel_format = format;
-        ESP_LOGI(TAG, "Pixel format changed");
-        return true;
+    SensorValue snapshot[SENSOR_SETTING_COUNT];
+    size_t snapshot_count = shadow_.isValid() ? shadow_.snapshot(snapshot, SENSOR_SETTING_COUNT) : 0;
+    // Quality comes from the new config, not from the old shadow
+    size_t kept = 0;
+    for (size_t i = 0; i < snapshot_count; i++) {
+        if (snapshot[i].setting != SensorSetting::QUALITY) {
+            snapshot[kept++] = snapshot[i];
+        }
     }
+    snapshot_count = kept;
+    DriverSettings previous = getDriverSettings();
+    bool was_streaming = streaming_.load();
+    int64_t start = esp_timer_get_time();
     
-    last_error_ = CameraError::INVALID_CONFIG;
-    last_error_message_ = "Failed to set pixel format";
-    return false;
+    deinitialize();
+    storeDriverSettings(settings);
+    bool ok = startDriver();
+    if (!ok) {
+        ESP_LOGE(TAG, "Reconfiguration failed, restoring previous driver settings");
+        storeDriverSettings(previous);
+        startDriver();
+    }
+    if (initialized_.load() && snapshot_count > 0) {
+        SensorProfile restore = {"restore", "Settings before reconfiguration", snapshot, (uint8_t)snapshot_count};
+        applyProfile(restore, false);
+    }
+    roi_ = RegionOfInterest();
+    streaming_.store(was_streaming);
+    
+    ESP_LOGI(TAG, "Driver reconfigured (format %d, frame size %d, q %d, fb %d, grab %d, xclk %d) %s in %lu ms",
+             config_.pixel_format, config_.frame_size, config_.jpeg_quality, (int)config_.fb_count,
+             config_.grab_mode, config_.xclk_freq_hz, ok ? "OK" : "FAILED",
+             (uint32_t)((esp_timer_get_time() - start) / 1000));
+    return ok;
+}
+
+void OV2640Camera::storeDriverSettings(const DriverSettings& settings) {
+    config_.pixel_format = settings.pixel_format;
+    config_.frame_size = settings.frame_size;
+    config_.jpeg_quality = settings.jpeg_quality;
+    config_.fb_count = settings.fb_count;
+    config_.grab_mode = settings.grab_mode;
+    config_.xclk_freq_hz = (int)settings.xclk_freq_hz;
 }
 
 bool OV2640Camera::setGrayscaleMode(bool enable) {
@@ -339,26 +784,16 @@ bool OV2640Camera::setGrayscaleMode(bool enable) {
     if (enable) {
         // Включаем черно-белый режим для уменьшения размера файла
         ESP_LOGI(TAG, "🎬 Enabling GRAYSCALE mode for smaller file sizes");
-        
-        // Убираем насыщенность цветов (делаем изображение серым)
-        sensor->set_saturation(sensor, -2);    // Минимальная насыщенность
-        sensor->set_special_effect(sensor, 2); // Grayscale special effect
-        
-        // Дополнительные настройки для лучшего черно-белого изображения
-        sensor->set_contrast(sensor, 2);       // Увеличиваем контраст
-        sensor->set_brightness(sensor, 0);     // Нормальная яркость
-        
+        if (!applyProfile(SensorProfiles::GRAYSCALE)) {
+            return false;
+        }
         ESP_LOGI(TAG, "✅ Grayscale mode enabled - expect 30-50%% smaller JPEG files");
-        
     } else {
         // Возвращаем цветной режим
         ESP_LOGI(TAG, "🌈 Enabling COLOR mode");
-        
-        sensor->set_saturation(sensor, 0);     // Нормальная насыщенность
-        sensor->set_special_effect(sensor, 0); // Без эффектов
-        sensor->set_contrast(sensor, 1);       // Нормальный контраст
-        sensor->set_brightness(sensor, 0);     // Нормальная яркость
-        
+        if (!applyProfile(SensorProfiles::COLOR)) {
+            return false;
+        }
         ESP_LOGI(TAG, "✅ Color mode enabled");
     }
     
@@ -390,6 +825,7 @@ void OV2640Camera::logDetailedStats() const {
     ESP_LOGI(TAG, "Dropped frames: %lu (%.2f%%)", 
              stats.dropped_frames, 
              stats.total_frames > 0 ? (stats.dropped_frames * 100.0f / stats.total_frames) : 0.0f);
+    ESP_LOGI(TAG, "Corrupt frames: %lu, trimmed: %lu", stats.corrupt_frames, stats.trimmed_frames);
     ESP_LOGI(TAG, "Current FPS: %.2f", stats.current_fps);
     ESP_LOGI(TAG, "Average frame size: %lu bytes", stats.avg_frame_size);
     ESP_LOGI(TAG, "Min free heap: %lu bytes", stats.min_heap);
@@ -483,6 +919,42 @@ bool OV2640Camera::isValidFrameSize(framesize_t size) {
 }
 
 // Private helper methods
+bool OV2640Camera::validateFrame(camera_fb_t* fb) {
+    if (fb->format != PIXFORMAT_JPEG || jpeg_validation_ == JpegValidation::OFF) {
+        return true;
+    }
+    
+    uint32_t start = ESP.getCycleCount();
+    size_t frame_end = fb->len;
+    JpegCheck check = validateJpegFrame(fb->buf, fb->len, jpeg_validation_, frame_end);
+    uint32_t cycles = ESP.getCycleCount() - start;
+    
+    bool valid = check == JpegCheck::OK;
+    bool trimmed = valid && frame_end < fb->len;
+    if (trimmed) {
+        fb->len = frame_end;    // Drop trailing garbage after EOI
+    }
+    
+    if (xSemaphoreTake(stats_mutex_, pdMS_TO_TICKS(10)) == pdTRUE) {
+        stats_.avg_validate_cycles = stats_.avg_validate_cycles == 0
+            ? cycles : stats_.avg_validate_cycles - stats_.avg_validate_cycles / 16 + cycles / 16;
+        if (trimmed) {
+            stats_.trimmed_frames++;
+        }
+        if (!valid) {
+            stats_.corrupt_frames++;
+            stats_.dropped_frames++;
+        }
+        xSemaphoreGive(stats_mutex_);
+    }
+    
+    if (!valid) {
+        last_jpeg_reject_ = check;
+        ESP_LOGW(TAG, "Corrupt frame dropped: %s (%zu bytes)", jpegCheckName(check), fb->len);
+    }
+    return valid;
+}
+
 void OV2640Camera::updateStats(camera_fb_t* fb, unsigned long capture_time) {
     if (!fb || xSemaphoreTake(stats_mutex_, pdMS_TO_TICKS(10)) != pdTRUE) {
         return;
@@ -0,0 +1,172 @@
+// src/camera/pixel_convert.cpp - RGB565/YUV422 -> BGR888 (таблицы + пословная обработка)
+#include "pixel_convert.h"
+
+namespace {
+
+// BT.601 full-range coefficients in 16.16 fixed point
+const int32_t K_RV = 91881;     // 1.402
+const int32_t K_GU = 22554;     // 0.344136
+const int32_t K_GV = 46802;     // 0.714136
+const int32_t K_BU = 116130;    // 1.772
+const int CLAMP_OFFSET = 288;   // Covers Y + the largest chroma term
+
+inline int32_t fixedRound(int32_t value) {
+    return (value + 32768) >> 16;
+}
+
+inline uint8_t clampByte(int32_t value) {
+    return value < 0 ? 0 : (value > 255 ? 255 : (uint8_t)value);
+}
+
+// RGB565 channel expansion: x5 -> (x << 3) | (x >> 2), x6 -> (x << 2) | (x >> 4)
+inline uint32_t expandRgb565(uint8_t hi, uint8_t lo) {
+    uint32_t r5 = hi >> 3;
+    uint32_t g6 = ((uint32_t)(hi & 0x07) << 3) | (lo >> 5);
+    uint32_t b5 = lo & 0x1F;
+    uint32_t r = (r5 << 3) | (r5 >> 2);
+    uint32_t g = (g6 << 2) | (g6 >> 4);
+    uint32_t b = (b5 << 3) | (b5 >> 2);
+    return (r << 16) | (g << 8) | b;
+}
+
+struct ConvertTables {
+    // 0x00RRGGBB contributions of the RGB565 high and low byte; the green bits
+    // of the two bytes don't overlap, so a pixel is HI[h] | LO[l]
+    uint32_t rgb565_hi[256];
+    uint32_t rgb565_lo[256];
+    int16_t r_v[256];
+    int16_t g_uv_u[256];
+    int16_t g_uv_v[256];
+    int16_t b_u[256];
+    uint8_t clamp[256 + 2 * CLAMP_OFFSET];
+
+    ConvertTables() {
+        for (int i = 0; i < 256; i++) {
+            rgb565_hi[i] = expandRgb565((uint8_t)i, 0);
+            rgb565_lo[i] = expandRgb565(0, (uint8_t)i);
+            int32_t c = i - 128;
+            r_v[i] = (int16_t)fixedRound(K_RV * c);
+            g_uv_u[i] = (int16_t)(-K_GU * c >> 8);   // 8.8, summed before rounding
+            g_uv_v[i] = (int16_t)(-K_GV * c >> 8);
+            b_u[i] = (int16_t)fixedRound(K_BU * c);
+        }
+        for (int i = 0; i < 256 + 2 * CLAMP_OFFSET; i++) {
+            clamp[i] = clampByte(i - CLAMP_OFFSET);
+        }
+    }
+};
+
+const ConvertTables tables;
+
+inline void storeBgr(uint8_t* dst, uint32_t pixel) {
+    dst[0] = (uint8_t)pixel;
+    dst[1] = (uint8_t)(pixel >> 8);
+    dst[2] = (uint8_t)(pixel >> 16);
+}
+
+// Chroma terms shared by a YUYV pixel pair
+struct Chroma {
+    int32_t r;
+    int32_t g;
+    int32_t b;
+};
+
+inline Chroma chromaTerms(uint8_t u, uint8_t v) {
+    Chroma c;
+    c.r = tables.r_v[v];
+    c.g = (tables.g_uv_u[u] + tables.g_uv_v[v] + 128) >> 8;
+    c.b = tables.b_u[u];
+    return c;
+}
+
+inline uint32_t yuvPixel(uint8_t y, const Chroma& c) {
+    const uint8_t* clamp = tables.clamp + CLAMP_OFFSET;
+    return ((uint32_t)clamp[y + c.r] << 16) | ((uint32_t)clamp[y + c.g] << 8) | clamp[y + c.b];
+}
+
+inline bool wordAligned(const void* p) {
+    return ((uintptr_t)p & 3) == 0;
+}
+
+} // namespace
+
+namespace PixelConvert {
+
+void rgb565ToBgr888Scalar(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    for (size_t i = 0; i < pixels; i++) {
+        storeBgr(dst + i * 3, expandRgb565(src[i * 2], src[i * 2 + 1]));
+    }
+}
+
+void rgb565ToBgr888(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    size_t i = 0;
+    if (wordAligned(src) && wordAligned(dst)) {
+        // Four pixels: two source words in, three destination words out
+        const uint32_t* in = (const uint32_t*)src;
+        uint32_t* out = (uint32_t*)dst;
+        const uint32_t* hi = tables.rgb565_hi;
+        const uint32_t* lo = tables.rgb565_lo;
+        for (; i + 4 <= pixels; i += 4) {
+            uint32_t w0 = *in++;
+            uint32_t w1 = *in++;
+            uint32_t p0 = hi[w0 & 0xFF] | lo[(w0 >> 8) & 0xFF];
+            uint32_t p1 = hi[(w0 >> 16) & 0xFF] | lo[w0 >> 24];
+            uint32_t p2 = hi[w1 & 0xFF] | lo[(w1 >> 8) & 0xFF];
+            uint32_t p3 = hi[(w1 >> 16) & 0xFF] | lo[w1 >> 24];
+            *out++ = p0 | (p1 << 24);
+            *out++ = (p1 >> 8) | (p2 << 16);
+            *out++ = (p2 >> 16) | (p3 << 8);
+        }
+    }
+    for (; i < pixels; i++) {
+        storeBgr(dst + i * 3, tables.rgb565_hi[src[i * 2]] | tables.rgb565_lo[src[i * 2 + 1]]);
+    }
+}
+
+void yuyvToBgr888Scalar(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    for (size_t i = 0; i + 1 < pixels; i += 2) {
+        const uint8_t* p = src + i * 2;
+        int32_t u = p[1] - 128;
+        int32_t v = p[3] - 128;
+        int32_t r = fixedRound(K_RV * v);
+        int32_t g = ((-K_GU * u >> 8) + (-K_GV * v >> 8) + 128) >> 8;
+        int32_t b = fixedRound(K_BU * u);
+        for (int k = 0; k < 2; k++) {
+            int32_t y = p[k * 2];
+            uint8_t* out = dst + (i + k) * 3;
+            out[0] = clampByte(y + b);
+            out[1] = clampByte(y + g);
+            out[2] = clampByte(y + r);
+        }
+    }
+}
+
+void yuyvToBgr888(const uint8_t* src, uint8_t* dst, size_t pixels) {
+    size_t i = 0;
+    if (wordAligned(src) && wordAligned(dst)) {
+        // One source word is a pixel pair; two pairs fill three output words
+        const uint32_t* in = (const uint32_t*)src;
+        uint32_t* out = (uint32_t*)dst;
+        for (; i + 4 <= pixels; i += 4) {
+            uint32_t w0 = *in++;
+            uint32_t w1 = *in++;
+            Chroma c0 = chromaTerms((uint8_t)(w0 >> 8), (uint8_t)(w0 >> 24));
+            Chroma c1 = chromaTerms((uint8_t)(w1 >> 8), (uint8_t)(w1 >> 24));
+            uint32_t p0 = yuvPixel((uint8_t)w0, c0);
+            uint32_t p1 = yuvPixel((uint8_t)(w0 >> 16), c0);
+            uint32_t p2 = yuvPixel((uint8_t)w1, c1);
+            uint32_t p3 = yuvPixel((uint8_t)(w1 >> 16), c1);
+            *out++ = p0 | (p1 << 24);
+            *out++ = (p1 >> 8) | (p2 << 16);
+            *out++ = (p2 >> 16) | (p3 << 8);
+        }
+    }
+    for (; i + 1 < pixels; i += 2) {
+        const uint8_t* p = src + i * 2;
+        Chroma c = chromaTerms(p[1], p[3]);
+        storeBgr(dst + i * 3, yuvPixel(p[0], c));
+        storeBgr(dst + (i + 1) * 3, yuvPixel(p[2], c));
+    }
+}
+
+} // namespace PixelConvert
@@ -0,0 +1,380 @@
+// src/camera/raw_pipeline.cpp - RAW захват (ядро 1) -> BGR888 + OSD -> программный JPEG (ядро 0)
+#include "raw_pipeline.h"
+#include "pixel_convert.h"
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <img_converters.h>
+#include <string.h>
+
+namespace {
+
+uint8_t* allocateFrameMemory(size_t size) {
+    uint8_t* buffer = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!buffer) {
+        buffer = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    return buffer;
+}
+
+uint32_t averageUs(uint32_t average, int64_t start, int64_t end) {
+    uint32_t sample = (uint32_t)(end - start);
+    return average == 0 ? sample : average - average / 8 + sample / 8;
+}
+
+// fmt2jpg_cb sink: copies the encoder output into a fixed buffer
+struct JpegWriter {
+    uint8_t* data;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+};
+
+size_t writeJpegChunk(void* arg, size_t index, const void* data, size_t len) {
+    JpegWriter* writer = (JpegWriter*)arg;
+    if (!data || len == 0) {
+        return 0;
+    }
+    if (index + len > writer->capacity) {
+        writer->overflow = true;
+        return len;
+    }
+    memcpy(writer->data + index, data, len);
+    writer->length = index + len;
+    return len;
+}
+
+} // namespace
+
+RawPipeline::RawPipeline()
+    : camera_(nullptr), previous_format_(PIXFORMAT_JPEG), previous_size_(FRAMESIZE_QVGA),
+      slot_capacity_(0), bgr_(nullptr), free_slots_(nullptr), ready_slots_(nullptr),
+      capture_task_(nullptr), encode_task_(nullptr), notify_task_(nullptr), notify_bits_(0),
+      running_(false), stop_requested_(false), published_(-1), reading_(-1), sequence_(0),
+      osd_enabled_(true), quality_(RawPipelineConfig::JPEG_QUALITY),
+      fps_window_start_(0), fps_window_frames_(0) {
+    memset(slots_, 0, sizeof(slots_));
+    memset(outputs_, 0, sizeof(outputs_));
+}
+
+RawPipeline::~RawPipeline() {
+    stop();
+}
+
+bool RawPipeline::allocate(uint16_t width, uint16_t height) {
+    size_t pixels = (size_t)width * height;
+    slot_capacity_ = pixels * 2;
+    for (uint8_t i = 0; i < RawPipelineConfig::SLOT_COUNT; i++) {
+        slots_[i].data = allocateFrameMemory(slot_capacity_);
+        if (!slots_[i].data) return false;
+    }
+    bgr_ = allocateFrameMemory(pixels * 3);
+    if (!bgr_) return false;
+    // One byte per pixel is far above what quality <= 90 produces
+    for (Output& output : outputs_) {
+        output.capacity = pixels;
+        output.data = allocateFrameMemory(output.capacity);
+        if (!output.data) return false;
+    }
+
+    free_slots_ = xQueueCreate(RawPipelineConfig::SLOT_COUNT, sizeof(uint8_t));
+    ready_slots_ = xQueueCreate(RawPipelineConfig::SLOT_COUNT, sizeof(uint8_t));
+    if (!free_slots_ || !ready_slots_) return false;
+    for (uint8_t i = 0; i < RawPipelineConfig::SLOT_COUNT; i++) {
+        xQueueSend(free_slots_, &i, 0);
+    }
+    return true;
+}
+
+void RawPipeline::release() {
+    for (Slot& slot : slots_) {
+        free(slot.data);
+        slot.data = nullptr;
+    }
+    free(bgr_);
+    bgr_ = nullptr;
+    for (Output& output : outputs_) {
+        free(output.data);
+        output.data = nullptr;
+        output.capacity = 0;
+    }
+    if (free_slots_) {
+        vQueueDelete(free_slots_);
+        free_slots_ = nullptr;
+    }
+    if (ready_slots_) {
+        vQueueDelete(ready_slots_);
+        ready_slots_ = nullptr;
+    }
+    slot_capacity_ = 0;
+}
+
+bool RawPipeline::start(OV2640Camera* camera, pixformat_t format, framesize_t size) {
+    if (running_) {
+        return true;
+    }
+    if (!camera || !camera->isInitialized()) {
+        Serial.println("[RAW] ❌ Camera not initialized");
+        return false;
+    }
+    if (format != PIXFORMAT_RGB565 && format != PIXFORMAT_YUV422) {
+        Serial.println("[RAW] ❌ Only RGB565 and YUV422 are supported");
+        return false;
+    }
+
+    camera_ = camera;
+    previous_format_ = camera->getPixelFormat();
+    previous_size_ = camera->getFrameSize();
+    if (!camera->reconfigure(format, size)) {
+        Serial.printf("[RAW] ❌ Camera reconfiguration failed: %s\n", camera->getLastErrorMessage().c_str());
+        return false;
+    }
+
+    uint16_t width = resolution[size].width;
+    uint16_t height = resolution[size].height;
+    if (!allocate(width, height)) {
+        Serial.println("[RAW] ❌ Not enough memory for frame buffers");
+        release();
+        camera->reconfigure(previous_format_, previous_size_);
+        return false;
+    }
+
+    stats_ = RawPipelineStats();
+    published_ = -1;
+    reading_ = -1;
+    sequence_ = 0;
+    fps_window_start_ = millis();
+    fps_window_frames_ = 0;
+    stop_requested_ = false;
+    running_ = true;
+
+    BaseType_t capture = xTaskCreatePinnedToCore(captureTask, "RawCapture", RawPipelineConfig::CAPTURE_STACK,
+                                                 this, RawPipelineConfig::CAPTURE_PRIORITY, &capture_task_,
+                                                 RawPipelineConfig::CAPTURE_CORE);
+    BaseType_t encode = xTaskCreatePinnedToCore(encodeTask, "RawEncode", RawPipelineConfig::ENCODE_STACK,
+                                                this, RawPipelineConfig::ENCODE_PRIORITY, &encode_task_,
+                                                RawPipelineConfig::ENCODE_CORE);
+    if (capture != pdPASS || encode != pdPASS) {
+        Serial.println("[RAW] ❌ Failed to create pipeline tasks");
+        stop();
+        return false;
+    }
+
+    Serial.printf("[RAW] ✅ Pipeline started: %s %ux%u, capture on core %d, encode on core %d\n",
+                  format == PIXFORMAT_RGB565 ? "RGB565" : "YUV422", width, height,
+                  (int)RawPipelineConfig::CAPTURE_CORE, (int)RawPipelineConfig::ENCODE_CORE);
+    return true;
+}
+
+void RawPipeline::stop() {
+    if (!running_) {
+        return;
+    }
+    stop_requested_ = true;
+    uint32_t start = millis();
+    while ((capture_task_ || encode_task_) && millis() - start < RawPipelineConfig::STOP_TIMEOUT_MS) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (capture_task_ || encode_task_) {
+        // A task stuck in the driver or encoder; deleting it is the lesser evil
+        Serial.println("[RAW] ⚠️ Pipeline task did not stop in time, deleting");
+        if (capture_task_) vTaskDelete(capture_task_);
+        if (encode_task_) vTaskDelete(encode_task_);
+        capture_task_ = nullptr;
+        encode_task_ = nullptr;
+    }
+
+    portENTER_CRITICAL(&lock_);
+    running_ = false;
+    published_ = -1;
+    reading_ = -1;
+    portEXIT_CRITICAL(&lock_);
+    release();
+
+    if (camera_ && !camera_->reconfigure(previous_format_, previous_size_)) {
+        Serial.printf("[RAW] ⚠️ Could not restore camera format: %s\n", camera_->getLastErrorMessage().c_str());
+    }
+    Serial.printf("[RAW] Pipeline stopped after %lu frames\n", stats_.encoded);
+}
+
+void RawPipeline::captureTask(void* parameter) {
+    RawPipeline* pipeline = static_cast<RawPipeline*>(parameter);
+    pipeline->captureLoop();
+    pipeline->capture_task_ = nullptr;
+    vTaskDelete(nullptr);
+}
+
+void RawPipeline::encodeTask(void* parameter) {
+    RawPipeline* pipeline = static_cast<RawPipeline*>(parameter);
+    pipeline->encodeLoop();
+    pipeline->encode_task_ = nullptr;
+    vTaskDelete(nullptr);
+}
+
+void RawPipeline::captureLoop() {
+    uint8_t index;
+    while (!stop_requested_) {
+        if (xQueueReceive(free_slots_, &index, pdMS_TO_TICKS(100)) != pdTRUE) {
+            continue;   // Encoder still busy with both slots
+        }
+        camera_fb_t* fb = camera_->getFrameBuffer();
+        if (!fb || fb->len > slot_capacity_ ||
+            (fb->format != PIXFORMAT_RGB565 && fb->format != PIXFORMAT_YUV422)) {
+            if (fb) camera_->returnFrameBuffer(fb);
+            stats_.capture_failed++;
+            xQueueSend(free_slots_, &index, 0);
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+
+        // The driver buffer goes back right away; the slot is what crosses cores
+        int64_t start = esp_timer_get_time();
+        Slot& slot = slots_[index];
+        memcpy(slot.data, fb->buf, fb->len);
+        slot.length = fb->len;
+        slot.width = (uint16_t)fb->width;
+        slot.height = (uint16_t)fb->height;
+        slot.format = fb->format;
+        slot.timestamp = fb->timestamp;
+        camera_->returnFrameBuffer(fb);
+        stats_.avg_copy_us = averageUs(stats_.avg_copy_us, start, esp_timer_get_time());
+        stats_.captured++;
+
+        xQueueSend(ready_slots_, &index, portMAX_DELAY);
+    }
+}
+
+void RawPipeline::encodeLoop() {
+    uint8_t index;
+    while (!stop_requested_) {
+        if (xQueueReceive(ready_slots_, &index, pdMS_TO_TICKS(100)) != pdTRUE) {
+            continue;
+        }
+        Slot& slot = slots_[index];
+        uint16_t width = slot.width;
+        uint16_t height = slot.height;
+        struct timeval timestamp = slot.timestamp;
+        size_t pixels = (size_t)width * height;
+
+        int64_t start = esp_timer_get_time();
+        if (slot.format == PIXFORMAT_RGB565) {
+            PixelConvert::rgb565ToBgr888(slot.data, bgr_, pixels);
+        } else {
+            PixelConvert::yuyvToBgr888(slot.data, bgr_, pixels);
+        }
+        int64_t converted = esp_timer_get_time();
+        stats_.avg_convert_us = averageUs(stats_.avg_convert_us, start, converted);
+        // Capture can refill the slot while this frame is encoded
+        xQueueSend(free_slots_, &index, 0);
+
+        if (osd_enabled_) {
+            OsdTelemetry telemetry;
+            portENTER_CRITICAL(&lock_);
+            telemetry = telemetry_;
+            portEXIT_CRITICAL(&lock_);
+            osd_.render(bgr_, width, height, telemetry);
+            stats_.avg_osd_us = averageUs(stats_.avg_osd_us, converted, esp_timer_get_time());
+        }
+
+        // Write into the output nobody reads; the published one stays valid meanwhile
+        int target;
+        for (;;) {
+            portENTER_CRITICAL(&lock_);
+            target = published_ < 0 ? 0 : 1 - published_;
+            bool busy = reading_ == target;
+            portEXIT_CRITICAL(&lock_);
+            if (!busy || stop_requested_) break;
+            vTaskDelay(1);
+        }
+        if (stop_requested_) {
+            break;
+        }
+
+        Output& output = outputs_[target];
+        size_t length = 0;
+        int64_t encode_start = esp_timer_get_time();
+        bool ok = encode(slot, output, length);
+        stats_.avg_encode_us = averageUs(stats_.avg_encode_us, encode_start, esp_timer_get_time());
+        if (!ok) {
+            stats_.encode_failed++;
+            continue;
+        }
+
+        output.frame.buf = output.data;
+        output.frame.len = length;
+        output.frame.width = width;
+        output.frame.height = height;
+        output.frame.format = PIXFORMAT_JPEG;
+        output.frame.timestamp = timestamp;
+
+        portENTER_CRITICAL(&lock_);
+        published_ = target;
+        sequence_++;
+        portEXIT_CRITICAL(&lock_);
+        if (notify_task_) {
+            xTaskNotify(notify_task_, notify_bits_, eSetBits);
+        }
+
+        stats_.encoded++;
+        stats_.last_jpeg_size = length;
+        fps_window_frames_++;
+        uint32_t elapsed = millis() - fps_window_start_;
+        if (elapsed >= 1000) {
+            stats_.output_fps = fps_window_frames_ * 1000.0f / elapsed;
+            fps_window_start_ = millis();
+            fps_window_frames_ = 0;
+        }
+    }
+}
+
+bool RawPipeline::encode(const Slot& slot, Output& output, size_t& length) {
+    // bgr_ holds the converted slot; esp32-camera's RGB888 is B,G,R in memory
+    JpegWriter writer = {output.data, output.capacity, 0, false};
+    bool ok = fmt2jpg_cb(bgr_, (size_t)slot.width * slot.height * 3, slot.width, slot.height,
+                         PIXFORMAT_RGB888, quality_, writeJpegChunk, &writer);
+    if (!ok || writer.overflow || writer.length == 0) {
+        return false;
+    }
+    length = writer.length;
+    return true;
+}
+
+camera_fb_t* RawPipeline::acquireFrame(uint32_t& last_seq) {
+    camera_fb_t* frame = nullptr;
+    portENTER_CRITICAL(&lock_);
+    if (running_ && published_ >= 0 && reading_ < 0 && sequence_ != last_seq) {
+        reading_ = published_;
+        last_seq = sequence_;
+        frame = &outputs_[reading_].frame;
+    }
+    portEXIT_CRITICAL(&lock_);
+    return frame;
+}
+
+void RawPipeline::releaseFrame() {
+    portENTER_CRITICAL(&lock_);
+    reading_ = -1;
+    portEXIT_CRITICAL(&lock_);
+}
+
+void RawPipeline::setTelemetry(const OsdTelemetry& telemetry) {
+    portENTER_CRITICAL(&lock_);
+    telemetry_ = telemetry;
+    portEXIT_CRITICAL(&lock_);
+}
+
+void RawPipeline::printStatus(Print& out) const {
+    out.println("\n🎞️  === RAW PIPELINE ===");
+    if (!running_) {
+        out.println("State: stopped (sensor JPEG path active)");
+        return;
+    }
+    out.printf("State: running, %s %ux%u, JPEG quality %u, OSD %s\n",
+               slots_[0].format == PIXFORMAT_RGB565 ? "RGB565" : "YUV422",
+               slots_[0].width, slots_[0].height, quality_, osd_enabled_ ? "on" : "off");
+    out.printf("Frames: captured %lu (failed %lu), encoded %lu (failed %lu)\n",
+               stats_.captured, stats_.capture_failed, stats_.encoded, stats_.encode_failed);
+    out.printf("Core 1: copy %lu us\n", stats_.avg_copy_us);
+    out.printf("Core 0: convert %lu us + OSD %lu us + JPEG %lu us\n",
+               stats_.avg_convert_us, osd_enabled_ ? stats_.avg_osd_us : (uint32_t)0, stats_.avg_encode_us);
+    out.printf("Output: %.1f fps, last JPEG %lu bytes\n", stats_.output_fps, stats_.last_jpeg_size);
+}
@@ -0,0 +1,192 @@
+// src/camera/sensor_profile.cpp - Профили сенсора и вычисление разницы с теневыми регистрами
+#include "sensor_profile.h"
+#include <string.h>
+
+static const char* const SETTING_NAMES[SENSOR_SETTING_COUNT] = {
+    "vflip", "hmirror", "brightness", "contrast", "saturation", "special_effect",
+    "awb", "awb_gain", "wb_mode", "aec", "aec2", "ae_level", "aec_value", "agc",
+    "agc_gain", "gainceiling", "bpc", "wpc", "raw_gma", "lenc", "dcw", "quality",
+};
+
+const char* sensorSettingName(SensorSetting setting) {
+    size_t index = (size_t)setting;
+    return index < SENSOR_SETTING_COUNT ? SETTING_NAMES[index] : "?";
+}
+
+SensorShadow::SensorShadow() : valid_(false) {
+    memset(values_, 0, sizeof(values_));
+}
+
+void SensorShadow::load(const camera_status_t& status) {
+    note(SensorSetting::VFLIP, status.vflip);
+    note(SensorSetting::HMIRROR, status.hmirror);
+    note(SensorSetting::BRIGHTNESS, status.brightness);
+    note(SensorSetting::CONTRAST, status.contrast);
+    note(SensorSetting::SATURATION, status.saturation);
+    note(SensorSetting::SPECIAL_EFFECT, status.special_effect);
+    note(SensorSetting::AWB, status.awb);
+    note(SensorSetting::AWB_GAIN, status.awb_gain);
+    note(SensorSetting::WB_MODE, status.wb_mode);
+    note(SensorSetting::AEC, status.aec);
+    note(SensorSetting::AEC2, status.aec2);
+    note(SensorSetting::AE_LEVEL, status.ae_level);
+    note(SensorSetting::AEC_VALUE, (int16_t)status.aec_value);
+    note(SensorSetting::AGC, status.agc);
+    note(SensorSetting::AGC_GAIN, status.agc_gain);
+    note(SensorSetting::GAINCEILING, status.gainceiling);
+    note(SensorSetting::BPC, status.bpc);
+    note(SensorSetting::WPC, status.wpc);
+    note(SensorSetting::RAW_GMA, status.raw_gma);
+    note(SensorSetting::LENC, status.lenc);
+    note(SensorSetting::DCW, status.dcw);
+    note(SensorSetting::QUALITY, status.quality);
+    valid_ = true;
+}
+
+void SensorShadow::compile(const SensorProfile& profile, SensorDiff& diff) const {
+    diff.count = 0;
+    for (uint8_t i = 0; i < profile.count; i++) {
+        const SensorValue& v = profile.values[i];
+        if (!valid_ || get(v.setting) != v.value) {
+            diff.values[diff.count++] = v;
+        }
+    }
+}
+
+size_t SensorShadow::snapshot(SensorValue* out, size_t capacity) const {
+    size_t count = 0;
+    for (size_t i = 0; i < SENSOR_SETTING_COUNT && count < capacity; i++) {
+        out[count].setting = (SensorSetting)i;
+        out[count].value = values_[i];
+        count++;
+    }
+    return count;
+}
+
+int writeSensorSetting(sensor_t* s, SensorSetting setting, int value) {
+    switch (setting) {
+        case SensorSetting::VFLIP:          return s->set_vflip(s, value);
+        case SensorSetting::HMIRROR:        return s->set_hmirror(s, value);
+        case SensorSetting::BRIGHTNESS:     return s->set_brightness(s, value);
+        case SensorSetting::CONTRAST:       return s->set_contrast(s, value);
+        case SensorSetting::SATURATION:     return s->set_saturation(s, value);
+        case SensorSetting::SPECIAL_EFFECT: return s->set_special_effect(s, value);
+        case SensorSetting::AWB:            return s->set_whitebal(s, value);
+        case SensorSetting::AWB_GAIN:       return s->set_awb_gain(s, value);
+        case SensorSetting::WB_MODE:        return s->set_wb_mode(s, value);
+        case SensorSetting::AEC:            return s->set_exposure_ctrl(s, value);
+        case SensorSetting::AEC2:           return s->set_aec2(s, value);
+        case SensorSetting::AE_LEVEL:       return s->set_ae_level(s, value);
+        case SensorSetting::AEC_VALUE:      return s->set_aec_value(s, value);
+        case SensorSetting::AGC:            return s->set_gain_ctrl(s, value);
+        case SensorSetting::AGC_GAIN:       return s->set_agc_gain(s, value);
+        case SensorSetting::GAINCEILING:    return s->set_gainceiling(s, (gainceiling_t)value);
+        case SensorSetting::BPC:            return s->set_bpc(s, value);
+        case SensorSetting::WPC:            return s->set_wpc(s, value);
+        case SensorSetting::RAW_GMA:        return s->set_raw_gma(s, value);
+        case SensorSetting::LENC:           return s->set_lenc(s, value);
+        case SensorSetting::DCW:            return s->set_dcw(s, value);
+        case SensorSetting::QUALITY:        return s->set_quality(s, value);
+        default:                            return -1;
+    }
+}
+
+// === ПРОФИЛИ ===
+
+namespace SensorProfiles {
+
+static const SensorValue BASE_VALUES[] = {
+    {SensorSetting::VFLIP, 1},
+    {SensorSetting::HMIRROR, 0},
+    {SensorSetting::BRIGHTNESS, 1},         // -2 to 2
+    {SensorSetting::CONTRAST, 1},           // -2 to 2
+    {SensorSetting::SATURATION, 0},         // -2 to 2
+    {SensorSetting::SPECIAL_EFFECT, 0},     // 0 to 6 (0 - no effect)
+    {SensorSetting::AWB, 1},
+    {SensorSetting::AWB_GAIN, 1},
+    {SensorSetting::WB_MODE, 0},            // 0 to 4 (0 - auto)
+    {SensorSetting::AEC, 1},
+    {SensorSetting::AEC2, 0},
+    {SensorSetting::AE_LEVEL, 0},           // -2 to 2
+    {SensorSetting::AEC_VALUE, 300},        // 0 to 1200
+    {SensorSetting::AGC, 1},
+    {SensorSetting::AGC_GAIN, 0},           // 0 to 30
+    {SensorSetting::GAINCEILING, 0},        // 0 to 6 (2x .. 128x)
+    {SensorSetting::BPC, 0},
+    {SensorSetting::WPC, 1},
+    {SensorSetting::RAW_GMA, 1},
+    {SensorSetting::LENC, 1},
+};
+
+static const SensorValue COLOR_VALUES[] = {
+    {SensorSetting::BRIGHTNESS, 0},
+    {SensorSetting::CONTRAST, 1},
+    {SensorSetting::SATURATION, 0},
+    {SensorSetting::SPECIAL_EFFECT, 0},
+};
+
+// Grayscale special effect; 30-50% smaller JPEG frames
+static const SensorValue GRAYSCALE_VALUES[] = {
+    {SensorSetting::BRIGHTNESS, 0},
+    {SensorSetting::CONTRAST, 2},
+    {SensorSetting::SATURATION, -2},
+    {SensorSetting::SPECIAL_EFFECT, 2},
+};
+
+static const SensorValue DAY_VALUES[] = {
+    {SensorSetting::AEC, 1},
+    {SensorSetting::AEC2, 0},
+    {SensorSetting::AE_LEVEL, 0},
+    {SensorSetting::AGC, 1},
+    {SensorSetting::GAINCEILING, 0},
+};
+
+// Night exposure (DSP AEC) and up to 32x gain: brighter, noisier
+static const SensorValue NIGHT_VALUES[] = {
+    {SensorSetting::AEC, 1},
+    {SensorSetting::AEC2, 1},
+    {SensorSetting::AE_LEVEL, 2},
+    {SensorSetting::AGC, 1},
+    {SensorSetting::GAINCEILING, 4},
+};
+
+// Fixed short exposure against motion blur, gain makes up the brightness
+static const SensorValue SPORT_VALUES[] = {
+    {SensorSetting::AEC, 0},
+    {SensorSetting::AEC2, 0},
+    {SensorSetting::AEC_VALUE, 120},
+    {SensorSetting::AGC, 1},
+    {SensorSetting::GAINCEILING, 3},
+};
+
+#define SENSOR_PROFILE(values) values, (uint8_t)(sizeof(values) / sizeof(values[0]))
+
+const SensorProfile BASE = {"base", "Boot defaults", SENSOR_PROFILE(BASE_VALUES)};
+const SensorProfile COLOR = {"color", "Color image", SENSOR_PROFILE(COLOR_VALUES)};
+const SensorProfile GRAYSCALE = {"grayscale", "Grayscale, smaller frames", SENSOR_PROFILE(GRAYSCALE_VALUES)};
+const SensorProfile DAY = {"day", "Auto exposure, low gain", SENSOR_PROFILE(DAY_VALUES)};
+const SensorProfile NIGHT = {"night", "Long exposure, up to 32x gain", SENSOR_PROFILE(NIGHT_VALUES)};
+const SensorProfile SPORT = {"sport", "Short fixed exposure, less blur", SENSOR_PROFILE(SPORT_VALUES)};
+
+#undef SENSOR_PROFILE
+
+static const SensorProfile* const ALL[] = {&BASE, &COLOR, &GRAYSCALE, &DAY, &NIGHT, &SPORT};
+
+const SensorProfile* find(const char* name, size_t length) {
+    for (size_t i = 0; i < count(); i++) {
+        if (strlen(ALL[i]->name) == length && strncmp(ALL[i]->name, name, length) == 0) {
+            return ALL[i];
+        }
+    }
+    return nullptr;
+}
+
+size_t count() {
+    return sizeof(ALL) / sizeof(ALL[0]);
+}
+
+const SensorProfile& at(size_t index) {
+    return *ALL[index];
+}
+
+} // namespace SensorProfiles
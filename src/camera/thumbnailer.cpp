@@ -0,0 +1,104 @@
+// src/camera/thumbnailer.cpp - Миниатюры 1/8 из DC-коэффициентов JPEG
+#include "thumbnailer.h"
+#include "img_converters.h"
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+namespace {
+
+// Buffers are only needed while a thumbnail is requested; prefer PSRAM
+uint8_t* allocateBuffer(size_t size) {
+    uint8_t* buffer = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!buffer) {
+        buffer = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    return buffer;
+}
+
+uint32_t movingAverage(uint32_t average, uint32_t sample, uint32_t count) {
+    return count <= 1 ? sample : average - average / 8 + sample / 8;
+}
+
+} // namespace
+
+Thumbnailer::Thumbnailer() : rgb_(nullptr), error_("") {
+    for (uint8_t i = 0; i < JpegDcDecoder::MAX_COMPONENTS; i++) {
+        planes_[i] = nullptr;
+    }
+}
+
+Thumbnailer::~Thumbnailer() {
+    for (uint8_t i = 0; i < JpegDcDecoder::MAX_COMPONENTS; i++) {
+        free(planes_[i]);
+    }
+    free(rgb_);
+}
+
+bool Thumbnailer::allocate() {
+    if (rgb_) {
+        return true;
+    }
+    for (uint8_t i = 0; i < JpegDcDecoder::MAX_COMPONENTS; i++) {
+        if (!planes_[i]) planes_[i] = allocateBuffer(ThumbnailConfig::PLANE_CAPACITY);
+        if (!planes_[i]) return false;
+    }
+    rgb_ = allocateBuffer(ThumbnailConfig::PLANE_CAPACITY * 3);
+    return rgb_ != nullptr;
+}
+
+bool Thumbnailer::encode(const camera_fb_t* fb, bool color, uint8_t** out, size_t* out_len) {
+    *out = nullptr;
+    *out_len = 0;
+    if (!fb || fb->format != PIXFORMAT_JPEG) {
+        error_ = "frame is not JPEG";
+        stats_.failed++;
+        return false;
+    }
+    if (!allocate()) {
+        error_ = "out of memory";
+        stats_.failed++;
+        return false;
+    }
+
+    int64_t start = esp_timer_get_time();
+    uint8_t* luma_only[JpegDcDecoder::MAX_COMPONENTS] = {planes_[0], nullptr, nullptr};
+    if (!decoder_.decodePlanes(fb->buf, fb->len, color ? planes_ : luma_only, ThumbnailConfig::PLANE_CAPACITY)) {
+        error_ = decoder_.lastError();
+        stats_.failed++;
+        return false;
+    }
+    int64_t decoded = esp_timer_get_time();
+
+    uint16_t width = decoder_.planeWidth();
+    uint16_t height = decoder_.planeHeight();
+    bool ok;
+    if (color && decoder_.componentCount() == 3) {
+        decoder_.toRgb888(planes_, rgb_, true);
+        ok = fmt2jpg(rgb_, (size_t)width * height * 3, width, height, PIXFORMAT_RGB888,
+                     ThumbnailConfig::JPEG_QUALITY, out, out_len);
+    } else {
+        ok = fmt2jpg(planes_[0], (size_t)width * height, width, height, PIXFORMAT_GRAYSCALE,
+                     ThumbnailConfig::JPEG_QUALITY, out, out_len);
+    }
+    if (!ok) {
+        error_ = "JPEG encode failed";
+        stats_.failed++;
+        return false;
+    }
+
+    stats_.encoded++;
+    stats_.last_size = *out_len;
+    stats_.avg_decode_us = movingAverage(stats_.avg_decode_us, (uint32_t)(decoded - start), stats_.encoded);
+    stats_.avg_encode_us = movingAverage(stats_.avg_encode_us, (uint32_t)(esp_timer_get_time() - decoded), stats_.encoded);
+    return true;
+}
+
+void Thumbnailer::printStatus(Print& out) const {
+    out.println("\n🖼️  === THUMBNAILS ===");
+    out.printf("Size: %ux%u, last JPEG %lu bytes\n", getWidth(), getHeight(), stats_.last_size);
+    out.printf("Encoded: %lu, failed: %lu%s%s\n", stats_.encoded, stats_.failed,
+               stats_.failed ? ", last error: " : "", stats_.failed ? error_ : "");
+    out.printf("Cost: DC decode %lu us + re-encode %lu us\n", stats_.avg_decode_us, stats_.avg_encode_us);
+    out.printf("Buffers: %s\n", rgb_ ? "allocated" : "not allocated (first request allocates)");
+    out.println("URL: http://192.168.4.1/thumb (?gray, ?stream)");
+}
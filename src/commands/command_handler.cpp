@@ -1,251 +1,981 @@
 // src/commands/command_handler.cpp - Расширенные команды для диагностики
 #include "command_handler.h"
 #include "system_manager.h"
+#include "camera_bench.h"
+#include "esp_timer.h"
 
-CommandHandler::CommandHandler() : systemManager(nullptr) {
+// Sorted by name for binary-search dispatch; order is checked at compile time
+#define COMMAND_SPEC(name, alias_of, group, usage, help, handler) \
+    {name, alias_of, CommandGroup::group, usage, help, &CommandHandler::handler},
+
+struct CommandTable {
+    static constexpr CommandSpec entries[] = {
+        COMMAND_TABLE(COMMAND_SPEC)
+    };
+
+    static constexpr size_t count = sizeof(entries) / sizeof(entries[0]);
+
+    static constexpr bool isSorted(size_t index = 1) {
+        return index >= count ||
+            (constexprStrcmp(entries[index - 1].name, entries[index].name) < 0 && isSorted(index + 1));
+    }
+
+    static const CommandSpec* find(const CommandToken& name) {
+        return findCommand(entries, count, name);
+    }
+};
+
+constexpr CommandSpec CommandTable::entries[];
+static_assert(CommandTable::isSorted(), "Command table must be sorted by name");
+
+CommandHandler::CommandHandler() : systemManager(nullptr), out(&Serial) {
 }
 
-void CommandHandler::processCommands() {
-    if (!Serial.available()) return;
-    
-    String command = Serial.readStringUntil('\n');
-    command.trim();
-    command.toLowerCase();
-    
-    if (command.isEmpty()) return;
-    
-    Serial.printf("[CMD] Выполняется команда: '%s'\n", command.c_str());
-    processCommand(command);
+void CommandHandler::beginNetwork(uint16_t port) {
+    controlChannel.begin(this, port);
 }
 
-void CommandHandler::processCommand(const String& command) {
+// Console RX callbacks run on the USB/UART event task and only post
+static EventLoop* console_events = nullptr;
+
+#if ARDUINO_USB_CDC_ON_BOOT
+static void onConsoleRx(void* arg, esp_event_base_t base, int32_t id, void* data) {
+    if (console_events) {
+        console_events->post(EventSource::SERIAL_RX);
+    }
+}
+#endif
+
+void CommandHandler::attachEvents(EventLoop& events) {
+    console_events = &events;
+#if ARDUINO_USB_CDC_ON_BOOT && ARDUINO_USB_MODE
+    Serial.onEvent(ARDUINO_HW_CDC_RX_EVENT, onConsoleRx);
+#elif ARDUINO_USB_CDC_ON_BOOT
+    Serial.onEvent(ARDUINO_USB_CDC_RX_EVENT, onConsoleRx);
+#else
+    Serial.onReceive([]() { console_events->post(EventSource::SERIAL_RX); });
+#endif
+    events.on(EventSource::SERIAL_RX, [this]() { processSerial(); });
+
+    // Network requests are executed on the loop task too, so every command runs there
+    events.on(EventSource::NET, [this]() { controlChannel.poll(); });
+
+    // Bytes that arrived before the callback was registered raise no event
+    events.addTimer("console", CommandConfig::CONSOLE_BACKSTOP_MS, [this]() {
+        if (Serial.available()) {
+            processSerial();
+        }
+    });
+}
+
+void CommandHandler::processSerial() {
+    while (Serial.available()) {
+        int c = Serial.read();
+        if (c < 0) break;
+        if (lineReader.feed((char)c)) {
+            processCommand(lineReader.line());
+            lineReader.clear();
+        }
+    }
+}
+
+void CommandHandler::processCommand(char* line) {
+    execute(line, Serial);
+}
+
+bool CommandHandler::execute(char* line, Print& output) {
+    out = &output;
+
     if (!systemManager) {
-        Serial.println("[ERROR] ❌ SystemManager не инициализирован!");
+        out->println("[ERROR] ❌ SystemManager не инициализирован!");
+        out = &Serial;
+        return false;
+    }
+
+    CommandToken tokens[CommandConfig::MAX_TOKENS];
+    CommandArgs args;
+    args.tokens = tokens;
+    args.count = tokenizeCommand(line, tokens, CommandConfig::MAX_TOKENS);
+    if (args.count == 0) {
+        out = &Serial;
+        return false;
+    }
+
+    Serial.printf("[CMD] Выполняется команда: '%s'\n", tokens[0].data);
+
+    const CommandSpec* spec = CommandTable::find(tokens[0]);
+    if (!spec) {
+        out->printf("[ERROR] Unknown command: '%s'. Type 'help' for available commands.\n",
+                    tokens[0].data);
+        out = &Serial;
+        return false;
+    }
+    (this->*spec->handler)(args);
+    out = &Serial;
+    return true;
+}
+
+// === КАМЕРА КОМАНДЫ ===
+
+void CommandHandler::handleStart(const CommandArgs& args) {
+    systemManager->getTaskManager().enableVideoStreaming();
+    out->println("[CMD] Video streaming started");
+}
+
+void CommandHandler::handleStop(const CommandArgs& args) {
+    systemManager->getTaskManager().disableVideoStreaming();
+    out->println("[CMD] Video streaming stopped");
+}
+
+void CommandHandler::handleReset(const CommandArgs& args) {
+    auto& camera = systemManager->getCamera();
+    out->println("[CMD] Resetting camera in place (profile and ROI are kept)...");
+    if (camera.recover("manual")) {
+        out->printf("[SUCCESS] Camera reset successful in %lu ms\n", camera.getRecoveryStats().last_ms);
+    } else {
+        out->printf("[ERROR] Camera reset failed: %s\n", 
+                     camera.getLastErrorMessage().c_str());
+    }
+}
+
+void CommandHandler::handleCameraWatchdog(const CommandArgs& args) {
+    auto& camera = systemManager->getCamera();
+    if (args.argc() > 0) {
+        if (!args.arg(0).equals("on") && !args.arg(0).equals("off")) {
+            out->println("[ERROR] Usage: camwd [on|off]");
+            return;
+        }
+        camera.setWatchdogEnabled(args.arg(0).equals("on"));
+    }
+    const CameraRecoveryStats& recovery = camera.getRecoveryStats();
+    out->printf("[CAMERA] Watchdog: %s (streak %u, stall %lu ms)\n", camera.isWatchdogEnabled() ? "ON" : "OFF",
+                CameraWatchdogConfig::FAILURE_STREAK, CameraWatchdogConfig::STALL_MS);
+    out->printf("[CAMERA] Recoveries: %lu, failed: %lu, last: %s, %lu ms (%lu s ago), max: %lu ms\n",
+                recovery.recoveries, recovery.failed, recovery.last_reason, recovery.last_ms,
+                recovery.last_at_ms ? (millis() - recovery.last_at_ms) / 1000 : 0, recovery.max_ms);
+}
+
+void CommandHandler::handleJpegCheck(const CommandArgs& args) {
+    auto& camera = systemManager->getCamera();
+    static const char* const modes[] = {"off", "fast", "strict"};
+    if (args.argc() > 0) {
+        size_t i = 0;
+        while (i < 3 && !args.arg(0).equals(modes[i])) i++;
+        if (i == 3) {
+            out->println("[ERROR] Usage: jpegcheck [off|fast|strict]");
+            return;
+        }
+        camera.setJpegValidation((JpegValidation)i);
+    }
+    FrameStats stats = camera.getStatistics();
+    out->printf("[CAMERA] JPEG validation: %s, corrupt %lu, trimmed %lu, last reject: %s\n",
+                modes[(size_t)camera.getJpegValidation()], stats.corrupt_frames, stats.trimmed_frames,
+                jpegCheckName(camera.getLastJpegReject()));
+    out->printf("[CAMERA] Validation cost: %lu cycles (%lu us) per frame\n",
+                stats.avg_validate_cycles, stats.avg_validate_cycles / ESP.getCpuFreqMHz());
+}
+
+void CommandHandler::printRegionOfInterest() {
+    const RegionOfInterest& roi = systemManager->getCamera().getRegionOfInterest();
+    if (!roi.active) {
+        out->println("[CAMERA] ROI: off (full field of view)");
         return;
     }
-    
-    // === СПРАВОЧНЫЕ КОМАНДЫ ===
-    if (command == "help" || command == "?") {
-        showHelp();
+    static const char* const modes[] = {"UXGA", "SVGA", "CIF"};
+    out->printf("[CAMERA] ROI: %ux%u at %u,%u -> %ux%u, zoom %.2fx, %s readout, applied in %lu us\n",
+                roi.width, roi.height, roi.x, roi.y, roi.output_width, roi.output_height,
+                roi.zoom, modes[roi.mode], roi.apply_us);
+}
+
+void CommandHandler::handleRoi(const CommandArgs& args) {
+    auto& camera = systemManager->getCamera();
+    if (args.argc() == 1 && args.arg(0).equals("off")) {
+        if (!camera.clearRegionOfInterest()) {
+            out->printf("[ERROR] ❌ %s\n", camera.getLastErrorMessage().c_str());
+            return;
+        }
+    } else if (args.argc() == 4 || args.argc() == 6) {
+        long values[6] = {0, 0, 0, 0, 0, 0};
+        for (size_t i = 0; i < args.argc(); i++) {
+            if (!args.arg(i).toInt(values[i]) || values[i] < 0 || values[i] > SensorWindow::SENSOR_WIDTH) {
+                out->println("[ERROR] Usage: roi <x> <y> <w> <h> [out_w out_h] | roi off (UXGA coordinates)");
+                return;
+            }
+        }
+        // Without an explicit output size the window is encoded 1:1
+        if (args.argc() == 4) {
+            values[4] = values[2];
+            values[5] = values[3];
+        }
+        if (!camera.setRegionOfInterest(values[0], values[1], values[2], values[3], values[4], values[5])) {
+            out->printf("[ERROR] ❌ %s\n", camera.getLastErrorMessage().c_str());
+            return;
+        }
+    } else if (args.argc() != 0) {
+        out->println("[ERROR] Usage: roi <x> <y> <w> <h> [out_w out_h] | roi off (UXGA coordinates)");
         return;
     }
-    
-    // === СИСТЕМНЫЕ КОМАНДЫ ===
-    if (command == "status" || command == "info") {
-        handleSystemCommands(command);
+    printRegionOfInterest();
+}
+
+void CommandHandler::handleZoom(const CommandArgs& args) {
+    auto& camera = systemManager->getCamera();
+    long percent = 0;
+    long center_x = 50;
+    long center_y = 50;
+    if (args.argc() == 1 && args.arg(0).equals("off")) {
+        camera.clearRegionOfInterest();
+    } else if (args.argc() > 0) {
+        bool valid = args.arg(0).toInt(percent) &&
+                     (args.argc() == 1 || (args.argc() == 3 && args.arg(1).toInt(center_x) && args.arg(2).toInt(center_y)));
+        if (!valid || center_x < 0 || center_x > 100 || center_y < 0 || center_y > 100) {
+            out->println("[ERROR] Usage: zoom <100-800> [cx cy] (percent) | zoom off");
+            return;
+        }
+        if (!camera.setDigitalZoom(percent / 100.0f, center_x / 100.0f, center_y / 100.0f)) {
+            out->printf("[ERROR] ❌ %s\n", camera.getLastErrorMessage().c_str());
+            return;
+        }
+    }
+    printRegionOfInterest();
+}
+
+void CommandHandler::handleThumb(const CommandArgs& args) {
+    systemManager->getMJPEGServer().getThumbnailer().printStatus(*out);
+}
+
+void CommandHandler::handleTrace(const CommandArgs& args) {
+    auto& server = systemManager->getMJPEGServer();
+    if (args.argc() == 0) {
+        server.printTrace(*out);
         return;
     }
-    
-    if (command == "restart" || command == "reboot") {
-        Serial.println("[CMD] 🔄 Перезагрузка системы через 3 секунды...");
-        delay(3000);
-        ESP.restart();
+
+    const CommandToken& action = args.arg(0);
+    if (action.equals("start")) {
+        long megabytes = FrameTraceConfig::DEFAULT_CAPACITY / (1024 * 1024);
+        if (args.argc() > 1 && (!args.arg(1).toInt(megabytes) || megabytes < 1 ||
+                                (size_t)megabytes * 1024 * 1024 > FrameTraceConfig::MAX_CAPACITY)) {
+            out->printf("[ERROR] Trace size must be 1-%u MB\n",
+                        (unsigned)(FrameTraceConfig::MAX_CAPACITY / (1024 * 1024)));
+            return;
+        }
+        if (!server.startTrace((size_t)megabytes * 1024 * 1024)) {
+            out->println("[ERROR] Not enough PSRAM for the trace buffer");
+            return;
+        }
+        out->printf("[TRACE] Recording streamed frames into %ld MB (needs a /stream viewer)\n", megabytes);
+    } else if (action.equals("stop")) {
+        server.stopTrace();
+        server.printTrace(*out);
+    } else if (action.equals("clear")) {
+        server.clearTrace();
+        out->println("[TRACE] Trace buffer freed");
+    } else {
+        out->println("[ERROR] Usage: trace [start [mb]|stop|clear]");
+    }
+}
+
+void CommandHandler::handleMotion(const CommandArgs& args) {
+    auto& analyzer = systemManager->getFrameAnalyzer();
+    if (args.argc() == 0) {
+        analyzer.printStatus(*out);
         return;
     }
-    
-    if (command == "memory" || command == "mem") {
-        showMemoryInfo();
+
+    const CommandToken& action = args.arg(0);
+    long interval = 0;
+    if (action.equals("on") || action.equals("off")) {
+        analyzer.setEnabled(action.equals("on"));
+        out->printf("[MOTION] Analysis: %s\n", analyzer.isEnabled() ? "ON" : "OFF");
+    } else if (action.equals("skip")) {
+        analyzer.setSkipStatic(!analyzer.isSkipStatic());
+        out->printf("[MOTION] Skip static frames: %s (keepalive every %lu ms)\n",
+                    analyzer.isSkipStatic() ? "ON" : "OFF", AnalyzerConfig::KEEPALIVE_MS);
+    } else if (action.equals("every") && args.argc() > 1 && args.arg(1).toInt(interval) &&
+               interval >= 1 && interval <= 30) {
+        analyzer.setInterval((uint8_t)interval);
+        out->printf("[MOTION] Analyzing every %u frame(s)\n", analyzer.getInterval());
+    } else if (action.equals("reset")) {
+        analyzer.resetStats();
+        out->println("[MOTION] Statistics reset");
+    } else {
+        out->println("[ERROR] Usage: motion [on|off|skip|every <1-30>|reset]");
+    }
+}
+
+void CommandHandler::handlePipelineMode(const CommandArgs& args) {
+    MJPEGServer& server = systemManager->getMJPEGServer();
+    if (args.argc() == 0) {
+        const DriverSettings& settings = systemManager->getCamera().getDriverSettings();
+        out->printf("[PIPELINE] Mode: %s (%u frame buffers, grab %s, TCP_NODELAY %s)\n",
+                    pipelineModeName(server.getPipelineMode()), settings.fb_count,
+                    settings.grab_mode == CAMERA_GRAB_LATEST ? "latest" : "when empty",
+                    server.getPipelineMode() == PipelineMode::LATENCY ? "on" : "off");
+        server.printPacing(*out);
         return;
     }
-    
-    if (command == "uptime") {
-        showUptimeInfo();
+
+    PipelineMode mode;
+    if (args.arg(0).equals("latency")) {
+        mode = PipelineMode::LATENCY;
+    } else if (args.arg(0).equals("throughput")) {
+        mode = PipelineMode::THROUGHPUT;
+    } else {
+        out->println("[ERROR] Usage: pipeline [latency|throughput]");
         return;
     }
-    
-    // === КАМЕРА КОМАНДЫ ===
-    if (command.startsWith("cam") || command == "start" || command == "stop" || 
-        command == "reset" || command == "quality" || command == "stats" || 
-        command == "verbose" || command == "clear" || command == "fps") {
-        handleCameraCommands(command);
+    if (server.setPipelineMode(mode)) {
+        out->printf("[PIPELINE] ✅ Mode: %s\n", pipelineModeName(mode));
+    } else {
+        out->println("[PIPELINE] ❌ Not switched: camera not ready or raw pipeline running");
+    }
+}
+
+void CommandHandler::handleFps(const CommandArgs& args) {
+    FrameStats stats = systemManager->getCamera().getStatistics();
+    out->printf("[CAMERA] FPS: %.2f, Frames: %lu, Dropped: %lu\n",
+                 stats.current_fps, stats.total_frames, stats.dropped_frames);
+}
+
+void CommandHandler::handleStats(const CommandArgs& args) {
+    FrameStats stats = systemManager->getCamera().getStatistics();
+    out->println("=== Camera Performance Statistics ===");
+    out->printf("Total frames: %lu\n", stats.total_frames);
+    out->printf("Dropped frames: %lu (%.2f%%)\n", stats.dropped_frames,
+                stats.total_frames > 0 ? (stats.dropped_frames * 100.0f / stats.total_frames) : 0.0f);
+    out->printf("Corrupt frames: %lu, trimmed: %lu (validation ~%lu cycles/frame)\n",
+                stats.corrupt_frames, stats.trimmed_frames, stats.avg_validate_cycles);
+    const CameraRecoveryStats& recovery = systemManager->getCamera().getRecoveryStats();
+    out->printf("Watchdog: %s, recoveries %lu (failed %lu), last %lu ms (%s), max %lu ms\n",
+                systemManager->getCamera().isWatchdogEnabled() ? "ON" : "OFF",
+                recovery.recoveries, recovery.failed, recovery.last_ms, recovery.last_reason, recovery.max_ms);
+    out->printf("Current FPS: %.2f\n", stats.current_fps);
+    out->printf("Average frame size: %lu bytes\n", stats.avg_frame_size);
+    out->printf("Min free heap: %lu bytes\n", stats.min_heap);
+    out->printf("Max frame time: %lu ms\n", stats.max_frame_time);
+    out->printf("Uptime: %lu seconds\n", (millis() - stats.last_reset_time) / 1000);
+    out->println("=====================================");
+}
+
+void CommandHandler::handleClear(const CommandArgs& args) {
+    systemManager->getCamera().resetStatistics();
+    out->println("[CMD] Statistics cleared");
+}
+
+void CommandHandler::handleQuality(const CommandArgs& args) {
+    auto& camera = systemManager->getCamera();
+
+    if (args.argc() == 0) {
+        sensor_t* sensor = esp_camera_sensor_get();
+        out->printf("[CAMERA] JPEG quality: %d (usage: quality <0-63>, lower=better)\n",
+                     sensor ? sensor->status.quality : -1);
         return;
     }
-    
-    // === WiFi КОМАНДЫ ===
-    if (command.startsWith("wifi") || command == "clients") {
-        handleWiFiCommands(command);
+
+    long quality = 0;
+    if (!args.arg(0).toInt(quality) || quality < 0 || quality > 63) {
+        out->printf("[ERROR] Invalid quality '%s' (expected 0-63)\n", args.arg(0).data);
         return;
     }
 
-    if (command.startsWith("fc")) {
-        handleFlightControllerCommands(command);
+    if (camera.setJpegQuality((uint8_t)quality)) {
+        out->printf("[SUCCESS] JPEG quality set to %ld\n", quality);
+    } else {
+        out->printf("[ERROR] Failed to set quality: %s\n", 
+                     camera.getLastErrorMessage().c_str());
+    }
+}
+
+void CommandHandler::handleGrayscale(const CommandArgs& args) {
+    auto& camera = systemManager->getCamera();
+    out->println("[CMD] 🎬 Switching to GRAYSCALE mode...");
+    if (camera.setGrayscaleMode(true)) {
+        out->println("[SUCCESS] ✅ Grayscale mode enabled");
+        out->println("[INFO] 📊 JPEG files will be 30-50% smaller");
+        out->println("[INFO] 🚀 Better WebSocket stability with large scenes");
+    } else {
+        out->printf("[ERROR] ❌ Failed to enable grayscale: %s\n", 
+                     camera.getLastErrorMessage().c_str());
+    }
+}
+
+void CommandHandler::handleColor(const CommandArgs& args) {
+    auto& camera = systemManager->getCamera();
+    out->println("[CMD] 🌈 Switching to COLOR mode...");
+    if (camera.setGrayscaleMode(false)) {
+        out->println("[SUCCESS] ✅ Color mode enabled");
+        out->println("[INFO] 🎨 Full color video streaming");
+        out->println("[WARNING] ⚠️  Larger JPEG files - may cause disconnects");
+    } else {
+        out->printf("[ERROR] ❌ Failed to enable color: %s\n", 
+                     camera.getLastErrorMessage().c_str());
+    }
+}
+
+void CommandHandler::handleProfile(const CommandArgs& args) {
+    auto& camera = systemManager->getCamera();
+    if (args.argc() > 0 && args.arg(0).equals("resync")) {
+        camera.resyncSensorShadow();
+        out->println("[PROFILE] Shadow reloaded from driver status");
         return;
     }
-    
-    // WebSocket commands
-    if (command.startsWith("web") || command == "clients" || command.startsWith("ws")) {
-        handleMJPEGCommands(command);
+
+    if (args.argc() > 0) {
+        const CommandToken& name = args.arg(0);
+        const SensorProfile* profile = SensorProfiles::find(name.data, name.length);
+        if (!profile) {
+            out->println("[ERROR] Unknown profile, see 'profile' for the list");
+            return;
+        }
+        bool ok = camera.applyProfile(*profile);
+        const SensorSwitchStats& st = camera.getProfileStats();
+        out->printf("[PROFILE] %s %s: %u write(s), %u unchanged, VSYNC wait %lu us, applied in %lu us\n",
+                    profile->name, ok ? "applied" : "FAILED", (unsigned)st.last_writes,
+                    (unsigned)(profile->count - st.last_writes), st.last_wait_us, st.last_apply_us);
         return;
     }
-    
-    Serial.printf("[ERROR] Unknown command: '%s'. Type 'help' for available commands.\n", 
-                 command.c_str());
+
+    const SensorSwitchStats& st = camera.getProfileStats();
+    out->printf("[PROFILE] Last: %s, switches %lu, writes %lu, skipped %lu, failed %lu, VSYNC timeouts %lu\n",
+                st.last_profile, st.switches, st.writes, st.skipped_writes, st.failed_writes, st.vblank_timeouts);
+    out->printf("[PROFILE] Last switch: %lu us VSYNC wait + %lu us SCCB (max %lu us)\n",
+                st.last_wait_us, st.last_apply_us, st.max_apply_us);
+
+    const SensorShadow& shadow = camera.getSensorShadow();
+    for (size_t i = 0; i < SensorProfiles::count(); i++) {
+        const SensorProfile& profile = SensorProfiles::at(i);
+        SensorDiff diff;
+        shadow.compile(profile, diff);
+        out->printf("  %-10s %-32s %u change(s)\n", profile.name, profile.description, (unsigned)diff.count);
+    }
 }
 
-void CommandHandler::handleCameraCommands(const String& command) {
+void CommandHandler::handleBench(const CommandArgs& args) {
     auto& camera = systemManager->getCamera();
-    auto& taskManager = systemManager->getTaskManager();
-    
-    if (command == "start") {
-        taskManager.enableVideoStreaming();
-        Serial.println("[CMD] Video streaming started");
-    }
-    else if (command == "stop") {
-        taskManager.disableVideoStreaming();
-        Serial.println("[CMD] Video streaming stopped");
-    }
-    else if (command == "reset") {
-        Serial.println("[CMD] Resetting camera...");
-        camera.deinitialize();
-        delay(1000);
-        if (camera.initialize()) {
-            Serial.println("[SUCCESS] Camera reset successful");
-        } else {
-            Serial.printf("[ERROR] Camera reset failed: %s\n", 
-                         camera.getLastErrorMessage().c_str());
+    if (systemManager->getRawPipeline().isRunning()) {
+        out->println("[BENCH] Raw pipeline owns the camera, 'rawpipe off' first");
+        return;
+    }
+
+    CameraBenchMatrix matrix;
+    matrix.reset(camera.getDriverSettings());
+    for (size_t i = 0; i < args.argc(); i++) {
+        const CommandToken& token = args.arg(i);
+        const char* equals = (const char*)memchr(token.data, '=', token.length);
+        char key[8];
+        size_t key_length = equals ? (size_t)(equals - token.data) : 0;
+        if (key_length == 0 || key_length >= sizeof(key)) {
+            out->printf("[ERROR] Expected key=value, got '%s'\n", token.data);
+            return;
+        }
+        memcpy(key, token.data, key_length);
+        key[key_length] = '\0';
+        if (!matrix.set(key, equals + 1, token.length - key_length - 1)) {
+            out->printf("[ERROR] Bad value list in '%s' (size=hd,vga q=0-63 fb=1-4 grab=empty,latest xclk=%lu-%lu n=1-%u)\n",
+                        token.data, DriverLimits::MIN_XCLK_HZ / 1000000, DriverLimits::MAX_XCLK_HZ / 1000000,
+                        (unsigned)CameraBenchConfig::MAX_FRAMES);
+            return;
         }
     }
-    else if (command == "stats") {
-        camera.logDetailedStats();
+
+    size_t combinations = matrix.combinations();
+    if (combinations > CameraBenchConfig::MAX_COMBINATIONS) {
+        out->printf("[ERROR] %u combinations, at most %u\n", (unsigned)combinations,
+                    (unsigned)CameraBenchConfig::MAX_COMBINATIONS);
+        return;
     }
-    else if (command == "clear") {
-        camera.resetStatistics();
-        Serial.println("[CMD] Statistics cleared");
+    out->printf("# %u combination(s) x %u frames; streaming pauses until the sweep ends\n",
+                (unsigned)combinations, matrix.frames);
+    if (!CameraBench::run(camera, matrix, *out)) {
+        out->println("[ERROR] Camera not initialized");
     }
-    else if (command == "quality") {
-        Serial.println("[CMD] Enter JPEG quality (0-63, lower=better): ");
-        while (!Serial.available()) delay(10);
-        int quality = Serial.parseInt();
-        if (camera.setJpegQuality(quality)) {
-            Serial.printf("[SUCCESS] JPEG quality set to %d\n", quality);
-        } else {
-            Serial.printf("[ERROR] Failed to set quality: %s\n", 
-                         camera.getLastErrorMessage().c_str());
-        }
+}
+
+void CommandHandler::handleRawPipeline(const CommandArgs& args) {
+    auto& pipeline = systemManager->getRawPipeline();
+    auto& camera = systemManager->getCamera();
+    if (args.argc() == 0) {
+        pipeline.printStatus(*out);
+        return;
     }
-    else if (command == "verbose") {
-        taskManager.toggleVerboseLogging();
-        Serial.printf("[CMD] Verbose logging: %s\n", 
-                     taskManager.isVerboseLogging() ? "ON" : "OFF");
+
+    const CommandToken& action = args.arg(0);
+    if (action.equals("on")) {
+        pixformat_t format = RawPipelineConfig::DEFAULT_FORMAT;
+        framesize_t size = RawPipelineConfig::DEFAULT_FRAME_SIZE;
+        for (size_t i = 1; i < args.argc(); i++) {
+            const CommandToken& option = args.arg(i);
+            if (option.equals("rgb")) format = PIXFORMAT_RGB565;
+            else if (option.equals("yuv")) format = PIXFORMAT_YUV422;
+            else if (option.equals("qvga")) size = FRAMESIZE_QVGA;
+            else if (option.equals("hvga")) size = FRAMESIZE_HVGA;
+            else if (option.equals("vga")) size = FRAMESIZE_VGA;
+            else {
+                out->printf("[ERROR] Unknown option '%s' (rgb|yuv, qvga|hvga|vga)\n", option.data);
+                return;
+            }
+        }
+        if (pipeline.isRunning()) {
+            out->println("[RAW] Already running, 'rawpipe off' first");
+            return;
+        }
+        out->println(pipeline.start(&camera, format, size) ? "[RAW] ✅ Streaming raw pipeline frames"
+                                                            : "[ERROR] Raw pipeline did not start");
+    } else if (action.equals("off")) {
+        pipeline.stop();
+        out->println("[RAW] Sensor JPEG path restored");
+    } else if (action.equals("osd")) {
+        pipeline.setOsdEnabled(!pipeline.isOsdEnabled());
+        out->printf("[RAW] OSD: %s\n", pipeline.isOsdEnabled() ? "ON" : "OFF");
+    } else if (action.equals("bench")) {
+        long seconds = 5;
+        if (args.argc() > 1 && (!args.arg(1).toInt(seconds) || seconds < 1 || seconds > 30)) {
+            out->println("[ERROR] Bench duration must be 1-30 s");
+            return;
+        }
+        if (pipeline.isRunning()) {
+            out->println("[RAW] Bench compares both paths, 'rawpipe off' first");
+            return;
+        }
+        runRawPipelineBench((uint32_t)seconds * 1000);
+    } else {
+        out->println("[ERROR] Usage: rawpipe [on [rgb|yuv] [qvga|hvga|vga]|off|osd|bench [1-30]]");
     }
-    else if (command == "grayscale" || command == "bw") {
-        Serial.println("[CMD] 🎬 Switching to GRAYSCALE mode...");
-        if (camera.setGrayscaleMode(true)) {
-            Serial.println("[SUCCESS] ✅ Grayscale mode enabled");
-            Serial.println("[INFO] 📊 JPEG files will be 30-50% smaller");
-            Serial.println("[INFO] 🚀 Better WebSocket stability with large scenes");
-        } else {
-            Serial.printf("[ERROR] ❌ Failed to enable grayscale: %s\n", 
-                         camera.getLastErrorMessage().c_str());
+}
+
+// Blocks the console for two windows: sensor JPEG frames pulled as fast as the
+// driver delivers them, then frames the raw pipeline publishes (default format)
+void CommandHandler::runRawPipelineBench(uint32_t window_ms) {
+    auto& pipeline = systemManager->getRawPipeline();
+    auto& camera = systemManager->getCamera();
+
+    out->printf("[RAW] Bench: %lu ms per path...\n", window_ms);
+    uint32_t sensor_frames = 0;
+    uint64_t sensor_bytes = 0;
+    uint32_t start = millis();
+    while (millis() - start < window_ms) {
+        camera_fb_t* fb = camera.getFrameBuffer();
+        if (fb) {
+            sensor_frames++;
+            sensor_bytes += fb->len;
+            camera.returnFrameBuffer(fb);
         }
     }
-    else if (command == "color" || command == "rgb") {
-        Serial.println("[CMD] 🌈 Switching to COLOR mode...");
-        if (camera.setGrayscaleMode(false)) {
-            Serial.println("[SUCCESS] ✅ Color mode enabled");
-            Serial.println("[INFO] 🎨 Full color video streaming");
-            Serial.println("[WARNING] ⚠️  Larger JPEG files - may cause disconnects");
+    float sensor_fps = sensor_frames * 1000.0f / window_ms;
+
+    if (!pipeline.start(&camera)) {
+        out->println("[ERROR] Raw pipeline did not start");
+        return;
+    }
+    uint32_t raw_frames = 0;
+    uint64_t raw_bytes = 0;
+    uint32_t seq = 0;
+    start = millis();
+    while (millis() - start < window_ms) {
+        camera_fb_t* fb = pipeline.acquireFrame(seq);
+        if (fb) {
+            raw_frames++;
+            raw_bytes += fb->len;
+            pipeline.releaseFrame();
         } else {
-            Serial.printf("[ERROR] ❌ Failed to enable color: %s\n", 
-                         camera.getLastErrorMessage().c_str());
+            vTaskDelay(1);
         }
     }
+    RawPipelineStats stats = pipeline.getStats();
+    pipeline.stop();
+
+    out->printf("[RAW] Sensor JPEG  : %5.1f fps, avg %lu bytes\n", sensor_fps,
+                sensor_frames ? (uint32_t)(sensor_bytes / sensor_frames) : 0);
+    out->printf("[RAW] Raw pipeline : %5.1f fps, avg %lu bytes (%lu encode failures)\n",
+                raw_frames * 1000.0f / window_ms, raw_frames ? (uint32_t)(raw_bytes / raw_frames) : 0,
+                stats.encode_failed);
+    out->printf("[RAW] Stages: copy %lu us | convert %lu + OSD %lu + JPEG %lu us\n",
+                stats.avg_copy_us, stats.avg_convert_us, stats.avg_osd_us, stats.avg_encode_us);
 }
 
-void CommandHandler::handleWiFiCommands(const String& command) {
+// === WiFi КОМАНДЫ ===
+
+void CommandHandler::handleWiFiStatus(const CommandArgs& args) {
     auto& wifi = systemManager->getWiFi();
-    
-    if (command == "wifi") {
-        Serial.printf("[WiFi] 📡 SSID: ESP32-S3_Drone_30fps\n");
-        Serial.printf("[WiFi] 🌐 IP: %s\n", WiFi.softAPIP().toString().c_str());
-        Serial.printf("[WiFi] 👥 Connected clients: %d\n", WiFi.softAPgetStationNum());
-        Serial.printf("[WiFi] 📶 Channel: %d\n", WiFi.channel());
-        Serial.printf("[WiFi] 📊 Mode: %s\n", (WiFi.getMode() & WIFI_AP) ? "AP active" : "AP inactive");
-        Serial.printf("[WiFi] 🔋 Power: %d dBm\n", WiFi.getTxPower());
-        Serial.printf("[WiFi] ✅ Stability: %s\n", wifi.isConnected() ? "STABLE" : "ISSUES");
-    }
-    else if (command == "wifireset") {
-        Serial.println("[WiFi] 🔄 Full WiFi configuration reset...");
-        wifi.stop();
-        delay(1000);
-        wifi.init("ESP32-S3_Drone_30fps", "drone2024");
-        delay(500);
-        wifi.start();
-        Serial.println("[WiFi] ✅ WiFi restarted. Try connecting again.");
-    }
-    else if (command == "wificlients") {
+    out->printf("[WiFi] 📡 SSID: ESP32-S3_Drone_30fps\n");
+    out->printf("[WiFi] 🌐 IP: %s\n", WiFi.softAPIP().toString().c_str());
+    out->printf("[WiFi] 👥 Connected clients: %d\n", WiFi.softAPgetStationNum());
+    out->printf("[WiFi] 📶 Channel: %d (recommended: %d)\n", wifi.getChannel(), wifi.recommendChannel());
+    out->printf("[WiFi] 📊 Mode: %s\n", (WiFi.getMode() & WIFI_AP) ? "AP active" : "AP inactive");
+    out->printf("[WiFi] 🔋 Power: %d dBm\n", WiFi.getTxPower());
+    out->printf("[WiFi] ✅ Stability: %s\n", wifi.isConnected() ? "STABLE" : "ISSUES");
+}
+
+void CommandHandler::handleWiFiReset(const CommandArgs& args) {
+    auto& wifi = systemManager->getWiFi();
+    out->println("[WiFi] 🔄 Full WiFi configuration reset...");
+    wifi.stop();
+    delay(1000);
+    wifi.init("ESP32-S3_Drone_30fps", "drone2024");
+    delay(500);
+    wifi.start();
+    out->println("[WiFi] ✅ WiFi restarted. Try connecting again.");
+}
+
+void CommandHandler::handleWiFiClients(const CommandArgs& args) {
+    auto& wifi = systemManager->getWiFi();
+    if (args.tokens[0].equals("clients")) {
+        wifi.showConnectedClients(*out);
+    } else {
         wifi.checkStability();
     }
 }
 
-void CommandHandler::handleMJPEGCommands(const String& command) {
-    if (command == "mjpegstatus") {
-        Serial.println("[MJPEG] MJPEG server is RUNNING on port 80");
-        Serial.println("[MJPEG] Stream URL: http://192.168.4.1/stream");
+void CommandHandler::handleWiFiScan(const CommandArgs& args) {
+    systemManager->getWiFi().scanNetworks(*out);
+}
+
+void CommandHandler::handleWiFiSurvey(const CommandArgs& args) {
+    systemManager->getWiFi().printChannelSurvey(*out);
+}
+
+void CommandHandler::handleWiFiBest(const CommandArgs& args) {
+    auto& wifi = systemManager->getWiFi();
+    wifi.requestChannelSwitch(wifi.recommendChannel());
+}
+
+void CommandHandler::handleWiFiAuto(const CommandArgs& args) {
+    auto& wifi = systemManager->getWiFi();
+    wifi.setSurveyEnabled(!wifi.isSurveyEnabled());
+    out->printf("[WiFi] Фоновый обзор каналов: %s\n", wifi.isSurveyEnabled() ? "ON" : "OFF");
+}
+
+void CommandHandler::handleMJPEGStatus(const CommandArgs& args) {
+    auto& server = systemManager->getMJPEGServer();
+    if (args.argc() > 0 && args.arg(0).equals("reset")) {
+        server.resetPacing();
+        out->println("[PACING] Statistics reset");
+        return;
+    }
+    out->println("[MJPEG] MJPEG server is RUNNING on port 80");
+    out->println("[MJPEG] Stream URL: http://192.168.4.1/stream");
+    out->printf("[CTRL] UDP command channel: %s, port %u, requests %lu, rejected %lu\n",
+                controlChannel.isRunning() ? "RUNNING" : "STOPPED", controlChannel.getPort(),
+                controlChannel.getRequestCount(), controlChannel.getRejectedCount());
+    server.printPacing(*out);
+}
+
+// "aa:bb:cc:dd:ee:ff" -> 6 bytes
+static bool parseMac(const CommandToken& token, uint8_t mac[6]) {
+    if (token.length != 17) {
+        return false;
+    }
+    for (size_t i = 0; i < 6; i++) {
+        const char* p = token.data + i * 3;
+        if (i < 5 && p[2] != ':') {
+            return false;
+        }
+        uint8_t value = 0;
+        for (size_t k = 0; k < 2; k++) {
+            char c = p[k];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= (uint8_t)(c - '0');
+            else if (c >= 'a' && c <= 'f') value |= (uint8_t)(c - 'a' + 10);
+            else return false;
+        }
+        mac[i] = value;
+    }
+    return true;
+}
+
+void CommandHandler::handleViewers(const CommandArgs& args) {
+    auto& server = systemManager->getMJPEGServer();
+    auto& policy = server.getViewerPolicy();
+    if (args.argc() == 0) {
+        server.printViewers(*out);
+        return;
+    }
+
+    const CommandToken& action = args.arg(0);
+    uint8_t mac[6];
+    long fps = 0;
+    long kbps = 0;
+    if (action.equals("token") && args.argc() > 1) {
+        const CommandToken& token = args.arg(1);
+        if (token.equals("off")) {
+            policy.clearPilotToken();
+            out->println("[VIEWERS] Pilot token cleared");
+        } else {
+            policy.setPilotToken(token.data, token.length);
+            out->println("[VIEWERS] Pilot token set, connect with /stream?token=<t>");
+        }
+    } else if (action.equals("pilot") && args.argc() > 1 && parseMac(args.arg(1), mac)) {
+        out->println(policy.addPilotMac(mac) ? "[VIEWERS] Pilot MAC added (applies on next connect)"
+                                             : "[ERROR] Pilot MAC list is full");
+    } else if (action.equals("unpilot") && args.argc() > 1 && parseMac(args.arg(1), mac)) {
+        out->println(policy.removePilotMac(mac) ? "[VIEWERS] Pilot MAC removed" : "[ERROR] MAC not in pilot list");
+    } else if (action.equals("observer") && args.argc() > 2 && args.arg(1).toInt(fps) && args.arg(2).toInt(kbps) &&
+               fps >= 1 && fps <= 30 && kbps >= 16 && kbps <= 4096) {
+        policy.setObserverLimits(1000 / fps, (uint32_t)kbps * 1024);
+        out->printf("[VIEWERS] Observers: up to %ld FPS, %ld KB/s\n", fps, kbps);
+    } else {
+        out->println("[ERROR] Usage: viewers [token <t>|token off|pilot <mac>|unpilot <mac>|observer <1-30> <16-4096>]");
     }
 }
 
-void CommandHandler::handleFlightControllerCommands(const String& command) {
+void CommandHandler::handleFlightControllerTest(const CommandArgs& args) {
+    systemManager->getFlightController().testConnection(*out);
+    out->println("[CMD] Sent test command to flight controller.");
+}
+
+void CommandHandler::handleFlightControllerBaud(const CommandArgs& args) {
     auto& fc = systemManager->getFlightController();
-    
-    if (command == "fctest") {
-        fc.testConnection();
-        Serial.println("[CMD] Sent test command to flight controller.");
-    }
-}
-
-void CommandHandler::handleSystemCommands(const String& command) {
-    if (command == "status" || command == "info") {
-        systemManager->printSystemStatus();
-    }
-}
-
-void CommandHandler::showHelp() {
-    Serial.println("\n🚁 ===== ESP32-S3 FPV DRONE CAMERA КОМАНДЫ =====");
-    Serial.println();
-    Serial.println("📷 УПРАВЛЕНИЕ КАМЕРОЙ:");
-    Serial.println("  start         - ▶️  Запустить видео стриминг");
-    Serial.println("  stop          - ⏹️  Остановить видео стриминг");  
-    Serial.println("  reset         - 🔄 Перезапустить модуль камеры");
-    Serial.println("  fps           - 📊 Показать текущий FPS");
-    Serial.println("  quality       - 🎨 Установить качество JPEG (0-63)");
-    Serial.println("  grayscale/bw  - 🎬 Черно-белый режим (меньше размер)");
-    Serial.println("  color/rgb     - 🌈 Цветной режим (больше размер)");
-    Serial.println("  stats         - 📈 Статистика камеры");
-    Serial.println();
-    Serial.println("🌐 СЕТЬ И ПОДКЛЮЧЕНИЯ:");
-    Serial.println("  wifi          - 📶 Статус WiFi точки доступа"); 
-    Serial.println("  clients       - 👥 Список подключенных клиентов");
-    Serial.println("  ws            - 🔌 Статус WebSocket сервера");
-    Serial.println();
-    Serial.println("🖥️  СИСТЕМА И ДИАГНОСТИКА:");
-    Serial.println("  status        - ℹ️  Полный статус системы");
-    Serial.println("  memory        - 💾 Использование памяти");
-    Serial.println("  uptime        - ⏱️  Время работы системы");
-    Serial.println("  restart       - 🔄 Перезагрузка ESP32-S3");
-    Serial.println();
-    Serial.println("🛠️  ОТЛАДКА:");
-    Serial.println("  verbose       - 🔍 Переключить подробные логи");
-    Serial.println("  clear         - 🧹 Очистить экран");
-    Serial.println("  help          - ❓ Показать эту справку");
-    Serial.println();
-    Serial.println("💡 ПРИМЕРЫ:");
-    Serial.println("  > status      # Показать статус всех модулей");  
-    Serial.println("  > fps         # Узнать текущую частоту кадров");
-    Serial.println("  > grayscale   # Включить ч/б режим (стабильнее)");
-    Serial.println("  > color       # Включить цветной режим");
-    Serial.println("  > clients     # Сколько устройств подключено");
-    Serial.println("  > memory      # Проверить свободную память");
-    Serial.println();
-    Serial.println("🌐 ПОДКЛЮЧЕНИЕ К ДРОНУ:");
-    Serial.println("  WiFi:    ESP32-S3_Drone_30fps");
-    Serial.println("  Пароль:  drone2024");
-    Serial.println("  Браузер: http://192.168.4.1:8080");
-    Serial.println("==================================================");
-}
-
-void CommandHandler::showMemoryInfo() {
-    Serial.println("\n💾 ===== ИНФОРМАЦИЯ О ПАМЯТИ =====");
+    if (args.argc() == 0) {
+        out->printf("[FC] UART baud: %lu (usage: fcbaud <rate>)\n", fc.getBaud());
+        return;
+    }
+
+    long baud = 0;
+    if (!args.arg(0).toInt(baud) || baud <= 0 || !fc.setBaud((uint32_t)baud)) {
+        out->printf("[ERROR] Unsupported baud '%s' (9600-921600 standard rates, 420000 for CRSF)\n", args.arg(0).data);
+        return;
+    }
+    out->printf("[SUCCESS] FC UART at %ld baud (kept across reboots via 'warm')\n", baud);
+}
+
+void CommandHandler::handleFlightControllerProtocol(const CommandArgs& args) {
+    auto& fc = systemManager->getFlightController();
+    if (args.argc() == 0) {
+        out->printf("[FC] Protocol: %s (usage: fcproto msp|mavlink)\n", fcLinkProtocolName(fc.getProtocol()));
+        return;
+    }
+
+    const CommandToken& protocol = args.arg(0);
+    if (args.argc() == 1 && protocol.equals("msp")) {
+        fc.setProtocol(FcLinkProtocol::MSP);
+    } else if (args.argc() == 1 && protocol.equals("mavlink")) {
+        fc.setProtocol(FcLinkProtocol::MAVLINK);
+    } else {
+        out->println("[ERROR] Usage: fcproto [msp|mavlink]");
+        return;
+    }
+    out->printf("[SUCCESS] FC link speaks %s (kept across reboots via 'warm'); telemetry starts over\n",
+                fcLinkProtocolName(fc.getProtocol()));
+}
+
+void CommandHandler::handleFlightControllerStats(const CommandArgs& args) {
+    auto& fc = systemManager->getFlightController();
+    if (args.argc() == 1 && args.arg(0).equals("reset")) {
+        fc.resetStats();
+        out->println("[FC] Link statistics reset");
+        return;
+    }
+    if (args.argc() != 0) {
+        out->println("[ERROR] Usage: fcstat [reset]");
+        return;
+    }
+    fc.printStatus(*out);
+}
+
+void CommandHandler::handleBlackbox(const CommandArgs& args) {
+    auto& blackbox = systemManager->getBlackbox();
+    if (args.argc() == 0) {
+        blackbox.printStatus(*out);
+        return;
+    }
+
+    const CommandToken& action = args.arg(0);
+    if (action.equals("start") && args.argc() <= 2) {
+        long rate = BlackboxConfig::DEFAULT_RATE_HZ;
+        if (args.argc() == 2 && (!args.arg(1).toInt(rate) || rate < BlackboxConfig::MIN_RATE_HZ ||
+                                 rate > BlackboxConfig::MAX_RATE_HZ)) {
+            out->printf("[ERROR] Rate %u-%u Hz\n", BlackboxConfig::MIN_RATE_HZ, BlackboxConfig::MAX_RATE_HZ);
+            return;
+        }
+        if (!systemManager->startBlackbox((uint16_t)rate)) {
+            out->printf("[ERROR] Blackbox is %s (full: run 'blackbox erase' first)\n",
+                        blackboxStateName(blackbox.getState()));
+            return;
+        }
+        out->printf("[SUCCESS] Logging FC telemetry at %ld Hz, session %u\n", rate, blackbox.getSession());
+    } else if (action.equals("stop") && args.argc() == 1) {
+        systemManager->stopBlackbox();
+        out->printf("[BLACKBOX] Stopped, %lu KB logged\n", (uint32_t)(blackbox.getUsedBytes() / 1024));
+    } else if (action.equals("erase") && args.argc() == 1) {
+        if (!blackbox.erase()) {
+            out->printf("[ERROR] Blackbox is %s\n", blackboxStateName(blackbox.getState()));
+            return;
+        }
+        out->println("[BLACKBOX] Erasing in the background (a few seconds; the FC link and stream stall meanwhile)");
+    } else {
+        out->println("[ERROR] Usage: blackbox [start [hz]|stop|erase]");
+    }
+}
+
+// === СИСТЕМНЫЕ КОМАНДЫ ===
+
+void CommandHandler::handleStatus(const CommandArgs& args) {
+    systemManager->printSystemStatus(*out);
+}
+
+void CommandHandler::handleRestart(const CommandArgs& args) {
+    out->println("[CMD] 🔄 Перезагрузка системы через 3 секунды...");
+    delay(3000);
+    ESP.restart();
+}
+
+// === ОТЛАДКА ===
+
+void CommandHandler::handleVerbose(const CommandArgs& args) {
+    auto& taskManager = systemManager->getTaskManager();
+    taskManager.toggleVerboseLogging();
+    out->printf("[CMD] Verbose logging: %s\n", 
+                 taskManager.isVerboseLogging() ? "ON" : "OFF");
+}
+
+void CommandHandler::handlePower(const CommandArgs& args) {
+    PowerGovernor& governor = systemManager->getPowerGovernor();
+    if (args.argc() > 0) {
+        long mhz = 0;
+        if (args.arg(0).equals("auto")) {
+            mhz = 0;
+        } else if (!args.arg(0).toInt(mhz)) {
+            mhz = -1;
+        }
+        if (mhz < 0 || !governor.setFixedMhz((uint16_t)mhz)) {
+            out->println("[ERROR] Usage: power [auto|80|160|240]");
+            return;
+        }
+        if (mhz) {
+            out->printf("[POWER] Clock fixed at %ld MHz\n", mhz);
+        } else {
+            out->println("[POWER] Clock governed by load");
+        }
+    }
+    governor.printStatus(*out);
+}
+
+void CommandHandler::handleWarmStart(const CommandArgs& args) {
+    auto& warm = systemManager->getWarmStart();
+    if (args.argc() > 0 && args.arg(0).equals("save")) {
+        bool ok = warm.save(systemManager->captureWarmState());
+        out->println(ok ? "[WARM] Current state saved" : "[ERROR] Save failed (value out of range or NVS error)");
+        return;
+    }
+    if (args.argc() > 0 && args.arg(0).equals("clear")) {
+        out->println(warm.clear() ? "[WARM] Cleared, next boot is a cold start" : "[ERROR] NVS erase failed");
+        return;
+    }
+    warm.printStatus(systemManager->captureWarmState(), *out);
+}
+
+void CommandHandler::handleTasks(const CommandArgs& args) {
+    auto& profiler = systemManager->getProfiler();
+    if (args.argc() > 0 && args.arg(0).equals("reset")) {
+        profiler.resetLoopJitter();
+        out->println("[PROF] loop() histogram reset");
+        return;
+    }
+    profiler.printReport(*out);
+}
+
+void CommandHandler::handleEvents(const CommandArgs& args) {
+    EventLoop& events = systemManager->getEventLoop();
+    Profiler& profiler = systemManager->getProfiler();
+    if (args.argc() > 0 && args.arg(0).equals("reset")) {
+        events.resetStats();
+        profiler.resetLoopJitter();
+        out->println("[EVENTS] Statistics reset");
+        return;
+    }
+
+    if (profiler.hasRuntimeStats()) {
+        out->printf("[EVENTS] Idle CPU: core0 %.1f%%, core1 %.1f%% (loop task on core %d)\n",
+                    100.0f - profiler.getCoreLoad(0), 100.0f - profiler.getCoreLoad(1), xPortGetCoreID());
+    } else {
+        out->println("[EVENTS] Idle CPU: n/a (CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS disabled)");
+    }
+    events.printStatus(*out);
+}
+
+void CommandHandler::handleCommandBenchmark(const CommandArgs& args) {
+    // Tokenize + look up every table entry; dispatch must not touch the heap
+    const uint32_t rounds = 1000;
+    char line[CommandConfig::MAX_LINE_LENGTH];
+    CommandToken tokens[CommandConfig::MAX_TOKENS];
+    uint32_t found = 0;
+
+    uint32_t heap_before = ESP.getFreeHeap();
+    int64_t start = esp_timer_get_time();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < CommandTable::count; i++) {
+            strncpy(line, CommandTable::entries[i].name, sizeof(line) - 1);
+            line[sizeof(line) - 1] = '\0';
+            size_t n = tokenizeCommand(line, tokens, CommandConfig::MAX_TOKENS);
+            if (n > 0 && CommandTable::find(tokens[0]) == &CommandTable::entries[i]) {
+                found++;
+            }
+        }
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    uint32_t heap_after = ESP.getFreeHeap();
+
+    uint32_t lookups = rounds * CommandTable::count;
+    out->printf("[BENCH] %lu lookups over %u commands: %lld us total, %.3f us/command\n",
+                 lookups, (unsigned)CommandTable::count, elapsed, (double)elapsed / lookups);
+    out->printf("[BENCH] Resolved: %lu/%lu, heap delta: %ld bytes\n",
+                 found, lookups, (long)heap_before - (long)heap_after);
+}
+
+void CommandHandler::showHelp(const CommandArgs& args) {
+    static const char* const group_titles[] = {
+        "📷 УПРАВЛЕНИЕ КАМЕРОЙ:",
+        "🌐 СЕТЬ И ПОДКЛЮЧЕНИЯ:",
+        "✈️  ПОЛЁТНЫЙ КОНТРОЛЛЕР:",
+        "🖥️  СИСТЕМА И ДИАГНОСТИКА:",
+        "🛠️  ОТЛАДКА:",
+    };
+
+    out->println("\n🚁 ===== ESP32-S3 FPV DRONE CAMERA КОМАНДЫ =====");
+
+    // Help is generated from the dispatch table; aliases are appended to their primary name
+    for (uint8_t group = 0; group < sizeof(group_titles) / sizeof(group_titles[0]); group++) {
+        out->println();
+        out->println(group_titles[group]);
+
+        for (size_t i = 0; i < CommandTable::count; i++) {
+            const CommandSpec& spec = CommandTable::entries[i];
+            if ((uint8_t)spec.group != group || spec.alias_of != nullptr) continue;
+
+            char names[40];
+            int len = snprintf(names, sizeof(names), "%s", spec.name);
+            for (size_t j = 0; j < CommandTable::count; j++) {
+                const char* alias_of = CommandTable::entries[j].alias_of;
+                if (alias_of != nullptr && strcmp(alias_of, spec.name) == 0 && len < (int)sizeof(names)) {
+                    len += snprintf(names + len, sizeof(names) - len, "/%s", CommandTable::entries[j].name);
+                }
+            }
+            if (spec.usage[0] != '\0' && len < (int)sizeof(names)) {
+                snprintf(names + len, sizeof(names) - len, " %s", spec.usage);
+            }
+            out->printf("  %-14s- %s\n", names, spec.help);
+        }
+    }
+
+    out->println();
+    out->println("💡 ПРИМЕРЫ:");
+    out->println("  > status      # Показать статус всех модулей");  
+    out->println("  > fps         # Узнать текущую частоту кадров");
+    out->println("  > quality 20  # Установить качество JPEG");
+    out->println("  > grayscale   # Включить ч/б режим (стабильнее)");
+    out->println("  > clients     # Сколько устройств подключено");
+    out->println("  > memory      # Проверить свободную память");
+    out->println();
+    out->println("🌐 ПОДКЛЮЧЕНИЕ К ДРОНУ:");
+    out->println("  WiFi:    ESP32-S3_Drone_30fps");
+    out->println("  Пароль:  drone2024");
+    out->println("  Браузер: http://192.168.4.1:8080");
+    out->println("==================================================");
+}
+
+void CommandHandler::showMemoryInfo(const CommandArgs& args) {
+    out->println("\n💾 ===== ИНФОРМАЦИЯ О ПАМЯТИ =====");
     
     // Heap память
     uint32_t freeHeap = ESP.getFreeHeap();
@@ -253,11 +983,11 @@ void CommandHandler::showMemoryInfo() {
     uint32_t usedHeap = totalHeap - freeHeap;
     float heapUsage = (float)usedHeap / totalHeap * 100;
     
-    Serial.printf("📊 HEAP память:\n");
-    Serial.printf("   Свободно: %lu KB (%lu bytes)\n", freeHeap / 1024, freeHeap);
-    Serial.printf("   Занято:   %lu KB (%lu bytes)\n", usedHeap / 1024, usedHeap);
-    Serial.printf("   Всего:    %lu KB (%lu bytes)\n", totalHeap / 1024, totalHeap);
-    Serial.printf("   Загрузка: %.1f%%\n", heapUsage);
+    out->printf("📊 HEAP память:\n");
+    out->printf("   Свободно: %lu KB (%lu bytes)\n", freeHeap / 1024, freeHeap);
+    out->printf("   Занято:   %lu KB (%lu bytes)\n", usedHeap / 1024, usedHeap);
+    out->printf("   Всего:    %lu KB (%lu bytes)\n", totalHeap / 1024, totalHeap);
+    out->printf("   Загрузка: %.1f%%\n", heapUsage);
     
     // PSRAM память
     uint32_t freePsram = ESP.getFreePsram();
@@ -265,39 +995,48 @@ void CommandHandler::showMemoryInfo() {
     uint32_t usedPsram = totalPsram - freePsram;
     float psramUsage = totalPsram > 0 ? (float)usedPsram / totalPsram * 100 : 0;
     
-    Serial.printf("\n📊 PSRAM память:\n");
+    out->printf("\n📊 PSRAM память:\n");
     if (totalPsram > 0) {
-        Serial.printf("   Свободно: %lu MB (%lu KB)\n", freePsram / 1024 / 1024, freePsram / 1024);
-        Serial.printf("   Занято:   %lu MB (%lu KB)\n", usedPsram / 1024 / 1024, usedPsram / 1024);
-        Serial.printf("   Всего:    %lu MB (%lu KB)\n", totalPsram / 1024 / 1024, totalPsram / 1024);
-        Serial.printf("   Загрузка: %.1f%%\n", psramUsage);
+        out->printf("   Свободно: %lu MB (%lu KB)\n", freePsram / 1024 / 1024, freePsram / 1024);
+        out->printf("   Занято:   %lu MB (%lu KB)\n", usedPsram / 1024 / 1024, usedPsram / 1024);
+        out->printf("   Всего:    %lu MB (%lu KB)\n", totalPsram / 1024 / 1024, totalPsram / 1024);
+        out->printf("   Загрузка: %.1f%%\n", psramUsage);
     } else {
-        Serial.println("   ❌ PSRAM не обнаружена или не инициализирована");
+        out->println("   ❌ PSRAM не обнаружена или не инициализирована");
     }
     
     // Flash память
     uint32_t flashSize = ESP.getFlashChipSize();
-    Serial.printf("\n📊 FLASH память:\n");
-    Serial.printf("   Размер:   %lu MB (%lu KB)\n", flashSize / 1024 / 1024, flashSize / 1024);
+    out->printf("\n📊 FLASH память:\n");
+    out->printf("   Размер:   %lu MB (%lu KB)\n", flashSize / 1024 / 1024, flashSize / 1024);
+    
+    // Фрагментация и арены
+    MemoryMonitor& monitor = MemoryPools::monitor();
+    monitor.sample();
+    monitor.printReport(*out);
+    MemoryPools::printStatus(*out);
     
     // Рекомендации
-    Serial.println("\n💡 РЕКОМЕНДАЦИИ:");
+    out->println("\n💡 РЕКОМЕНДАЦИИ:");
     if (heapUsage > 80) {
-        Serial.println("   ⚠️  Высокое использование HEAP! Возможны сбои.");
+        out->println("   ⚠️  Высокое использование HEAP! Возможны сбои.");
     } else if (heapUsage > 60) {
-        Serial.println("   ⚡ Умеренное использование HEAP.");
+        out->println("   ⚡ Умеренное использование HEAP.");
     } else {
-        Serial.println("   ✅ Оптимальное использование HEAP.");
+        out->println("   ✅ Оптимальное использование HEAP.");
     }
     
     if (totalPsram > 0 && psramUsage > 80) {
-        Serial.println("   ⚠️  Высокое использование PSRAM!");
+        out->println("   ⚠️  Высокое использование PSRAM!");
+    }
+    if (monitor.getRegion(0).fragmentation_percent >= MemoryConfig::FRAGMENTATION_WARN_PERCENT) {
+        out->println("   ⚠️  Внутренняя память фрагментирована - крупные буферы могут не выделиться.");
     }
     
-    Serial.println("=====================================");
+    out->println("=====================================");
 }
 
-void CommandHandler::showUptimeInfo() {
+void CommandHandler::showUptimeInfo(const CommandArgs& args) {
     unsigned long uptimeMs = millis();
     unsigned long seconds = uptimeMs / 1000;
     unsigned long minutes = seconds / 60;
@@ -308,61 +1047,61 @@ void CommandHandler::showUptimeInfo() {
     minutes %= 60;
     hours %= 24;
     
-    Serial.println("\n⏱️  ===== ВРЕМЯ РАБОТЫ СИСТЕМЫ =====");
-    Serial.printf("🚀 Система работает: ");
+    out->println("\n⏱️  ===== ВРЕМЯ РАБОТЫ СИСТЕМЫ =====");
+    out->printf("🚀 Система работает: ");
     
     if (days > 0) {
-        Serial.printf("%lu дн. ", days);
+        out->printf("%lu дн. ", days);
     }
     if (hours > 0) {
-        Serial.printf("%lu ч. ", hours);
+        out->printf("%lu ч. ", hours);
     }
     if (minutes > 0) {
-        Serial.printf("%lu мин. ", minutes);
+        out->printf("%lu мин. ", minutes);
     }
-    Serial.printf("%lu сек.\n", seconds);
+    out->printf("%lu сек.\n", seconds);
     
-    Serial.printf("📊 Всего миллисекунд: %lu\n", uptimeMs);
-    Serial.printf("🔄 Частота CPU: %lu MHz\n", ESP.getCpuFreqMHz());
+    out->printf("📊 Всего миллисекунд: %lu\n", uptimeMs);
+    out->printf("🔄 Частота CPU: %lu MHz\n", ESP.getCpuFreqMHz());
     
     // Статистика перезагрузок
     esp_reset_reason_t resetReason = esp_reset_reason();
-    Serial.printf("🔄 Причина последней перезагрузки: ");
+    out->printf("🔄 Причина последней перезагрузки: ");
     switch (resetReason) {
         case ESP_RST_POWERON:
-            Serial.println("Включение питания");
+            out->println("Включение питания");
             break;
         case ESP_RST_EXT:
-            Serial.println("Внешний сброс");
+            out->println("Внешний сброс");
             break;
         case ESP_RST_SW:
-            Serial.println("Программный сброс");
+            out->println("Программный сброс");
             break;
         case ESP_RST_PANIC:
-            Serial.println("Паника/Exception");
+            out->println("Паника/Exception");
             break;
         case ESP_RST_INT_WDT:
-            Serial.println("Watchdog таймер");
+            out->println("Watchdog таймер");
             break;
         case ESP_RST_TASK_WDT:
-            Serial.println("Task Watchdog");
+            out->println("Task Watchdog");
             break;
         case ESP_RST_WDT:
-            Serial.println("Другой Watchdog");
+            out->println("Другой Watchdog");
             break;
         case ESP_RST_DEEPSLEEP:
-            Serial.println("Выход из Deep Sleep");
+            out->println("Выход из Deep Sleep");
             break;
         case ESP_RST_BROWNOUT:
-            Serial.println("Просадка питания");
+            out->println("Просадка питания");
             break;
         case ESP_RST_SDIO:
-            Serial.println("SDIO сброс");
+            out->println("SDIO сброс");
             break;
         default:
-            Serial.printf("Неизвестная причина (%d)", resetReason);
+            out->printf("Неизвестная причина (%d)", resetReason);
             break;
     }
     
-    Serial.println("=====================================");
+    out->println("=====================================");
 }
@@ -0,0 +1,123 @@
+// src/commands/control_channel.cpp - Сетевой канал команд (UDP)
+#include "control_channel.h"
+#include "command_handler.h"
+
+size_t ResponseBuffer::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t ResponseBuffer::write(const uint8_t* buffer, size_t size) {
+    size_t room = sizeof(data_) - length_;
+    if (size > room) {
+        truncated_ = true;
+        size = room;
+    }
+    memcpy(data_ + length_, buffer, size);
+    length_ += size;
+    return size;
+}
+
+ControlChannel::ControlChannel()
+    : handler_(nullptr), port_(0), running_(false),
+      last_ip_(0), last_port_(0), last_request_id_(0), last_tx_length_(0),
+      requests_(0), rejected_(0) {
+}
+
+bool ControlChannel::begin(CommandHandler* handler, uint16_t port) {
+    if (!handler) {
+        return false;
+    }
+
+    handler_ = handler;
+    port_ = port;
+    running_ = udp_.begin(port) == 1;
+
+    if (running_) {
+        Serial.printf("[CTRL] UDP command channel listening on port %u\n", port_);
+    } else {
+        Serial.printf("[CTRL] ❌ Failed to open UDP port %u\n", port_);
+    }
+    return running_;
+}
+
+void ControlChannel::stop() {
+    if (!running_) return;
+    udp_.stop();
+    running_ = false;
+}
+
+void ControlChannel::poll() {
+    if (!running_) return;
+
+    // Drain everything queued since the last pass; each request runs on this (main) task
+    int size;
+    while ((size = udp_.parsePacket()) > 0) {
+        if ((size_t)size > ControlProtocol::MAX_DATAGRAM) {
+            udp_.read(rx_, sizeof(rx_));    // Discard oversized datagram
+            rejected_++;
+            continue;
+        }
+
+        int length = udp_.read(rx_, ControlProtocol::MAX_DATAGRAM);
+        ControlFrame request;
+        if (length <= 0 || !decodeControlFrame(rx_, (size_t)length, request) ||
+            request.type != ControlMessageType::REQUEST) {
+            rejected_++;
+            continue;
+        }
+
+        uint32_t ip = (uint32_t)udp_.remoteIP();
+        uint16_t remote_port = udp_.remotePort();
+        if (ip == last_ip_ && remote_port == last_port_ &&
+            request.request_id == last_request_id_ && last_tx_length_ > 0) {
+            sendDatagram(tx_, last_tx_length_);
+            continue;
+        }
+
+        if (request.payload_length == 0 || request.payload_length >= sizeof(rx_) - ControlProtocol::HEADER_SIZE) {
+            reject(request, ControlStatus::BAD_REQUEST);
+            continue;
+        }
+
+        // Payload becomes a NUL-terminated line tokenized in place
+        char* line = (char*)(rx_ + ControlProtocol::HEADER_SIZE);
+        line[request.payload_length] = '\0';
+
+        requests_++;
+        response_.clear();
+        bool known = handler_->execute(line, response_);
+
+        ControlFrame response;
+        response.type = ControlMessageType::RESPONSE;
+        response.request_id = request.request_id;
+        response.status = known ? ControlStatus::OK : ControlStatus::UNKNOWN_COMMAND;
+        response.flags = response_.isTruncated() ? ControlFlags::TRUNCATED : 0;
+        response.payload_length = (uint16_t)response_.length();
+        encodeControlHeader(response, tx_);
+        memcpy(tx_ + ControlProtocol::HEADER_SIZE, response_.data(), response_.length());
+
+        last_ip_ = ip;
+        last_port_ = remote_port;
+        last_request_id_ = request.request_id;
+        last_tx_length_ = ControlProtocol::HEADER_SIZE + response_.length();
+        sendDatagram(tx_, last_tx_length_);
+    }
+}
+
+void ControlChannel::reject(const ControlFrame& request, ControlStatus status) {
+    rejected_++;
+
+    ControlFrame response;
+    response.type = ControlMessageType::RESPONSE;
+    response.request_id = request.request_id;
+    response.status = status;
+    // Own buffer: tx_ still holds the cached reply to the last request
+    encodeControlHeader(response, reject_tx_);
+    sendDatagram(reject_tx_, sizeof(reject_tx_));
+}
+
+void ControlChannel::sendDatagram(const uint8_t* data, size_t length) {
+    udp_.beginPacket(udp_.remoteIP(), udp_.remotePort());
+    udp_.write(data, length);
+    udp_.endPacket();
+}
@@ -0,0 +1,272 @@
+// src/flight_controller/blackbox.cpp - Чёрный ящик: телеметрия FC во flash-раздел из фоновой задачи
+#include "blackbox.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+
+const char* blackboxStateName(BlackboxState state) {
+    switch (state) {
+        case BlackboxState::DISABLED: return "disabled";
+        case BlackboxState::IDLE:     return "idle";
+        case BlackboxState::LOGGING:  return "logging";
+        case BlackboxState::ERASING:  return "erasing";
+        case BlackboxState::FULL:     return "full";
+        default:                      return "?";
+    }
+}
+
+Blackbox::Blackbox()
+    : partition_(nullptr), state_(BlackboxState::DISABLED), rate_hz_(BlackboxConfig::DEFAULT_RATE_HZ),
+      session_(0), sequence_(0), write_offset_(0), erase_offset_(0), buffers_(nullptr), free_queue_(nullptr),
+      full_queue_(nullptr), lock_(nullptr), writer_task_(nullptr), current_(-1), session_start_offset_(0),
+      session_start_ms_(0) {}
+
+bool Blackbox::begin() {
+    partition_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                          BlackboxConfig::PARTITION_LABEL);
+    if (!partition_) {
+        Serial.printf("⚠️  [BLACKBOX] No '%s' partition, logging disabled\n", BlackboxConfig::PARTITION_LABEL);
+        return false;
+    }
+
+    buffers_ = (uint8_t*)heap_caps_malloc(BlackboxConfig::BUFFER_BLOCKS * BlackboxFormat::BLOCK_SIZE,
+                                          MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    free_queue_ = xQueueCreate(BlackboxConfig::BUFFER_BLOCKS, sizeof(uint8_t));
+    full_queue_ = xQueueCreate(BlackboxConfig::BUFFER_BLOCKS + 1, sizeof(uint8_t));
+    lock_ = xSemaphoreCreateMutex();
+    if (!buffers_ || !free_queue_ || !full_queue_ || !lock_ ||
+        xTaskCreatePinnedToCore(writerTask, "Blackbox", BlackboxConfig::WRITER_STACK, this,
+                                BlackboxConfig::WRITER_PRIORITY, &writer_task_,
+                                BlackboxConfig::WRITER_CORE) != pdPASS) {
+        Serial.println("❌ [BLACKBOX] Not enough memory for the writer");
+        partition_ = nullptr;
+        return false;
+    }
+    for (uint8_t i = 0; i < BlackboxConfig::BUFFER_BLOCKS; i++) {
+        xQueueSend(free_queue_, &i, 0);
+    }
+
+    write_offset_ = findLogEnd();
+    state_ = write_offset_ + BlackboxFormat::BLOCK_SIZE > partition_->size ? BlackboxState::FULL
+                                                                          : BlackboxState::IDLE;
+    Serial.printf("📼 [BLACKBOX] Partition %lu KB, %lu KB logged (%u session(s))\n", partition_->size / 1024,
+                  (uint32_t)(write_offset_ / 1024), session_);
+    return true;
+}
+
+// Blocks are written in order, so "erased" flips once from false to true:
+// a binary search finds the end in a dozen header reads
+size_t Blackbox::findLogEnd() {
+    uint8_t header[BlackboxFormat::HEADER_SIZE];
+    BlackboxBlockInfo info;
+    size_t low = 0, high = partition_->size / BlackboxFormat::BLOCK_SIZE;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        esp_partition_read(partition_, mid * BlackboxFormat::BLOCK_SIZE, header, sizeof(header));
+        if (blackboxReadHeader(header, info) == BlackboxBlockStatus::ERASED) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    if (low > 0) {
+        esp_partition_read(partition_, (low - 1) * BlackboxFormat::BLOCK_SIZE, header, sizeof(header));
+        if (blackboxReadHeader(header, info) == BlackboxBlockStatus::OK) {
+            session_ = info.session;
+            sequence_ = info.sequence + 1;
+        }
+    }
+    return low * BlackboxFormat::BLOCK_SIZE;
+}
+
+bool Blackbox::start(uint16_t rate_hz) {
+    if (state_ != BlackboxState::IDLE) {
+        return false;
+    }
+    if (rate_hz < BlackboxConfig::MIN_RATE_HZ) rate_hz = BlackboxConfig::MIN_RATE_HZ;
+    if (rate_hz > BlackboxConfig::MAX_RATE_HZ) rate_hz = BlackboxConfig::MAX_RATE_HZ;
+    rate_hz_ = rate_hz;
+    session_++;
+    session_start_offset_ = write_offset_;
+    session_start_ms_ = millis();
+    stats_ = BlackboxStats();
+    state_ = BlackboxState::LOGGING;
+    Serial.printf("📼 [BLACKBOX] Session %u started at %u Hz\n", session_, rate_hz_);
+    return true;
+}
+
+void Blackbox::stop() {
+    if (state_ != BlackboxState::LOGGING && state_ != BlackboxState::FULL) {
+        return;
+    }
+    if (state_ == BlackboxState::LOGGING) {
+        state_ = BlackboxState::IDLE;
+    }
+    // The FC task may be inside record(); it gives the lock back within microseconds
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    if (current_ >= 0) {
+        sealBlock();
+    }
+    xSemaphoreGive(lock_);
+    Serial.printf("📼 [BLACKBOX] Session %u stopped: %lu records, %lu dropped\n", session_, stats_.records,
+                  stats_.dropped_records);
+}
+
+bool Blackbox::erase() {
+    if (state_ != BlackboxState::IDLE && state_ != BlackboxState::FULL) {
+        return false;
+    }
+    state_ = BlackboxState::ERASING;
+    erase_offset_ = 0;
+    uint8_t request = ERASE_REQUEST;
+    xQueueSend(full_queue_, &request, portMAX_DELAY);
+    return true;
+}
+
+void Blackbox::record(FcField field, const FcTelemetry& telemetry) {
+    if (state_ != BlackboxState::LOGGING) {
+        return;
+    }
+    if (xSemaphoreTake(lock_, 0) != pdTRUE) {
+        stats_.dropped_records++;       // stop() is sealing the block
+        return;
+    }
+
+    int32_t values[FcTelemetryConfig::MAX_FIELD_VALUES];
+    size_t count = fcFieldValues(field, telemetry, values);
+    uint32_t time_us = telemetry.updated_us[(size_t)field];
+    bool stored = false;
+    if (current_ >= 0 || takeBlock(time_us)) {
+        stored = writer_.append((uint8_t)field, time_us, values, count);
+        if (!stored) {
+            sealBlock();
+            stored = takeBlock(time_us) && writer_.append((uint8_t)field, time_us, values, count);
+        }
+    }
+    if (stored) {
+        stats_.records++;
+    } else {
+        stats_.dropped_records++;
+    }
+    xSemaphoreGive(lock_);
+}
+
+bool Blackbox::takeBlock(uint32_t start_us) {
+    uint8_t index;
+    if (xQueueReceive(free_queue_, &index, 0) != pdTRUE) {
+        return false;
+    }
+    current_ = index;
+    writer_.begin(buffer(index), sequence_++, session_, start_us);
+    return true;
+}
+
+void Blackbox::sealBlock() {
+    uint8_t index = (uint8_t)current_;
+    writer_.finish();
+    current_ = -1;
+    // Never full: every buffer index is in exactly one of the two queues or current_
+    xQueueSend(full_queue_, &index, 0);
+    uint32_t queued = uxQueueMessagesWaiting(full_queue_);
+    if (queued > stats_.max_queued) stats_.max_queued = queued;
+}
+
+void Blackbox::writerTask(void* parameter) {
+    Blackbox* blackbox = static_cast<Blackbox*>(parameter);
+    uint8_t index;
+    for (;;) {
+        if (xQueueReceive(blackbox->full_queue_, &index, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (index == ERASE_REQUEST) {
+            blackbox->eraseAll();
+        } else {
+            blackbox->writeBlock(index);
+            xQueueSend(blackbox->free_queue_, &index, 0);
+        }
+    }
+}
+
+void Blackbox::writeBlock(uint8_t index) {
+    if (write_offset_ + BlackboxFormat::BLOCK_SIZE > partition_->size) {
+        return;     // Queued behind the last block that fit
+    }
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = esp_partition_write(partition_, write_offset_, buffer(index), BlackboxFormat::BLOCK_SIZE);
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    if (err != ESP_OK) {
+        stats_.write_errors++;
+        return;
+    }
+    write_offset_ += BlackboxFormat::BLOCK_SIZE;
+    stats_.blocks_written++;
+    stats_.avg_write_us = stats_.avg_write_us ? stats_.avg_write_us - stats_.avg_write_us / 8 + elapsed / 8 : elapsed;
+    if (elapsed > stats_.max_write_us) stats_.max_write_us = elapsed;
+
+    if (write_offset_ + BlackboxFormat::BLOCK_SIZE > partition_->size && state_ == BlackboxState::LOGGING) {
+        state_ = BlackboxState::FULL;
+        Serial.printf("⚠️  [BLACKBOX] Partition full, session %u stopped at %lu KB\n", session_,
+                      (uint32_t)(write_offset_ / 1024));
+    }
+}
+
+void Blackbox::eraseAll() {
+    unsigned long start = millis();
+    Serial.printf("📼 [BLACKBOX] Erasing %lu KB...\n", partition_->size / 1024);
+    bool ok = true;
+    for (size_t offset = 0; offset < partition_->size; offset += BlackboxConfig::ERASE_STEP) {
+        size_t length = partition_->size - offset < BlackboxConfig::ERASE_STEP ? partition_->size - offset
+                                                                                : BlackboxConfig::ERASE_STEP;
+        if (esp_partition_erase_range(partition_, offset, length) != ESP_OK) {
+            ok = false;
+            break;
+        }
+        erase_offset_ = offset + length;
+    }
+    write_offset_ = 0;
+    sequence_ = 0;
+    session_ = 0;
+    state_ = ok ? BlackboxState::IDLE : BlackboxState::FULL;
+    Serial.printf("%s [BLACKBOX] Erase %s in %lu ms\n", ok ? "✅" : "❌", ok ? "done" : "failed", millis() - start);
+}
+
+bool Blackbox::read(size_t offset, uint8_t* buffer, size_t length) const {
+    if (!partition_ || offset + length > write_offset_) {
+        return false;
+    }
+    return esp_partition_read(partition_, offset, buffer, length) == ESP_OK;
+}
+
+void Blackbox::printStatus(Print& out) const {
+    out.println("\n=== Blackbox ===");
+    if (!partition_) {
+        out.printf("No '%s' partition (flash with partitions.csv)\n", BlackboxConfig::PARTITION_LABEL);
+        out.println("================\n");
+        return;
+    }
+    size_t used = write_offset_;
+    size_t capacity = partition_->size;
+    out.printf("State: %s", blackboxStateName(state_));
+    if (state_ == BlackboxState::LOGGING) {
+        out.printf(" at %u Hz", rate_hz_);
+    } else if (state_ == BlackboxState::ERASING) {
+        out.printf(" %u%%", (unsigned)(erase_offset_ * 100 / capacity));
+    }
+    out.printf(", session %u\n", session_);
+    out.printf("Flash: %lu/%lu KB used (%.1f%%)", (uint32_t)(used / 1024), (uint32_t)(capacity / 1024),
+               used * 100.0f / capacity);
+    unsigned long elapsed_ms = millis() - session_start_ms_;
+    size_t session_bytes = used - session_start_offset_;
+    if (state_ == BlackboxState::LOGGING && elapsed_ms > 1000 && session_bytes > 0) {
+        float bytes_per_s = session_bytes * 1000.0f / elapsed_ms;
+        out.printf(", %.1f KB/s, ~%lu s left", bytes_per_s / 1024, (uint32_t)((capacity - used) / bytes_per_s));
+    }
+    out.println();
+    out.printf("Records: %lu, dropped: %lu; blocks written: %lu, write errors: %lu\n", stats_.records,
+               stats_.dropped_records, stats_.blocks_written, stats_.write_errors);
+    out.printf("Block write: avg %lu us, max %lu us; peak queue %lu/%u blocks\n", stats_.avg_write_us,
+               stats_.max_write_us, stats_.max_queued, BlackboxConfig::BUFFER_BLOCKS);
+    if (used > 0) {
+        out.println("Download: curl -o flight.bbx http://192.168.4.1/blackbox (decode with tools/blackbox_decode.cpp)");
+    }
+    out.println("================\n");
+}
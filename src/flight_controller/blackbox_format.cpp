@@ -0,0 +1,191 @@
+// src/flight_controller/blackbox_format.cpp - Формат блоков чёрного ящика
+#include "blackbox_format.h"
+#include <string.h>
+
+namespace {
+
+void put16(uint8_t* p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+void put32(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+uint16_t get16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+uint32_t get32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+size_t putVarint(uint8_t* p, uint32_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        p[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    p[length++] = (uint8_t)value;
+    return length;
+}
+
+// False on a varint running past `end` or longer than 5 bytes
+bool getVarint(const uint8_t* p, const uint8_t* end, size_t& offset, uint32_t& value) {
+    value = 0;
+    for (size_t i = 0; i < BlackboxFormat::MAX_VARINT; i++) {
+        if (p + offset >= end) return false;
+        uint8_t byte = p[offset++];
+        value |= (uint32_t)(byte & 0x7F) << (7 * i);
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+int32_t unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+// Nibble table: 64 bytes instead of 1 KB, fast enough for a few blocks a second
+const uint32_t kCrcNibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+} // namespace
+
+const char* blackboxBlockStatusName(BlackboxBlockStatus status) {
+    switch (status) {
+        case BlackboxBlockStatus::OK:         return "ok";
+        case BlackboxBlockStatus::ERASED:     return "erased";
+        case BlackboxBlockStatus::BAD_MAGIC:  return "bad magic";
+        case BlackboxBlockStatus::BAD_LENGTH: return "bad length";
+        case BlackboxBlockStatus::BAD_CRC:    return "bad crc";
+        default:                              return "?";
+    }
+}
+
+uint32_t blackboxCrc32(const uint8_t* data, size_t length, uint32_t crc) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ kCrcNibble[crc & 0x0F];
+        crc = (crc >> 4) ^ kCrcNibble[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+BlackboxBlockStatus blackboxReadHeader(const uint8_t* block, BlackboxBlockInfo& info) {
+    uint32_t magic = get32(block);
+    if (magic == BlackboxFormat::ERASED) return BlackboxBlockStatus::ERASED;
+    if (magic != BlackboxFormat::MAGIC) return BlackboxBlockStatus::BAD_MAGIC;
+    info.sequence = get32(block + 4);
+    info.session = get16(block + 8);
+    info.length = get16(block + 10);
+    info.start_us = get32(block + 12);
+    return info.length <= BlackboxFormat::PAYLOAD_SIZE ? BlackboxBlockStatus::OK : BlackboxBlockStatus::BAD_LENGTH;
+}
+
+void BlackboxBlockWriter::begin(uint8_t* block, uint32_t sequence, uint16_t session, uint32_t start_us) {
+    block_ = block;
+    info_.sequence = sequence;
+    info_.session = session;
+    info_.start_us = start_us;
+    length_ = 0;
+    records_ = 0;
+    last_us_ = start_us;
+    memset(previous_, 0, sizeof(previous_));
+}
+
+bool BlackboxBlockWriter::append(uint8_t field, uint32_t time_us, const int32_t* values, size_t count) {
+    if (!block_ || field >= BlackboxFormat::MAX_FIELDS || count > BlackboxFormat::MAX_VALUES) {
+        return false;
+    }
+    // Worst case, so the check needs no trial encode
+    if (length_ + 1 + BlackboxFormat::MAX_VARINT * (1 + count) > BlackboxFormat::PAYLOAD_SIZE) {
+        return false;
+    }
+
+    uint8_t* p = block_ + BlackboxFormat::HEADER_SIZE + length_;
+    size_t n = 0;
+    p[n++] = (uint8_t)(field << 5 | count);
+    n += putVarint(p + n, time_us - last_us_);
+    int32_t* previous = previous_[field];
+    for (size_t i = 0; i < count; i++) {
+        // Unsigned difference: mode flags use all 32 bits
+        n += putVarint(p + n, zigzag((int32_t)((uint32_t)values[i] - (uint32_t)previous[i])));
+        previous[i] = values[i];
+    }
+    last_us_ = time_us;
+    length_ += n;
+    records_++;
+    return true;
+}
+
+void BlackboxBlockWriter::finish() {
+    if (!block_) return;
+    memset(block_ + BlackboxFormat::HEADER_SIZE + length_, 0xFF, BlackboxFormat::PAYLOAD_SIZE - length_);
+    put32(block_, BlackboxFormat::MAGIC);
+    put32(block_ + 4, info_.sequence);
+    put16(block_ + 8, info_.session);
+    put16(block_ + 10, (uint16_t)length_);
+    put32(block_ + 12, info_.start_us);
+    uint32_t crc = blackboxCrc32(block_, 16);
+    crc = blackboxCrc32(block_ + BlackboxFormat::HEADER_SIZE, length_, crc);
+    put32(block_ + 16, crc);
+    block_ = nullptr;
+}
+
+BlackboxBlockStatus BlackboxBlockReader::open(const uint8_t* block) {
+    block_ = nullptr;
+    malformed_ = false;
+    BlackboxBlockStatus status = blackboxReadHeader(block, info_);
+    if (status != BlackboxBlockStatus::OK) return status;
+
+    uint32_t crc = blackboxCrc32(block, 16);
+    crc = blackboxCrc32(block + BlackboxFormat::HEADER_SIZE, info_.length, crc);
+    if (crc != get32(block + 16)) return BlackboxBlockStatus::BAD_CRC;
+
+    block_ = block;
+    offset_ = 0;
+    last_us_ = info_.start_us;
+    memset(previous_, 0, sizeof(previous_));
+    return BlackboxBlockStatus::OK;
+}
+
+bool BlackboxBlockReader::next(BlackboxSample& sample) {
+    if (!block_ || offset_ >= info_.length) return false;
+    const uint8_t* payload = block_ + BlackboxFormat::HEADER_SIZE;
+    const uint8_t* end = payload + info_.length;
+
+    uint8_t tag = payload[offset_++];
+    sample.field = tag >> 5;
+    sample.count = tag & 0x1F;
+    uint32_t delta = 0;
+    if (!getVarint(payload, end, offset_, delta)) {
+        malformed_ = true;
+        return false;
+    }
+    last_us_ += delta;
+    sample.time_us = last_us_;
+
+    int32_t* previous = previous_[sample.field];
+    for (size_t i = 0; i < sample.count; i++) {
+        uint32_t value = 0;
+        if (!getVarint(payload, end, offset_, value)) {
+            malformed_ = true;
+            return false;
+        }
+        previous[i] = (int32_t)((uint32_t)previous[i] + (uint32_t)unzigzag(value));
+        sample.values[i] = previous[i];
+    }
+    return true;
+}
@@ -0,0 +1,139 @@
+// src/flight_controller/fc_frame_parser.cpp - Сборка кадров MSP из потока байт UART контроллера полёта
+#include "fc_frame_parser.h"
+#include "esp_timer.h"
+
+const char* fcProtocolName(FcProtocol protocol) {
+    switch (protocol) {
+        case FcProtocol::MSP_V1:     return "MSP v1";
+        case FcProtocol::MSP_V2:     return "MSP v2";
+        case FcProtocol::MAVLINK_V2: return "MAVLink v2";
+        default:                     return "?";
+    }
+}
+
+FcFrameParser::FcFrameParser()
+    : state_(State::IDLE), received_(0), checksum_(0), oversize_(false), frame_() {}
+
+void FcFrameParser::reset() {
+    state_ = State::IDLE;
+    received_ = 0;
+    checksum_ = 0;
+    oversize_ = false;
+}
+
+uint8_t FcFrameParser::crc8DvbS2(uint8_t crc, uint8_t byte) {
+    crc ^= byte;
+    for (int i = 0; i < 8; i++) {
+        crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0xD5) : (uint8_t)(crc << 1);
+    }
+    return crc;
+}
+
+FcFrameParser::State FcFrameParser::afterHeader() {
+    received_ = 0;
+    oversize_ = frame_.size > FcFrameConfig::MAX_PAYLOAD;
+    return frame_.size > 0 ? State::PAYLOAD : State::CHECKSUM;
+}
+
+bool FcFrameParser::feed(uint8_t byte) {
+    switch (state_) {
+        case State::IDLE:
+            if (byte == '$') {
+                state_ = State::PROTOCOL;
+            } else {
+                stats_.garbage_bytes++;
+            }
+            return false;
+
+        case State::PROTOCOL:
+            if (byte == 'M' || byte == 'X') {
+                frame_.protocol = byte == 'M' ? FcProtocol::MSP_V1 : FcProtocol::MSP_V2;
+                state_ = State::DIRECTION;
+            } else {
+                // A second '$' may start the real frame
+                stats_.garbage_bytes += byte == '$' ? 1 : 2;
+                state_ = byte == '$' ? State::PROTOCOL : State::IDLE;
+            }
+            return false;
+
+        case State::DIRECTION:
+            if (byte != '<' && byte != '>' && byte != '!') {
+                stats_.garbage_bytes += 3;
+                reset();
+                return false;
+            }
+            frame_.direction = (char)byte;
+            checksum_ = 0;
+            state_ = frame_.protocol == FcProtocol::MSP_V1 ? State::V1_SIZE : State::V2_FLAG;
+            return false;
+
+        case State::V1_SIZE:
+            frame_.size = byte;
+            checksum_ ^= byte;
+            state_ = State::V1_COMMAND;
+            return false;
+
+        case State::V1_COMMAND:
+            frame_.command = byte;
+            checksum_ ^= byte;
+            state_ = afterHeader();
+            return false;
+
+        case State::V2_FLAG:
+            checksum_ = crc8DvbS2(checksum_, byte);
+            state_ = State::V2_COMMAND_LO;
+            return false;
+
+        case State::V2_COMMAND_LO:
+            frame_.command = byte;
+            checksum_ = crc8DvbS2(checksum_, byte);
+            state_ = State::V2_COMMAND_HI;
+            return false;
+
+        case State::V2_COMMAND_HI:
+            frame_.command |= (uint16_t)byte << 8;
+            checksum_ = crc8DvbS2(checksum_, byte);
+            state_ = State::V2_SIZE_LO;
+            return false;
+
+        case State::V2_SIZE_LO:
+            frame_.size = byte;
+            checksum_ = crc8DvbS2(checksum_, byte);
+            state_ = State::V2_SIZE_HI;
+            return false;
+
+        case State::V2_SIZE_HI:
+            frame_.size |= (uint16_t)byte << 8;
+            checksum_ = crc8DvbS2(checksum_, byte);
+            state_ = afterHeader();
+            return false;
+
+        case State::PAYLOAD:
+            if (!oversize_) {
+                frame_.payload[received_] = byte;
+            }
+            checksum_ = frame_.protocol == FcProtocol::MSP_V1 ? checksum_ ^ byte : crc8DvbS2(checksum_, byte);
+            if (++received_ >= frame_.size) {
+                state_ = State::CHECKSUM;
+            }
+            return false;
+
+        case State::CHECKSUM: {
+            bool valid = byte == checksum_;
+            bool oversize = oversize_;
+            reset();
+            if (!valid) {
+                stats_.checksum_errors++;
+                return false;
+            }
+            if (oversize) {
+                stats_.oversize++;
+                return false;
+            }
+            frame_.received_us = (uint32_t)esp_timer_get_time();
+            stats_.frames++;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,205 @@
+// src/flight_controller/fc_telemetry.cpp - Разбор телеметрии MSP и раскладка полей для чёрного ящика
+#include "fc_telemetry.h"
+#include "mavlink_v2.h"
+
+namespace {
+
+int16_t getS16(const uint8_t* p) {
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+uint16_t getU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Radians -> tenths of a degree, rounded
+int32_t radiansToDecidegrees(float radians) {
+    float decidegrees = radians * (1800.0f / 3.14159265f);
+    return (int32_t)(decidegrees < 0 ? decidegrees - 0.5f : decidegrees + 0.5f);
+}
+
+} // namespace
+
+const char* fcFieldName(FcField field) {
+    switch (field) {
+        case FcField::ATTITUDE: return "attitude";
+        case FcField::IMU:      return "imu";
+        case FcField::RC:       return "rc";
+        case FcField::STATUS:   return "status";
+        case FcField::ANALOG:   return "analog";
+        case FcField::ALTITUDE: return "altitude";
+        default:                return "?";
+    }
+}
+
+const char* fcFieldColumns(FcField field) {
+    switch (field) {
+        case FcField::ATTITUDE: return "roll_dd,pitch_dd,yaw_deg";
+        case FcField::IMU:      return "acc_x,acc_y,acc_z,gyro_x,gyro_y,gyro_z";
+        case FcField::RC:       return "ch1..chN";
+        case FcField::STATUS:   return "armed,mode_flags";
+        case FcField::ANALOG:   return "battery_cv,current_ca,consumed_mah";
+        case FcField::ALTITUDE: return "altitude_cm,vario_cms";
+        default:                return "";
+    }
+}
+
+size_t fcFieldValues(FcField field, const FcTelemetry& t, int32_t* values) {
+    switch (field) {
+        case FcField::ATTITUDE:
+            values[0] = t.roll_dd;
+            values[1] = t.pitch_dd;
+            values[2] = t.yaw_deg;
+            return 3;
+        case FcField::IMU:
+            for (size_t i = 0; i < 3; i++) {
+                values[i] = t.acc[i];
+                values[3 + i] = t.gyro[i];
+            }
+            return 6;
+        case FcField::RC:
+            for (size_t i = 0; i < t.rc_count; i++) {
+                values[i] = t.rc[i];
+            }
+            return t.rc_count;
+        case FcField::STATUS:
+            values[0] = t.armed ? 1 : 0;
+            values[1] = (int32_t)t.mode_flags;
+            return 2;
+        case FcField::ANALOG:
+            values[0] = t.battery_cv;
+            values[1] = t.current_ca;
+            values[2] = t.consumed_mah;
+            return 3;
+        case FcField::ALTITUDE:
+            values[0] = t.altitude_cm;
+            values[1] = t.vario_cms;
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+// Layouts as Betaflight/INAV send them; trailing fields newer firmware
+// appends are ignored
+FcField decodeMspTelemetry(uint16_t command, const uint8_t* p, uint16_t size, FcTelemetry& t) {
+    switch (command) {
+        case MspCommand::ATTITUDE:
+            if (size < 6) break;
+            t.roll_dd = getS16(p);
+            t.pitch_dd = getS16(p + 2);
+            t.yaw_deg = getS16(p + 4);
+            return FcField::ATTITUDE;
+
+        case MspCommand::RAW_IMU:
+            if (size < 12) break;
+            for (size_t i = 0; i < 3; i++) {
+                t.acc[i] = getS16(p + 2 * i);
+                t.gyro[i] = getS16(p + 6 + 2 * i);
+            }
+            return FcField::IMU;
+
+        case MspCommand::RC: {
+            size_t count = size / 2;
+            if (count > FcTelemetryConfig::MAX_RC_CHANNELS) count = FcTelemetryConfig::MAX_RC_CHANNELS;
+            for (size_t i = 0; i < count; i++) {
+                t.rc[i] = getU16(p + 2 * i);
+            }
+            t.rc_count = (uint8_t)count;
+            return FcField::RC;
+        }
+
+        case MspCommand::STATUS:
+            // cycle time, i2c errors, sensors, then the box flags; ARM is box 0
+            if (size < 10) break;
+            t.mode_flags = getU32(p + 6);
+            t.armed = (t.mode_flags & 1) != 0;
+            return FcField::STATUS;
+
+        case MspCommand::ANALOG:
+            // vbat (0.1 V), mAh, rssi, amperage (0.01 A)[, voltage (0.01 V)]
+            if (size < 7) break;
+            t.consumed_mah = getU16(p + 1);
+            t.current_ca = getS16(p + 5);
+            t.battery_cv = size >= 9 ? getU16(p + 7) : (uint16_t)(p[0] * 10);
+            return FcField::ANALOG;
+
+        case MspCommand::ALTITUDE:
+            if (size < 6) break;
+            t.altitude_cm = (int32_t)getU32(p);
+            t.vario_cms = getS16(p + 4);
+            return FcField::ALTITUDE;
+
+        default:
+            break;
+    }
+    return FcField::COUNT;
+}
+
+// Offsets are the wire order of the definitions in mavlink_v2.h. Unknown
+// values (UINT16_MAX volts, -1 current or mAh) leave the cache as it was.
+FcField decodeMavlinkTelemetry(const MavlinkFrame& frame, FcTelemetry& t) {
+    switch (frame.msgid) {
+        case MavlinkMessage::ATTITUDE.id: {
+            t.roll_dd = (int16_t)radiansToDecidegrees(frame.get<float>(4));
+            t.pitch_dd = (int16_t)radiansToDecidegrees(frame.get<float>(8));
+            // -180..180 -> 0..359, the MSP heading range
+            int32_t yaw = (radiansToDecidegrees(frame.get<float>(12)) + 5) / 10;
+            t.yaw_deg = (int16_t)(yaw < 0 ? yaw + 360 : yaw % 360);
+            return FcField::ATTITUDE;
+        }
+
+        case MavlinkMessage::RAW_IMU.id:
+            for (size_t i = 0; i < 3; i++) {
+                t.acc[i] = frame.get<int16_t>(8 + 2 * i);
+                t.gyro[i] = frame.get<int16_t>(14 + 2 * i);
+            }
+            return FcField::IMU;
+
+        case MavlinkMessage::RC_CHANNELS.id: {
+            size_t count = frame.get<uint8_t>(40);
+            if (count > FcTelemetryConfig::MAX_RC_CHANNELS) count = FcTelemetryConfig::MAX_RC_CHANNELS;
+            for (size_t i = 0; i < count; i++) {
+                t.rc[i] = frame.get<uint16_t>(4 + 2 * i);
+            }
+            t.rc_count = (uint8_t)count;
+            return FcField::RC;
+        }
+
+        case MavlinkMessage::HEARTBEAT.id:
+            // Custom mode is the autopilot's own flight mode number
+            t.mode_flags = frame.get<uint32_t>(0);
+            t.armed = (frame.get<uint8_t>(6) & MavlinkEnum::MAV_MODE_FLAG_SAFETY_ARMED) != 0;
+            return FcField::STATUS;
+
+        case MavlinkMessage::SYS_STATUS.id: {
+            uint16_t millivolts = frame.get<uint16_t>(14);
+            int16_t current = frame.get<int16_t>(16);
+            if (millivolts != UINT16_MAX) t.battery_cv = (uint16_t)(millivolts / 10);
+            if (current >= 0) t.current_ca = current;
+            return FcField::ANALOG;
+        }
+
+        case MavlinkMessage::BATTERY_STATUS.id: {
+            // First battery only, like SYS_STATUS
+            if (frame.get<uint8_t>(32) != 0) break;
+            int32_t consumed = frame.get<int32_t>(0);
+            if (consumed >= 0) t.consumed_mah = (uint16_t)(consumed > UINT16_MAX ? UINT16_MAX : consumed);
+            return FcField::ANALOG;
+        }
+
+        case MavlinkMessage::GLOBAL_POSITION_INT.id:
+            // Above home in mm; vz is positive down
+            t.altitude_cm = frame.get<int32_t>(16) / 10;
+            t.vario_cms = (int16_t)-frame.get<int16_t>(24);
+            return FcField::ALTITUDE;
+
+        default:
+            break;
+    }
+    return FcField::COUNT;
+}
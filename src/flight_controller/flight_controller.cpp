@@ -1,65 +1,584 @@
 // src/flight_controller/flight_controller.cpp
 #include "flight_controller.h"
+#include "esp_timer.h"
 
-FlightController::FlightController() : fcSerial(Serial1) {}
+const char* fcLinkProtocolName(FcLinkProtocol protocol) {
+    switch (protocol) {
+        case FcLinkProtocol::MSP:     return "msp";
+        case FcLinkProtocol::MAVLINK: return "mavlink";
+        default:                      return "?";
+    }
+}
+
+FlightController::FlightController()
+    : baud_(FlightControllerConfig::DEFAULT_BAUD), uart_queue_(nullptr), frame_queue_(nullptr),
+      task_(nullptr), protocol_(FcLinkProtocol::MSP), active_protocol_(FcLinkProtocol::MSP), mav_rx_length_(0),
+      mav_system_id_(0), mav_component_id_(0), mav_tx_sequence_(0), mav_rx_sequence_(0), mav_sequence_valid_(false),
+      requested_hz_(0), next_heartbeat_us_(0), next_stream_request_us_(0),
+      poll_hz_(FlightControllerConfig::TELEMETRY_POLL_HZ), next_poll_us_(0), last_poll_us_(0),
+      awaiting_replies_(0), slow_poll_index_(0), poll_count_(0), last_frame_us_(0), last_command_(0),
+      last_size_(0) {}
 
-void FlightController::initialize() {
+void FlightController::initialize(uint32_t baud) {
     // Initialize serial communication with the flight controller
-    // Common baud rates for flight controllers are 115200 or 57600
-    Serial1.begin(57600); // RX on GPIO 1, TX on GPIO 2
-    Serial.println("Flight Controller serial initialized.");
+    // Common baud rates for flight controllers are 115200 or 57600 (420000 for CRSF)
+    baud_ = isSupportedBaud(baud) ? baud : FlightControllerConfig::DEFAULT_BAUD;
+
+    uart_config_t config = {};
+    config.baud_rate = (int)baud_;
+    config.data_bits = UART_DATA_8_BITS;
+    config.parity = UART_PARITY_DISABLE;
+    config.stop_bits = UART_STOP_BITS_1;
+    config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+    config.source_clk = UART_SCLK_APB;
+
+    const uart_port_t port = FlightControllerConfig::UART_PORT;
+    esp_err_t err = uart_driver_install(port, FlightControllerConfig::RX_RING_SIZE,
+                                        FlightControllerConfig::TX_RING_SIZE,
+                                        FlightControllerConfig::EVENT_QUEUE_LENGTH, &uart_queue_, 0);
+    if (err != ESP_OK) {
+        Serial.printf("❌ [FC] UART driver install failed: %s\n", esp_err_to_name(err));
+        return;
+    }
+    err = uart_param_config(port, &config);
+    if (err == ESP_OK) {
+        err = uart_set_pin(port, FlightControllerConfig::TX_PIN, FlightControllerConfig::RX_PIN,
+                           UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    }
+    // The ISR empties the FIFO at the threshold and on an idle line, so a
+    // frame reaches the task a couple of character times after its last byte
+    if (err == ESP_OK) {
+        err = uart_set_rx_full_threshold(port, FlightControllerConfig::RX_FIFO_THRESHOLD);
+    }
+    if (err == ESP_OK) {
+        err = uart_set_rx_timeout(port, FlightControllerConfig::RX_TIMEOUT_SYMBOLS);
+    }
+    if (err == ESP_OK) {
+        frame_queue_ = xQueueCreate(FlightControllerConfig::FRAME_QUEUE_LENGTH, sizeof(FcFrame));
+        err = frame_queue_ ? ESP_OK : ESP_ERR_NO_MEM;
+    }
+    if (err == ESP_OK &&
+        xTaskCreatePinnedToCore(uartTask, "FcUart", FlightControllerConfig::TASK_STACK, this,
+                                FlightControllerConfig::TASK_PRIORITY, &task_,
+                                FlightControllerConfig::TASK_CORE) != pdPASS) {
+        task_ = nullptr;
+        err = ESP_ERR_NO_MEM;
+    }
+    if (err != ESP_OK) {
+        Serial.printf("❌ [FC] UART setup failed: %s\n", esp_err_to_name(err));
+        if (frame_queue_) {
+            vQueueDelete(frame_queue_);
+            frame_queue_ = nullptr;
+        }
+        uart_driver_delete(port);
+        uart_queue_ = nullptr;
+        return;
+    }
+
+    Serial.printf("Flight Controller serial initialized at %lu baud, %s (RX GPIO %d, TX GPIO %d, %d byte ring).\n",
+                  baud_, fcLinkProtocolName(protocol_), FlightControllerConfig::RX_PIN, FlightControllerConfig::TX_PIN,
+                  FlightControllerConfig::RX_RING_SIZE);
+}
+
+bool FlightController::setBaud(uint32_t baud) {
+    if (!isSupportedBaud(baud)) return false;
+    if (isRunning() && uart_set_baudrate(FlightControllerConfig::UART_PORT, baud) != ESP_OK) return false;
+    baud_ = baud;
+    return true;
+}
+
+bool FlightController::isSupportedBaud(uint32_t baud) {
+    static const uint32_t rates[] = {9600, 19200, 38400, 57600, 115200, 230400, 250000, 420000, 460800, 921600};
+    for (uint32_t rate : rates) {
+        if (rate == baud) return true;
+    }
+    return false;
+}
+
+void FlightController::onReceive(std::function<void()> callback) {
+    receive_callback_ = callback;
+}
+
+// Waits on the driver's event queue; bytes are parsed here, at task
+// priority, so the main loop only ever sees whole frames. Telemetry polls
+// go out from here too, between events.
+void FlightController::uartTask(void* parameter) {
+    FlightController* fc = static_cast<FlightController*>(parameter);
+    const uart_port_t port = FlightControllerConfig::UART_PORT;
+    uart_event_t event;
+
+    for (;;) {
+        if (fc->protocol_ != fc->active_protocol_) {
+            fc->switchProtocol();
+        }
+        if (xQueueReceive(fc->uart_queue_, &event, fc->pollIfDue()) != pdTRUE) {
+            continue;
+        }
+        switch (event.type) {
+            case UART_DATA:
+                fc->stats_.data_events++;
+                if (event.timeout_flag) fc->stats_.rx_timeouts++;
+                if (fc->active_protocol_ == FcLinkProtocol::MAVLINK) {
+                    fc->readMavlink();
+                } else {
+                    fc->readAvailable();
+                }
+                break;
+
+            case UART_FIFO_OVF:
+            case UART_BUFFER_FULL:
+                // Bytes are already lost: drop the partial frame and whatever
+                // is queued behind it, resync on the next '$'
+                fc->stats_.overruns++;
+                uart_flush_input(port);
+                xQueueReset(fc->uart_queue_);
+                fc->parser_.reset();
+                fc->mav_rx_length_ = 0;
+                break;
+
+            case UART_FRAME_ERR:
+            case UART_PARITY_ERR:
+            case UART_BREAK:
+                fc->stats_.line_errors++;
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+// Driver task: both parsers and the cached telemetry start from scratch
+void FlightController::switchProtocol() {
+    active_protocol_ = protocol_;
+    parser_.reset();
+    mav_rx_length_ = 0;
+    mav_system_id_ = 0;
+    mav_sequence_valid_ = false;
+    awaiting_replies_ = 0;
+    next_heartbeat_us_ = 0;
+    next_stream_request_us_ = 0;
+    telemetry_ = FcTelemetry();
+    portENTER_CRITICAL(&telemetry_lock_);
+    published_ = telemetry_;
+    portEXIT_CRITICAL(&telemetry_lock_);
+    uart_flush_input(FlightControllerConfig::UART_PORT);
+}
+
+void FlightController::readAvailable() {
+    const uart_port_t port = FlightControllerConfig::UART_PORT;
+    uint8_t chunk[FlightControllerConfig::RX_CHUNK];
+    bool delivered = false;
+
+    size_t buffered = 0;
+    uart_get_buffered_data_len(port, &buffered);
+    if (buffered > stats_.max_buffered) stats_.max_buffered = buffered;
+
+    while (buffered > 0) {
+        int length = uart_read_bytes(port, chunk, buffered < sizeof(chunk) ? buffered : sizeof(chunk), 0);
+        if (length <= 0) break;
+        stats_.rx_bytes += length;
+        buffered -= length;
+
+        for (int i = 0; i < length; i++) {
+            if (!parser_.feed(chunk[i])) continue;
+            handleFrame(parser_.frame());
+            // Copied by the queue: the parser reuses its frame with the next byte
+            delivered |= queueFrame(parser_.frame());
+        }
+    }
+
+    if (delivered && receive_callback_) {
+        receive_callback_();
+    }
+}
+
+// Reads straight into a linear buffer and decodes frames where they lie;
+// only an incomplete frame at the end is moved, to the front, to wait for
+// the rest of its bytes
+void FlightController::readMavlink() {
+    const uart_port_t port = FlightControllerConfig::UART_PORT;
+    bool delivered = false;
+
+    size_t buffered = 0;
+    uart_get_buffered_data_len(port, &buffered);
+    if (buffered > stats_.max_buffered) stats_.max_buffered = buffered;
+
+    while (buffered > 0) {
+        // A kept partial frame is under MAX_FRAME bytes, so there is always room
+        size_t room = sizeof(mav_rx_) - mav_rx_length_;
+        int length = uart_read_bytes(port, mav_rx_ + mav_rx_length_, buffered < room ? buffered : room, 0);
+        if (length <= 0) break;
+        stats_.rx_bytes += length;
+        buffered -= length;
+        mav_rx_length_ += length;
+
+        uint32_t received_us = (uint32_t)esp_timer_get_time();
+        size_t offset = 0;
+        MavlinkFrame frame;
+        while (mavlink_.next(mav_rx_, mav_rx_length_, offset, frame)) {
+            handleMavlinkFrame(frame, received_us);
+            // The main loop gets its own copy, as with MSP
+            FcFrame copy;
+            copy.protocol = FcProtocol::MAVLINK_V2;
+            copy.direction = '>';
+            copy.command = frame.msgid;
+            copy.size = frame.length;
+            copy.received_us = received_us;
+            memcpy(copy.payload, frame.payload(), frame.length);
+            delivered |= queueFrame(copy);
+        }
+        mav_rx_length_ -= offset;
+        memmove(mav_rx_, mav_rx_ + offset, mav_rx_length_);
+    }
+
+    if (delivered && receive_callback_) {
+        receive_callback_();
+    }
+}
+
+bool FlightController::queueFrame(const FcFrame& frame) {
+    if (xQueueSend(frame_queue_, &frame, 0) == pdTRUE) {
+        return true;
+    }
+    stats_.queue_drops++;
+    return false;
+}
+
+// Replies update the telemetry here, before the frame is queued for the
+// main loop, so the blackbox sees them at line rate
+void FlightController::handleFrame(const FcFrame& frame) {
+    last_frame_us_ = frame.received_us;
+    if (frame.direction == '<') {
+        return;
+    }
+    if (awaiting_replies_ > 0) {
+        awaiting_replies_--;
+    }
+    FcField field = decodeMspTelemetry((uint16_t)frame.command, frame.payload, frame.size, telemetry_);
+    if (field != FcField::COUNT) {
+        publishTelemetry(field, frame.received_us);
+    }
+}
+
+// Telemetry comes only from the autopilot the first flight-controller
+// HEARTBEAT named; a GCS or companion it routes to this port is ignored
+void FlightController::handleMavlinkFrame(const MavlinkFrame& frame, uint32_t received_us) {
+    last_frame_us_ = received_us;
+    if (mav_system_id_ == 0) {
+        if (frame.msgid != MavlinkMessage::HEARTBEAT.id ||
+            frame.get<uint8_t>(5) == MavlinkEnum::MAV_AUTOPILOT_INVALID ||
+            frame.get<uint8_t>(4) == MavlinkEnum::MAV_TYPE_GCS) {
+            return;
+        }
+        mav_system_id_ = frame.system_id;
+        mav_component_id_ = frame.component_id;
+        mav_sequence_valid_ = false;
+        next_stream_request_us_ = 0;
+    }
+    if (frame.system_id != mav_system_id_ || frame.component_id != mav_component_id_) {
+        return;
+    }
+
+    if (mav_sequence_valid_) {
+        stats_.sequence_gaps += (uint8_t)(frame.sequence - mav_rx_sequence_ - 1);
+    }
+    mav_rx_sequence_ = frame.sequence;
+    mav_sequence_valid_ = true;
+
+    if (frame.msgid == MavlinkMessage::COMMAND_ACK.id) {
+        if (frame.get<uint8_t>(2) == MavlinkEnum::MAV_RESULT_ACCEPTED) {
+            stats_.command_acks++;
+        } else {
+            stats_.command_nacks++;
+        }
+        return;
+    }
+    FcField field = decodeMavlinkTelemetry(frame, telemetry_);
+    if (field != FcField::COUNT) {
+        publishTelemetry(field, received_us);
+    }
+}
+
+void FlightController::publishTelemetry(FcField field, uint32_t received_us) {
+    telemetry_.updated_us[(size_t)field] = received_us;
+    portENTER_CRITICAL(&telemetry_lock_);
+    published_ = telemetry_;
+    portEXIT_CRITICAL(&telemetry_lock_);
+    if (telemetry_handler_) {
+        telemetry_handler_(field, telemetry_);
+    }
+}
+
+// Sends a poll when one is due; returns how long the task may wait for events
+TickType_t FlightController::pollIfDue() {
+    if (active_protocol_ == FcLinkProtocol::MAVLINK) {
+        return mavlinkIfDue();
+    }
+    uint16_t hz = poll_hz_;
+    if (hz == 0) {
+        return portMAX_DELAY;
+    }
+    int64_t period_us = 1000000 / hz;
+    int64_t now = esp_timer_get_time();
+    if (now >= next_poll_us_) {
+        sendPoll();
+        next_poll_us_ += period_us;
+        if (next_poll_us_ <= now) {
+            next_poll_us_ = now + period_us;    // Rate changed or the task fell behind: no burst
+        }
+    }
+    TickType_t ticks = (TickType_t)((next_poll_us_ - now) / 1000 / portTICK_PERIOD_MS);
+    return ticks > 0 ? ticks : 1;
+}
+
+// Attitude, IMU and RC every poll; status, analog and altitude take turns
+// at about 10 Hz each. Held back while the last burst's replies are still
+// arriving, so a slow baud rate lowers the rate instead of piling up requests.
+void FlightController::sendPoll() {
+    static const uint8_t FAST[] = {MspCommand::ATTITUDE, MspCommand::RAW_IMU, MspCommand::RC};
+    static const uint8_t SLOW[] = {MspCommand::STATUS, MspCommand::ANALOG, MspCommand::ALTITUDE};
+
+    int64_t now = esp_timer_get_time();
+    if (awaiting_replies_ > 0 && now - last_poll_us_ < (int64_t)FlightControllerConfig::POLL_REPLY_TIMEOUT_MS * 1000) {
+        stats_.poll_skips++;
+        return;
+    }
+
+    uint8_t request[6 * (sizeof(FAST) + 1)];
+    size_t length = 0;
+    uint8_t commands[sizeof(FAST) + 1];
+    size_t count = 0;
+    for (uint8_t command : FAST) {
+        commands[count++] = command;
+    }
+    uint16_t slow_every = poll_hz_ / 30 > 0 ? poll_hz_ / 30 : 1;
+    if (poll_count_++ % slow_every == 0) {
+        commands[count++] = SLOW[slow_poll_index_];
+        slow_poll_index_ = (slow_poll_index_ + 1) % sizeof(SLOW);
+    }
+    // MSP v1 request without payload: the checksum is size ^ command = command
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t frame[6] = {'$', 'M', '<', 0, commands[i], commands[i]};
+        memcpy(request + length, frame, sizeof(frame));
+        length += sizeof(frame);
+    }
+    write(request, length);
+    awaiting_replies_ = (uint8_t)count;
+    last_poll_us_ = now;
+    stats_.polls++;
+}
+
+// MAVLink autopilots stream on their own once asked: the task only sends
+// its HEARTBEAT and repeats the interval requests now and then
+TickType_t FlightController::mavlinkIfDue() {
+    int64_t now = esp_timer_get_time();
+    if (now >= next_heartbeat_us_) {
+        uint8_t frame[MavlinkConfig::MAX_FRAME];
+        uint8_t* payload = frame + MavlinkConfig::HEADER_SIZE;
+        memset(payload, 0, MavlinkMessage::HEARTBEAT.length);
+        payload[4] = MavlinkEnum::MAV_TYPE_CAMERA;
+        payload[5] = MavlinkEnum::MAV_AUTOPILOT_INVALID;
+        payload[7] = MavlinkEnum::MAV_STATE_ACTIVE;
+        payload[8] = 3;     // mavlink_version
+        sendMavlink(frame, MavlinkMessage::HEARTBEAT);
+        next_heartbeat_us_ = now + (int64_t)FlightControllerConfig::MAVLINK_HEARTBEAT_MS * 1000;
+
+        if (mav_system_id_ != 0 && !isLinkUp()) {
+            mav_system_id_ = 0;     // Gone: lock on to whichever autopilot speaks next
+        }
+    }
+    int64_t next_us = next_heartbeat_us_;
+    if (mav_system_id_ != 0) {
+        if (now >= next_stream_request_us_ || requested_hz_ != poll_hz_) {
+            requestStreams();
+            next_stream_request_us_ = now + (int64_t)FlightControllerConfig::MAVLINK_STREAM_REFRESH_MS * 1000;
+        }
+        if (next_stream_request_us_ < next_us) next_us = next_stream_request_us_;
+    }
+    TickType_t ticks = (TickType_t)((next_us - now) / 1000 / portTICK_PERIOD_MS);
+    return ticks > 0 ? ticks : 1;
+}
+
+// Our frames carry the autopilot's system id, as a component of the same vehicle
+void FlightController::sendMavlink(uint8_t* frame, const MavlinkMessageInfo& message) {
+    uint8_t system_id = mav_system_id_ ? mav_system_id_ : 1;
+    size_t size = mavlinkFinishFrame(frame, message, mav_tx_sequence_++, system_id,
+                                     FlightControllerConfig::MAVLINK_COMPONENT_ID);
+    write(frame, size);
+}
+
+// SET_MESSAGE_INTERVAL works on ArduPilot and PX4 alike and applies to this
+// port only, so a GCS on another link keeps its own rates
+void FlightController::requestStreams() {
+    static const uint32_t FAST[] = {MavlinkMessage::ATTITUDE.id, MavlinkMessage::RAW_IMU.id,
+                                    MavlinkMessage::RC_CHANNELS.id};
+    static const uint32_t SLOW[] = {MavlinkMessage::SYS_STATUS.id, MavlinkMessage::BATTERY_STATUS.id,
+                                    MavlinkMessage::GLOBAL_POSITION_INT.id};
+
+    uint16_t hz = poll_hz_;
+    uint16_t slow_hz = hz < FlightControllerConfig::MAVLINK_SLOW_STREAM_HZ ? hz
+                                                                          : FlightControllerConfig::MAVLINK_SLOW_STREAM_HZ;
+    uint8_t frame[MavlinkConfig::MAX_FRAME];
+    uint8_t* payload = frame + MavlinkConfig::HEADER_SIZE;
+    for (size_t i = 0; i < sizeof(FAST) / sizeof(FAST[0]) + sizeof(SLOW) / sizeof(SLOW[0]); i++) {
+        bool fast = i < sizeof(FAST) / sizeof(FAST[0]);
+        uint32_t msgid = fast ? FAST[i] : SLOW[i - sizeof(FAST) / sizeof(FAST[0])];
+        uint16_t rate = fast ? hz : slow_hz;
+        memset(payload, 0, MavlinkMessage::COMMAND_LONG.length);
+        mavlinkPut<float>(payload, 0, (float)msgid);                                // param1: message id
+        mavlinkPut<float>(payload, 4, rate ? 1000000.0f / rate : -1.0f);            // param2: interval us, -1 = off
+        mavlinkPut<uint16_t>(payload, 28, MavlinkEnum::MAV_CMD_SET_MESSAGE_INTERVAL);
+        payload[30] = mav_system_id_;
+        payload[31] = mav_component_id_;
+        sendMavlink(frame, MavlinkMessage::COMMAND_LONG);
+        stats_.stream_requests++;
+    }
+    requested_hz_ = hz;
+}
+
+FcTelemetry FlightController::getTelemetry() const {
+    portENTER_CRITICAL(&telemetry_lock_);
+    FcTelemetry copy = published_;
+    portEXIT_CRITICAL(&telemetry_lock_);
+    return copy;
+}
+
+bool FlightController::isLinkUp() const {
+    uint32_t last = last_frame_us_;
+    return last != 0 && (uint32_t)esp_timer_get_time() - last < FlightControllerConfig::LINK_TIMEOUT_MS * 1000;
 }
 
 void FlightController::update() {
-    // Read data from the flight controller and process it
-     while (Serial1.available()) {
-      uint8_t c = Serial1.read();
-      Serial.print("0x");
-      Serial.print(c, HEX);
-      Serial.print(" ");
-    }
-}
-
-void FlightController::testConnection() {
-   Serial.println("=== Отправка MSP запроса ===");
-    
-    uint8_t msp_request[] = {'$', 'M', '<', 0, 101, 101};
-    Serial1.write(msp_request, sizeof(msp_request));
-    
-    Serial.print("Отправлено: ");
-    for(int i = 0; i < sizeof(msp_request); i++) {
-        Serial.print("0x");
-        if(msp_request[i] < 16) Serial.print("0");
-        Serial.print(msp_request[i], HEX);
-        Serial.print(" ");
-    }
-    Serial.println();
-    
-    Serial.println("Ожидание ответа FC (3 сек)...");
-    
-    // Ждем ответ 3 секунды
+    if (!frame_queue_) return;
+    FcFrame frame;
+    while (xQueueReceive(frame_queue_, &frame, 0) == pdTRUE) {
+        noteDelivered(frame);
+    }
+}
+
+void FlightController::noteDelivered(const FcFrame& frame) {
+    uint32_t delivery_us = (uint32_t)esp_timer_get_time() - frame.received_us;
+    stats_.avg_delivery_us = stats_.avg_delivery_us
+        ? stats_.avg_delivery_us - stats_.avg_delivery_us / 8 + delivery_us / 8
+        : delivery_us;
+    if (delivery_us > stats_.max_delivery_us) stats_.max_delivery_us = delivery_us;
+    last_command_ = frame.command;
+    last_size_ = frame.size;
+
+    if (frame_handler_) {
+        frame_handler_(frame);
+    }
+}
+
+size_t FlightController::write(const uint8_t* data, size_t length) {
+    if (!isRunning()) return 0;
+    int written = uart_write_bytes(FlightControllerConfig::UART_PORT, data, length);
+    return written > 0 ? (size_t)written : 0;
+}
+
+void FlightController::resetStats() {
+    stats_ = FcLinkStats();
+    parser_.resetStats();
+    mavlink_.resetStats();
+}
+
+void FlightController::printStatus(Print& out) const {
+    const FcParserStats& parser = parser_.getStats();
+    const MavlinkParserStats& mavlink = mavlink_.getStats();
+    out.println("\n=== Flight Controller Link ===");
+    out.printf("UART%d at %lu baud, RX GPIO %d, TX GPIO %d, driver task %s\n", (int)FlightControllerConfig::UART_PORT,
+               baud_, FlightControllerConfig::RX_PIN, FlightControllerConfig::TX_PIN,
+               isRunning() ? "running" : "NOT running");
+    out.printf("RX: %lu bytes in %lu events (%lu on idle line), peak ring %lu/%d bytes\n", stats_.rx_bytes,
+               stats_.data_events, stats_.rx_timeouts, stats_.max_buffered, FlightControllerConfig::RX_RING_SIZE);
+    if (protocol_ == FcLinkProtocol::MAVLINK) {
+        if (mav_system_id_) {
+            out.printf("Protocol: MAVLink v2, autopilot system %u component %u, %lu frames lost (sequence gaps)\n",
+                       mav_system_id_, mav_component_id_, stats_.sequence_gaps);
+        } else {
+            out.println("Protocol: MAVLink v2, no autopilot HEARTBEAT yet");
+        }
+        out.printf("Frames: %lu ok, %lu checksum errors, %lu not in subset, %lu signed, %lu bad headers, "
+                   "%lu garbage bytes\n", mavlink.frames, mavlink.crc_errors, mavlink.unknown, mavlink.signed_frames,
+                   mavlink.bad_headers, mavlink.garbage_bytes);
+    } else {
+        out.println("Protocol: MSP");
+        out.printf("Frames: %lu ok, %lu checksum errors, %lu oversize, %lu garbage bytes\n", parser.frames,
+                   parser.checksum_errors, parser.oversize, parser.garbage_bytes);
+    }
+    out.printf("Overruns: %lu%s, line errors: %lu, queue drops: %lu\n", stats_.overruns,
+               stats_.overruns ? " ⚠️" : "", stats_.line_errors, stats_.queue_drops);
+    out.printf("Delivery (driver task -> loop): avg %lu us, max %lu us; last frame cmd %lu, %u bytes\n",
+               stats_.avg_delivery_us, stats_.max_delivery_us, last_command_, last_size_);
+    if (protocol_ == FcLinkProtocol::MAVLINK) {
+        out.printf("Telemetry streams: %u Hz requested, %lu interval commands (%lu accepted, %lu refused); link %s\n",
+                   poll_hz_, stats_.stream_requests, stats_.command_acks, stats_.command_nacks,
+                   isLinkUp() ? "up" : "down");
+    } else {
+        out.printf("Telemetry poll: %u Hz, %lu sent, %lu held back for replies; link %s\n", poll_hz_, stats_.polls,
+                   stats_.poll_skips, isLinkUp() ? "up" : "down");
+    }
+    out.println("==============================\n");
+}
+
+void FlightController::testConnection(Print& out) {
+    // MAVLink: запрос не нужен, автопилот сам шлёт HEARTBEAT раз в секунду
+    bool mavlink = protocol_ == FcLinkProtocol::MAVLINK;
+    const uint32_t expected = mavlink ? MavlinkMessage::HEARTBEAT.id : 101;
+    out.println(mavlink ? "=== Ожидание MAVLink HEARTBEAT ===" : "=== Отправка MSP запроса ===");
+    if (!isRunning()) {
+        out.println("UART драйвер не запущен ❌");
+        out.println("========================");
+        return;
+    }
+
+    if (!mavlink) {
+        uint8_t msp_request[] = {'$', 'M', '<', 0, 101, 101};
+        write(msp_request, sizeof(msp_request));
+
+        out.print("Отправлено: ");
+        for(size_t i = 0; i < sizeof(msp_request); i++) {
+            out.print("0x");
+            if(msp_request[i] < 16) out.print("0");
+            out.print(msp_request[i], HEX);
+            out.print(" ");
+        }
+        out.println();
+    }
+
+    out.println("Ожидание ответа FC (3 сек)...");
+
+    // Ответ приходит кадром из задачи драйвера; прочие кадры идут обычным путём
     unsigned long start = millis();
     bool got_response = false;
-    
-    while(millis() - start < 3000) {
-        if(Serial1.available()) {
-            if(!got_response) {
-                Serial.print("Ответ FC: ");
-                got_response = true;
-            }
-            uint8_t byte = Serial1.read();
-            Serial.print("0x");
-            if(byte < 16) Serial.print("0");
-            Serial.print(byte, HEX);
-            Serial.print(" ");
-        }
-        delay(1);
-    }
-    
+    FcFrame frame;
+
+    while(!got_response && millis() - start < FlightControllerConfig::TEST_TIMEOUT_MS) {
+        uint32_t remaining = FlightControllerConfig::TEST_TIMEOUT_MS - (millis() - start);
+        if (xQueueReceive(frame_queue_, &frame, pdMS_TO_TICKS(remaining)) != pdTRUE) {
+            continue;
+        }
+        noteDelivered(frame);
+        if (frame.command != expected || frame.direction == '<' ||
+            (frame.protocol == FcProtocol::MAVLINK_V2) != mavlink) {
+            continue;
+        }
+        got_response = true;
+        out.printf("Ответ FC (%s%s, %u байт): ", fcProtocolName(frame.protocol),
+                   frame.direction == '!' ? ", ошибка" : "", frame.size);
+        for (uint16_t i = 0; i < frame.size; i++) {
+            out.print("0x");
+            if(frame.payload[i] < 16) out.print("0");
+            out.print(frame.payload[i], HEX);
+            out.print(" ");
+        }
+    }
+
     if(got_response) {
-        Serial.println(" <- СВЯЗЬ РАБОТАЕТ! ✅");
+        out.println(" <- СВЯЗЬ РАБОТАЕТ! ✅");
     } else {
-        Serial.println("НЕТ ОТВЕТА - проверьте подключение ❌");
+        out.println("НЕТ ОТВЕТА - проверьте подключение ❌");
     }
-    Serial.println("========================");
+    out.println("========================");
 }
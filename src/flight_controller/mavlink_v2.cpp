@@ -0,0 +1,143 @@
+// src/flight_controller/mavlink_v2.cpp - MAVLink v2: разбор кадров на месте и сборка исходящих
+#include "mavlink_v2.h"
+
+// The generated values against the ones mavgen publishes for common.xml: a
+// mistyped or misordered field list stops the build here
+static_assert(MavlinkMessage::HEARTBEAT.crc_extra == 50 && MavlinkMessage::HEARTBEAT.length == 9, "HEARTBEAT");
+static_assert(MavlinkMessage::SYS_STATUS.crc_extra == 124 && MavlinkMessage::SYS_STATUS.length == 31, "SYS_STATUS");
+static_assert(MavlinkMessage::RAW_IMU.crc_extra == 144 && MavlinkMessage::RAW_IMU.length == 26, "RAW_IMU");
+static_assert(MavlinkMessage::ATTITUDE.crc_extra == 39 && MavlinkMessage::ATTITUDE.length == 28, "ATTITUDE");
+static_assert(MavlinkMessage::GLOBAL_POSITION_INT.crc_extra == 104 && MavlinkMessage::GLOBAL_POSITION_INT.length == 28,
+              "GLOBAL_POSITION_INT");
+static_assert(MavlinkMessage::RC_CHANNELS.crc_extra == 118 && MavlinkMessage::RC_CHANNELS.length == 42, "RC_CHANNELS");
+static_assert(MavlinkMessage::COMMAND_LONG.crc_extra == 152 && MavlinkMessage::COMMAND_LONG.length == 33,
+              "COMMAND_LONG");
+static_assert(MavlinkMessage::COMMAND_ACK.crc_extra == 143 && MavlinkMessage::COMMAND_ACK.length == 3, "COMMAND_ACK");
+static_assert(MavlinkMessage::BATTERY_STATUS.crc_extra == 154 && MavlinkMessage::BATTERY_STATUS.length == 36,
+              "BATTERY_STATUS");
+
+namespace {
+
+// Sorted by id for the lookup
+const MavlinkMessageInfo kMessages[] = {
+    MavlinkMessage::HEARTBEAT,
+    MavlinkMessage::SYS_STATUS,
+    MavlinkMessage::RAW_IMU,
+    MavlinkMessage::ATTITUDE,
+    MavlinkMessage::GLOBAL_POSITION_INT,
+    MavlinkMessage::RC_CHANNELS,
+    MavlinkMessage::COMMAND_LONG,
+    MavlinkMessage::COMMAND_ACK,
+    MavlinkMessage::BATTERY_STATUS,
+};
+
+} // namespace
+
+const MavlinkMessageInfo* mavlinkFindMessage(uint32_t id) {
+    for (const MavlinkMessageInfo& info : kMessages) {
+        if (info.id == id) return &info;
+        if (info.id > id) break;
+    }
+    return nullptr;
+}
+
+uint16_t mavlinkCrc(const uint8_t* data, size_t length, uint16_t crc) {
+    for (size_t i = 0; i < length; i++) {
+        crc = MavlinkDetail::x25(crc, data[i]);
+    }
+    return crc;
+}
+
+bool MavlinkParser::next(const uint8_t* data, size_t length, size_t& offset, MavlinkFrame& frame) {
+    while (offset < length) {
+        const uint8_t* start = (const uint8_t*)memchr(data + offset, MavlinkConfig::STX, length - offset);
+        if (!start) {
+            stats_.garbage_bytes += length - offset;
+            offset = length;
+            return false;
+        }
+        stats_.garbage_bytes += (size_t)(start - (data + offset));
+        offset = (size_t)(start - data);
+
+        size_t available = length - offset;
+        if (available < 3) return false;
+        uint8_t payload_length = start[1];
+        uint8_t incompat = start[2];
+        if (incompat & ~MavlinkConfig::INCOMPAT_SIGNED) {
+            stats_.bad_headers++;
+            stats_.garbage_bytes++;
+            offset++;
+            continue;
+        }
+        bool is_signed = (incompat & MavlinkConfig::INCOMPAT_SIGNED) != 0;
+        size_t size = MavlinkConfig::HEADER_SIZE + payload_length + MavlinkConfig::CHECKSUM_SIZE +
+                      (is_signed ? MavlinkConfig::SIGNATURE_SIZE : 0);
+        if (available < size) return false;
+
+        uint32_t msgid = start[7] | ((uint32_t)start[8] << 8) | ((uint32_t)start[9] << 16);
+        const MavlinkMessageInfo* info = mavlinkFindMessage(msgid);
+        if (!info) {
+            // Without its CRC_EXTRA the checksum cannot be checked. The length
+            // is trusted only when the next frame starts right behind it: a
+            // corrupted length byte would otherwise skip the real frames it
+            // covers. Until that byte has arrived the frame is kept
+            if (available == size) return false;
+            if (start[size] != MavlinkConfig::STX) {
+                stats_.garbage_bytes++;
+                offset++;
+                continue;
+            }
+            stats_.unknown++;
+            offset += size;
+            continue;
+        }
+
+        const uint8_t* checksum = start + MavlinkConfig::HEADER_SIZE + payload_length;
+        uint16_t crc = mavlinkCrc(start + 1, MavlinkConfig::HEADER_SIZE - 1 + payload_length);
+        crc = MavlinkDetail::x25(crc, info->crc_extra);
+        if (crc != (uint16_t)(checksum[0] | (checksum[1] << 8))) {
+            stats_.crc_errors++;
+            stats_.garbage_bytes++;
+            offset++;
+            continue;
+        }
+
+        frame.data = start;
+        frame.info = info;
+        frame.msgid = msgid;
+        frame.length = payload_length;
+        frame.sequence = start[4];
+        frame.system_id = start[5];
+        frame.component_id = start[6];
+        frame.is_signed = is_signed;
+        offset += size;
+        stats_.frames++;
+        if (is_signed) stats_.signed_frames++;
+        return true;
+    }
+    return false;
+}
+
+size_t mavlinkFinishFrame(uint8_t* frame, const MavlinkMessageInfo& info, uint8_t sequence, uint8_t system_id,
+                          uint8_t component_id) {
+    const uint8_t* payload = frame + MavlinkConfig::HEADER_SIZE;
+    size_t length = info.length;
+    while (length > 1 && payload[length - 1] == 0) {
+        length--;
+    }
+    frame[0] = MavlinkConfig::STX;
+    frame[1] = (uint8_t)length;
+    frame[2] = 0;
+    frame[3] = 0;
+    frame[4] = sequence;
+    frame[5] = system_id;
+    frame[6] = component_id;
+    frame[7] = (uint8_t)info.id;
+    frame[8] = (uint8_t)(info.id >> 8);
+    frame[9] = (uint8_t)(info.id >> 16);
+    uint16_t crc = mavlinkCrc(frame + 1, MavlinkConfig::HEADER_SIZE - 1 + length);
+    crc = MavlinkDetail::x25(crc, info.crc_extra);
+    frame[MavlinkConfig::HEADER_SIZE + length] = (uint8_t)crc;
+    frame[MavlinkConfig::HEADER_SIZE + length + 1] = (uint8_t)(crc >> 8);
+    return MavlinkConfig::HEADER_SIZE + length + MavlinkConfig::CHECKSUM_SIZE;
+}
@@ -1,61 +1,804 @@
 // src/http/mjpeg_server.cpp
 #include "mjpeg_server.h"
+#include "memory_pool.h"
+#include "camera_bench.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "web_assets.h"      // генерируется tools/embed_web.py
+#include "esp_netif.h"
+#include "lwip/sockets.h"
+#include <algorithm>
+#include <errno.h>
 
-MJPEGServer::MJPEGServer(int port) : server(port), camera(nullptr) {}
+static const char STREAM_RESPONSE_HEADER[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: multipart/x-mixed-replace; boundary=--frame\r\n"
+    "Connection: close\r\n\r\n";
+
+// Page URLs are not versioned, so a cached copy must be revalidated; the
+// ETag turns that into an empty 304 while the firmware is unchanged
+static const char ASSET_CACHE_CONTROL[] = "no-cache";
+static const char* ASSET_REQUEST_HEADERS[] = {"If-None-Match"};
+
+// Longer gaps between sent frames are pauses (no viewers, motion skip), not jitter
+static const uint32_t PACING_GAP_US = 500000;
+static const long MAX_VIEWER_FPS = 30;
+
+// Print adapter that streams text reports as chunked HTTP content. Buffers
+// come from the socket pool; a small inline buffer covers an exhausted pool.
+class ChunkedResponsePrint : public Print {
+public:
+    explicit ChunkedResponsePrint(WebServer& server)
+        : server_(server), pooled_(MemoryPools::socketBuffers().acquire()), length_(0) {
+        buffer_ = pooled_ ? (char*)pooled_ : fallback_;
+        capacity_ = pooled_ ? MemoryPools::socketBuffers().getBlockSize() : sizeof(fallback_);
+    }
+
+    ~ChunkedResponsePrint() {
+        flush();
+        MemoryPools::socketBuffers().release(pooled_);
+    }
+
+    size_t write(uint8_t c) override {
+        if (length_ == capacity_) flush();
+        buffer_[length_++] = (char)c;
+        return 1;
+    }
+
+    void flush() override {
+        if (length_ == 0) return;
+        server_.sendContent(buffer_, length_);
+        length_ = 0;
+    }
+
+private:
+    WebServer& server_;
+    uint8_t* pooled_;
+    char* buffer_;
+    size_t capacity_;
+    size_t length_;
+    char fallback_[128];
+};
+
+// Station MAC behind a client IP, from the AP's DHCP lease table
+static bool findStationMac(const IPAddress& ip, uint8_t mac[6]) {
+    wifi_sta_list_t stations;
+    esp_netif_sta_list_t leases;
+    if (esp_wifi_ap_get_sta_list(&stations) != ESP_OK ||
+        esp_netif_get_sta_list(&stations, &leases) != ESP_OK) {
+        return false;
+    }
+    for (int i = 0; i < leases.num; i++) {
+        if (leases.sta[i].ip.addr == (uint32_t)ip) {
+            memcpy(mac, leases.sta[i].mac, 6);
+            return true;
+        }
+    }
+    return false;
+}
+
+enum class PartWrite : uint8_t {
+    SENT,
+    NO_ROOM,        // Send buffer full before the first byte: skip this frame
+    SHORT           // Stopped mid-part (deadline, error): the stream is out of sync
+};
+
+// Non-blocking send of one piece of a part. Waits for room only once the
+// part has started, and never past the deadline.
+static PartWrite sendPiece(int fd, const uint8_t* data, size_t length, int64_t deadline_us, bool& started) {
+    while (length > 0) {
+        int n = send(fd, data, length, MSG_DONTWAIT);
+        if (n > 0) {
+            started = true;
+            data += n;
+            length -= (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            return PartWrite::SHORT;
+        }
+        if (!started) {
+            return PartWrite::NO_ROOM;
+        }
+        int64_t left_us = deadline_us - esp_timer_get_time();
+        if (left_us <= 0) {
+            return PartWrite::SHORT;
+        }
+        fd_set set;
+        FD_ZERO(&set);
+        FD_SET(fd, &set);
+        struct timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = (long)left_us;
+        if (select(fd + 1, nullptr, &set, nullptr, &tv) < 0) {
+            return PartWrite::SHORT;
+        }
+    }
+    return PartWrite::SENT;
+}
+
+// One multipart part: boundary and headers go out in a single write.
+// X-Timestamp is the capture time (seconds since boot); clients use it to
+// measure delivery delay, e.g. tools/stream_load.cpp. WiFiClient::write
+// would retry a full send buffer for ~10 s on the loop task; here a stalled
+// viewer costs nothing and a slow one at most WRITE_DEADLINE_MS.
+static PartWrite writeMultipartFrame(WiFiClient& client, const uint8_t* data, size_t length,
+                                     const struct timeval& timestamp) {
+    ArenaScope scope(MemoryPools::http());
+    char* header = scope.arena().format(
+        "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\nX-Timestamp: %ld.%06ld\r\n\r\n",
+        (unsigned)length, (long)timestamp.tv_sec, (long)timestamp.tv_usec);
+    if (!header) {
+        return PartWrite::NO_ROOM;
+    }
+    int fd = client.fd();
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)ViewerConfig::WRITE_DEADLINE_MS * 1000;
+    bool started = false;
+    PartWrite result = sendPiece(fd, (const uint8_t*)header, strlen(header), deadline_us, started);
+    if (result == PartWrite::SENT) {
+        result = sendPiece(fd, data, length, deadline_us, started);
+    }
+    if (result == PartWrite::SENT) {
+        result = sendPiece(fd, (const uint8_t*)"\r\n", 2, deadline_us, started);
+    }
+    return result;
+}
+
+const char* pipelineModeName(PipelineMode mode) {
+    return mode == PipelineMode::LATENCY ? "latency" : "throughput";
+}
+
+MJPEGServer::MJPEGServer(int port)
+    : server(port), camera(nullptr), profiler(nullptr), analyzer(nullptr), rawPipeline(nullptr), blackbox(nullptr),
+      trace_buffer(nullptr), tracing(false), download(DownloadSource::NONE), download_offset(0),
+      download_size(0), download_progress_ms(0), raw_seq(0), pipeline_mode(PipelineMode::THROUGHPUT),
+      frame_signal_seq(0), frame_signal_us(0),
+      last_send_us(0) {}
 
 void MJPEGServer::start(OV2640Camera* cam) {
     this->camera = cam;
-    server.on("/", HTTP_GET, [this]() {
-        this->handleRoot();
-    });
+    pipeline_mode = cam->getDriverSettings().grab_mode == CAMERA_GRAB_LATEST ? PipelineMode::LATENCY
+                                                                             : PipelineMode::THROUGHPUT;
+    for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+        const WebAsset* asset = &WEB_ASSETS[i];
+        server.on(asset->path, HTTP_GET, [this, asset]() {
+            this->handleAsset(*asset);
+        });
+    }
     server.on("/stream", HTTP_GET, [this]() {
         this->handleStream();
     });
+    server.on("/tasks", HTTP_GET, [this]() {
+        this->handleTasks();
+    });
+    server.on("/thumb", HTTP_GET, [this]() {
+        this->handleThumb();
+    });
+    server.on("/bench", HTTP_GET, [this]() {
+        this->handleBench();
+    });
+    server.on("/trace", HTTP_GET, [this]() {
+        this->handleTrace();
+    });
+    server.on("/blackbox", HTTP_GET, [this]() {
+        this->handleBlackbox();
+    });
+    server.collectHeaders(ASSET_REQUEST_HEADERS, 1);
     server.begin();
     Serial.println("MJPEG server started on port 80");
 }
 
-void MJPEGServer::handleClients() {
+void MJPEGServer::handleRequests() {
     server.handleClient();
+    continueDownload();
 }
 
-void MJPEGServer::handleRoot() {
-    server.send(200, "text/html", "<html><head><title>ESP32-S3 MJPEG Stream</title><style>body{margin:0;padding:0;background-color:#000;}img{width:100vw;height:100vh;object-fit:contain;}</style></head><body><img src='/stream'></body></html>");
+// Precompressed page from flash. A matching If-None-Match gets an empty 304,
+// so a reconnecting viewer costs one small request instead of a page transfer.
+void MJPEGServer::handleAsset(const WebAsset& asset) {
+    server.sendHeader("ETag", asset.etag);
+    server.sendHeader("Cache-Control", ASSET_CACHE_CONTROL);
+
+    if (server.hasHeader("If-None-Match") && server.header("If-None-Match") == asset.etag) {
+        server.send(304);
+        return;
+    }
+
+    server.sendHeader("Content-Encoding", "gzip");
+    server.send_P(200, asset.content_type, (const char*)asset.data, asset.length);
+}
+
+void MJPEGServer::handleTasks() {
+    if (!profiler) {
+        server.send(503, "text/plain", "Profiler not attached");
+        return;
+    }
+
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/plain", "");
+    {
+        ChunkedResponsePrint out(server);
+        profiler->printReport(out);
+    }
+    server.sendContent("");     // Terminating chunk
+}
+
+// Same sweep as the `bench` console command: /bench?size=hd,vga&q=12,25&fb=2,3
+void MJPEGServer::handleBench() {
+    if (rawPipeline && rawPipeline->isRunning()) {
+        server.send(409, "text/plain", "Raw pipeline owns the camera");
+        return;
+    }
+
+    CameraBenchMatrix matrix;
+    matrix.reset(camera->getDriverSettings());
+    static const char* const KEYS[] = {"size", "q", "fb", "grab", "xclk", "n"};
+    for (const char* key : KEYS) {
+        if (!server.hasArg(key)) {
+            continue;
+        }
+        String values = server.arg(key);
+        if (!matrix.set(key, values.c_str(), values.length())) {
+            server.send(400, "text/plain", String("Bad value list for ") + key);
+            return;
+        }
+    }
+    if (matrix.combinations() > CameraBenchConfig::MAX_COMBINATIONS) {
+        server.send(400, "text/plain", "Too many combinations");
+        return;
+    }
+
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/csv", "");
+    {
+        ChunkedResponsePrint out(server);
+        CameraBench::run(*camera, matrix, out);
+    }
+    server.sendContent("");     // Terminating chunk
 }
 
+// Adopts the connection into a viewer slot and returns; frames are fanned
+// out to all viewers from streamToViewers() without blocking loop().
 void MJPEGServer::handleStream() {
     WiFiClient client = server.client();
     if (!client) {
         return;
     }
 
-    String response = "HTTP/1.1 200 OK\r\n";
-    response += "Content-Type: multipart/x-mixed-replace; boundary=--frame\r\n";
-    response += "Connection: close\r\n\r\n";
-    server.sendContent(response);
+    uint8_t mac[6];
+    bool known_mac = findStationMac(client.remoteIP(), mac);
+    String token = server.arg("token");
+    ViewerRole role = viewerPolicy.classify(token.c_str(), known_mac ? mac : nullptr);
 
-    while (client.connected()) {
-        camera_fb_t* fb = camera->getFrameBuffer();
-        if (!fb) {
-            Serial.println("Failed to get frame buffer");
+    int evicted = -1;
+    int slot = viewerPolicy.admit(role, known_mac ? mac : nullptr, millis(), &evicted);
+    if (slot < 0) {
+        server.send(503, "text/plain", "Viewer limit reached");
+        return;
+    }
+    if (evicted >= 0) {
+        Serial.printf("[STREAM] Observer %d replaced by a pilot\n", evicted);
+        viewers[evicted].stop();
+    }
+
+    // Video goes out in the WMM video access category (AC_VI)
+    int tos = ViewerConfig::VIDEO_IP_TOS;
+    setsockopt(client.fd(), IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+    client.setNoDelay(pipeline_mode == PipelineMode::LATENCY);
+
+    // Optional own frame rate: /stream?fps=15
+    long fps = server.hasArg("fps") ? server.arg("fps").toInt() : 0;
+    if (fps > 0) {
+        viewerPolicy.setTargetFps(slot, (uint32_t)(fps < MAX_VIEWER_FPS ? fps : MAX_VIEWER_FPS), millis());
+    }
+
+    viewers[slot] = client;
+    feeds[slot] = ViewerFeed::FRAME;
+    server.sendContent(STREAM_RESPONSE_HEADER, sizeof(STREAM_RESPONSE_HEADER) - 1);
+    Serial.printf("[STREAM] %s %s joined (slot %d, %u viewer(s)%s)\n", viewerRoleName(role),
+                  client.remoteIP().toString().c_str(), slot, (unsigned)viewerPolicy.getActiveCount(),
+                  fps > 0 ? ", paced" : "");
+}
+
+void MJPEGServer::dropViewer(int slot, const char* reason) {
+    const ViewerSlot& viewer = viewerPolicy.getSlot(slot);
+    Serial.printf("[STREAM] %s in slot %d left (%s), %lu frames sent\n",
+                  viewerRoleName(viewer.role), slot, reason, viewer.stats.frames_sent);
+    viewers[slot].stop();
+    viewers[slot] = WiFiClient();
+    feeds[slot] = ViewerFeed::FRAME;
+    viewerPolicy.release(slot);
+}
+
+// One camera frame per new sensor frame, written to the pilots that are due
+// and then to the observers whose rate and byte budget allow it. Nothing
+// here waits on a timer: the VSYNC count (or the raw pipeline's sequence)
+// says when a frame is ready, per-viewer rates are deadlines in ViewerPolicy.
+bool MJPEGServer::streamToViewers() {
+    if (viewerPolicy.getActiveCount() == 0) {
+        last_send_us = 0;
+        return false;
+    }
+    if (!frameReady()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < ViewerConfig::MAX_VIEWERS; i++) {
+        if (viewerPolicy.getSlot(i).active && !viewers[i].connected()) {
+            dropViewer((int)i, "disconnected");
+        }
+    }
+    if (viewerPolicy.getActiveCount() == 0) {
+        return false;
+    }
+
+    int64_t wait_start = esp_timer_get_time();
+    camera_fb_t* fb = nextFrame();
+    if (!fb) {
+        return false;
+    }
+    int64_t frame_us = esp_timer_get_time();
+    unsigned long now = millis();
+    if (tracing) {
+        recordTraceFrame(fb, (uint32_t)(frame_us - wait_start));
+    }
+
+    if (analyzer && !analyzer->shouldSend(fb)) {
+        returnFrame(fb);
+        return false;
+    }
+
+    int order[ViewerConfig::MAX_VIEWERS];
+    size_t count = viewerPolicy.planFrame((uint32_t)now, fb->len, order, ViewerConfig::MAX_VIEWERS);
+    bool sent = false;
+    // Thumbnails are encoded at most once per frame and variant, only when a
+    // planned viewer wants one
+    uint8_t* thumb_jpg[2] = {nullptr, nullptr};
+    size_t thumb_len[2] = {0, 0};
+    for (size_t k = 0; k < count; k++) {
+        WiFiClient& client = viewers[order[k]];
+        ViewerFeed feed = feeds[order[k]];
+        const uint8_t* data = fb->buf;
+        size_t length = fb->len;
+        if (feed != ViewerFeed::FRAME) {
+            if (!encodeThumbnail(fb, feed, thumb_jpg, thumb_len)) {
+                viewerPolicy.frameSkipped(order[k]);
+                continue;
+            }
+            size_t variant = feed == ViewerFeed::THUMB_COLOR ? 0 : 1;
+            data = thumb_jpg[variant];
+            length = thumb_len[variant];
+        }
+        PartWrite result = writeMultipartFrame(client, data, length, fb->timestamp);
+        if (result == PartWrite::SHORT) {
+            dropViewer(order[k], "short write");
             continue;
         }
+        if (result == PartWrite::NO_ROOM) {
+            viewerPolicy.frameSkipped(order[k]);
+        } else {
+            viewerPolicy.frameWritten(order[k], length);
+            sent = true;
+        }
 
-        client.write("--frame\r\n");
-        client.write("Content-Type: image/jpeg\r\n");
-        client.write("Content-Length: ");
-        client.print(fb->len);
-        client.write("\r\n\r\n");
-        client.write((const char*)fb->buf, fb->len);
-        client.write("\r\n");
+        // Discard anything the viewer sends without building a String
+        while (client.available() > 0) {
+            client.read();
+        }
+    }
 
-        camera->returnFrameBuffer(fb);
+    free(thumb_jpg[0]);
+    free(thumb_jpg[1]);
 
-        // Enforce 30 FPS
-        vTaskDelay(pdMS_TO_TICKS(33)); // 1000ms / 30fps = 33ms
+    if (sent) {
+        noteFrameSent(fb, frame_us);
+        if (analyzer) {
+            analyzer->frameSent(millis());
+        }
+    }
+    returnFrame(fb);
+    return sent;
+}
+
+// Preview of this frame for a thumbnail viewer; reuses one already encoded
+// for the same variant. Index 0 is colour, 1 grayscale.
+bool MJPEGServer::encodeThumbnail(camera_fb_t* fb, ViewerFeed feed, uint8_t* jpg[2], size_t len[2]) {
+    bool color = feed == ViewerFeed::THUMB_COLOR;
+    size_t variant = color ? 0 : 1;
+    if (jpg[variant]) {
+        return true;
+    }
+    return thumbnailer.encode(fb, color, &jpg[variant], &len[variant]);
+}
+
+// New frame since the last one taken. Without the VSYNC interrupt the
+// blocking driver get is the only frame sync left.
+bool MJPEGServer::frameReady() const {
+    if (rawPipeline && rawPipeline->isRunning()) {
+        return rawPipeline->getSequence() != raw_seq;
+    }
+    const FrameSignal& signal = camera->getFrameSignal();
+    return !signal.armed || signal.count != frame_signal_seq;
+}
 
-        if (client.available() > 0) {
-            client.readStringUntil('\r');
+bool MJPEGServer::hasQueuedFrame() const {
+    if (viewerPolicy.getActiveCount() == 0) {
+        return false;
+    }
+    if (rawPipeline && rawPipeline->isRunning()) {
+        return rawPipeline->getSequence() != raw_seq;
+    }
+    // Unarmed: no count to compare, the caller's fallback timer paces instead
+    const FrameSignal& signal = camera->getFrameSignal();
+    return signal.armed && signal.count != frame_signal_seq;
+}
+
+// Sensor JPEG, or the raw pipeline's newest encoded frame while it runs
+camera_fb_t* MJPEGServer::nextFrame() {
+    if (rawPipeline && rawPipeline->isRunning()) {
+        return rawPipeline->acquireFrame(raw_seq);
+    }
+    noteFrameSignal();
+    return camera->getFrameBuffer();
+}
+
+static void trackInterval(uint32_t interval_us, uint32_t& avg_us, uint32_t& jitter_us) {
+    if (avg_us == 0) {
+        avg_us = interval_us;
+        return;
+    }
+    uint32_t deviation = interval_us > avg_us ? interval_us - avg_us : avg_us - interval_us;
+    avg_us = avg_us - avg_us / 8 + interval_us / 8;
+    jitter_us = jitter_us - jitter_us / 8 + deviation / 8;
+}
+
+// Consumes the pending VSYNC edges; consecutive ones give the sensor cadence
+void MJPEGServer::noteFrameSignal() {
+    const FrameSignal& signal = camera->getFrameSignal();
+    if (!signal.armed) {
+        return;
+    }
+    uint32_t count = signal.count;
+    uint32_t at_us = signal.last_us;
+    uint32_t edges = count - frame_signal_seq;
+    if (edges > 1 && pipeline_mode == PipelineMode::THROUGHPUT) {
+        // The driver queued these frames, up to its buffer count; take them
+        // one per call, oldest first. Edges beyond that were dropped.
+        uint32_t queued = std::min<uint32_t>(edges, PipelineConfig::THROUGHPUT_FB_COUNT);
+        pacing.missed_signals += edges - queued;
+        frame_signal_seq = count - queued + 1;
+        frame_signal_us = 0;
+        return;
+    }
+    if (edges == 1 && frame_signal_us != 0 && at_us - frame_signal_us < PACING_GAP_US) {
+        trackInterval(at_us - frame_signal_us, pacing.vsync_interval_us, pacing.vsync_jitter_us);
+    } else if (edges > 1 && frame_signal_us != 0) {
+        // GRAB_LATEST already replaced the stale frames
+        pacing.missed_signals += edges - 1;
+    }
+    frame_signal_seq = count;
+    frame_signal_us = at_us;
+}
+
+void MJPEGServer::noteFrameSent(const camera_fb_t* fb, int64_t now_us) {
+    pacing.frames++;
+
+    // Driver and raw pipeline both stamp frames with esp_timer time
+    int64_t captured_us = (int64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+    uint32_t age = now_us > captured_us ? (uint32_t)(now_us - captured_us) : 0;
+    pacing.avg_age_us = pacing.avg_age_us ? pacing.avg_age_us - pacing.avg_age_us / 8 + age / 8 : age;
+    if (age > pacing.max_age_us) pacing.max_age_us = age;
+    size_t bucket = 0;
+    for (uint32_t limit_ms = 10; bucket < PipelineConfig::AGE_BUCKETS - 1 && age >= limit_ms * 1000; limit_ms *= 2) {
+        bucket++;
+    }
+    pacing.age_buckets[bucket]++;
+
+    if (last_send_us != 0 && now_us - last_send_us < PACING_GAP_US) {
+        uint32_t interval = (uint32_t)(now_us - last_send_us);
+        trackInterval(interval, pacing.avg_interval_us, pacing.jitter_us);
+        if (interval > pacing.max_interval_us) pacing.max_interval_us = interval;
+    }
+    last_send_us = now_us;
+}
+
+bool MJPEGServer::setPipelineMode(PipelineMode mode) {
+    if (!camera || (rawPipeline && rawPipeline->isRunning())) {
+        return false;
+    }
+    DriverSettings settings = camera->getDriverSettings();
+    if (mode == PipelineMode::LATENCY) {
+        settings.grab_mode = CAMERA_GRAB_LATEST;
+        settings.fb_count = PipelineConfig::LATENCY_FB_COUNT;
+    } else {
+        settings.grab_mode = CAMERA_GRAB_WHEN_EMPTY;
+        settings.fb_count = PipelineConfig::THROUGHPUT_FB_COUNT;
+    }
+    if (!camera->applyDriverSettings(settings)) {
+        return false;
+    }
+    pipeline_mode = mode;
+
+    // Connected viewers switch with the pipeline, not on their next reconnect
+    for (size_t i = 0; i < ViewerConfig::MAX_VIEWERS; i++) {
+        if (viewerPolicy.getSlot(i).active) {
+            viewers[i].setNoDelay(mode == PipelineMode::LATENCY);
+        }
+    }
+    // Edges counted during the driver restart refer to frames that are gone
+    frame_signal_seq = camera->getFrameSignal().count;
+    resetPacing();
+    return true;
+}
+
+void MJPEGServer::resetPacing() {
+    pacing = StreamPacingStats();
+    last_send_us = 0;
+    frame_signal_us = 0;
+}
+
+void MJPEGServer::printPacing(Print& out) const {
+    const char* sync = (rawPipeline && rawPipeline->isRunning()) ? "raw pipeline sequence"
+                     : camera && camera->getFrameSignal().armed ? "VSYNC interrupt" : "blocking driver get";
+    out.printf("[PACING] Mode: %s, frame sync: %s, %lu frames sent\n", pipelineModeName(pipeline_mode), sync,
+               pacing.frames);
+    if (pacing.avg_interval_us > 0) {
+        out.printf("[PACING] Send interval: avg %.1f ms (%.1f fps), jitter %.2f ms, max %.1f ms\n",
+                   pacing.avg_interval_us / 1000.0f, 1000000.0f / pacing.avg_interval_us,
+                   pacing.jitter_us / 1000.0f, pacing.max_interval_us / 1000.0f);
+    }
+    if (pacing.vsync_interval_us > 0) {
+        out.printf("[PACING] Sensor VSYNC: avg %.1f ms, jitter %.2f ms, edges passed while busy %lu\n",
+                   pacing.vsync_interval_us / 1000.0f, pacing.vsync_jitter_us / 1000.0f, pacing.missed_signals);
+    }
+    if (pacing.frames > 0) {
+        const uint32_t* b = pacing.age_buckets;
+        out.printf("[PACING] Capture->send age: avg %.1f ms, max %.1f ms; <10 %lu, <20 %lu, <40 %lu, <80 %lu, >=80 %lu\n",
+                   pacing.avg_age_us / 1000.0f, pacing.max_age_us / 1000.0f, b[0], b[1], b[2], b[3], b[4]);
+    }
+}
+
+void MJPEGServer::returnFrame(camera_fb_t* fb) {
+    if (rawPipeline && rawPipeline->isRunning()) {
+        rawPipeline->releaseFrame();
+        return;
+    }
+    camera->returnFrameBuffer(fb);
+}
+
+bool MJPEGServer::startTrace(size_t capacity) {
+    // A new recording overwrites the buffer the download reads from
+    if (download == DownloadSource::TRACE) {
+        finishDownload("trace restarted");
+    }
+    if (capacity > FrameTraceConfig::MAX_CAPACITY) {
+        capacity = FrameTraceConfig::MAX_CAPACITY;
+    }
+    if (trace_buffer && trace.capacity() != capacity) {
+        free(trace_buffer);
+        trace_buffer = nullptr;
+    }
+    if (!trace_buffer) {
+        trace_buffer = (uint8_t*)heap_caps_malloc(capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!trace_buffer) {
+            return false;
         }
     }
+    trace.begin(trace_buffer, capacity);
+    tracing = true;
+    return true;
+}
+
+void MJPEGServer::stopTrace() {
+    tracing = false;
+}
+
+void MJPEGServer::clearTrace() {
+    tracing = false;
+    if (download == DownloadSource::TRACE) {
+        finishDownload("trace cleared");
+    }
+    free(trace_buffer);
+    trace_buffer = nullptr;
+    trace.begin(nullptr, 0);
+}
+
+void MJPEGServer::recordTraceFrame(const camera_fb_t* fb, uint32_t capture_us) {
+    uint64_t timestamp_us = (uint64_t)fb->timestamp.tv_sec * 1000000 + fb->timestamp.tv_usec;
+    if (!trace.append(timestamp_us, capture_us, (uint16_t)fb->width, (uint16_t)fb->height, fb->buf, fb->len)) {
+        tracing = false;
+        Serial.printf("[TRACE] Buffer full, recording stopped at %lu frames\n", trace.frames());
+    }
+}
+
+void MJPEGServer::printTrace(Print& out) const {
+    out.printf("[TRACE] %s, %lu frames, %u/%u KB\n", tracing ? "RECORDING" : "stopped",
+               trace.frames(), (unsigned)(trace.size() / 1024), (unsigned)(trace.capacity() / 1024));
+    if (trace.frames() > 0) {
+        out.println("[TRACE] Download: curl -o flight.trace http://192.168.4.1/trace");
+    }
+}
+
+// Raw trace download; replay it with tools/trace_replay.cpp
+void MJPEGServer::handleTrace() {
+    if (trace.frames() == 0) {
+        server.send(404, "text/plain", "No trace recorded");
+        return;
+    }
+    beginDownload(DownloadSource::TRACE, trace.size(), "flight.trace");
+}
+
+void MJPEGServer::handleBlackbox() {
+    size_t size = blackbox ? blackbox->getUsedBytes() : 0;
+    if (size == 0) {
+        server.send(404, "text/plain", "No blackbox log");
+        return;
+    }
+    beginDownload(DownloadSource::BLACKBOX, size, "flight.bbx");
+}
+
+// Sends the headers and keeps the client; the body follows from
+// continueDownload() on the next network ticks
+bool MJPEGServer::beginDownload(DownloadSource source, size_t size, const char* filename) {
+    if (download != DownloadSource::NONE) {
+        if (download_client.connected()) {
+            server.send(503, "text/plain", "Another download is in progress");
+            return false;
+        }
+        finishDownload("disconnected");
+    }
+    String disposition = String("attachment; filename=") + filename;
+    server.sendHeader("Content-Disposition", disposition);
+    server.setContentLength(size);
+    server.send(200, "application/octet-stream", "");
+
+    download_client = server.client();
+    download = source;
+    download_offset = 0;
+    download_size = size;
+    download_progress_ms = millis();
+    Serial.printf("[HTTP] Download %s started (%u bytes)\n", filename, (unsigned)size);
+    return true;
+}
+
+// At most TICK_BYTES per call, and only what the socket takes without waiting
+void MJPEGServer::continueDownload() {
+    if (download == DownloadSource::NONE) {
+        return;
+    }
+    if (!download_client.connected()) {
+        finishDownload("disconnected");
+        return;
+    }
+
+    uint8_t chunk[2 * BlackboxFormat::BLOCK_SIZE];
+    size_t budget = DownloadConfig::TICK_BYTES;
+    while (budget > 0 && download_offset < download_size) {
+        size_t length = std::min(std::min(download_size - download_offset, budget), sizeof(chunk));
+        const uint8_t* data = chunk;
+        if (download == DownloadSource::TRACE) {
+            data = trace.data() + download_offset;
+        } else if (!blackbox->read(download_offset, chunk, length)) {
+            finishDownload("read error");
+            return;
+        }
+        ssize_t sent = send(download_client.fd(), data, length, MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            finishDownload("send error");
+            return;
+        }
+        download_offset += (size_t)sent;
+        budget -= (size_t)sent;
+        download_progress_ms = millis();
+        if ((size_t)sent < length) {
+            break;
+        }
+    }
+
+    if (download_offset >= download_size) {
+        finishDownload(nullptr);
+    } else if (millis() - download_progress_ms > DownloadConfig::STALL_TIMEOUT_MS) {
+        finishDownload("stalled");
+    }
+}
+
+void MJPEGServer::finishDownload(const char* reason) {
+    if (reason) {
+        Serial.printf("[HTTP] Download aborted (%s) at %u of %u bytes\n", reason, (unsigned)download_offset,
+                      (unsigned)download_size);
+    } else {
+        Serial.printf("[HTTP] Download done (%u bytes)\n", (unsigned)download_size);
+    }
+    download_client.stop();
+    download_client = WiFiClient();
+    download = DownloadSource::NONE;
+}
+
+void MJPEGServer::printViewers(Print& out) const {
+    out.printf("[VIEWERS] %u/%u connected, %u pilot(s); observers: every %lu ms, %lu KB/s\n",
+               (unsigned)viewerPolicy.getActiveCount(), (unsigned)ViewerConfig::MAX_VIEWERS,
+               (unsigned)viewerPolicy.getPilotCount(), viewerPolicy.getObserverInterval(),
+               viewerPolicy.getObserverByteRate() / 1024);
+    out.printf("[VIEWERS] Pilot token: %s, pilot MACs: %u\n",
+               viewerPolicy.hasPilotToken() ? "set" : "none", (unsigned)viewerPolicy.getPilotMacCount());
+    for (size_t i = 0; i < viewerPolicy.getPilotMacCount(); i++) {
+        const uint8_t* mac = viewerPolicy.getPilotMac(i);
+        out.printf("  pilot MAC %02X:%02X:%02X:%02X:%02X:%02X\n",
+                   mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    }
+
+    unsigned long now = millis();
+    for (size_t i = 0; i < ViewerConfig::MAX_VIEWERS; i++) {
+        const ViewerSlot& viewer = viewerPolicy.getSlot(i);
+        if (!viewer.active) {
+            continue;
+        }
+        uint32_t seconds = (now - viewer.joined_ms) / 1000;
+        out.printf("  [%u] %-8s %02X:%02X:%02X:%02X:%02X:%02X  %lus  sent %lu, skipped %lu, %lu KB (%lu KB/s)",
+                   (unsigned)i, viewerRoleName(viewer.role),
+                   viewer.mac[0], viewer.mac[1], viewer.mac[2], viewer.mac[3], viewer.mac[4], viewer.mac[5],
+                   seconds, viewer.stats.frames_sent, viewer.stats.frames_skipped,
+                   (uint32_t)(viewer.stats.bytes_sent / 1024),
+                   seconds ? (uint32_t)(viewer.stats.bytes_sent / 1024 / seconds) : 0UL);
+        if (viewer.interval_ms > 0) {
+            out.printf(", target %lu fps", 1000 / viewer.interval_ms);
+        }
+        if (feeds[i] != ViewerFeed::FRAME) {
+            out.print(feeds[i] == ViewerFeed::THUMB_COLOR ? ", thumbnail" : ", gray thumbnail");
+        }
+        out.println();
+    }
+}
+
+// 1/8-scale preview: a single JPEG, or a low-rate MJPEG stream with ?stream
+void MJPEGServer::handleThumb() {
+    bool color = !server.hasArg("gray");
+    if (rawPipeline && rawPipeline->isRunning()) {
+        // Thumbnails are cut from sensor JPEG; raw frames would only starve the pipeline
+        server.send(503, "text/plain", "Raw pipeline active");
+        return;
+    }
+
+    if (!server.hasArg("stream")) {
+        camera_fb_t* fb = camera->getFrameBuffer();
+        uint8_t* jpg = nullptr;
+        size_t len = 0;
+        bool ok = fb && thumbnailer.encode(fb, color, &jpg, &len);
+        camera->returnFrameBuffer(fb);
+        if (!ok) {
+            server.send(503, "text/plain", fb ? thumbnailer.getLastError() : "No frame");
+            return;
+        }
+        server.sendHeader("Cache-Control", "no-store");
+        server.setContentLength(len);
+        server.send(200, "image/jpeg", "");
+        server.sendContent((const char*)jpg, len);
+        free(jpg);
+        return;
+    }
+
+    // Spectators join as observers in a viewer slot like /stream; each
+    // planned frame is thumbnailed in streamToViewers()
+    WiFiClient client = server.client();
+    if (!client) {
+        return;
+    }
+    uint8_t mac[6];
+    bool known_mac = findStationMac(client.remoteIP(), mac);
+    int evicted = -1;
+    int slot = viewerPolicy.admit(ViewerRole::OBSERVER, known_mac ? mac : nullptr, millis(), &evicted);
+    if (slot < 0) {
+        server.send(503, "text/plain", "Viewer limit reached");
+        return;
+    }
+    viewerPolicy.setTargetFps(slot, 1000 / ThumbnailConfig::STREAM_INTERVAL_MS, millis());
+
+    viewers[slot] = client;
+    feeds[slot] = color ? ViewerFeed::THUMB_COLOR : ViewerFeed::THUMB_GRAY;
+    server.sendContent(STREAM_RESPONSE_HEADER, sizeof(STREAM_RESPONSE_HEADER) - 1);
+    Serial.printf("[STREAM] Thumbnail %s joined (slot %d, %u viewer(s))\n", client.remoteIP().toString().c_str(),
+                  slot, (unsigned)viewerPolicy.getActiveCount());
 }
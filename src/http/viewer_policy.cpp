@@ -0,0 +1,230 @@
+// src/http/viewer_policy.cpp - Роли зрителей и распределение кадров
+#include "viewer_policy.h"
+#include <string.h>
+#include <strings.h>
+
+const char* viewerRoleName(ViewerRole role) {
+    return role == ViewerRole::PILOT ? "pilot" : "observer";
+}
+
+ViewerPolicy::ViewerPolicy()
+    : pilot_mac_count_(0),
+      observer_interval_ms_(ViewerConfig::OBSERVER_FRAME_INTERVAL_MS),
+      observer_bytes_per_sec_(ViewerConfig::OBSERVER_BYTES_PER_SEC),
+      rotation_(0) {
+    token_[0] = '\0';
+}
+
+void ViewerPolicy::setPilotToken(const char* token, size_t length) {
+    if (length > ViewerConfig::TOKEN_MAX_LENGTH) {
+        length = ViewerConfig::TOKEN_MAX_LENGTH;
+    }
+    memcpy(token_, token, length);
+    token_[length] = '\0';
+}
+
+int ViewerPolicy::findPilotMac(const uint8_t mac[6]) const {
+    for (size_t i = 0; i < pilot_mac_count_; i++) {
+        if (memcmp(pilot_macs_[i], mac, 6) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+bool ViewerPolicy::addPilotMac(const uint8_t mac[6]) {
+    if (findPilotMac(mac) >= 0) {
+        return true;
+    }
+    if (pilot_mac_count_ >= ViewerConfig::MAX_PILOT_MACS) {
+        return false;
+    }
+    memcpy(pilot_macs_[pilot_mac_count_++], mac, 6);
+    return true;
+}
+
+bool ViewerPolicy::removePilotMac(const uint8_t mac[6]) {
+    int index = findPilotMac(mac);
+    if (index < 0) {
+        return false;
+    }
+    pilot_mac_count_--;
+    memmove(pilot_macs_[index], pilot_macs_[index + 1], (pilot_mac_count_ - index) * 6);
+    return true;
+}
+
+ViewerRole ViewerPolicy::classify(const char* token, const uint8_t* mac) const {
+    if (token && hasPilotToken() && strcasecmp(token, token_) == 0) {
+        return ViewerRole::PILOT;
+    }
+    if (mac && findPilotMac(mac) >= 0) {
+        return ViewerRole::PILOT;
+    }
+    return ViewerRole::OBSERVER;
+}
+
+int ViewerPolicy::admit(ViewerRole role, const uint8_t* mac, uint32_t now_ms, int* evicted) {
+    *evicted = -1;
+    int slot = -1;
+    for (size_t i = 0; i < ViewerConfig::MAX_VIEWERS; i++) {
+        if (!slots_[i].active) {
+            slot = (int)i;
+            break;
+        }
+    }
+
+    if (slot < 0 && role == ViewerRole::PILOT) {
+        uint32_t oldest_age = 0;
+        for (size_t i = 0; i < ViewerConfig::MAX_VIEWERS; i++) {
+            uint32_t age = now_ms - slots_[i].joined_ms;
+            if (slots_[i].role == ViewerRole::OBSERVER && (slot < 0 || age > oldest_age)) {
+                slot = (int)i;
+                oldest_age = age;
+            }
+        }
+        *evicted = slot;
+    }
+
+    if (slot < 0) {
+        return -1;
+    }
+
+    ViewerSlot& s = slots_[slot];
+    s = ViewerSlot();
+    s.active = true;
+    s.role = role;
+    if (mac) {
+        memcpy(s.mac, mac, 6);
+    }
+    s.joined_ms = now_ms;
+    s.next_due_ms = now_ms;
+    s.refill_ms = now_ms;
+    s.credit_bytes = (int32_t)ViewerConfig::OBSERVER_BURST_BYTES;
+    return slot;
+}
+
+void ViewerPolicy::release(int slot) {
+    if (slot >= 0 && slot < (int)ViewerConfig::MAX_VIEWERS) {
+        slots_[slot].active = false;
+    }
+}
+
+// Frame schedule plus a byte budget. The budget may go negative by one frame,
+// so frames larger than the burst still get through, just less often.
+bool ViewerPolicy::observerReady(ViewerSlot& slot, uint32_t now_ms, size_t frame_len) {
+    uint32_t elapsed = now_ms - slot.refill_ms;
+    if (elapsed > 1000) {
+        elapsed = 1000;
+    }
+    int64_t credit = slot.credit_bytes + (int64_t)elapsed * observer_bytes_per_sec_ / 1000;
+    if (credit > (int64_t)ViewerConfig::OBSERVER_BURST_BYTES) {
+        credit = ViewerConfig::OBSERVER_BURST_BYTES;
+    }
+    slot.credit_bytes = (int32_t)credit;
+    slot.refill_ms = now_ms;
+
+    if (slot.credit_bytes <= 0) {
+        return false;
+    }
+    uint32_t interval = slot.interval_ms > observer_interval_ms_ ? slot.interval_ms : observer_interval_ms_;
+    if (!takeDeadline(slot, now_ms, interval)) {
+        return false;
+    }
+    slot.credit_bytes -= (int32_t)frame_len;
+    slot.charged_bytes = (uint32_t)frame_len;
+    return true;
+}
+
+// Keep the average rate when frames arrive early or late, resync after a long gap
+bool ViewerPolicy::takeDeadline(ViewerSlot& slot, uint32_t now_ms, uint32_t interval_ms) {
+    if ((int32_t)(now_ms + ViewerConfig::PACING_EARLY_MS - slot.next_due_ms) < 0) {
+        return false;
+    }
+    slot.next_due_ms += interval_ms;
+    if ((int32_t)(now_ms - slot.next_due_ms) >= 0) {
+        slot.next_due_ms = now_ms + interval_ms;
+    }
+    return true;
+}
+
+void ViewerPolicy::setTargetFps(int slot, uint32_t fps, uint32_t now_ms) {
+    if (slot < 0 || slot >= (int)ViewerConfig::MAX_VIEWERS) {
+        return;
+    }
+    slots_[slot].interval_ms = fps ? 1000 / fps : 0;
+    slots_[slot].next_due_ms = now_ms;
+}
+
+size_t ViewerPolicy::planFrame(uint32_t now_ms, size_t frame_len, int* order, size_t capacity) {
+    size_t count = 0;
+    for (size_t i = 0; i < ViewerConfig::MAX_VIEWERS && count < capacity; i++) {
+        ViewerSlot& slot = slots_[i];
+        if (!slot.active || slot.role != ViewerRole::PILOT) {
+            continue;
+        }
+        if (slot.interval_ms == 0 || takeDeadline(slot, now_ms, slot.interval_ms)) {
+            order[count++] = (int)i;
+        } else {
+            slot.stats.frames_skipped++;
+        }
+    }
+
+    // Round-robin from the observer after the last one served; an observer
+    // over quota stays due and is served on a later frame
+    size_t observers = 0;
+    size_t start = rotation_;
+    for (size_t k = 0; k < ViewerConfig::MAX_VIEWERS; k++) {
+        size_t i = (start + k) % ViewerConfig::MAX_VIEWERS;
+        ViewerSlot& slot = slots_[i];
+        if (!slot.active || slot.role != ViewerRole::OBSERVER) {
+            continue;
+        }
+        if (count < capacity && observers < ViewerConfig::OBSERVERS_PER_FRAME &&
+            observerReady(slot, now_ms, frame_len)) {
+            order[count++] = (int)i;
+            observers++;
+            rotation_ = (uint8_t)((i + 1) % ViewerConfig::MAX_VIEWERS);
+        } else {
+            slot.stats.frames_skipped++;
+        }
+    }
+    return count;
+}
+
+void ViewerPolicy::frameWritten(int slot, size_t frame_len) {
+    ViewerSlot& s = slots_[slot];
+    if (s.charged_bytes > frame_len) {
+        s.credit_bytes += (int32_t)(s.charged_bytes - frame_len);
+    }
+    s.charged_bytes = 0;
+    s.stats.frames_sent++;
+    s.stats.bytes_sent += frame_len;
+}
+
+void ViewerPolicy::frameSkipped(int slot) {
+    ViewerSlot& s = slots_[slot];
+    s.credit_bytes += (int32_t)s.charged_bytes;
+    s.charged_bytes = 0;
+    s.stats.frames_skipped++;
+}
+
+void ViewerPolicy::setObserverLimits(uint32_t interval_ms, uint32_t bytes_per_sec) {
+    observer_interval_ms_ = interval_ms;
+    observer_bytes_per_sec_ = bytes_per_sec;
+}
+
+size_t ViewerPolicy::getActiveCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < ViewerConfig::MAX_VIEWERS; i++) {
+        count += slots_[i].active ? 1 : 0;
+    }
+    return count;
+}
+
+size_t ViewerPolicy::getPilotCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < ViewerConfig::MAX_VIEWERS; i++) {
+        count += (slots_[i].active && slots_[i].role == ViewerRole::PILOT) ? 1 : 0;
+    }
+    return count;
+}
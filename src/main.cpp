@@ -48,22 +48,26 @@ void setup() {
     // Подключение обработчика команд
     Serial.println("🔌 Connecting command handler to system manager...");
     commandHandler.setSystemManager(&systemManager);
+    commandHandler.beginNetwork();
+    commandHandler.attachEvents(systemManager.getEventLoop());
     
     Serial.println("\n============================================================");
     Serial.println("✅ SYSTEM INITIALIZED SUCCESSFULLY - Dual core operation active");
     Serial.println("📝 Type 'help' for available commands");
     Serial.println("🌐 Connect to WiFi: ESP32-S3_Drone_30fps (password: drone2024)");
     Serial.println("🔗 Web interface: http://192.168.4.1");
+    Serial.println("🛰️  UDP commands: 192.168.4.1:4242 (tools/drone_ctl)");
     Serial.println("============================================================");
 }
 
 void loop() {
-    // System manager handles all operations
-    systemManager.update();
+    // Sleeps until an event or a timer is due; sources and timers are set up
+    // in SystemManager::registerEvents() and CommandHandler::attachEvents()
+    EventLoop& events = systemManager.getEventLoop();
+    uint32_t posted = events.wait();
     
-    // Handle serial commands
-    commandHandler.processCommands();
-    
-    // Minimal delay to prevent WDT reset
-    delayMicroseconds(100);
+    Profiler& profiler = systemManager.getProfiler();
+    profiler.loopBegin();
+    events.dispatch(posted);
+    profiler.loopEnd();
 }
@@ -0,0 +1,245 @@
+// src/system/event_loop.cpp - Диспетчер событий главной задачи вместо опроса loop()
+#include "event_loop.h"
+#include "esp_timer.h"
+
+// Upper bounds (us) of the wake-up latency buckets; the last bucket is open-ended
+static const uint32_t kLatencyLimitsUs[EventLoopConfig::LATENCY_BUCKETS - 1] = {
+    50, 200, 1000, 5000, 20000
+};
+
+static const char* const kLatencyLabels[EventLoopConfig::LATENCY_BUCKETS] = {
+    "  <50us", " <200us", "   <1ms", "   <5ms", "  <20ms", " >=20ms"
+};
+
+const char* eventSourceName(EventSource source) {
+    switch (source) {
+        case EventSource::SERIAL_RX: return "serial";
+        case EventSource::FC_RX:     return "fc_uart";
+        case EventSource::WIFI:      return "wifi";
+        case EventSource::FRAME:     return "frame";
+        case EventSource::NET:       return "net";
+        default:                     return "?";
+    }
+}
+
+EventLoop::EventLoop()
+    : task_(nullptr), handler_count_(0), timer_count_(0), wakeups_(0), timeouts_(0),
+      busy_us_(0), stats_start_us_(0) {
+    for (size_t i = 0; i < EVENT_SOURCE_COUNT; i++) {
+        posted_us_[i] = 0;
+        external_posted_us_[i] = nullptr;
+    }
+    for (size_t i = 0; i < EventLoopConfig::LATENCY_BUCKETS; i++) {
+        latency_buckets_[i] = 0;
+    }
+}
+
+void EventLoop::begin() {
+    task_ = xTaskGetCurrentTaskHandle();
+    // Anything posted before begin() went nowhere; start from a clean value
+    xTaskNotifyWait(0, UINT32_MAX, nullptr, 0);
+    resetStats();
+}
+
+bool EventLoop::on(EventSource source, EventHandler handler) {
+    if (handler_count_ >= EventLoopConfig::MAX_HANDLERS || !handler) {
+        return false;
+    }
+    handlers_[handler_count_].source = source;
+    handlers_[handler_count_].handler = handler;
+    handler_count_++;
+    return true;
+}
+
+EventLoop::Timer* EventLoop::newTimer(const char* name, uint32_t interval_ms) {
+    if (timer_count_ >= EventLoopConfig::MAX_TIMERS) {
+        return nullptr;
+    }
+    Timer& timer = timers_[timer_count_];
+    timer.handler = nullptr;
+    timer.source = EventSource::COUNT;
+    timer.next_ms = millis() + interval_ms;
+    timer.stats = EventTimerStats();
+    timer.stats.name = name;
+    timer.stats.interval_ms = interval_ms;
+    return &timer;
+}
+
+int EventLoop::addTimer(const char* name, uint32_t interval_ms, EventHandler handler) {
+    Timer* timer = handler ? newTimer(name, interval_ms) : nullptr;
+    if (!timer) {
+        return -1;
+    }
+    timer->handler = handler;
+    return (int)timer_count_++;
+}
+
+int EventLoop::addTimer(const char* name, uint32_t interval_ms, EventSource source) {
+    Timer* timer = newTimer(name, interval_ms);
+    if (!timer) {
+        return -1;
+    }
+    timer->source = source;
+    return (int)timer_count_++;
+}
+
+void EventLoop::setTimerInterval(int id, uint32_t interval_ms) {
+    if (id < 0 || (size_t)id >= timer_count_ || timers_[id].stats.interval_ms == interval_ms) {
+        return;
+    }
+    timers_[id].stats.interval_ms = interval_ms;
+    timers_[id].next_ms = millis() + interval_ms;
+}
+
+void EventLoop::post(EventSource source) {
+    posted_us_[(size_t)source] = (uint32_t)esp_timer_get_time();
+    if (task_) {
+        xTaskNotify(task_, bit(source), eSetBits);
+    }
+}
+
+uint32_t EventLoop::wait() {
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(nextTimeout(millis())));
+    return bits;
+}
+
+void EventLoop::dispatch(uint32_t bits) {
+    int64_t start = esp_timer_get_time();
+    wakeups_++;
+    if (bits == 0) {
+        timeouts_++;
+    }
+    for (size_t i = 0; i < EVENT_SOURCE_COUNT; i++) {
+        if ((bits & (1UL << i)) == 0) continue;
+        EventSourceStats& stats = sources_[i];
+        stats.events++;
+        uint32_t posted = external_posted_us_[i] ? *external_posted_us_[i] : posted_us_[i];
+        if (posted != 0) {
+            noteLatency(stats, (uint32_t)start - posted);
+        }
+        runSource((EventSource)i);
+    }
+    runTimers();
+    busy_us_ += esp_timer_get_time() - start;
+}
+
+// Until the earliest running timer; MAX_WAIT_MS bounds a sleep with no timers
+uint32_t EventLoop::nextTimeout(unsigned long now) const {
+    uint32_t timeout = EventLoopConfig::MAX_WAIT_MS;
+    for (size_t i = 0; i < timer_count_; i++) {
+        const Timer& timer = timers_[i];
+        if (timer.stats.interval_ms == 0) continue;
+        long remaining = (long)(timer.next_ms - now);
+        if (remaining <= 0) return 0;
+        if ((uint32_t)remaining < timeout) timeout = (uint32_t)remaining;
+    }
+    return timeout;
+}
+
+void EventLoop::runSource(EventSource source) {
+    EventSourceStats& stats = sources_[(size_t)source];
+    for (size_t i = 0; i < handler_count_; i++) {
+        if (handlers_[i].source != source) continue;
+        int64_t start = esp_timer_get_time();
+        handlers_[i].handler();
+        uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+        stats.handler_us += elapsed;
+        if (elapsed > stats.max_handler_us) stats.max_handler_us = elapsed;
+    }
+}
+
+// Due timers, plus the ones due within TIMER_SLACK_MS: they share this
+// wake-up instead of each costing one of their own
+void EventLoop::runTimers() {
+    unsigned long now = millis();
+    for (size_t i = 0; i < timer_count_; i++) {
+        Timer& timer = timers_[i];
+        if (timer.stats.interval_ms == 0 ||
+            (long)(timer.next_ms - now) > (long)EventLoopConfig::TIMER_SLACK_MS) {
+            continue;
+        }
+        int64_t start = esp_timer_get_time();
+        if (timer.handler) {
+            timer.handler();
+        } else {
+            runSource(timer.source);
+        }
+        uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+        timer.stats.runs++;
+        if (elapsed > timer.stats.max_us) timer.stats.max_us = elapsed;
+
+        // A late run does not cause a burst of catch-up runs
+        timer.next_ms += timer.stats.interval_ms;
+        if ((long)(timer.next_ms - millis()) <= 0) {
+            timer.next_ms = millis() + timer.stats.interval_ms;
+        }
+    }
+}
+
+void EventLoop::noteLatency(EventSourceStats& stats, uint32_t latency_us) {
+    stats.avg_latency_us = stats.avg_latency_us
+        ? stats.avg_latency_us - stats.avg_latency_us / 8 + latency_us / 8
+        : latency_us;
+    if (latency_us > stats.max_latency_us) stats.max_latency_us = latency_us;
+
+    size_t bucket = 0;
+    while (bucket < EventLoopConfig::LATENCY_BUCKETS - 1 && latency_us >= kLatencyLimitsUs[bucket]) {
+        bucket++;
+    }
+    latency_buckets_[bucket]++;
+}
+
+float EventLoop::getBusyPercent() const {
+    int64_t elapsed = esp_timer_get_time() - stats_start_us_;
+    return elapsed > 0 ? busy_us_ * 100.0f / elapsed : 0.0f;
+}
+
+void EventLoop::resetStats() {
+    for (size_t i = 0; i < EVENT_SOURCE_COUNT; i++) {
+        sources_[i] = EventSourceStats();
+    }
+    for (size_t i = 0; i < EventLoopConfig::LATENCY_BUCKETS; i++) {
+        latency_buckets_[i] = 0;
+    }
+    for (size_t i = 0; i < timer_count_; i++) {
+        timers_[i].stats.runs = 0;
+        timers_[i].stats.max_us = 0;
+    }
+    wakeups_ = 0;
+    timeouts_ = 0;
+    busy_us_ = 0;
+    stats_start_us_ = esp_timer_get_time();
+}
+
+void EventLoop::printStatus(Print& out) const {
+    float seconds = (esp_timer_get_time() - stats_start_us_) / 1000000.0f;
+    out.println("\n=== Event Loop ===");
+    out.printf("Wake-ups: %lu (%.1f/s, %lu for timers only), loop task busy %.2f%%\n", wakeups_,
+               seconds > 0 ? wakeups_ / seconds : 0.0f, timeouts_, getBusyPercent());
+
+    out.println("Source    Events  Avg wake  Max wake  Avg handler  Max handler");
+    for (size_t i = 0; i < EVENT_SOURCE_COUNT; i++) {
+        const EventSourceStats& stats = sources_[i];
+        out.printf("%-8s %7lu %7lu us %7lu us %9lu us %9lu us\n", eventSourceName((EventSource)i),
+                   stats.events, stats.avg_latency_us, stats.max_latency_us,
+                   stats.events ? (uint32_t)(stats.handler_us / stats.events) : 0, stats.max_handler_us);
+    }
+
+    out.println("Timer        Interval    Runs     Max");
+    for (size_t i = 0; i < timer_count_; i++) {
+        const EventTimerStats& stats = timers_[i].stats;
+        if (stats.interval_ms == 0) {
+            out.printf("%-10s %10s %7lu %6lu us\n", stats.name, "stopped", stats.runs, stats.max_us);
+        } else {
+            out.printf("%-10s %7lu ms %7lu %6lu us\n", stats.name, stats.interval_ms, stats.runs, stats.max_us);
+        }
+    }
+
+    out.println("--- wake-up latency (post -> handler) ---");
+    for (size_t i = 0; i < EventLoopConfig::LATENCY_BUCKETS; i++) {
+        if (latency_buckets_[i] == 0) continue;
+        out.printf("%s: %8lu\n", kLatencyLabels[i], latency_buckets_[i]);
+    }
+    out.println("==================\n");
+}
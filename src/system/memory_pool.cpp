@@ -0,0 +1,242 @@
+// src/system/memory_pool.cpp - Арены, пулы блоков и монитор фрагментации кучи
+#include "memory_pool.h"
+
+namespace {
+
+// Take the requested capability, then fall back to any 8-bit capable RAM
+uint8_t* allocateRegion(size_t size, uint32_t caps, bool& internal) {
+    uint8_t* block = (uint8_t*)heap_caps_malloc(size, caps);
+    if (!block && (caps & MALLOC_CAP_SPIRAM)) {
+        block = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        caps = MALLOC_CAP_INTERNAL;
+    }
+    internal = block && !(caps & MALLOC_CAP_SPIRAM);
+    return block;
+}
+
+} // namespace
+
+// --- Arena ---
+
+Arena::Arena(const char* name, size_t capacity, uint32_t caps)
+    : name_(name), base_(nullptr), capacity_(capacity), used_(0), high_water_(0),
+      failures_(0), caps_(caps), internal_(false) {
+}
+
+bool Arena::begin() {
+    if (!base_) {
+        base_ = allocateRegion(capacity_, caps_, internal_);
+    }
+    return base_ != nullptr;
+}
+
+void* Arena::allocate(size_t size, size_t align) {
+    size_t start = (used_ + align - 1) & ~(align - 1);
+    if (!base_ || start + size > capacity_) {
+        failures_++;
+        return nullptr;
+    }
+    used_ = start + size;
+    if (used_ > high_water_) high_water_ = used_;
+    return base_ + start;
+}
+
+char* Arena::vformat(const char* fmt, va_list args) {
+    if (!base_ || used_ >= capacity_) {
+        failures_++;
+        return nullptr;
+    }
+    // Format straight into the free tail, then commit what was used
+    char* text = (char*)base_ + used_;
+    size_t room = capacity_ - used_;
+    int length = vsnprintf(text, room, fmt, args);
+    if (length < 0 || (size_t)length >= room) {
+        failures_++;
+        return nullptr;
+    }
+    allocate(length + 1, 1);
+    return text;
+}
+
+char* Arena::format(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    char* text = vformat(fmt, args);
+    va_end(args);
+    return text;
+}
+
+// --- BlockPool ---
+
+BlockPool::BlockPool(const char* name, size_t block_size, size_t block_count, uint32_t caps)
+    : name_(name), storage_(nullptr), free_list_(nullptr),
+      block_size_((block_size + 3) & ~(size_t)3), block_count_(block_count),
+      available_(0), min_available_(0), failures_(0), caps_(caps), internal_(false) {
+}
+
+bool BlockPool::begin() {
+    if (storage_) {
+        return true;
+    }
+    storage_ = allocateRegion(block_size_ * block_count_, caps_, internal_);
+    if (!storage_) {
+        return false;
+    }
+    for (size_t i = block_count_; i > 0; i--) {
+        FreeBlock* block = (FreeBlock*)(storage_ + (i - 1) * block_size_);
+        block->next = free_list_;
+        free_list_ = block;
+    }
+    available_ = block_count_;
+    min_available_ = block_count_;
+    return true;
+}
+
+uint8_t* BlockPool::acquire() {
+    portENTER_CRITICAL(&lock_);
+    FreeBlock* block = free_list_;
+    if (block) {
+        free_list_ = block->next;
+        available_--;
+        if (available_ < min_available_) min_available_ = available_;
+    } else {
+        failures_++;
+    }
+    portEXIT_CRITICAL(&lock_);
+    return (uint8_t*)block;
+}
+
+void BlockPool::release(uint8_t* block) {
+    if (!block) return;
+    portENTER_CRITICAL(&lock_);
+    FreeBlock* entry = (FreeBlock*)block;
+    entry->next = free_list_;
+    free_list_ = entry;
+    available_++;
+    portEXIT_CRITICAL(&lock_);
+}
+
+// --- MemoryMonitor ---
+
+MemoryMonitor::MemoryMonitor() : last_sample_ms_(0) {
+    static const char* const names[MemoryConfig::HEAP_REGIONS] = {"INTERNAL", "DMA", "PSRAM"};
+    static const uint32_t caps[MemoryConfig::HEAP_REGIONS] = {
+        MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, MALLOC_CAP_DMA, MALLOC_CAP_SPIRAM
+    };
+    for (size_t i = 0; i < MemoryConfig::HEAP_REGIONS; i++) {
+        regions_[i].name = names[i];
+        regions_[i].caps = caps[i];
+        warned_[i] = false;
+    }
+}
+
+void MemoryMonitor::update() {
+    unsigned long now = millis();
+    if (last_sample_ms_ != 0 && now - last_sample_ms_ < MemoryConfig::MONITOR_INTERVAL_MS) {
+        return;
+    }
+    last_sample_ms_ = now;
+    sample();
+}
+
+void MemoryMonitor::sample() {
+    for (size_t i = 0; i < MemoryConfig::HEAP_REGIONS; i++) {
+        HeapRegionInfo& region = regions_[i];
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, region.caps);
+
+        region.total = heap_caps_get_total_size(region.caps);
+        region.free_bytes = info.total_free_bytes;
+        region.largest_block = info.largest_free_block;
+        region.minimum_free = info.minimum_free_bytes;
+        if (region.total == 0) continue;
+
+        if (region.worst_largest_block == 0 || region.largest_block < region.worst_largest_block) {
+            region.worst_largest_block = region.largest_block;
+        }
+        region.fragmentation_percent = region.free_bytes > 0
+            ? (uint8_t)(100 - (uint64_t)region.largest_block * 100 / region.free_bytes) : 0;
+        if (region.fragmentation_percent > region.peak_fragmentation) {
+            region.peak_fragmentation = region.fragmentation_percent;
+        }
+
+        bool fragmented = region.fragmentation_percent >= MemoryConfig::FRAGMENTATION_WARN_PERCENT;
+        if (fragmented && !warned_[i]) {
+            Serial.printf("⚠️  [MEMORY] %s fragmented: %u%% (largest block %u of %u bytes free)\n",
+                          region.name, region.fragmentation_percent,
+                          (unsigned)region.largest_block, (unsigned)region.free_bytes);
+        }
+        warned_[i] = fragmented;
+    }
+}
+
+void MemoryMonitor::printReport(Print& out) const {
+    out.println("\n🧩 Фрагментация (свободно / крупнейший блок):");
+    for (size_t i = 0; i < MemoryConfig::HEAP_REGIONS; i++) {
+        const HeapRegionInfo& region = regions_[i];
+        if (region.total == 0) {
+            out.printf("   %-8s нет\n", region.name);
+            continue;
+        }
+        out.printf("   %-8s %6u KB / %6u KB, фрагм. %u%% (пик %u%%), мин. свободно %u KB, худший блок %u KB\n",
+                   region.name, (unsigned)(region.free_bytes / 1024), (unsigned)(region.largest_block / 1024),
+                   region.fragmentation_percent, region.peak_fragmentation,
+                   (unsigned)(region.minimum_free / 1024), (unsigned)(region.worst_largest_block / 1024));
+    }
+}
+
+// --- Subsystem pools ---
+
+namespace MemoryPools {
+
+namespace {
+Arena http_arena("http", MemoryConfig::HTTP_ARENA_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+Arena log_arena("log", MemoryConfig::LOG_ARENA_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+BlockPool socket_pool("socket", MemoryConfig::SOCKET_BLOCK_SIZE, MemoryConfig::SOCKET_BLOCK_COUNT,
+                      MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+MemoryMonitor memory_monitor;
+}
+
+bool begin() {
+    bool ok = http_arena.begin() & log_arena.begin() & socket_pool.begin();
+    memory_monitor.sample();
+    return ok;
+}
+
+Arena& http() { return http_arena; }
+Arena& log() { return log_arena; }
+BlockPool& socketBuffers() { return socket_pool; }
+MemoryMonitor& monitor() { return memory_monitor; }
+
+size_t logf(Print& out, const char* fmt, ...) {
+    ArenaScope scope(log_arena);
+    va_list args;
+    va_start(args, fmt);
+    char* line = log_arena.vformat(fmt, args);
+    va_end(args);
+    if (!line) {
+        // Arena missing or line too long: print what fits on the stack
+        char fallback[128];
+        va_start(args, fmt);
+        vsnprintf(fallback, sizeof(fallback), fmt, args);
+        va_end(args);
+        return out.print(fallback);
+    }
+    return out.print(line);
+}
+
+void printStatus(Print& out) {
+    out.println("\n🧱 Арены и пулы:");
+    const Arena* arenas[] = {&http_arena, &log_arena};
+    for (const Arena* arena : arenas) {
+        out.printf("   arena %-6s %4u B %s, пик %u B, отказов %lu\n",
+                   arena->getName(), (unsigned)arena->getCapacity(), arena->isInternal() ? "IRAM" : "PSRAM",
+                   (unsigned)arena->getHighWater(), arena->getFailures());
+    }
+    out.printf("   pool  %-6s %u x %u B %s, свободно %u (мин. %u), отказов %lu\n",
+               socket_pool.getName(), (unsigned)socket_pool.getBlockCount(), (unsigned)socket_pool.getBlockSize(),
+               socket_pool.isInternal() ? "IRAM" : "PSRAM", (unsigned)socket_pool.getAvailable(),
+               (unsigned)socket_pool.getMinAvailable(), socket_pool.getFailures());
+}
+
+} // namespace MemoryPools
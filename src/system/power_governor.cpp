@@ -0,0 +1,232 @@
+// src/system/power_governor.cpp - Частота CPU и мощность TX по нагрузке (DVFS)
+#include "power_governor.h"
+#include <esp_wifi.h>
+#include "esp_timer.h"
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
+
+#if CONFIG_PM_ENABLE
+#if CONFIG_IDF_TARGET_ESP32S3
+typedef esp_pm_config_esp32s3_t PmConfig;
+#else
+typedef esp_pm_config_esp32_t PmConfig;
+#endif
+#endif
+
+const char* powerStateName(PowerState state) {
+    switch (state) {
+        case PowerState::IDLE:      return "idle";
+        case PowerState::CONNECTED: return "connected";
+        case PowerState::BOOST:     return "boost";
+        case PowerState::STREAMING: return "streaming";
+        default:                    return "?";
+    }
+}
+
+PowerGovernor::PowerGovernor()
+    : state_(PowerState::STREAMING), mhz_(PowerConfig::MAX_MHZ), fixed_mhz_(0), pm_enabled_(false),
+      max_lock_held_(false), max_lock_(nullptr), tx_qdbm_(PowerConfig::TX_MAX_QDBM), state_since_(0),
+      last_busy_(0), last_stream_(0), last_update_(0), saved_mah_(0.0f) {}
+
+void PowerGovernor::begin() {
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_handle_t lock = nullptr;
+    if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "governor", &lock) == ESP_OK) {
+        max_lock_ = lock;
+        pm_enabled_ = true;
+    }
+#endif
+    // Start at full clock like the boot did; the first update() past
+    // STREAM_HOLD_MS moves to the clock of the actual state
+    unsigned long now = millis();
+    last_update_ = now;
+    last_stream_ = now;
+    state_since_ = now;
+    PowerStateStats& stats = stats_[(size_t)state_];
+    stats.entries++;
+    stats.switch_us = applyMhz(mhz_, true);
+    stats.max_switch_us = stats.switch_us;
+    Serial.printf("⚡ [POWER] Governor started (%s)\n", pm_enabled_ ? "esp_pm locks" : "setCpuFrequencyMhz");
+}
+
+void PowerGovernor::update(const PowerInputs& inputs) {
+    unsigned long now = millis();
+    unsigned long elapsed = now - last_update_;
+    last_update_ = now;
+    last_inputs_ = inputs;
+
+    // Time, current and latency accrue to the state that was active
+    PowerStateStats& current = stats_[(size_t)state_];
+    current.time_ms += elapsed;
+    uint16_t mhz = fixed_mhz_ ? fixed_mhz_ : mhz_;
+    float ma = estimateMa(mhz, inputs.avg_load_percent);
+    current.avg_ma = current.avg_ma > 0.0f ? current.avg_ma - current.avg_ma / 8 + ma / 8 : ma;
+    if (inputs.wake_latency_us) {
+        current.wake_latency_us = current.wake_latency_us
+            ? current.wake_latency_us - current.wake_latency_us / 8 + inputs.wake_latency_us / 8
+            : inputs.wake_latency_us;
+    }
+    // Same work at 240 MHz takes proportionally less of the core
+    float ma_at_max = estimateMa(PowerConfig::MAX_MHZ, inputs.avg_load_percent * mhz / PowerConfig::MAX_MHZ);
+    saved_mah_ += (ma_at_max - ma) * elapsed / 3600000.0f;
+
+    if (inputs.load_percent > PowerConfig::RELAX_LOAD_PERCENT) last_busy_ = now;
+    if (inputs.streaming) last_stream_ = now;
+
+    updateTxPower(inputs);
+
+    if (fixed_mhz_) return;
+    PowerState next = choose(inputs, now);
+    if (next != state_) {
+        enter(next, now);
+    }
+}
+
+PowerState PowerGovernor::choose(const PowerInputs& inputs, unsigned long now) const {
+    if (inputs.streaming || now - last_stream_ < PowerConfig::STREAM_HOLD_MS) {
+        return PowerState::STREAMING;
+    }
+    if (inputs.load_percent > PowerConfig::BOOST_LOAD_PERCENT ||
+        (state_ == PowerState::BOOST && now - last_busy_ < PowerConfig::RELAX_MS)) {
+        return PowerState::BOOST;
+    }
+    return inputs.stations > 0 ? PowerState::CONNECTED : PowerState::IDLE;
+}
+
+void PowerGovernor::enter(PowerState state, unsigned long now) {
+    PowerState previous = state_;
+    state_ = state;
+    state_since_ = now;
+    mhz_ = mhzFor(state);
+
+    PowerStateStats& stats = stats_[(size_t)state];
+    stats.entries++;
+    stats.switch_us = applyMhz(mhz_, state == PowerState::STREAMING || state == PowerState::BOOST);
+    if (stats.switch_us > stats.max_switch_us) stats.max_switch_us = stats.switch_us;
+
+    Serial.printf("⚡ [POWER] %s -> %s: %u MHz (switch %lu us)\n", powerStateName(previous),
+                  powerStateName(state), mhz_, stats.switch_us);
+}
+
+// Clock cap for the state. With esp_pm the clock may still drop to
+// IDLE_MHZ between bursts unless a CPU_FREQ_MAX lock (ours or Wi-Fi's) is
+// held; the governor holds one while streaming or boosted.
+uint32_t PowerGovernor::applyMhz(uint16_t mhz, bool hold_max) {
+    int64_t start = esp_timer_get_time();
+#if CONFIG_PM_ENABLE
+    if (pm_enabled_) {
+        PmConfig config = {};
+        config.max_freq_mhz = mhz;
+        config.min_freq_mhz = PowerConfig::IDLE_MHZ;
+        config.light_sleep_enable = false;      // The AP has to answer at any time
+        if (esp_pm_configure(&config) == ESP_OK) {
+            esp_pm_lock_handle_t lock = static_cast<esp_pm_lock_handle_t>(max_lock_);
+            if (hold_max && !max_lock_held_) {
+                max_lock_held_ = esp_pm_lock_acquire(lock) == ESP_OK;
+            } else if (!hold_max && max_lock_held_) {
+                esp_pm_lock_release(lock);
+                max_lock_held_ = false;
+            }
+            return (uint32_t)(esp_timer_get_time() - start);
+        }
+        // PM compiled in but refused (e.g. no DFS support): fixed clocks from now on
+        if (max_lock_held_) {
+            esp_pm_lock_release(static_cast<esp_pm_lock_handle_t>(max_lock_));
+            max_lock_held_ = false;
+        }
+        pm_enabled_ = false;
+    }
+#endif
+    setCpuFrequencyMhz(mhz);
+    return (uint32_t)(esp_timer_get_time() - start);
+}
+
+// Full power whenever video is on air or somebody may be joining from afar;
+// lower only for a bench session right next to the drone
+void PowerGovernor::updateTxPower(const PowerInputs& inputs) {
+    int8_t current;
+    if (esp_wifi_get_max_tx_power(&current) == ESP_OK) {
+        tx_qdbm_ = current;     // A restarted AP is back at max
+    }
+
+    int8_t target = tx_qdbm_;
+    if (inputs.streaming || inputs.stations == 0 || inputs.weakest_rssi < PowerConfig::FAR_RSSI_DBM) {
+        target = PowerConfig::TX_MAX_QDBM;
+    } else if (inputs.weakest_rssi >= PowerConfig::NEAR_RSSI_DBM) {
+        target = PowerConfig::TX_NEAR_QDBM;
+    }
+    if (target != tx_qdbm_ && esp_wifi_set_max_tx_power(target) == ESP_OK) {
+        Serial.printf("⚡ [POWER] TX power %.2f -> %.2f dBm (weakest station %d dBm)\n", tx_qdbm_ / 4.0f,
+                      target / 4.0f, inputs.weakest_rssi);
+        tx_qdbm_ = target;
+    }
+}
+
+bool PowerGovernor::setFixedMhz(uint16_t mhz) {
+    if (mhz != 0 && mhz != PowerConfig::IDLE_MHZ && mhz != PowerConfig::CONNECTED_MHZ &&
+        mhz != PowerConfig::MAX_MHZ) {
+        return false;
+    }
+    fixed_mhz_ = mhz;
+    if (mhz) {
+        applyMhz(mhz, true);
+    } else {
+        enter(choose(last_inputs_, millis()), millis());
+    }
+    return true;
+}
+
+uint16_t PowerGovernor::mhzFor(PowerState state) {
+    switch (state) {
+        case PowerState::IDLE:      return PowerConfig::IDLE_MHZ;
+        case PowerState::CONNECTED: return PowerConfig::CONNECTED_MHZ;
+        default:                    return PowerConfig::MAX_MHZ;
+    }
+}
+
+float PowerGovernor::estimateMa(uint16_t mhz, float load_percent) {
+    uint16_t idle = PowerConfig::MA_IDLE_240, busy = PowerConfig::MA_BUSY_240;
+    if (mhz <= 80) {
+        idle = PowerConfig::MA_IDLE_80;
+        busy = PowerConfig::MA_BUSY_80;
+    } else if (mhz <= 160) {
+        idle = PowerConfig::MA_IDLE_160;
+        busy = PowerConfig::MA_BUSY_160;
+    }
+    float load = load_percent < 0.0f ? 0.0f : (load_percent > 100.0f ? 100.0f : load_percent);
+    return idle + (busy - idle) * load / 100.0f;
+}
+
+void PowerGovernor::printStatus(Print& out) const {
+    out.println("\n=== Power Governor ===");
+    if (fixed_mhz_) {
+        out.printf("Mode: fixed %u MHz", fixed_mhz_);
+    } else {
+        out.printf("Mode: governed, state %s for %lu s, cap %u MHz", powerStateName(state_),
+                   (millis() - state_since_) / 1000, mhz_);
+    }
+    out.printf(", running at %lu MHz (%s%s)\n", ESP.getCpuFreqMHz(),
+               pm_enabled_ ? "esp_pm" : "setCpuFrequencyMhz", max_lock_held_ ? ", max lock held" : "");
+    out.printf("Load: busiest core %.0f%%, both cores %.0f%%; stations %u, streaming %s\n",
+               last_inputs_.load_percent, last_inputs_.avg_load_percent, last_inputs_.stations,
+               last_inputs_.streaming ? "yes" : "no");
+
+    out.println("State       MHz   Time s  Entries  Switch us  Max us  Wake us  CPU mA");
+    for (size_t i = 0; i < POWER_STATE_COUNT; i++) {
+        const PowerStateStats& stats = stats_[i];
+        out.printf("%-10s %4u %8lu %8lu %10lu %7lu %8lu %7.1f\n", powerStateName((PowerState)i),
+                   mhzFor((PowerState)i), (uint32_t)(stats.time_ms / 1000), stats.entries, stats.switch_us,
+                   stats.max_switch_us, stats.wake_latency_us, stats.avg_ma);
+    }
+
+    uint16_t mhz = fixed_mhz_ ? fixed_mhz_ : mhz_;
+    out.printf("CPU now ~%.0f mA (fixed 240 MHz: ~%.0f mA), saved ~%.1f mAh since boot\n",
+               estimateMa(mhz, last_inputs_.avg_load_percent),
+               estimateMa(PowerConfig::MAX_MHZ, last_inputs_.avg_load_percent * mhz / PowerConfig::MAX_MHZ),
+               saved_mah_);
+    out.printf("TX power: %.2f dBm; ~%u mA while transmitting at max, ~%u mA at %.0f dBm (RX not included)\n",
+               tx_qdbm_ / 4.0f, PowerConfig::MA_TX_MAX, PowerConfig::MA_TX_NEAR, PowerConfig::TX_NEAR_QDBM / 4.0f);
+    out.println("Estimates from datasheet figures, not measured current");
+    out.println("======================\n");
+}
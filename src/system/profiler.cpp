@@ -0,0 +1,193 @@
+// src/system/profiler.cpp - Профилирование задач FreeRTOS и джиттера loop()
+#include "profiler.h"
+#include "esp_timer.h"
+
+// Upper bounds (us) of the loop period buckets; the last bucket is open-ended
+static const uint32_t kBucketLimitsUs[ProfilerConfig::JITTER_BUCKETS - 1] = {
+    200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000
+};
+
+Profiler::Profiler()
+    : task_count_(0), hidden_tasks_(0), status_(nullptr), status_capacity_(0),
+      last_total_runtime_(0), last_sample_ms_(0),
+      sample_cost_us_(0), overhead_percent_(0.0f),
+      runtime_stats_available_(configGENERATE_RUN_TIME_STATS == 1),
+      loop_start_cycles_(0), last_loop_start_cycles_(0), cycles_per_us_(240) {
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        core_load_[i] = 0.0f;
+        idle_runtime_[i] = 0;
+    }
+}
+
+void Profiler::loopBegin() {
+    uint32_t now = ESP.getCycleCount();
+    if (last_loop_start_cycles_ != 0) {
+        uint32_t period_us = (now - last_loop_start_cycles_) / cycles_per_us_;
+        jitter_.buckets[bucketFor(period_us)]++;
+        if (period_us > jitter_.max_period_us) {
+            jitter_.max_period_us = period_us;
+        }
+    }
+    last_loop_start_cycles_ = now;
+    loop_start_cycles_ = now;
+}
+
+void Profiler::loopEnd() {
+    uint32_t duration_us = (ESP.getCycleCount() - loop_start_cycles_) / cycles_per_us_;
+    jitter_.iterations++;
+    jitter_.total_duration_us += duration_us;
+    if (duration_us > jitter_.max_duration_us) {
+        jitter_.max_duration_us = duration_us;
+    }
+}
+
+void Profiler::update() {
+    unsigned long now = millis();
+    if (now - last_sample_ms_ < ProfilerConfig::SAMPLE_INTERVAL_MS) {
+        return;
+    }
+
+    int64_t start = esp_timer_get_time();
+    sample();
+    sample_cost_us_ = (uint32_t)(esp_timer_get_time() - start);
+
+    if (last_sample_ms_ != 0) {
+        overhead_percent_ = sample_cost_us_ / ((now - last_sample_ms_) * 10.0f);
+    }
+    last_sample_ms_ = now;
+
+    // Cycle counter is per core; the loop task stays on one core, only the clock may change
+    cycles_per_us_ = ESP.getCpuFreqMHz();
+}
+
+void Profiler::sample() {
+#if configUSE_TRACE_FACILITY == 1
+    // uxTaskGetSystemState() returns nothing at all when the array is short
+    size_t wanted = uxTaskGetNumberOfTasks() + ProfilerConfig::TASK_HEADROOM;
+    if (wanted > status_capacity_) {
+        free(status_);
+        status_ = (TaskStatus_t*)malloc(wanted * sizeof(TaskStatus_t));
+        status_capacity_ = status_ ? wanted : 0;
+        if (!status_) {
+            return;
+        }
+    }
+    uint32_t total_runtime = 0;
+    UBaseType_t count = uxTaskGetSystemState(status_, status_capacity_, &total_runtime);
+    if (count == 0) {
+        return;     // Outgrew the headroom meanwhile; the next sample allocates more
+    }
+
+    uint32_t elapsed = total_runtime - last_total_runtime_;
+    bool have_interval = runtime_stats_available_ && last_total_runtime_ != 0 && elapsed != 0;
+    TaskSample previous[ProfilerConfig::MAX_TASKS];
+    size_t previous_count = task_count_;
+    memcpy(previous, tasks_, sizeof(TaskSample) * previous_count);
+
+    // Core load = 100% minus that core's idle task, which may be past MAX_TASKS
+    for (UBaseType_t i = 0; i < count; i++) {
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            if (status_[i].xHandle != xTaskGetIdleTaskHandleForCPU(core)) {
+                continue;
+            }
+            uint32_t idle = status_[i].ulRunTimeCounter;
+            core_load_[core] = have_interval ? 100.0f - (idle - idle_runtime_[core]) * 100.0f / elapsed : 0.0f;
+            idle_runtime_[core] = idle;
+        }
+    }
+
+    task_count_ = 0;
+    hidden_tasks_ = count > ProfilerConfig::MAX_TASKS ? count - ProfilerConfig::MAX_TASKS : 0;
+    for (UBaseType_t i = 0; i < count && task_count_ < ProfilerConfig::MAX_TASKS; i++) {
+        const TaskStatus_t* status = &status_[i];
+        TaskSample& task = tasks_[task_count_++];
+        task.handle = status->xHandle;
+        strncpy(task.name, status->pcTaskName, sizeof(task.name) - 1);
+        task.name[sizeof(task.name) - 1] = '\0';
+        task.priority = (uint8_t)status->uxCurrentPriority;
+        task.stack_free = status->usStackHighWaterMark;   // Bytes on ESP-IDF
+#if configTASKLIST_INCLUDE_COREID
+        task.core = status->xCoreID == tskNO_AFFINITY ? -1 : (int8_t)status->xCoreID;
+#else
+        task.core = -1;
+#endif
+        task.runtime = status->ulRunTimeCounter;
+        task.cpu_percent = 0.0f;
+
+        if (!have_interval) {
+            continue;
+        }
+        for (size_t j = 0; j < previous_count; j++) {
+            if (previous[j].handle == task.handle) {
+                task.cpu_percent = (task.runtime - previous[j].runtime) * 100.0f / elapsed;
+                break;
+            }
+        }
+    }
+    last_total_runtime_ = total_runtime;
+#endif
+}
+
+size_t Profiler::bucketFor(uint32_t period_us) {
+    for (size_t i = 0; i < ProfilerConfig::JITTER_BUCKETS - 1; i++) {
+        if (period_us < kBucketLimitsUs[i]) {
+            return i;
+        }
+    }
+    return ProfilerConfig::JITTER_BUCKETS - 1;
+}
+
+const char* Profiler::bucketLabel(size_t bucket) {
+    static const char* const labels[ProfilerConfig::JITTER_BUCKETS] = {
+        "   <200us", "   <500us", "     <1ms", "     <2ms", "     <5ms",
+        "    <10ms", "    <20ms", "    <50ms", "   <100ms", "  >=100ms"
+    };
+    return labels[bucket];
+}
+
+void Profiler::printReport(Print& out) const {
+    out.println("\n=== Task Profile ===");
+
+#if configUSE_TRACE_FACILITY == 1
+    if (runtime_stats_available_) {
+        out.printf("Core load: core0 %.1f%%, core1 %.1f%%\n", core_load_[0], core_load_[1]);
+    } else {
+        out.println("Core load: n/a (CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS disabled)");
+    }
+    out.println("Task              Core Prio   CPU%  Stack free");
+    for (size_t i = 0; i < task_count_; i++) {
+        const TaskSample& task = tasks_[i];
+        char core[4];
+        if (task.core < 0) {
+            snprintf(core, sizeof(core), "-");
+        } else {
+            snprintf(core, sizeof(core), "%d", task.core);
+        }
+        out.printf("%-16s  %4s %4u %6.1f %8lu B%s\n", task.name, core, task.priority,
+                   task.cpu_percent, task.stack_free, task.stack_free < 512 ? "  ⚠️" : "");
+    }
+    if (hidden_tasks_ > 0) {
+        out.printf("... %u more task(s) not shown (ProfilerConfig::MAX_TASKS = %u)\n",
+                   (unsigned)hidden_tasks_, (unsigned)ProfilerConfig::MAX_TASKS);
+    }
+#else
+    out.println("Task list: n/a (CONFIG_FREERTOS_USE_TRACE_FACILITY disabled)");
+#endif
+
+    out.println("\n--- loop() wake-up period histogram ---");
+    uint32_t periods = 0;
+    for (size_t i = 0; i < ProfilerConfig::JITTER_BUCKETS; i++) {
+        periods += jitter_.buckets[i];
+    }
+    for (size_t i = 0; i < ProfilerConfig::JITTER_BUCKETS; i++) {
+        if (jitter_.buckets[i] == 0) continue;
+        out.printf("%s: %8lu (%.1f%%)\n", bucketLabel(i), jitter_.buckets[i],
+                   periods > 0 ? jitter_.buckets[i] * 100.0f / periods : 0.0f);
+    }
+    out.printf("Iterations: %lu, avg duration: %lu us, max duration: %lu us, max period: %lu us\n",
+               jitter_.iterations,
+               jitter_.iterations > 0 ? (uint32_t)(jitter_.total_duration_us / jitter_.iterations) : 0,
+               jitter_.max_duration_us, jitter_.max_period_us);
+    out.printf("Profiler overhead: %lu us per sample (%.3f%% CPU)\n", sample_cost_us_, overhead_percent_);
+    out.println("====================\n");
+}
@@ -1,8 +1,9 @@
 // src/system/system_manager.cpp
 #include "system_manager.h"
+#include <algorithm>
 
 SystemManager::SystemManager() 
-    : mjpegServer(80), system_initialized(false), last_stats_log(0) {
+    : mjpegServer(80), system_initialized(false), net_timer(-1) {
 }
 
 SystemManager::~SystemManager() {
@@ -16,6 +17,17 @@ bool SystemManager::initialize() {
     Serial.printf("📊 [MEMORY] Initial free heap: %lu KB\n", ESP.getFreeHeap() / 1024);
     Serial.printf("🧠 [MEMORY] Initial free PSRAM: %lu KB\n", ESP.getFreePsram() / 1024);
 
+    // Bound to this (the loop) task: callbacks registered below may post right away
+    eventLoop.begin();
+
+    // Long-lived scratch memory first, before the heap gets fragmented
+    if (!MemoryPools::begin()) {
+        Serial.println("⚠️  [MEMORY] Some arenas/pools could not be preallocated");
+    }
+
+    // Last known-good tuning; applied step by step as components come up
+    bool warm = warmStart.load();
+
     // Initialize camera first (critical for system stability)
     Serial.println("📷 [INIT] Step 1/4: Initializing OV2640 camera...");
     delay(500); // Дополнительная задержка для стабильности
@@ -27,12 +39,15 @@ bool SystemManager::initialize() {
         return false;
     }
     Serial.println("✅ [SUCCESS] Camera initialized successfully");
+    if (warm) {
+        applyWarmState(warmStart.stored());
+    }
     Serial.printf("📊 [MEMORY] After camera init - Free heap: %lu KB\n", ESP.getFreeHeap() / 1024);
 
     // Initialize WiFi
     Serial.println("📡 [INIT] Step 2/4: Initializing WiFi Access Point...");
     delay(500);
-    wifi.init("Drone", "drone2024");
+    wifi.init("Drone", "drone2024", warm ? (uint8_t)warmStart.stored().get(WarmField::WIFI_CHANNEL) : 0);
     delay(200);
     wifi.start();
     delay(1000);
@@ -41,13 +56,34 @@ bool SystemManager::initialize() {
     // Initialize MJPEG Server
     Serial.println("🌐 [INIT] Step 3/4: Initializing MJPEG server...");
     delay(500);
+    mjpegServer.attachProfiler(&profiler);
+    mjpegServer.attachAnalyzer(&frameAnalyzer);
+    mjpegServer.attachRawPipeline(&rawPipeline);
+    mjpegServer.attachBlackbox(&blackbox);
+    frameAnalyzer.onMotion([](bool active, const MotionResult& result) {
+        if (active) {
+            Serial.printf("🎯 [MOTION] Motion started: %u/%u cells, mean diff %.1f%s\n",
+                          result.changed_cells, result.total_cells, result.mean_abs_diff,
+                          result.scene_change ? " (scene change)" : "");
+        } else {
+            Serial.println("🎯 [MOTION] Motion ended");
+        }
+    });
     mjpegServer.start(&camera);
     Serial.printf("✅ [SUCCESS] MJPEG server running at http://%s/\n", WiFi.softAPIP().toString().c_str());
 
     // Initialize Flight Controller
     Serial.println("✈️  [INIT] Step 4/5: Initializing Flight Controller...");
-    flightController.initialize();
+    flightController.setProtocol(warm ? (FcLinkProtocol)warmStart.stored().get(WarmField::FC_PROTOCOL)
+                                      : FcLinkProtocol::MSP);
+    flightController.initialize(warm ? warmStart.stored().get(WarmField::FC_BAUD)
+                                     : FlightControllerConfig::DEFAULT_BAUD);
     flightController.testConnection();
+    // Encoded on the FC UART task as replies arrive; written to flash by the blackbox task
+    blackbox.begin();
+    flightController.onTelemetry([this](FcField field, const FcTelemetry& telemetry) {
+        blackbox.record(field, telemetry);
+    });
 
     // Initialize dual-core task manager
     Serial.println("⚙️  [INIT] Step 5/5: Starting dual-core task manager...");
@@ -57,8 +93,9 @@ bool SystemManager::initialize() {
         return false;
     }
 
+    registerEvents();
+    powerGovernor.begin();
     system_initialized = true;
-    last_stats_log = millis();
     
     Serial.println("🎉 [SUCCESS] ALL system components initialized successfully!");
     Serial.printf("📊 [FINAL] Free heap: %lu KB, Free PSRAM: %lu KB\n", 
@@ -66,33 +103,185 @@ bool SystemManager::initialize() {
     return true;
 }
 
-void SystemManager::update() {
-    if (!system_initialized) return;
-    
-    // Update task manager (handles dual-core operations)
-    taskManager.update();
-    
-    // Handle MJPEG clients
-    mjpegServer.handleClients();
-    
-    // Update Flight Controller
-    flightController.update();
-    
-    // Check WiFi stability
-    wifi.checkStability();
+// Each source wakes only its own handler; housekeeping runs on timers at
+// its own cadence. Between events the loop task sleeps.
+void SystemManager::registerEvents() {
+    // Frames: the VSYNC ISR or the raw pipeline's encoder wakes the stream
+    const FrameSignal& signal = camera.getFrameSignal();
+    camera.setFrameNotify(eventLoop.getTask(), EventLoop::bit(EventSource::FRAME));
+    rawPipeline.setFrameNotify(eventLoop.getTask(), EventLoop::bit(EventSource::FRAME));
+    eventLoop.on(EventSource::FRAME, [this]() {
+        if (mjpegServer.streamToViewers()) {
+            wifi.surveyAfterFrame();
+        }
+        // A queued frame has no edge of its own left to wake us
+        if (mjpegServer.hasQueuedFrame()) {
+            eventLoop.post(EventSource::FRAME);
+        }
+    });
+    if (signal.armed) {
+        eventLoop.setPostTime(EventSource::FRAME, &signal.last_us);
+    } else {
+        // No VSYNC interrupt on this target: the blocking frame get paces the stream
+        eventLoop.addTimer("frame", FRAME_POLL_INTERVAL, [this]() { eventLoop.post(EventSource::FRAME); });
+    }
+
+    // FC UART: the driver task posts once it queued whole frames, update() takes them here
+    flightController.onReceive([this]() { eventLoop.post(EventSource::FC_RX); });
+    eventLoop.on(EventSource::FC_RX, [this]() { flightController.update(); });
+
+    // WiFi: station changes set the network poll rate, scan results feed the survey
+    auto postWiFi = [this](arduino_event_id_t event, arduino_event_info_t info) {
+        eventLoop.post(EventSource::WIFI);
+    };
+    WiFi.onEvent(postWiFi, ARDUINO_EVENT_WIFI_AP_STACONNECTED);
+    WiFi.onEvent(postWiFi, ARDUINO_EVENT_WIFI_AP_STADISCONNECTED);
+    WiFi.onEvent(postWiFi, ARDUINO_EVENT_WIFI_SCAN_DONE);
+    eventLoop.on(EventSource::WIFI, [this]() {
+        updateNetPollRate();
+        updatePower();
+        wifi.updateChannelSurvey();
+    });
+
+    // lwIP sockets have no callback here: HTTP (and the UDP control channel,
+    // registered by CommandHandler) are polled, fast only while stations are on
+    net_timer = eventLoop.addTimer("net", EventLoopConfig::NET_POLL_IDLE_MS, EventSource::NET);
+    eventLoop.on(EventSource::NET, [this]() {
+        mjpegServer.handleRequests();
+        bool viewers = mjpegServer.getViewerPolicy().getActiveCount() > 0;
+        wifi.setStreaming(viewers);
+        // A new viewer gets the streaming clock now, not on the next governor tick
+        if (viewers && powerGovernor.getState() != PowerState::STREAMING) {
+            updatePower();
+        }
+    });
+    updateNetPollRate();
+
+    eventLoop.addTimer("power", PowerConfig::UPDATE_INTERVAL_MS, [this]() { updatePower(); });
+    eventLoop.addTimer("profiler", ProfilerConfig::SAMPLE_INTERVAL_MS, [this]() { profiler.update(); });
+    eventLoop.addTimer("heap", MemoryConfig::MONITOR_INTERVAL_MS, []() { MemoryPools::monitor().update(); });
+    eventLoop.addTimer("stats", STATS_LOG_INTERVAL, [this]() { logStatistics(); });
+    eventLoop.addTimer("tasks", TASK_STATUS_INTERVAL, [this]() { taskManager.update(); });
+    eventLoop.addTimer("wifi", WIFI_CHECK_INTERVAL, [this]() { wifi.checkStability(); });
+    // The capture path only flags a stall; the driver restart runs here
+    eventLoop.addTimer("camwd", CameraWatchdogConfig::SERVICE_INTERVAL_MS, [this]() { camera.serviceWatchdog(); });
+    eventLoop.addTimer("survey", SURVEY_STEP_INTERVAL, [this]() { wifi.updateChannelSurvey(); });
+    // OSD data for the raw pipeline
+    eventLoop.addTimer("osd", OSD_UPDATE_INTERVAL, [this]() {
+        if (rawPipeline.isRunning()) {
+            updateOsdTelemetry();
+        }
+    });
+    // Known-good state to NVS (rate-limited, only while frames flow)
+    eventLoop.addTimer("warm", WarmStartConfig::CHECK_INTERVAL_MS, [this]() {
+        warmStart.update(captureWarmState(), camera.isInitialized() && camera.getStatistics().current_fps > 0);
+    });
+}
+
+void SystemManager::updateNetPollRate() {
+    eventLoop.setTimerInterval(net_timer, WiFi.softAPgetStationNum() > 0 ? EventLoopConfig::NET_POLL_ACTIVE_MS
+                                                                        : EventLoopConfig::NET_POLL_IDLE_MS);
+}
+
+void SystemManager::updatePower() {
+    PowerInputs inputs;
+    inputs.streaming = mjpegServer.getViewerPolicy().getActiveCount() > 0 || rawPipeline.isRunning();
+    if (profiler.hasRuntimeStats()) {
+        inputs.load_percent = std::max(profiler.getCoreLoad(0), profiler.getCoreLoad(1));
+        inputs.avg_load_percent = (profiler.getCoreLoad(0) + profiler.getCoreLoad(1)) / 2;
+    } else {
+        // Only the loop task's share is known
+        inputs.load_percent = eventLoop.getBusyPercent();
+        inputs.avg_load_percent = inputs.load_percent / 2;
+    }
+    inputs.wake_latency_us = eventLoop.getSourceStats(EventSource::FRAME).avg_latency_us;
+
+    wifi_sta_list_t stations;
+    if (esp_wifi_ap_get_sta_list(&stations) == ESP_OK) {
+        inputs.stations = (uint8_t)stations.num;
+        for (int i = 0; i < stations.num; i++) {
+            if (i == 0 || stations.sta[i].rssi < inputs.weakest_rssi) {
+                inputs.weakest_rssi = stations.sta[i].rssi;
+            }
+        }
+    }
+    powerGovernor.update(inputs);
+}
+
+void SystemManager::logStatistics() {
+    MemoryPools::logf(Serial, "[SYSTEM] Uptime: %lu seconds\n", millis() / 1000);
     
-    // Periodic statistics logging
-    if (millis() - last_stats_log >= STATS_LOG_INTERVAL) {
-        Serial.printf("[SYSTEM] Uptime: %lu seconds\n", millis() / 1000);
-        
-        FrameStats stats = camera.getStatistics();
-        Serial.printf("[CAMERA] FPS: %.2f, Frames: %lu\n", stats.current_fps, stats.total_frames);
-        
-        last_stats_log = millis();
+    FrameStats stats = camera.getStatistics();
+    MemoryPools::logf(Serial, "[CAMERA] FPS: %.2f, Frames: %lu\n", stats.current_fps, stats.total_frames);
+}
+
+void SystemManager::updateOsdTelemetry() {
+    OsdTelemetry telemetry;
+    FcTelemetry fc = flightController.getTelemetry();
+    telemetry.fc_link = flightController.isLinkUp();
+    telemetry.armed = fc.armed;
+    telemetry.battery_v = fc.battery_cv / 100.0f;
+    telemetry.altitude_m = fc.altitude_cm / 100.0f;
+    telemetry.heading_deg = (uint16_t)((fc.yaw_deg % 360 + 360) % 360);
+    telemetry.fps = rawPipeline.getStats().output_fps;
+    telemetry.uptime_s = millis() / 1000;
+    telemetry.viewers = (uint8_t)mjpegServer.getViewerPolicy().getActiveCount();
+    rawPipeline.setTelemetry(telemetry);
+}
+
+bool SystemManager::startBlackbox(uint16_t rate_hz) {
+    if (!blackbox.start(rate_hz)) {
+        return false;
     }
+    flightController.setPollRate(blackbox.getRate());
+    return true;
+}
+
+void SystemManager::stopBlackbox() {
+    blackbox.stop();
+    flightController.setPollRate(FlightControllerConfig::TELEMETRY_POLL_HZ);
+}
+
+// Before the first frame: quality plus the exposure/gain the sensor had
+// settled on, so AEC/AGC start from there rather than from the defaults
+void SystemManager::applyWarmState(const WarmState& state) {
+    static const WarmField sensorFields[] = {
+        WarmField::AEC, WarmField::AEC2, WarmField::AE_LEVEL, WarmField::AEC_VALUE,
+        WarmField::AGC, WarmField::AGC_GAIN, WarmField::GAINCEILING,
+    };
+    static const SensorSetting sensorSettings[] = {
+        SensorSetting::AEC, SensorSetting::AEC2, SensorSetting::AE_LEVEL, SensorSetting::AEC_VALUE,
+        SensorSetting::AGC, SensorSetting::AGC_GAIN, SensorSetting::GAINCEILING,
+    };
+    SensorValue values[sizeof(sensorFields) / sizeof(sensorFields[0])];
+    for (size_t i = 0; i < sizeof(sensorFields) / sizeof(sensorFields[0]); i++) {
+        values[i].setting = sensorSettings[i];
+        values[i].value = (int16_t)state.get(sensorFields[i]);
+    }
+    SensorProfile profile = {"warm", "Restored from NVS", values, (uint8_t)(sizeof(values) / sizeof(values[0]))};
     
-    // Feed watchdog
-    // vTaskDelay(1); // Minimal delay to allow other tasks to run
+    // No frames are being read out yet, so no VSYNC wait
+    if (!camera.applyProfile(profile, false) ||
+        !camera.setJpegQuality((uint8_t)state.get(WarmField::JPEG_QUALITY))) {
+        Serial.printf("⚠️  [WARM] Sensor restore incomplete: %s\n", camera.getLastErrorMessage().c_str());
+    }
+}
+
+WarmState SystemManager::captureWarmState() const {
+    const SensorShadow& shadow = camera.getSensorShadow();
+    WarmState state;
+    state.set(WarmField::JPEG_QUALITY, shadow.get(SensorSetting::QUALITY));
+    state.set(WarmField::WIFI_CHANNEL, wifi.getChannel());
+    state.set(WarmField::FC_BAUD, (int32_t)flightController.getBaud());
+    state.set(WarmField::AEC, shadow.get(SensorSetting::AEC));
+    state.set(WarmField::AEC2, shadow.get(SensorSetting::AEC2));
+    state.set(WarmField::AE_LEVEL, shadow.get(SensorSetting::AE_LEVEL));
+    state.set(WarmField::AEC_VALUE, shadow.get(SensorSetting::AEC_VALUE));
+    state.set(WarmField::AGC, shadow.get(SensorSetting::AGC));
+    state.set(WarmField::AGC_GAIN, shadow.get(SensorSetting::AGC_GAIN));
+    state.set(WarmField::GAINCEILING, shadow.get(SensorSetting::GAINCEILING));
+    state.set(WarmField::FC_PROTOCOL, (int32_t)flightController.getProtocol());
+    return state;
 }
 
 void SystemManager::shutdown() {
@@ -100,6 +289,8 @@ void SystemManager::shutdown() {
     
     Serial.println("[SYSTEM] Shutting down system components...");
     
+    rawPipeline.stop();
+    stopBlackbox();
     taskManager.stop();
     
     // Stop network services
@@ -112,26 +303,26 @@ void SystemManager::shutdown() {
     Serial.println("[SYSTEM] Shutdown complete");
 }
 
-void SystemManager::printSystemStatus() {
-    Serial.println("\n=== System Status ===");
-    Serial.printf("System Initialized: %s\n", system_initialized ? "YES" : "NO");
-    Serial.printf("Uptime: %lu seconds\n", millis() / 1000);
-    Serial.printf("CPU Frequency: %lu MHz\n", ESP.getCpuFreqMHz());
-    Serial.printf("Flash Size: %lu MB\n", ESP.getFlashChipSize() / (1024 * 1024));
+void SystemManager::printSystemStatus(Print& out) {
+    out.println("\n=== System Status ===");
+    out.printf("System Initialized: %s\n", system_initialized ? "YES" : "NO");
+    out.printf("Uptime: %lu seconds\n", millis() / 1000);
+    out.printf("CPU Frequency: %lu MHz\n", ESP.getCpuFreqMHz());
+    out.printf("Flash Size: %lu MB\n", ESP.getFlashChipSize() / (1024 * 1024));
     
     // Camera status
-    Serial.printf("Camera: %s\n", camera.isInitialized() ? "Initialized" : "Not initialized");
+    out.printf("Camera: %s\n", camera.isInitialized() ? "Initialized" : "Not initialized");
     
     // WiFi status
-    Serial.printf("WiFi AP: %s\n", WiFi.softAPIP().toString().c_str());
-    Serial.printf("WiFi Clients: %d\n", WiFi.softAPgetStationNum());
+    out.printf("WiFi AP: %s\n", WiFi.softAPIP().toString().c_str());
+    out.printf("WiFi Clients: %d\n", WiFi.softAPgetStationNum());
     
     // Task manager status
-    Serial.printf("Dual-Core Tasks: %s\n", taskManager.isRunning() ? "Running" : "Stopped");
+    out.printf("Dual-Core Tasks: %s\n", taskManager.isRunning() ? "Running" : "Stopped");
     
-    Serial.println("\n--- Memory ---");
-    Serial.printf("Free Heap: %lu bytes\n", ESP.getFreeHeap());
-    Serial.printf("Free PSRAM: %lu bytes\n", ESP.getFreePsram());
+    out.println("\n--- Memory ---");
+    out.printf("Free Heap: %lu bytes\n", ESP.getFreeHeap());
+    out.printf("Free PSRAM: %lu bytes\n", ESP.getFreePsram());
     
-    Serial.println("=====================\n");
+    out.println("=====================\n");
 }
@@ -0,0 +1,164 @@
+// src/system/warm_start.cpp - Кэш рабочего состояния в NVS с ограничением записи
+#include "warm_start.h"
+#include <Preferences.h>
+#include <string.h>
+
+namespace {
+
+struct WarmBlobHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t field_count;
+    uint8_t reserved;
+};
+
+constexpr uint32_t WARM_MAGIC = 0x4D524157;    // "WARM"
+
+struct WarmBlob {
+    WarmBlobHeader header;
+    WarmState state;
+};
+
+} // namespace
+
+bool WarmState::equals(const WarmState& other) const {
+    return memcmp(values, other.values, sizeof(values)) == 0;
+}
+
+bool WarmState::isValid() const {
+    for (size_t i = 0; i < WARM_FIELD_COUNT; i++) {
+        if (values[i] < WARM_SCHEMA[i].min || values[i] > WARM_SCHEMA[i].max) return false;
+    }
+    return true;
+}
+
+WarmStart::WarmStart()
+    : stored_valid_(false), candidate_valid_(false), candidate_since_(0), last_write_(0),
+      writes_(0), load_result_("not loaded") {
+    memset(&stored_, 0, sizeof(stored_));
+    memset(&candidate_, 0, sizeof(candidate_));
+}
+
+bool WarmStart::load() {
+    stored_valid_ = false;
+    Preferences prefs;
+    if (!prefs.begin(WarmStartConfig::NVS_NAMESPACE, true)) {
+        load_result_ = "empty";
+        return false;
+    }
+
+    WarmBlob blob;
+    size_t length = prefs.getBytesLength(WarmStartConfig::NVS_KEY);
+    if (length == 0) {
+        load_result_ = "empty";
+    } else if (length != sizeof(blob) || prefs.getBytes(WarmStartConfig::NVS_KEY, &blob, sizeof(blob)) != sizeof(blob) ||
+               blob.header.magic != WARM_MAGIC || blob.header.version != WarmStartConfig::SCHEMA_VERSION ||
+               blob.header.field_count != WARM_FIELD_COUNT) {
+        load_result_ = "other schema";
+    } else if (!blob.state.isValid()) {
+        load_result_ = "out of range";
+    } else {
+        stored_ = blob.state;
+        stored_valid_ = true;
+        load_result_ = "restored";
+    }
+    prefs.end();
+
+    if (stored_valid_) {
+        Serial.printf("💾 [WARM] Restored schema v%u: quality %ld, channel %ld, FC %ld baud\n",
+                      WarmStartConfig::SCHEMA_VERSION, stored_.get(WarmField::JPEG_QUALITY),
+                      stored_.get(WarmField::WIFI_CHANNEL), stored_.get(WarmField::FC_BAUD));
+    } else {
+        Serial.printf("💾 [WARM] No warm state (%s), cold start\n", load_result_);
+    }
+    return stored_valid_;
+}
+
+void WarmStart::update(const WarmState& live, bool healthy) {
+    unsigned long now = millis();
+    // Any change or an unhealthy moment restarts the stability window
+    if (!healthy || !candidate_valid_ || !candidate_.equals(live)) {
+        candidate_ = live;
+        candidate_valid_ = healthy;
+        candidate_since_ = now;
+        return;
+    }
+    if (now - candidate_since_ < WarmStartConfig::STABLE_MS) return;
+    if (stored_valid_ && stored_.equals(candidate_)) return;
+    if (writes_ >= WarmStartConfig::MAX_WRITES_PER_BOOT) return;
+    if (writes_ > 0 && now - last_write_ < WarmStartConfig::MIN_WRITE_INTERVAL_MS) return;
+
+    if (write(candidate_)) {
+        Serial.printf("💾 [WARM] Known-good state saved (%u/%u writes this boot)\n",
+                      writes_, WarmStartConfig::MAX_WRITES_PER_BOOT);
+    }
+}
+
+bool WarmStart::save(const WarmState& live) {
+    return write(live);
+}
+
+bool WarmStart::write(const WarmState& state) {
+    if (!state.isValid()) return false;
+
+    WarmBlob blob;
+    memset(&blob, 0, sizeof(blob));
+    blob.header.magic = WARM_MAGIC;
+    blob.header.version = WarmStartConfig::SCHEMA_VERSION;
+    blob.header.field_count = WARM_FIELD_COUNT;
+    blob.state = state;
+
+    Preferences prefs;
+    if (!prefs.begin(WarmStartConfig::NVS_NAMESPACE, false)) return false;
+    bool ok = prefs.putBytes(WarmStartConfig::NVS_KEY, &blob, sizeof(blob)) == sizeof(blob);
+    prefs.end();
+
+    // A failed write still counts: retrying every second would defeat the limit
+    last_write_ = millis();
+    writes_++;
+    if (ok) {
+        stored_ = state;
+        stored_valid_ = true;
+    } else {
+        Serial.println("⚠️  [WARM] NVS write failed");
+    }
+    return ok;
+}
+
+bool WarmStart::clear() {
+    Preferences prefs;
+    if (!prefs.begin(WarmStartConfig::NVS_NAMESPACE, false)) return false;
+    bool ok = prefs.remove(WarmStartConfig::NVS_KEY);
+    prefs.end();
+    stored_valid_ = false;
+    candidate_valid_ = false;
+    return ok;
+}
+
+void WarmStart::printStatus(const WarmState& live, Print& out) const {
+    out.printf("\n=== Warm Start (schema v%u) ===\n", WarmStartConfig::SCHEMA_VERSION);
+    out.printf("Boot: %s, writes this boot: %u/%u\n", load_result_, writes_,
+               WarmStartConfig::MAX_WRITES_PER_BOOT);
+    out.printf("%-12s %10s %10s\n", "field", "live", "stored");
+    for (size_t i = 0; i < WARM_FIELD_COUNT; i++) {
+        out.printf("%-12s %10ld", WARM_SCHEMA[i].name, live.values[i]);
+        if (stored_valid_) {
+            out.printf(" %10ld%s\n", stored_.values[i], stored_.values[i] != live.values[i] ? " *" : "");
+        } else {
+            out.printf(" %10s\n", "-");
+        }
+    }
+
+    unsigned long now = millis();
+    if (candidate_valid_ && candidate_.equals(live)) {
+        out.printf("Stable for %lu s (known-good after %lu s)\n", (now - candidate_since_) / 1000,
+                   WarmStartConfig::STABLE_MS / 1000);
+    } else {
+        out.println("Not stable/healthy yet");
+    }
+    if (writes_ > 0 && now - last_write_ < WarmStartConfig::MIN_WRITE_INTERVAL_MS) {
+        out.printf("Next automatic write allowed in %lu s\n",
+                   (WarmStartConfig::MIN_WRITE_INTERVAL_MS - (now - last_write_)) / 1000);
+    }
+    out.println("==============================\n");
+}
@@ -1,20 +1,28 @@
 #include "wifi_module.h"
 #include <Arduino.h>
 
-WiFiModule::WiFiModule() : lastStabilityCheck_(0) {}
+// Relative interference of a network N channels away (in 1/8 units)
+static const uint8_t kOverlapWeight[] = {8, 6, 4, 2};
 
-void WiFiModule::init(const char* ssid, const char* password) {
-    ssid_ = String(ssid);
-    password_ = String(password);
+WiFiModule::WiFiModule()
+    : lastStabilityCheck_(0),
+      channel_(ChannelSurveyConfig::DEFAULT_CHANNEL), pendingChannel_(0),
+      surveyEnabled_(true), scanningChannel_(0), nextSurveyChannel_(0),
+      streaming_(false), fullScanRequested_(false), fullScanRunning_(false),
+      lastSurveyStep_(0), lastSweepEnd_(0), sweepsCompleted_(0) {}
+
+void WiFiModule::init(const char* ssid, const char* password, uint8_t preferred_channel) {
+    ssid_ = ssid;
+    password_ = password;
 
     // Жесткий сброс WiFi
     WiFi.disconnect(true);
     WiFi.mode(WIFI_OFF);
     delay(2000);
     
-    // Инициализация в режиме AP
-    if (!WiFi.mode(WIFI_AP)) {
-        Serial.println("[WiFi] ❌ Не удалось установить режим AP");
+    // Инициализация в режиме AP+STA: STA нужен только для фонового сканирования
+    if (!WiFi.mode(WIFI_AP_STA)) {
+        Serial.println("[WiFi] ❌ Не удалось установить режим AP+STA");
         return;
     }
 
@@ -28,6 +36,19 @@ void WiFiModule::init(const char* ssid, const char* password) {
 
     // Установка обработчика событий
     WiFi.onEvent(wifiEventHandler);
+
+    pendingChannel_ = 0;
+    if (isValidChannel(preferred_channel)) {
+        // Тёплый старт: канал из прошлой сессии, без ~1.5 с обзора при загрузке
+        channel_ = preferred_channel;
+        Serial.printf("[WiFi] Канал %d из тёплого старта\n", channel_);
+        return;
+    }
+
+    // Клиентов ещё нет - можно спокойно выбрать наименее загруженный канал
+    surveyAllChannels();
+    channel_ = recommendChannel();
+    Serial.printf("[WiFi] Выбран канал %d (score %lu)\n", channel_, channelScore(channel_));
 }
 
 void WiFiModule::start() {
@@ -38,7 +59,7 @@ void WiFiModule::start() {
     delay(1000);
     
     // Запуск AP с оптимизированными параметрами
-    if (!WiFi.softAP(ssid_.c_str(), NULL, 1, false, 4)) {
+    if (!WiFi.softAP(ssid_.c_str(), NULL, channel_, false, 4)) {
         Serial.println("[WiFi] ❌ Ошибка запуска AP!");
         return;
     }
@@ -49,6 +70,7 @@ void WiFiModule::start() {
     Serial.printf("[WiFi] Точка доступа запущена: %s\n", ssid_.c_str());
     Serial.printf("[WiFi] IP адрес: %s\n", WiFi.softAPIP().toString().c_str());
     Serial.printf("[WiFi] MAC адрес: %s\n", WiFi.softAPmacAddress().c_str());
+    Serial.printf("[WiFi] Канал: %d\n", channel_);
 }
 
 void WiFiModule::optimizeForFPV() {
@@ -56,13 +78,13 @@ void WiFiModule::optimizeForFPV() {
     WiFi.setSleep(false);
     esp_wifi_set_ps(WIFI_PS_NONE);
     
-    // Фиксированный канал 1
-    esp_wifi_set_channel(1, WIFI_SECOND_CHAN_NONE);
+    // Канал, выбранный по результатам обзора эфира
+    esp_wifi_set_channel(channel_, WIFI_SECOND_CHAN_NONE);
     
     // Allow 802.11b/g/n for better compatibility
     esp_wifi_set_protocol(WIFI_IF_AP, WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N);
     
-    // Максимальная мощность
+    // Максимальная мощность; PowerGovernor снижает её только без видео и вблизи
     WiFi.setTxPower(WIFI_POWER_19_5dBm);
     esp_wifi_set_max_tx_power(84); // 21dBm
     
@@ -86,31 +108,315 @@ void WiFiModule::checkStability() {
     if (millis() - lastStabilityCheck_ < 5000) return;
     lastStabilityCheck_ = millis();
 
-    if (WiFi.getMode() != WIFI_AP) {
+    if ((WiFi.getMode() & WIFI_AP) == 0) {
         Serial.println("[WiFi] Восстановление точки доступа...");
         start();
     }
 }
 
-void WiFiModule::scanNetworks() {
-    WiFi.mode(WIFI_STA);
-    WiFi.disconnect();
-    delay(100);
-    
-    Serial.println("[WiFi] Сканирование сетей...");
-    int n = WiFi.scanNetworks();
-    
-    if (n == 0) {
+void WiFiModule::scanNetworks(Print& out) {
+    // Полный проход уводит радио с канала AP на ~1.4 с - во время трансляции нельзя
+    if (streaming_) {
+        out.println("[WiFi] ⚠️ Сканирование недоступно во время трансляции");
+        return;
+    }
+    if (fullScanRequested_ || fullScanRunning_) {
+        out.println("[WiFi] Сканирование уже выполняется");
+        return;
+    }
+
+    // Сканирование в режиме AP+STA - клиенты точки доступа не отключаются.
+    // Асинхронно: результат придет событием SCAN_DONE
+    fullScanRequested_ = true;
+    if (scanningChannel_ == 0) {
+        startFullScan();
+    }
+    out.println("[WiFi] Сканирование сетей запущено, результаты - в Serial и wifisurvey");
+}
+
+void WiFiModule::startFullScan() {
+    fullScanRequested_ = false;
+    if (streaming_) {
+        Serial.println("[WiFi] ⚠️ Сканирование отменено: началась трансляция");
+        return;
+    }
+    int16_t started = WiFi.scanNetworks(true, true, true, ChannelSurveyConfig::DWELL_MS);
+    if (started != WIFI_SCAN_RUNNING) {
+        Serial.println("[WiFi] ❌ Не удалось запустить сканирование");
+        return;
+    }
+    // The full band replaces the sweep in progress
+    fullScanRunning_ = true;
+    nextSurveyChannel_ = 0;
+}
+
+void WiFiModule::finishFullScan(int16_t result) {
+    fullScanRunning_ = false;
+    if (result <= 0) {
         Serial.println("[WiFi] Сети не найдены");
     } else {
-        Serial.printf("[WiFi] Найдено %d сетей:\n", n);
-        for (int i = 0; i < n; i++) {
+        Serial.printf("[WiFi] Найдено %d сетей:\n", result);
+        for (int i = 0; i < result; i++) {
             Serial.printf("%d: %s (Канал %d) %ddBm\n",
                 i+1, WiFi.SSID(i).c_str(), WiFi.channel(i), WiFi.RSSI(i));
         }
     }
-    
-    WiFi.mode(WIFI_AP);
+
+    // Полное сканирование заодно обновляет статистику каналов
+    resetSweep();
+    for (int i = 0; i < result; i++) {
+        accumulateNetwork(WiFi.channel(i), WiFi.RSSI(i));
+    }
+    WiFi.scanDelete();
+    commitSweep(sweepsCompleted_ > 0);
+    lastSweepEnd_ = millis();
+    lastSurveyStep_ = lastSweepEnd_;
+}
+
+// --- Channel survey ---
+
+void WiFiModule::surveyAllChannels() {
+    Serial.println("[WiFi] Анализ загрузки каналов...");
+    resetSweep();
+
+    int n = WiFi.scanNetworks(false, true, true, ChannelSurveyConfig::DWELL_MS);
+    for (int i = 0; i < n; i++) {
+        accumulateNetwork(WiFi.channel(i), WiFi.RSSI(i));
+    }
+    WiFi.scanDelete();
+
+    commitSweep(false);
+    lastSweepEnd_ = millis();
+}
+
+void WiFiModule::updateChannelSurvey() {
+    if (fullScanRunning_) {
+        int16_t result = WiFi.scanComplete();
+        if (result == WIFI_SCAN_RUNNING) {
+            return;
+        }
+        finishFullScan(result);
+    }
+
+    // Collect the result of the single-channel step in flight
+    if (scanningChannel_ != 0) {
+        int16_t result = WiFi.scanComplete();
+        if (result == WIFI_SCAN_RUNNING) {
+            return;
+        }
+
+        // Only networks on the scanned channel count, neighbours get their own step
+        for (int i = 0; i < result; i++) {
+            if (WiFi.channel(i) == scanningChannel_) {
+                accumulateNetwork(WiFi.channel(i), WiFi.RSSI(i));
+            }
+        }
+        WiFi.scanDelete();
+        lastSurveyStep_ = millis();
+
+        if (scanningChannel_ >= ChannelSurveyConfig::LAST_CHANNEL) {
+            commitSweep(true);
+            nextSurveyChannel_ = 0;
+            lastSweepEnd_ = millis();
+            planAutoSwitch();
+        } else {
+            nextSurveyChannel_ = scanningChannel_ + 1;
+        }
+        scanningChannel_ = 0;
+    }
+
+    applyPendingChannelSwitch();
+
+    if (fullScanRequested_) {
+        startFullScan();
+        return;
+    }
+    if (!streaming_) {
+        startSurveyStep();
+    }
+}
+
+void WiFiModule::surveyAfterFrame() {
+    // The next frame is a full frame interval away; a short step fits in between
+    if (streaming_) {
+        startSurveyStep();
+    }
+}
+
+void WiFiModule::startSurveyStep() {
+    if (!surveyEnabled_ || scanningChannel_ != 0 || fullScanRunning_) {
+        return;
+    }
+
+    unsigned long now = millis();
+    if (nextSurveyChannel_ == 0) {
+        if (now - lastSweepEnd_ < ChannelSurveyConfig::SWEEP_INTERVAL_MS) {
+            return;
+        }
+        resetSweep();
+        nextSurveyChannel_ = ChannelSurveyConfig::FIRST_CHANNEL;
+    }
+
+    if (now - lastSurveyStep_ < ChannelSurveyConfig::STEP_INTERVAL_MS) {
+        return;
+    }
+
+    // One short dwell per step keeps the AP on its home channel most of the
+    // time. With stations on, an active probe answers within a few ms where a
+    // passive dwell would have to wait out a beacon interval
+    bool stations = WiFi.softAPgetStationNum() > 0;
+    int16_t started = WiFi.scanNetworks(true, true, !stations,
+                                        stations ? ChannelSurveyConfig::ACTIVE_DWELL_MS
+                                                 : ChannelSurveyConfig::DWELL_MS,
+                                        nextSurveyChannel_);
+    if (started == WIFI_SCAN_RUNNING) {
+        scanningChannel_ = nextSurveyChannel_;
+    } else {
+        lastSurveyStep_ = now;
+    }
+}
+
+void WiFiModule::resetSweep() {
+    for (uint8_t i = 0; i < ChannelSurveyConfig::CHANNEL_COUNT; i++) {
+        sweep_[i].reset();
+    }
+}
+
+void WiFiModule::accumulateNetwork(int32_t channel, int32_t rssi) {
+    if (!isValidChannel(channel)) {
+        return;
+    }
+
+    ChannelStats& entry = sweep_[channel - ChannelSurveyConfig::FIRST_CHANNEL];
+    entry.networks++;
+    if (rssi > entry.strongest_rssi) {
+        entry.strongest_rssi = (int8_t)rssi;
+    }
+
+    // Every network costs airtime; strong ones cost more (-100 dBm -> 10, -30 dBm -> 80)
+    int32_t strength = rssi + 100;
+    if (strength < 0) strength = 0;
+    if (strength > 70) strength = 70;
+    entry.load += 10 + strength;
+}
+
+void WiFiModule::commitSweep(bool smooth) {
+    for (uint8_t i = 0; i < ChannelSurveyConfig::CHANNEL_COUNT; i++) {
+        if (smooth) {
+            stats_[i].load = (stats_[i].load + sweep_[i].load) / 2;
+        } else {
+            stats_[i].load = sweep_[i].load;
+        }
+        stats_[i].networks = sweep_[i].networks;
+        stats_[i].strongest_rssi = sweep_[i].strongest_rssi;
+    }
+    sweepsCompleted_++;
+}
+
+uint32_t WiFiModule::channelScore(uint8_t channel) const {
+    if (!isValidChannel(channel)) {
+        return UINT32_MAX;
+    }
+
+    // Adjacent 2.4 GHz channels overlap up to 4 channels away
+    uint32_t score = 0;
+    for (uint8_t i = 0; i < ChannelSurveyConfig::CHANNEL_COUNT; i++) {
+        int distance = abs((int)(i + ChannelSurveyConfig::FIRST_CHANNEL) - (int)channel);
+        if (distance < (int)sizeof(kOverlapWeight)) {
+            score += stats_[i].load * kOverlapWeight[distance];
+        }
+    }
+    return score / kOverlapWeight[0];
+}
+
+uint8_t WiFiModule::recommendChannel() const {
+    uint8_t best = ChannelSurveyConfig::DEFAULT_CHANNEL;
+    uint32_t bestScore = UINT32_MAX;
+
+    for (uint8_t ch = ChannelSurveyConfig::FIRST_CHANNEL; ch <= ChannelSurveyConfig::LAST_CHANNEL; ch++) {
+        uint32_t score = channelScore(ch);
+        // On a tie prefer the non-overlapping channels 1/6/11
+        bool preferred = (ch == 1 || ch == 6 || ch == 11);
+        if (score < bestScore || (score == bestScore && preferred)) {
+            best = ch;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+bool WiFiModule::requestChannelSwitch(uint8_t channel) {
+    if (!isValidChannel(channel)) {
+        Serial.printf("[WiFi] ❌ Недопустимый канал: %d\n", channel);
+        return false;
+    }
+
+    pendingChannel_ = (channel == channel_) ? 0 : channel;
+    if (pendingChannel_ != 0) {
+        Serial.printf("[WiFi] Переход на канал %d запланирован (когда нет клиентов)\n", channel);
+    }
+    return true;
+}
+
+void WiFiModule::planAutoSwitch() {
+    uint8_t best = recommendChannel();
+    if (best == channel_) {
+        return;
+    }
+
+    uint64_t current = channelScore(channel_);
+    uint64_t candidate = channelScore(best);
+    if (candidate * 100 <= current * (100 - ChannelSurveyConfig::SWITCH_MARGIN_PERCENT)) {
+        Serial.printf("[WiFi] Канал %d загружен (score %llu), лучше канал %d (score %llu)\n",
+                      channel_, current, best, candidate);
+        requestChannelSwitch(best);
+    }
+}
+
+void WiFiModule::applyPendingChannelSwitch() {
+    // Never move a connected pilot; wait until the AP is idle
+    if (pendingChannel_ == 0 || scanningChannel_ != 0 || WiFi.softAPgetStationNum() > 0) {
+        return;
+    }
+
+    uint8_t previous = channel_;
+    channel_ = pendingChannel_;
+    pendingChannel_ = 0;
+
+    if (!WiFi.softAP(ssid_.c_str(), NULL, channel_, false, 4)) {
+        Serial.printf("[WiFi] ❌ Не удалось перейти на канал %d\n", channel_);
+        channel_ = previous;
+        return;
+    }
+    optimizeForFPV();
+    Serial.printf("[WiFi] ✅ Канал изменён: %d -> %d\n", previous, channel_);
+}
+
+bool WiFiModule::isValidChannel(int32_t channel) {
+    return channel >= ChannelSurveyConfig::FIRST_CHANNEL && channel <= ChannelSurveyConfig::LAST_CHANNEL;
+}
+
+void WiFiModule::printChannelSurvey(Print& out) const {
+    uint8_t best = recommendChannel();
+
+    out.println("\n=== WiFi Channel Survey ===");
+    out.printf("Current: %d, Recommended: %d, Pending: %d, Sweeps: %lu, Background: %s\n",
+                  channel_, best, pendingChannel_, sweepsCompleted_, surveyEnabled_ ? "ON" : "OFF");
+    out.println("Ch  Nets  Best RSSI   Load   Score");
+    for (uint8_t i = 0; i < ChannelSurveyConfig::CHANNEL_COUNT; i++) {
+        uint8_t ch = i + ChannelSurveyConfig::FIRST_CHANNEL;
+        const ChannelStats& entry = stats_[i];
+        out.printf("%2d  %4u  ", ch, entry.networks);
+        if (entry.networks > 0) {
+            out.printf("%5d dBm", entry.strongest_rssi);
+        } else {
+            out.printf("        -");
+        }
+        out.printf("  %5lu  %6lu %s%s\n", entry.load, channelScore(ch),
+                      ch == channel_ ? "*" : "", ch == best ? "<" : "");
+    }
+    out.println("(* current, < recommended)");
+    out.println("===========================\n");
 }
 
 void WiFiModule::showStatus() const {
@@ -148,15 +454,15 @@ void WiFiModule::wifiEventHandler(arduino_event_id_t event, arduino_event_info_t
     }
 }
 
-void WiFiModule::showConnectedClients() const {
+void WiFiModule::showConnectedClients(Print& out) const {
     wifi_sta_list_t clients;
     esp_wifi_ap_get_sta_list(&clients);
     
-    Serial.printf("Подключено клиентов: %d\n", clients.num);
+    out.printf("Подключено клиентов: %d\n", clients.num);
     for (int i = 0; i < clients.num; i++) {
         wifi_sta_info_t client = clients.sta[i];
-        Serial.printf("Client %d: MAC %02X:%02X:%02X:%02X:%02X:%02X, RSSI: %ddBm\n",
+        out.printf("Client %d: MAC %02X:%02X:%02X:%02X:%02X:%02X, RSSI: %ddBm\n",
             i+1, client.mac[0], client.mac[1], client.mac[2],
             client.mac[3], client.mac[4], client.mac[5], client.rssi);
     }
-}
\ No newline at end of file
+}
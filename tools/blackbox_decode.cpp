@@ -0,0 +1,235 @@
+// tools/blackbox_decode.cpp - Host decoder for the FC blackbox log
+//
+// Build:  g++ -std=c++11 -O2 -Iinclude tools/blackbox_decode.cpp src/flight_controller/blackbox_format.cpp src/flight_controller/fc_telemetry.cpp -o blackbox_decode
+// Usage:  blackbox_decode [-f field] [-S session] log.bbx > log.csv     # CSV records, summary on stderr
+//         blackbox_decode -s log.bbx                                    # summary only
+//         blackbox_decode -g out.bbx [-n seconds] [-r hz]               # writes a synthetic log
+//
+//   curl -o flight.bbx http://192.168.4.1/blackbox      # after `blackbox start` / `blackbox stop`
+//   blackbox_decode -f attitude flight.bbx > attitude.csv
+//
+// CSV columns: session, t_s (seconds since the session's first record),
+// field, then the field's values (see fcFieldColumns()). Blocks with a bad
+// CRC are skipped and counted; every other block decodes on its own.
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <unistd.h>
+#include <vector>
+
+#include "blackbox_format.h"
+#include "fc_telemetry.h"
+
+namespace {
+
+struct FieldSummary {
+    uint64_t records{0};
+    uint32_t first_us{0};
+    uint32_t last_us{0};
+};
+
+struct SessionSummary {
+    uint32_t blocks{0};
+    uint32_t first_us{0};
+    uint64_t span_us{0};
+    uint32_t last_us{0};
+    FieldSummary fields[FC_FIELD_COUNT];
+};
+
+bool readFile(const char* path, std::vector<uint8_t>& data) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    uint8_t chunk[65536];
+    size_t length;
+    while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + length);
+    }
+    fclose(file);
+    return true;
+}
+
+int fieldByName(const char* name) {
+    for (size_t i = 0; i < FC_FIELD_COUNT; i++) {
+        if (!strcmp(name, fcFieldName((FcField)i))) return (int)i;
+    }
+    return -1;
+}
+
+// Same record stream the firmware produces while polling at `rate_hz`:
+// attitude, IMU and RC every poll, status/analog/altitude at about 10 Hz
+int writeSynthetic(const char* path, uint32_t seconds, uint32_t rate_hz) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        perror(path);
+        return 2;
+    }
+    std::vector<uint8_t> block(BlackboxFormat::BLOCK_SIZE);
+    BlackboxBlockWriter writer;
+    uint32_t sequence = 0;
+    uint32_t period_us = 1000000 / rate_hz;
+    uint32_t slow_every = rate_hz / 10 > 0 ? rate_hz / 10 : 1;
+    uint32_t time_us = 5000000;
+    uint64_t records = 0;
+
+    FcTelemetry t;
+    t.rc_count = 8;
+    t.battery_cv = 1650;
+    for (uint32_t tick = 0; tick < seconds * rate_hz; tick++, time_us += period_us) {
+        double s = tick / (double)rate_hz;
+        t.roll_dd = (int16_t)(300 * sin(s * 2.1));
+        t.pitch_dd = (int16_t)(200 * sin(s * 1.3));
+        t.yaw_deg = (int16_t)fmod(s * 20, 360);
+        for (int i = 0; i < 3; i++) {
+            t.acc[i] = (int16_t)((i == 2 ? 2048 : 0) + 40 * sin(s * (7 + i)));
+            t.gyro[i] = (int16_t)(150 * sin(s * (3 + i)));
+        }
+        for (int i = 0; i < t.rc_count; i++) {
+            t.rc[i] = (uint16_t)(i < 4 ? 1500 + 400 * sin(s * (0.5 + i)) : 1000);
+        }
+        t.armed = s > 2;
+        t.battery_cv = (uint16_t)(1680 - s * 2);
+        t.altitude_cm = (int32_t)(s > 2 ? (s - 2) * 50 : 0);
+
+        std::vector<FcField> fields = {FcField::ATTITUDE, FcField::IMU, FcField::RC};
+        if (tick % slow_every == 0) {
+            fields.push_back(FcField::STATUS);
+            fields.push_back(FcField::ANALOG);
+            fields.push_back(FcField::ALTITUDE);
+        }
+        for (FcField field : fields) {
+            int32_t values[BlackboxFormat::MAX_VALUES];
+            size_t count = fcFieldValues(field, t, values);
+            if (!writer.active()) writer.begin(block.data(), sequence++, 1, time_us);
+            if (!writer.append((uint8_t)field, time_us, values, count)) {
+                writer.finish();
+                fwrite(block.data(), 1, block.size(), file);
+                writer.begin(block.data(), sequence++, 1, time_us);
+                writer.append((uint8_t)field, time_us, values, count);
+            }
+            records++;
+        }
+    }
+    if (writer.active()) {
+        writer.finish();
+        fwrite(block.data(), 1, block.size(), file);
+    }
+    fclose(file);
+    fprintf(stderr, "wrote %s: %u blocks, %llu records, %.1f KB/s at %u Hz\n", path, sequence,
+            (unsigned long long)records, sequence * BlackboxFormat::BLOCK_SIZE / 1024.0 / seconds, rate_hz);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* synthetic_path = nullptr;
+    uint32_t synthetic_seconds = 60;
+    uint32_t synthetic_rate = 250;
+    int only_field = -1;
+    long only_session = -1;
+    bool summary_only = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:S:sg:n:r:")) != -1) {
+        switch (opt) {
+            case 'f':
+                only_field = fieldByName(optarg);
+                if (only_field < 0) {
+                    fprintf(stderr, "unknown field '%s'\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'S': only_session = atol(optarg); break;
+            case 's': summary_only = true; break;
+            case 'g': synthetic_path = optarg; break;
+            case 'n': synthetic_seconds = (uint32_t)atoi(optarg); break;
+            case 'r': synthetic_rate = (uint32_t)atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-f field] [-S session] [-s] log.bbx\n"
+                                "       %s -g out.bbx [-n seconds] [-r hz]\n", argv[0], argv[0]);
+                return 2;
+        }
+    }
+    if (synthetic_path) {
+        if (synthetic_rate == 0 || synthetic_rate > 1000 || synthetic_seconds == 0) {
+            fprintf(stderr, "rate 1-1000 Hz, at least 1 second\n");
+            return 2;
+        }
+        return writeSynthetic(synthetic_path, synthetic_seconds, synthetic_rate);
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "need a log file\n");
+        return 2;
+    }
+
+    std::vector<uint8_t> file;
+    if (!readFile(argv[optind], file)) {
+        perror(argv[optind]);
+        return 2;
+    }
+    if (file.size() % BlackboxFormat::BLOCK_SIZE != 0) {
+        fprintf(stderr, "warning: %zu trailing bytes ignored\n", file.size() % BlackboxFormat::BLOCK_SIZE);
+    }
+
+    std::map<uint16_t, SessionSummary> sessions;
+    uint32_t status_counts[5] = {0, 0, 0, 0, 0};
+    uint32_t malformed = 0;
+    uint64_t records = 0;
+    BlackboxBlockReader reader;
+    BlackboxSample sample;
+
+    for (size_t offset = 0; offset + BlackboxFormat::BLOCK_SIZE <= file.size(); offset += BlackboxFormat::BLOCK_SIZE) {
+        BlackboxBlockStatus status = reader.open(file.data() + offset);
+        status_counts[(size_t)status]++;
+        if (status == BlackboxBlockStatus::ERASED) break;
+        if (status != BlackboxBlockStatus::OK) continue;
+
+        uint16_t session_id = reader.info().session;
+        SessionSummary& session = sessions[session_id];
+        if (session.blocks++ == 0) {
+            session.first_us = reader.info().start_us;
+            session.last_us = reader.info().start_us;
+        }
+        while (reader.next(sample)) {
+            records++;
+            if (sample.field >= FC_FIELD_COUNT) continue;
+            // 32-bit esp_timer stamps: accumulate deltas so a wrap does not matter
+            session.span_us += (uint32_t)(sample.time_us - session.last_us);
+            session.last_us = sample.time_us;
+            FieldSummary& field = session.fields[sample.field];
+            if (field.records++ == 0) field.first_us = sample.time_us;
+            field.last_us = sample.time_us;
+
+            if (summary_only || (only_field >= 0 && sample.field != only_field) ||
+                (only_session >= 0 && session_id != only_session)) {
+                continue;
+            }
+            printf("%u,%.6f,%s", session_id, session.span_us / 1e6, fcFieldName((FcField)sample.field));
+            for (size_t i = 0; i < sample.count; i++) {
+                printf(",%d", (int)sample.values[i]);
+            }
+            printf("\n");
+        }
+        if (reader.malformed()) malformed++;
+    }
+
+    fprintf(stderr, "blocks: %u ok, %u bad crc, %u bad magic, %u bad length, %u malformed; %llu records\n",
+            status_counts[(size_t)BlackboxBlockStatus::OK], status_counts[(size_t)BlackboxBlockStatus::BAD_CRC],
+            status_counts[(size_t)BlackboxBlockStatus::BAD_MAGIC],
+            status_counts[(size_t)BlackboxBlockStatus::BAD_LENGTH], malformed, (unsigned long long)records);
+    for (const auto& entry : sessions) {
+        const SessionSummary& session = entry.second;
+        fprintf(stderr, "session %u: %u blocks, %.1f s\n", entry.first, session.blocks, session.span_us / 1e6);
+        for (size_t i = 0; i < FC_FIELD_COUNT; i++) {
+            const FieldSummary& field = session.fields[i];
+            if (field.records == 0) continue;
+            double span = (uint32_t)(field.last_us - field.first_us) / 1e6;
+            fprintf(stderr, "  %-9s %8llu records, %7.1f Hz  (%s)\n", fcFieldName((FcField)i),
+                    (unsigned long long)field.records, span > 0 ? (field.records - 1) / span : 0.0,
+                    fcFieldColumns((FcField)i));
+        }
+    }
+    return status_counts[(size_t)BlackboxBlockStatus::BAD_CRC] + malformed > 0 ? 1 : 0;
+}
@@ -0,0 +1,162 @@
+// tools/command_dispatch_bench.cpp - Host benchmark for console command dispatch without heap allocations
+//
+// Build:  g++ -std=c++11 -O2 -Iinclude tools/command_dispatch_bench.cpp -o command_dispatch_bench
+// Usage:  command_dispatch_bench [-n rounds]
+//
+//   command_dispatch_bench                     # 5000 rounds over every command
+//   command_dispatch_bench -n 20000            # longer run for steadier timings
+//
+// Drives the firmware's LineReader, tokenizeCommand() and findCommand() with
+// the rows of the real dispatch table (COMMAND_TABLE in command_table.h),
+// expanded here without their CommandHandler member pointers. A counting
+// operator new fails the run on any heap allocation while lines are
+// dispatched; exit status 1 also on a wrong lookup.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "command_table.h"
+
+// Global allocation counter; every new in the process goes through here
+static size_t g_allocations = 0;
+
+void* operator new(size_t size) {
+    g_allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+namespace {
+
+using CommandConfig::MAX_LINE_LENGTH;
+using CommandConfig::MAX_TOKENS;
+
+// The firmware's rows; the handlers stay behind in command_handler.cpp
+#define BENCH_SPEC(name, alias_of, group, usage, help, handler) \
+    {name, alias_of, CommandGroup::group, usage, help, nullptr},
+
+constexpr CommandSpec kTable[] = {
+    COMMAND_TABLE(BENCH_SPEC)
+};
+constexpr size_t kTableSize = sizeof(kTable) / sizeof(kTable[0]);
+
+constexpr bool isSorted(size_t index = 1) {
+    return index >= kTableSize ||
+        (constexprStrcmp(kTable[index - 1].name, kTable[index].name) < 0 && isSorted(index + 1));
+}
+static_assert(isSorted(), "Command table must be sorted by name");
+
+// Console input as it arrives: mixed case, tabs, arguments, CRLF, plus
+// unknown commands and an overlong line that LineReader must drop.
+// expected[i] is the table index line i resolves to, -1 for unknown.
+void buildInput(const CommandSpec* table, size_t count, std::string& input, std::vector<int>& expected) {
+    for (size_t i = 0; i < count; i++) {
+        std::string name = table[i].name;
+        std::string upper = name;
+        for (char& c : upper) {
+            if (c >= 'a' && c <= 'z') c = (char)(c - 'a' + 'A');
+        }
+        input += name + "\n";
+        input += "  " + upper + "\t20  start\r\n";
+        input += name + " on 100 200 300 400 500 600 700\r\n";
+        expected.push_back((int)i);
+        expected.push_back((int)i);
+        expected.push_back((int)i);
+    }
+    input += "nosuchcommand 1\r\n";
+    expected.push_back(-1);
+    input += std::string(MAX_LINE_LENGTH + 20, 'x') + "\r\n";     // Dropped, no line
+    input += "\r\n";                                                // Empty, no line
+}
+
+double elapsedUs(std::chrono::steady_clock::time_point start, int iterations) {
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int rounds = 5000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n': rounds = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+            default:
+                fprintf(stderr, "usage: %s [-n rounds]\n", argv[0]);
+                return 2;
+        }
+    }
+    std::string input;
+    std::vector<int> expected;
+    buildInput(kTable, kTableSize, input, expected);
+
+    LineReader<MAX_LINE_LENGTH> reader;
+    CommandToken tokens[MAX_TOKENS];
+    size_t lines = 0;
+    size_t mismatches = 0;
+    size_t token_count = 0;
+
+    size_t allocations_before = g_allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        size_t line_index = 0;
+        for (char c : input) {
+            if (!reader.feed(c)) {
+                continue;
+            }
+            size_t count = tokenizeCommand(reader.line(), tokens, MAX_TOKENS);
+            const CommandSpec* spec = count > 0 ? findCommand(kTable, kTableSize, tokens[0]) : nullptr;
+            int index = spec ? (int)(spec - kTable) : -1;
+            if (line_index >= expected.size() || index != expected[line_index]) {
+                mismatches++;
+            }
+            token_count += count;
+            line_index++;
+            reader.clear();
+        }
+        if (line_index != expected.size()) {
+            mismatches++;
+        }
+        lines += line_index;
+    }
+    double us = elapsedUs(start, rounds);
+    size_t allocations = g_allocations - allocations_before;
+
+    printf("%zu commands, %zu lines x %d rounds\n", kTableSize, expected.size(), rounds);
+    printf("dispatch: %.1f ns/line, %.2f ns/byte (%.2f tokens/line)\n", us * 1000.0 / expected.size(),
+           us * 1000.0 / input.size(), (double)token_count / lines);
+    printf("lookups wrong: %zu, heap allocations while dispatching: %zu\n", mismatches, allocations);
+    if (mismatches || allocations) {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,111 @@
+// tools/dc_thumb_bench.cpp - Host benchmark for the DC-only JPEG thumbnail path
+//
+// Build:  g++ -std=c++11 -O2 -Iinclude tools/dc_thumb_bench.cpp src/camera/jpeg_dc_decoder.cpp -o dc_thumb_bench
+// Usage:  dc_thumb_bench [-n iterations] [-o out_dir] frame.jpg [frame.jpg...]
+//
+//   dc_thumb_bench -n 500 capture/*.jpg     # per-frame decode time, luma-only vs colour
+//   dc_thumb_bench -o /tmp/thumbs f.jpg     # also writes f.jpg.ppm (1/8-scale colour)
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "jpeg_dc_decoder.h"
+
+namespace {
+
+bool readFile(const char* path, std::vector<uint8_t>& data) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(f);
+    return true;
+}
+
+double elapsedUs(std::chrono::steady_clock::time_point start, int iterations) {
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = 200;
+    std::string out_dir;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:o:")) != -1) {
+        switch (opt) {
+            case 'n': iterations = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+            case 'o': out_dir = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations] [-o out_dir] frame.jpg...\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-n iterations] [-o out_dir] frame.jpg...\n", argv[0]);
+        return 2;
+    }
+
+    const size_t capacity = 256 * 256;
+    std::vector<uint8_t> planes_storage(capacity * JpegDcDecoder::MAX_COMPONENTS);
+    std::vector<uint8_t> rgb(capacity * 3);
+    uint8_t* planes[JpegDcDecoder::MAX_COMPONENTS] = {
+        &planes_storage[0], &planes_storage[capacity], &planes_storage[capacity * 2]
+    };
+    JpegDcDecoder decoder;
+    int failures = 0;
+
+    printf("%-28s %9s %11s %9s %10s %10s\n", "file", "bytes", "image", "plane", "luma_us", "color_us");
+    for (int i = optind; i < argc; i++) {
+        std::vector<uint8_t> jpeg;
+        if (!readFile(argv[i], jpeg)) {
+            fprintf(stderr, "%s: cannot read\n", argv[i]);
+            failures++;
+            continue;
+        }
+        if (!decoder.decodePlanes(jpeg.data(), jpeg.size(), planes, capacity)) {
+            fprintf(stderr, "%s: %s\n", argv[i], decoder.lastError());
+            failures++;
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int n = 0; n < iterations; n++) {
+            decoder.decodeLuma(jpeg.data(), jpeg.size(), planes[0], capacity);
+        }
+        double luma_us = elapsedUs(start, iterations);
+
+        start = std::chrono::steady_clock::now();
+        for (int n = 0; n < iterations; n++) {
+            decoder.decodePlanes(jpeg.data(), jpeg.size(), planes, capacity);
+            decoder.toRgb888(planes, rgb.data(), false);
+        }
+        double color_us = elapsedUs(start, iterations);
+
+        char image[16];
+        char plane[16];
+        snprintf(image, sizeof(image), "%ux%u", decoder.imageWidth(), decoder.imageHeight());
+        snprintf(plane, sizeof(plane), "%ux%u", decoder.planeWidth(), decoder.planeHeight());
+        printf("%-28s %9zu %11s %9s %10.1f %10.1f\n", argv[i], jpeg.size(), image, plane, luma_us, color_us);
+
+        if (!out_dir.empty()) {
+            const char* base = strrchr(argv[i], '/');
+            std::string path = out_dir + "/" + (base ? base + 1 : argv[i]) + ".ppm";
+            FILE* f = fopen(path.c_str(), "wb");
+            if (f) {
+                fprintf(f, "P6\n%u %u\n255\n", decoder.planeWidth(), decoder.planeHeight());
+                fwrite(rgb.data(), 3, (size_t)decoder.planeWidth() * decoder.planeHeight(), f);
+                fclose(f);
+            }
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
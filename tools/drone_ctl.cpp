@@ -0,0 +1,179 @@
+// tools/drone_ctl.cpp - Linux CLI client for the UDP command channel
+//
+// Build:  g++ -std=c++11 -O2 -Iinclude tools/drone_ctl.cpp -o drone_ctl
+// Usage:  drone_ctl [-h host] [-p port] [-t timeout_ms] [-r retries] [-n rounds] command [args...]
+//
+//   drone_ctl fps
+//   drone_ctl quality 20
+//   drone_ctl -n 200 fps      # round-trip benchmark, prints min/avg/max RTT
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "control_protocol.h"
+
+namespace {
+
+struct Options {
+    std::string host = "192.168.4.1";
+    uint16_t port = ControlProtocol::DEFAULT_PORT;
+    int timeout_ms = 500;
+    int retries = 3;
+    int rounds = 1;
+    std::string command;
+};
+
+const char* statusName(ControlStatus status) {
+    switch (status) {
+        case ControlStatus::OK: return "ok";
+        case ControlStatus::UNKNOWN_COMMAND: return "unknown command";
+        case ControlStatus::BAD_REQUEST: return "bad request";
+        case ControlStatus::BUSY: return "busy";
+        default: return "?";
+    }
+}
+
+void usage(const char* argv0) {
+    std::fprintf(stderr,
+        "usage: %s [-h host] [-p port] [-t timeout_ms] [-r retries] [-n rounds] command [args...]\n", argv0);
+}
+
+bool parseOptions(int argc, char** argv, Options& opt) {
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i += 2) {
+        if (i + 1 >= argc) return false;
+        char flag = argv[i][1];
+        const char* value = argv[i + 1];
+        switch (flag) {
+            case 'h': opt.host = value; break;
+            case 'p': opt.port = (uint16_t)std::atoi(value); break;
+            case 't': opt.timeout_ms = std::atoi(value); break;
+            case 'r': opt.retries = std::atoi(value); break;
+            case 'n': opt.rounds = std::max(1, std::atoi(value)); break;
+            default: return false;
+        }
+    }
+    for (; i < argc; i++) {
+        if (!opt.command.empty()) opt.command += ' ';
+        opt.command += argv[i];
+    }
+    return !opt.command.empty() && opt.command.size() <= ControlProtocol::MAX_PAYLOAD;
+}
+
+// Sends one request and waits for the matching response, retransmitting on timeout.
+// Returns the round-trip time of the answered attempt in microseconds, or -1.
+long transact(int fd, const sockaddr_in& addr, const Options& opt, uint16_t request_id,
+              std::vector<uint8_t>& response, ControlFrame& frame) {
+    std::vector<uint8_t> request(ControlProtocol::HEADER_SIZE + opt.command.size());
+    ControlFrame header;
+    header.type = ControlMessageType::REQUEST;
+    header.request_id = request_id;
+    header.payload_length = (uint16_t)opt.command.size();
+    encodeControlHeader(header, request.data());
+    std::memcpy(request.data() + ControlProtocol::HEADER_SIZE, opt.command.data(), opt.command.size());
+
+    response.resize(ControlProtocol::MAX_DATAGRAM);
+
+    for (int attempt = 0; attempt <= opt.retries; attempt++) {
+        auto start = std::chrono::steady_clock::now();
+        if (sendto(fd, request.data(), request.size(), 0, (const sockaddr*)&addr, sizeof(addr)) < 0) {
+            std::perror("sendto");
+            return -1;
+        }
+
+        int remaining = opt.timeout_ms;
+        while (remaining > 0) {
+            pollfd pfd = {fd, POLLIN, 0};
+            if (poll(&pfd, 1, remaining) <= 0) break;
+
+            ssize_t n = recv(fd, response.data(), response.size(), 0);
+            auto now = std::chrono::steady_clock::now();
+            long elapsed_us = (long)std::chrono::duration_cast<std::chrono::microseconds>(now - start).count();
+            remaining = opt.timeout_ms - (int)(elapsed_us / 1000);
+
+            // Late answers to earlier requests are ignored
+            if (n > 0 && decodeControlFrame(response.data(), (size_t)n, frame) &&
+                frame.type == ControlMessageType::RESPONSE && frame.request_id == request_id) {
+                return elapsed_us;
+            }
+        }
+        std::fprintf(stderr, "timeout (attempt %d/%d)\n", attempt + 1, opt.retries + 1);
+    }
+    return -1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* resolved = nullptr;
+    if (getaddrinfo(opt.host.c_str(), nullptr, &hints, &resolved) != 0 || !resolved) {
+        std::fprintf(stderr, "cannot resolve %s\n", opt.host.c_str());
+        return 1;
+    }
+    sockaddr_in addr = *(const sockaddr_in*)resolved->ai_addr;
+    addr.sin_port = htons(opt.port);
+    freeaddrinfo(resolved);
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        std::perror("socket");
+        return 1;
+    }
+
+    std::mt19937 rng((unsigned)std::chrono::steady_clock::now().time_since_epoch().count());
+    uint16_t request_id = (uint16_t)rng();
+
+    std::vector<long> rtts;
+    std::vector<uint8_t> response;
+    ControlFrame frame;
+    int failures = 0;
+
+    for (int round = 0; round < opt.rounds; round++) {
+        long rtt = transact(fd, addr, opt, request_id++, response, frame);
+        if (rtt < 0) {
+            failures++;
+            continue;
+        }
+        rtts.push_back(rtt);
+
+        if (opt.rounds == 1) {
+            std::fwrite(frame.payload, 1, frame.payload_length, stdout);
+            if (frame.flags & ControlFlags::TRUNCATED) std::printf("\n[output truncated]\n");
+            std::fprintf(stderr, "status: %s, rtt: %.2f ms\n", statusName(frame.status), rtt / 1000.0);
+        }
+    }
+    close(fd);
+
+    if (opt.rounds > 1 && !rtts.empty()) {
+        std::sort(rtts.begin(), rtts.end());
+        long sum = 0;
+        for (long v : rtts) sum += v;
+        std::printf("rounds: %d, answered: %zu, lost: %d\n", opt.rounds, rtts.size(), failures);
+        std::printf("rtt ms: min %.2f, avg %.2f, p50 %.2f, p99 %.2f, max %.2f\n",
+                    rtts.front() / 1000.0, sum / 1000.0 / rtts.size(), rtts[rtts.size() / 2] / 1000.0,
+                    rtts[std::min(rtts.size() - 1, rtts.size() * 99 / 100)] / 1000.0, rtts.back() / 1000.0);
+    }
+
+    if (rtts.empty()) return 1;
+    return frame.status == ControlStatus::OK ? 0 : 3;
+}
@@ -0,0 +1,102 @@
+# tools/embed_web.py - упаковка веб-интерфейса в flash (gzip + ETag)
+#
+# Runs as a PlatformIO pre-build script (extra_scripts = pre:tools/embed_web.py)
+# or standalone:  python3 tools/embed_web.py
+#
+# Every page in WEB_ASSETS is gzip-compressed and written to include/web_assets.h
+# as a constexpr byte array together with its length and a strong ETag derived
+# from the content. The header is rewritten only when its content changes, so
+# unchanged pages do not trigger a rebuild.
+
+import gzip
+import hashlib
+import os
+
+# (URL path, source file relative to the project root, Content-Type)
+WEB_ASSETS = [
+    ("/", "web/index.html", "text/html"),
+    ("/client", "drone_client.html", "text/html"),
+    ("/wstest", "websocket_test_client.html", "text/html"),
+]
+
+OUTPUT = os.path.join("include", "web_assets.h")
+
+
+def project_dir():
+    try:
+        Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+        return env["PROJECT_DIR"]  # noqa: F821
+    except NameError:
+        return os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def symbol_for(path):
+    name = os.path.splitext(os.path.basename(path))[0]
+    return "WEB_" + "".join(c if c.isalnum() else "_" for c in name).upper()
+
+
+def render(root):
+    lines = [
+        "// include/web_assets.h - сгенерировано tools/embed_web.py, не редактировать",
+        "#pragma once",
+        "",
+        "#include <stddef.h>",
+        "#include <stdint.h>",
+        "",
+    ]
+    table = []
+    for url, source, content_type in WEB_ASSETS:
+        with open(os.path.join(root, source), "rb") as f:
+            raw = f.read()
+        if not raw:
+            print("[embed_web] skip empty %s" % source)
+            continue
+        # mtime=0 keeps the output byte-identical between builds
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = '"%s"' % hashlib.sha1(raw).hexdigest()[:16]
+        symbol = symbol_for(source)
+
+        lines.append("// %s: %u -> %u bytes" % (source, len(raw), len(packed)))
+        lines.append("constexpr uint8_t %s[] = {" % symbol)
+        for i in range(0, len(packed), 16):
+            lines.append("    " + ", ".join("0x%02x" % b for b in packed[i:i + 16]) + ",")
+        lines.append("};")
+        lines.append("constexpr size_t %s_LENGTH = sizeof(%s);" % (symbol, symbol))
+        lines.append("")
+        table.append('    {"%s", "%s", %s, %s_LENGTH, "%s"},'
+                     % (url, content_type, symbol, symbol, etag.replace('"', '\\"')))
+
+    lines += [
+        "struct WebAsset {",
+        "    const char* path;",
+        "    const char* content_type;",
+        "    const uint8_t* data;     // gzip",
+        "    size_t length;",
+        "    const char* etag;",
+        "};",
+        "",
+        "constexpr WebAsset WEB_ASSETS[] = {",
+    ] + table + [
+        "};",
+        "constexpr size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def main():
+    root = project_dir()
+    output = os.path.join(root, OUTPUT)
+    content = render(root)
+    try:
+        with open(output, "r") as f:
+            if f.read() == content:
+                return
+    except IOError:
+        pass
+    with open(output, "w") as f:
+        f.write(content)
+    print("[embed_web] wrote %s" % OUTPUT)
+
+
+main()
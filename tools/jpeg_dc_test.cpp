@@ -0,0 +1,491 @@
+// tools/jpeg_dc_test.cpp - Host test for the DC-only JPEG decoder on valid and malformed headers
+//
+// Build:  g++ -std=c++11 -O1 -g -fsanitize=address,undefined -Iinclude tools/jpeg_dc_test.cpp src/camera/jpeg_dc_decoder.cpp -o jpeg_dc_test
+// Usage:  jpeg_dc_test [-n fuzz_iterations] [-s seed] [-b bench_iterations]
+//
+//   jpeg_dc_test                 # fixed DHT/SOF/SOS corpus, every truncation, 20000 mutations
+//   jpeg_dc_test -b 2000         # also times a 1280x720-sized scan per frame (build with -O2, no sanitizers)
+//
+// The frames are synthesised here with known DC levels, so the test needs no
+// capture files. Malformed inputs must be rejected cleanly (or decoded) without
+// any out-of-bounds access; the sanitizers turn the latter into a hard failure.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "jpeg_dc_decoder.h"
+
+namespace {
+
+// Standard luminance DC table (ITU T.81 K.3): categories 0-11
+const uint8_t kDcCounts[16] = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+const uint8_t kDcValues[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+// AC table with a single one-bit code: EOB. Every block is DC-only.
+const uint8_t kAcCounts[16] = {1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+const uint8_t kAcValues[1] = {0x00};
+
+struct Code {
+    uint16_t bits;
+    uint8_t length;
+};
+
+// Canonical Huffman codes for a counts/values table, indexed by symbol
+std::vector<Code> canonicalCodes(const uint8_t* counts, const uint8_t* values) {
+    std::vector<Code> codes(256, Code{0, 0});
+    uint16_t code = 0;
+    size_t index = 0;
+    for (int length = 1; length <= 16; length++) {
+        for (uint8_t i = 0; i < counts[length - 1]; i++) {
+            codes[values[index++]] = Code{code++, (uint8_t)length};
+        }
+        code <<= 1;
+    }
+    return codes;
+}
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out_(out), bits_(0), count_(0) {}
+
+    void put(uint32_t value, int length) {
+        for (int i = length - 1; i >= 0; i--) {
+            bits_ = (uint8_t)((bits_ << 1) | ((value >> i) & 1));
+            if (++count_ == 8) emit();
+        }
+    }
+
+    // Pads with 1 bits as T.81 requires
+    void flush() {
+        while (count_ != 0) put(1, 1);
+    }
+
+private:
+    void emit() {
+        out_.push_back(bits_);
+        if (bits_ == 0xFF) out_.push_back(0x00);    // Byte stuffing
+        bits_ = 0;
+        count_ = 0;
+    }
+
+    std::vector<uint8_t>& out_;
+    uint8_t bits_;
+    int count_;
+};
+
+void putU16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back((uint8_t)(value >> 8));
+    out.push_back((uint8_t)value);
+}
+
+void putSegment(std::vector<uint8_t>& out, uint8_t marker, const std::vector<uint8_t>& payload) {
+    out.push_back(0xFF);
+    out.push_back(marker);
+    putU16(out, (uint16_t)(payload.size() + 2));
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+std::vector<uint8_t> huffmanPayload(uint8_t table_class, uint8_t id, const uint8_t* counts, const uint8_t* values,
+                                    size_t value_count) {
+    std::vector<uint8_t> payload;
+    payload.push_back((uint8_t)((table_class << 4) | id));
+    payload.insert(payload.end(), counts, counts + 16);
+    payload.insert(payload.end(), values, values + value_count);
+    return payload;
+}
+
+// Segments of a grayscale baseline frame, kept apart so cases can replace one
+struct Frame {
+    std::vector<uint8_t> dqt;
+    std::vector<uint8_t> dht;
+    std::vector<uint8_t> sof;
+    std::vector<uint8_t> sos;
+    std::vector<uint8_t> scan;
+    uint16_t restart_interval;
+};
+
+// `levels` holds one DC level per 8x8 block; DC quantiser 8 makes the decoded
+// plane value equal to the coded DC + 128
+Frame makeFrame(uint16_t width, uint16_t height, const std::vector<int>& levels, uint16_t restart_interval = 0) {
+    Frame frame;
+    frame.restart_interval = restart_interval;
+    frame.dqt.push_back(0x00);
+    frame.dqt.push_back(8);
+    frame.dqt.resize(65, 1);
+
+    std::vector<uint8_t> dc = huffmanPayload(0, 0, kDcCounts, kDcValues, sizeof(kDcValues));
+    std::vector<uint8_t> ac = huffmanPayload(1, 0, kAcCounts, kAcValues, sizeof(kAcValues));
+    frame.dht = dc;
+    frame.dht.insert(frame.dht.end(), ac.begin(), ac.end());
+
+    frame.sof.push_back(8);
+    putU16(frame.sof, height);
+    putU16(frame.sof, width);
+    frame.sof.push_back(1);
+    frame.sof.push_back(1);         // Component id
+    frame.sof.push_back(0x11);      // 1x1 sampling
+    frame.sof.push_back(0);         // Quant table
+
+    frame.sos.push_back(1);
+    frame.sos.push_back(1);
+    frame.sos.push_back(0x00);      // DC table 0, AC table 0
+    frame.sos.push_back(0);
+    frame.sos.push_back(63);
+    frame.sos.push_back(0);
+
+    std::vector<Code> dc_codes = canonicalCodes(kDcCounts, kDcValues);
+    std::vector<Code> ac_codes = canonicalCodes(kAcCounts, kAcValues);
+    BitWriter writer(frame.scan);
+    int predictor = 0;
+    uint8_t rst = 0;
+    for (size_t i = 0; i < levels.size(); i++) {
+        if (restart_interval && i != 0 && i % restart_interval == 0) {
+            writer.flush();
+            frame.scan.push_back(0xFF);
+            frame.scan.push_back((uint8_t)(0xD0 + (rst++ & 7)));
+            predictor = 0;
+        }
+        int diff = levels[i] - 128 - predictor;
+        predictor = levels[i] - 128;
+        int magnitude = diff < 0 ? -diff : diff;
+        int size = 0;
+        while (magnitude >> size) size++;
+        writer.put(dc_codes[size].bits, dc_codes[size].length);
+        if (size) writer.put((uint32_t)(diff < 0 ? diff + (1 << size) - 1 : diff), size);
+        writer.put(ac_codes[0].bits, ac_codes[0].length);
+    }
+    writer.flush();
+    return frame;
+}
+
+std::vector<uint8_t> assemble(const Frame& frame) {
+    std::vector<uint8_t> out = {0xFF, 0xD8};
+    putSegment(out, 0xDB, frame.dqt);
+    putSegment(out, 0xC4, frame.dht);
+    if (frame.restart_interval) {
+        std::vector<uint8_t> dri;
+        putU16(dri, frame.restart_interval);
+        putSegment(out, 0xDD, dri);
+    }
+    putSegment(out, 0xC0, frame.sof);
+    putSegment(out, 0xDA, frame.sos);
+    out.insert(out.end(), frame.scan.begin(), frame.scan.end());
+    out.push_back(0xFF);
+    out.push_back(0xD9);
+    return out;
+}
+
+int g_failures = 0;
+
+void check(bool ok, const std::string& name, const char* detail = "") {
+    if (!ok) {
+        g_failures++;
+        printf("FAIL %s %s\n", name.c_str(), detail);
+    } else {
+        printf("ok   %s\n", name.c_str());
+    }
+}
+
+// Malformed input: must come back false with the given error
+void expectReject(const std::string& name, const std::vector<uint8_t>& jpeg, const char* error) {
+    JpegDcDecoder decoder;
+    uint8_t plane[64];
+    bool decoded = decoder.decodeLuma(jpeg.data(), jpeg.size(), plane, sizeof(plane));
+    check(!decoded && strcmp(decoder.lastError(), error) == 0, name, decoded ? "(decoded)" : decoder.lastError());
+}
+
+void expectLevels(const std::string& name, const std::vector<uint8_t>& jpeg, uint16_t blocks_x, uint16_t blocks_y,
+                  const std::vector<int>& levels) {
+    JpegDcDecoder decoder;
+    std::vector<uint8_t> plane(levels.size());
+    bool decoded = decoder.decodeLuma(jpeg.data(), jpeg.size(), plane.data(), plane.size());
+    bool match = decoded && decoder.planeWidth() == blocks_x && decoder.planeHeight() == blocks_y;
+    for (size_t i = 0; match && i < levels.size(); i++) {
+        match = plane[i] == levels[i];
+    }
+    check(match, name, decoded ? "(wrong levels)" : decoder.lastError());
+}
+
+std::vector<int> gradient(size_t blocks) {
+    std::vector<int> levels(blocks);
+    for (size_t i = 0; i < blocks; i++) {
+        levels[i] = (int)((i * 37) % 256);
+    }
+    return levels;
+}
+
+void testValid() {
+    std::vector<int> levels = gradient(4 * 2);
+    expectLevels("valid 32x16", assemble(makeFrame(32, 16, levels)), 4, 2, levels);
+    expectLevels("valid 32x16 with DRI", assemble(makeFrame(32, 16, levels, 3)), 4, 2, levels);
+    std::vector<int> extremes = {0, 255, 0, 255, 128, 1, 254, 127};
+    expectLevels("valid extremes", assemble(makeFrame(64, 8, extremes)), 8, 1, extremes);
+}
+
+void testDht() {
+    std::vector<int> levels = gradient(4);
+    Frame base = makeFrame(16, 16, levels);
+
+    // Three one-bit codes: only two exist
+    Frame f = base;
+    uint8_t counts[16] = {3};
+    uint8_t values[3] = {0, 1, 2};
+    f.dht = huffmanPayload(0, 0, counts, values, 3);
+    expectReject("DHT over-subscribed at length 1", assemble(f), "bad DHT");
+
+    // Fits at lengths 1-7, overflows at 8 (2 + 4 + ... + 256 slots needed)
+    f = base;
+    uint8_t deep_counts[16] = {1, 1, 1, 1, 1, 1, 1, 3};
+    uint8_t deep_values[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    f.dht = huffmanPayload(0, 0, deep_counts, deep_values, 10);
+    expectReject("DHT over-subscribed at length 8", assemble(f), "bad DHT");
+
+    // Codes past the lookup table are legal; they only have to decode without faults
+    f = base;
+    uint8_t long_counts[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 255};
+    std::vector<uint8_t> long_values(256, 0);
+    std::vector<uint8_t> dc = huffmanPayload(0, 0, kDcCounts, kDcValues, sizeof(kDcValues));
+    f.dht = huffmanPayload(1, 0, long_counts, long_values.data(), long_values.size());
+    f.dht.insert(f.dht.begin(), dc.begin(), dc.end());
+    std::vector<uint8_t> jpeg = assemble(f);
+    JpegDcDecoder decoder;
+    uint8_t plane[64];
+    decoder.decodeLuma(jpeg.data(), jpeg.size(), plane, sizeof(plane));
+    check(true, "DHT 15/16-bit codes");
+
+    f = base;
+    uint8_t overflow_counts[16] = {1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 255, 255};
+    std::vector<uint8_t> many_values(256 + 255, 0);
+    f.dht = huffmanPayload(0, 0, overflow_counts, many_values.data(), many_values.size());
+    expectReject("DHT more than 256 values", assemble(f), "bad DHT");
+
+    f = base;
+    f.dht[0] = 0x20;    // Class 2
+    expectReject("DHT bad class", assemble(f), "bad DHT");
+
+    f = base;
+    f.dht[0] = 0x02;    // Table id 2 is not baseline
+    expectReject("DHT bad table id", assemble(f), "bad DHT");
+
+    f = base;
+    f.dht.resize(10);
+    expectReject("DHT shorter than counts", assemble(f), "bad DHT");
+
+    f = base;
+    f.dht.resize(17 + 5);
+    expectReject("DHT values cut short", assemble(f), "bad DHT");
+}
+
+void testSof() {
+    std::vector<int> levels = gradient(4);
+    Frame base = makeFrame(16, 16, levels);
+
+    Frame f = base;
+    f.sof[0] = 12;
+    expectReject("SOF 12-bit precision", assemble(f), "unsupported precision");
+
+    f = base;
+    f.sof[3] = f.sof[4] = 0;
+    expectReject("SOF zero width", assemble(f), "bad SOF");
+
+    f = base;
+    f.sof[1] = f.sof[2] = 0;
+    expectReject("SOF zero height", assemble(f), "bad SOF");
+
+    f = base;
+    f.sof[5] = 2;
+    expectReject("SOF two components", assemble(f), "bad SOF");
+
+    f = base;
+    f.sof[5] = 3;       // Claims three, carries one
+    expectReject("SOF component list cut short", assemble(f), "bad SOF");
+
+    f = base;
+    f.sof[7] = 0x31;
+    expectReject("SOF 3x1 sampling", assemble(f), "unsupported sampling");
+
+    f = base;
+    f.sof[7] = 0x10;
+    expectReject("SOF zero vertical sampling", assemble(f), "unsupported sampling");
+
+    f = base;
+    f.sof.resize(4);
+    expectReject("SOF truncated", assemble(f), "unsupported precision");
+
+    // 4096x4096 needs 512x512 blocks; the 64-byte plane must be refused
+    f = base;
+    f.sof[1] = f.sof[3] = 0x10;
+    f.sof[2] = f.sof[4] = 0x00;
+    expectReject("SOF larger than plane", assemble(f), "plane buffer too small");
+}
+
+void testSos() {
+    std::vector<int> levels = gradient(4);
+    Frame base = makeFrame(16, 16, levels);
+
+    Frame f = base;
+    f.sos[0] = 3;
+    expectReject("SOS component count mismatch", assemble(f), "non-interleaved scans are not supported");
+
+    f = base;
+    f.sos[1] = 2;
+    expectReject("SOS unknown component id", assemble(f), "scan component order differs from frame");
+
+    f = base;
+    f.sos[2] = 0x11;    // Tables 1 were never defined
+    expectReject("SOS missing Huffman table", assemble(f), "missing Huffman table");
+
+    f = base;
+    f.sos[2] = 0x50;
+    expectReject("SOS table id out of range", assemble(f), "missing Huffman table");
+
+    f = base;
+    f.sos.resize(2);
+    expectReject("SOS truncated", assemble(f), "non-interleaved scans are not supported");
+
+    // SOS ahead of SOF
+    std::vector<uint8_t> jpeg = {0xFF, 0xD8};
+    putSegment(jpeg, 0xDB, base.dqt);
+    putSegment(jpeg, 0xC4, base.dht);
+    putSegment(jpeg, 0xDA, base.sos);
+    putSegment(jpeg, 0xC0, base.sof);
+    expectReject("SOS before SOF", jpeg, "SOS before SOF");
+}
+
+void testFraming() {
+    std::vector<int> levels = gradient(4);
+    std::vector<uint8_t> good = assemble(makeFrame(16, 16, levels));
+
+    std::vector<uint8_t> jpeg = good;
+    jpeg[1] = 0xD9;
+    expectReject("missing SOI", jpeg, "missing SOI");
+
+    jpeg = good;
+    jpeg[4] = 0xFF;     // DQT length 0xFFxx runs past the end
+    expectReject("segment longer than file", jpeg, "truncated segment");
+
+    jpeg = good;
+    jpeg[4] = 0x00;
+    jpeg[5] = 0x01;
+    expectReject("segment length below 2", jpeg, "truncated segment");
+
+    jpeg = good;
+    jpeg[2] = 0x12;
+    expectReject("garbage between segments", jpeg, "bad marker");
+
+    Frame f = makeFrame(16, 16, levels);
+    f.sof[0] = 8;
+    std::vector<uint8_t> progressive = {0xFF, 0xD8};
+    putSegment(progressive, 0xC2, f.sof);
+    expectReject("progressive SOF2", progressive, "progressive/lossless JPEG not supported");
+
+    jpeg = assemble(makeFrame(32, 16, gradient(8), 2));
+    // Replace the first RST0 with a stuffed zero: the restart marker is gone
+    for (size_t i = 0; i + 1 < jpeg.size(); i++) {
+        if (jpeg[i] == 0xFF && jpeg[i + 1] == 0xD0) {
+            jpeg[i + 1] = 0xD5;
+            break;
+        }
+    }
+    JpegDcDecoder decoder;
+    uint8_t plane[64];
+    check(decoder.decodeLuma(jpeg.data(), jpeg.size(), plane, sizeof(plane)), "out-of-sequence RST accepted");
+
+    // Every prefix of a valid frame: must not fault, and a header cut must fail
+    size_t header_end = good.size() - 2 - makeFrame(16, 16, levels).scan.size();
+    bool prefixes_ok = true;
+    for (size_t length = 0; length < good.size(); length++) {
+        bool decoded = decoder.decodeLuma(good.data(), length, plane, sizeof(plane));
+        if (decoded && length < header_end) prefixes_ok = false;
+    }
+    check(prefixes_ok, "every truncation");
+}
+
+// Random byte mutations of valid frames, including the header; only faults
+// (caught by the sanitizers) count as failures
+void fuzz(int iterations, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<std::vector<uint8_t>> corpus = {
+        assemble(makeFrame(32, 16, gradient(8))),
+        assemble(makeFrame(32, 16, gradient(8), 3)),
+        assemble(makeFrame(64, 8, {0, 255, 0, 255, 128, 1, 254, 127})),
+    };
+    JpegDcDecoder decoder;
+    std::vector<uint8_t> plane(4096);
+    int decoded = 0;
+    for (int i = 0; i < iterations; i++) {
+        std::vector<uint8_t> jpeg = corpus[rng() % corpus.size()];
+        int mutations = 1 + (int)(rng() % 4);
+        for (int m = 0; m < mutations; m++) {
+            size_t at = rng() % jpeg.size();
+            switch (rng() % 3) {
+                case 0: jpeg[at] = (uint8_t)rng(); break;
+                case 1: jpeg[at] ^= (uint8_t)(1u << (rng() % 8)); break;
+                default: jpeg.resize(at + 1); break;
+            }
+        }
+        // Exact-size heap copy so ASan sees any read past the end
+        std::vector<uint8_t> exact(jpeg.begin(), jpeg.end());
+        if (decoder.decodeLuma(exact.data(), exact.size(), plane.data(), plane.size())) decoded++;
+    }
+    printf("ok   fuzz: %d mutations, %d still decoded, seed %u\n", iterations, decoded, seed);
+}
+
+double elapsedUs(std::chrono::steady_clock::time_point start, int iterations) {
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+// A 1280x720 frame worth of DC-only blocks: measures the per-frame cost of
+// header parsing plus the entropy walk
+void bench(int iterations) {
+    std::vector<int> levels = gradient(160 * 90);
+    std::vector<uint8_t> jpeg = assemble(makeFrame(1280, 720, levels));
+    std::vector<uint8_t> plane(levels.size());
+    JpegDcDecoder decoder;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        decoder.decodeLuma(jpeg.data(), jpeg.size(), plane.data(), plane.size());
+    }
+    double us = elapsedUs(start, iterations);
+    printf("bench: 1280x720 DC scan (%zu bytes) %.1f us/frame, %.1f ns/block\n", jpeg.size(), us,
+           us * 1000.0 / levels.size());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int fuzz_iterations = 20000;
+    unsigned seed = 1;
+    int bench_iterations = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:b:")) != -1) {
+        switch (opt) {
+            case 'n': fuzz_iterations = atoi(optarg) > 0 ? atoi(optarg) : 0; break;
+            case 's': seed = (unsigned)strtoul(optarg, nullptr, 0); break;
+            case 'b': bench_iterations = atoi(optarg) > 0 ? atoi(optarg) : 0; break;
+            default:
+                fprintf(stderr, "usage: %s [-n fuzz_iterations] [-s seed] [-b bench_iterations]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    testValid();
+    testDht();
+    testSof();
+    testSos();
+    testFraming();
+    if (fuzz_iterations > 0) fuzz(fuzz_iterations, seed);
+    if (bench_iterations > 0) bench(bench_iterations);
+
+    if (g_failures) {
+        printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
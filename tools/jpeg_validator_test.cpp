@@ -0,0 +1,297 @@
+// tools/jpeg_validator_test.cpp - Host test for the JPEG frame validator (fast and strict modes)
+//
+// Build:  g++ -std=c++11 -O1 -g -fsanitize=address,undefined -Iinclude tools/jpeg_validator_test.cpp src/camera/jpeg_validator.cpp -o jpeg_validator_test
+// Usage:  jpeg_validator_test [-n fuzz_iterations] [-s seed]
+//
+// Frames are synthesised here: real header segments around a random scan
+// with stuffed 0xFF bytes and restart markers. The fixed corpus covers
+// truncation, trailing garbage (including stale EOIs) and broken headers;
+// the fuzz pass mutates it and checks that fast and strict mode agree
+// whenever the whole scan fits in the fast mode's window.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "jpeg_validator.h"
+
+namespace {
+
+void putSegment(std::vector<uint8_t>& out, uint8_t marker, size_t payload_length, uint8_t fill) {
+    out.push_back(0xFF);
+    out.push_back(marker);
+    out.push_back((uint8_t)((payload_length + 2) >> 8));
+    out.push_back((uint8_t)(payload_length + 2));
+    out.insert(out.end(), payload_length, fill);
+}
+
+// SOI, APP0, DQT, SOF0, DHT, SOS: what the OV2640 emits, contents aside
+std::vector<uint8_t> headers() {
+    std::vector<uint8_t> out = {0xFF, 0xD8};
+    putSegment(out, 0xE0, 14, 0x4A);
+    putSegment(out, 0xDB, 65, 0x10);
+    putSegment(out, 0xC0, 15, 0x01);
+    putSegment(out, 0xC4, 29, 0x02);
+    putSegment(out, 0xDA, 10, 0x00);
+    return out;
+}
+
+// Entropy-coded bytes: every 0xFF is stuffed, RSTn every `restart` bytes
+std::vector<uint8_t> scan(std::mt19937& rng, size_t length, size_t restart) {
+    std::vector<uint8_t> out;
+    uint8_t rst = 0;
+    while (out.size() < length) {
+        if (restart && !out.empty() && out.size() % restart == 0) {
+            out.push_back(0xFF);
+            out.push_back((uint8_t)(0xD0 + (rst++ & 7)));
+        }
+        uint8_t byte = (rng() % 16 == 0) ? 0xFF : (uint8_t)rng();
+        out.push_back(byte);
+        if (byte == 0xFF) out.push_back(0x00);
+    }
+    return out;
+}
+
+std::vector<uint8_t> frame(std::mt19937& rng, size_t scan_length, size_t restart = 0, bool eoi = true) {
+    std::vector<uint8_t> out = headers();
+    std::vector<uint8_t> data = scan(rng, scan_length, restart);
+    out.insert(out.end(), data.begin(), data.end());
+    if (eoi) {
+        out.push_back(0xFF);
+        out.push_back(0xD9);
+    }
+    return out;
+}
+
+void append(std::vector<uint8_t>& out, const std::vector<uint8_t>& tail) {
+    out.insert(out.end(), tail.begin(), tail.end());
+}
+
+int g_failures = 0;
+
+void expect(const std::string& name, const std::vector<uint8_t>& data, JpegValidation mode, JpegCheck check,
+            size_t frame_end) {
+    // Exact-size heap copy so ASan sees any read past the end
+    std::vector<uint8_t> exact(data.begin(), data.end());
+    size_t end = 0;
+    JpegCheck result = validateJpegFrame(exact.empty() ? nullptr : exact.data(), exact.size(), mode, end);
+    bool ok = result == check && (check != JpegCheck::OK || end == frame_end);
+    std::string label = name + (mode == JpegValidation::FAST ? " [fast]" : mode == JpegValidation::STRICT ? " [strict]"
+                                                                                                           : " [off]");
+    if (!ok) {
+        g_failures++;
+        printf("FAIL %s: %s, end %zu (want %s, end %zu)\n", label.c_str(), jpegCheckName(result), end,
+               jpegCheckName(check), frame_end);
+    } else {
+        printf("ok   %s\n", label.c_str());
+    }
+}
+
+void expectBoth(const std::string& name, const std::vector<uint8_t>& data, JpegCheck check, size_t frame_end) {
+    expect(name, data, JpegValidation::FAST, check, frame_end);
+    expect(name, data, JpegValidation::STRICT, check, frame_end);
+}
+
+void testScan(std::mt19937& rng) {
+    const size_t window = JpegValidatorConfig::MAX_TRAILING_SCAN;
+
+    std::vector<uint8_t> small = frame(rng, 2000, 256);
+    expectBoth("small frame", small, JpegCheck::OK, small.size());
+
+    std::vector<uint8_t> padded = small;
+    padded.insert(padded.end(), 300, 0x00);
+    expectBoth("trailing zeros trimmed", padded, JpegCheck::OK, small.size());
+
+    // Tail of an earlier, longer frame after the real EOI: trim at the first EOI
+    std::vector<uint8_t> stale = small;
+    append(stale, scan(rng, 500, 0));
+    stale.push_back(0xFF);
+    stale.push_back(0xD9);
+    expectBoth("stale EOI after the real one", stale, JpegCheck::OK, small.size());
+
+    std::vector<uint8_t> large = frame(rng, 30000, 0);
+    expectBoth("large frame", large, JpegCheck::OK, large.size());
+
+    std::vector<uint8_t> large_stale = large;
+    append(large_stale, scan(rng, 200, 0));
+    large_stale.push_back(0xFF);
+    large_stale.push_back(0xD9);
+    expectBoth("large frame, stale EOI after the real one", large_stale, JpegCheck::OK, large.size());
+
+    std::vector<uint8_t> truncated = frame(rng, 3000, 0, false);
+    expectBoth("truncated", truncated, JpegCheck::NO_EOI, 0);
+
+    std::vector<uint8_t> truncated_large = frame(rng, 30000, 0, false);
+    expectBoth("truncated large", truncated_large, JpegCheck::NO_EOI, 0);
+
+    // A header marker of some other frame in front of an EOI is not scan data
+    std::vector<uint8_t> spliced = frame(rng, 3000, 0, false);
+    putSegment(spliced, 0xC4, 29, 0x02);
+    spliced.push_back(0xFF);
+    spliced.push_back(0xD9);
+    expectBoth("foreign marker before EOI", spliced, JpegCheck::BAD_SCAN, 0);
+
+    std::vector<uint8_t> fill = frame(rng, 1000, 0, false);
+    fill.push_back(0xFF);
+    fill.push_back(0xFF);
+    fill.push_back(0xD9);
+    expectBoth("fill byte before EOI", fill, JpegCheck::OK, fill.size());
+
+    // EOI split across the fast window start: FF is the byte just before it
+    std::vector<uint8_t> split = frame(rng, 20000, 0, false);
+    split.push_back(0xFF);
+    split.push_back(0xD9);
+    size_t split_end = split.size();
+    split.insert(split.end(), window - 1, 0x00);
+    expectBoth("EOI across the window start", split, JpegCheck::OK, split_end);
+
+    // Stuffed FF 00 across the window start must not read as a marker
+    std::vector<uint8_t> stuffed = headers();
+    stuffed.insert(stuffed.end(), 20000, 0x11);
+    stuffed.push_back(0xFF);
+    stuffed.push_back(0x00);
+    stuffed.insert(stuffed.end(), window - 3, 0x22);
+    stuffed.push_back(0xFF);
+    stuffed.push_back(0xD9);
+    expectBoth("stuffed byte across the window start", stuffed, JpegCheck::OK, stuffed.size());
+
+    // The fast mode's documented blind spot: damage before the window
+    std::vector<uint8_t> early = headers();
+    early.insert(early.end(), 1000, 0x11);
+    early.push_back(0xFF);
+    early.push_back(0xC4);
+    early.insert(early.end(), 20000, 0x11);
+    early.push_back(0xFF);
+    early.push_back(0xD9);
+    expect("foreign marker before the window", early, JpegValidation::FAST, JpegCheck::OK, early.size());
+    expect("foreign marker before the window", early, JpegValidation::STRICT, JpegCheck::BAD_SCAN, 0);
+}
+
+void testHeaders(std::mt19937& rng) {
+    std::vector<uint8_t> good = frame(rng, 500, 0);
+    expect("off", std::vector<uint8_t>(10, 0x00), JpegValidation::OFF, JpegCheck::OK, 10);
+
+    expectBoth("empty", std::vector<uint8_t>(), JpegCheck::TOO_SHORT, 0);
+    expectBoth("three bytes", std::vector<uint8_t>(good.begin(), good.begin() + 3), JpegCheck::TOO_SHORT, 0);
+
+    std::vector<uint8_t> data = good;
+    data[1] = 0xD9;
+    expectBoth("no SOI", data, JpegCheck::NO_SOI, 0);
+
+    data = good;
+    data[2] = 0x00;
+    expectBoth("garbage between segments", data, JpegCheck::BAD_MARKER, 0);
+
+    data = good;
+    data[4] = 0xF0;     // APP0 length past the end
+    expectBoth("segment past the end", data, JpegCheck::BAD_LENGTH, 0);
+
+    data = good;
+    data[4] = 0x00;
+    data[5] = 0x01;
+    expectBoth("segment length below 2", data, JpegCheck::BAD_LENGTH, 0);
+
+    data = {0xFF, 0xD8};
+    putSegment(data, 0xE0, 14, 0x4A);
+    data.push_back(0xFF);
+    data.push_back(0xD9);
+    expectBoth("EOI before SOS", data, JpegCheck::NO_SOS, 0);
+
+    data = {0xFF, 0xD8};
+    for (int i = 0; i < JpegValidatorConfig::MAX_SEGMENTS + 1; i++) {
+        putSegment(data, 0xFE, 4, 0x20);
+    }
+    putSegment(data, 0xDA, 10, 0x00);
+    data.push_back(0xFF);
+    data.push_back(0xD9);
+    expectBoth("too many segments", data, JpegCheck::NO_SOS, 0);
+
+    data = std::vector<uint8_t>(good.begin(), good.begin() + headers().size() - 4);
+    expectBoth("cut inside SOS", data, JpegCheck::BAD_LENGTH, 0);
+
+    bool prefixes_ok = true;
+    for (size_t length = 0; length + 2 < good.size(); length++) {
+        std::vector<uint8_t> prefix(good.begin(), good.begin() + length);
+        size_t end;
+        prefixes_ok &= validateJpegFrame(prefix.data(), prefix.size(), JpegValidation::FAST, end) != JpegCheck::OK;
+        prefixes_ok &= validateJpegFrame(prefix.data(), prefix.size(), JpegValidation::STRICT, end) != JpegCheck::OK;
+    }
+    if (!prefixes_ok) g_failures++;
+    printf("%s every truncation rejected\n", prefixes_ok ? "ok  " : "FAIL");
+}
+
+// Random mutations: no faults, frame_end always within the buffer and on an
+// EOI when accepted, and fast == strict while the scan fits in the window
+void fuzz(std::mt19937& rng, int iterations) {
+    std::vector<std::vector<uint8_t>> corpus;
+    corpus.push_back(frame(rng, 1500, 0));
+    corpus.push_back(frame(rng, 3000, 128));
+    corpus.push_back(frame(rng, 12000, 512));
+    int accepted = 0;
+    int mismatches = 0;
+    for (int i = 0; i < iterations; i++) {
+        std::vector<uint8_t> data = corpus[rng() % corpus.size()];
+        int mutations = 1 + (int)(rng() % 4);
+        for (int m = 0; m < mutations; m++) {
+            size_t at = rng() % data.size();
+            switch (rng() % 4) {
+                case 0: data[at] = (uint8_t)rng(); break;
+                case 1: data[at] = 0xFF; break;
+                case 2: data.resize(at + 1); break;
+                default: data.insert(data.begin() + at, (size_t)(1 + rng() % 64), (uint8_t)rng()); break;
+            }
+        }
+        std::vector<uint8_t> exact(data.begin(), data.end());
+        size_t fast_end = 0;
+        size_t strict_end = 0;
+        JpegCheck fast = validateJpegFrame(exact.data(), exact.size(), JpegValidation::FAST, fast_end);
+        JpegCheck strict = validateJpegFrame(exact.data(), exact.size(), JpegValidation::STRICT, strict_end);
+        for (int k = 0; k < 2; k++) {
+            JpegCheck check = k ? strict : fast;
+            size_t end = k ? strict_end : fast_end;
+            if (check == JpegCheck::OK && (end < 4 || end > exact.size() || exact[end - 2] != 0xFF ||
+                                           exact[end - 1] != 0xD9)) {
+                mismatches++;
+            }
+        }
+        if (exact.size() < JpegValidatorConfig::MAX_TRAILING_SCAN && (fast != strict || fast_end != strict_end)) {
+            mismatches++;
+        }
+        if (fast == JpegCheck::OK) accepted++;
+    }
+    if (mismatches) g_failures++;
+    printf("%s fuzz: %d mutations, %d accepted, %d mismatches\n", mismatches ? "FAIL" : "ok  ", iterations, accepted,
+           mismatches);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int fuzz_iterations = 50000;
+    unsigned seed = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n': fuzz_iterations = atoi(optarg) > 0 ? atoi(optarg) : 0; break;
+            case 's': seed = (unsigned)strtoul(optarg, nullptr, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-n fuzz_iterations] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    std::mt19937 rng(seed);
+    testScan(rng);
+    testHeaders(rng);
+    if (fuzz_iterations > 0) fuzz(rng, fuzz_iterations);
+
+    if (g_failures) {
+        printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
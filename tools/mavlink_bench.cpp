@@ -0,0 +1,576 @@
+// tools/mavlink_bench.cpp - Host throughput benchmark for the MAVLink v2 parser
+//
+// Build:  g++ -std=c++11 -O2 -Iinclude tools/mavlink_bench.cpp src/flight_controller/mavlink_v2.cpp src/flight_controller/fc_telemetry.cpp -o mavlink_bench
+// Usage:  mavlink_bench [-i iterations] [-c chunk] [-d] [-r every] capture.tlog [...]   # parse rate per file
+//         mavlink_bench -g out.tlog [-n seconds] [-x permille]             # writes a synthetic tlog
+//
+//   mavlink_bench -c 64 flight.tlog          # firmware path fed in 64-byte reads (the FIFO threshold)
+//   mavlink_bench -d flight.tlog             # also decodes telemetry, prints the last values
+//   mavlink_bench -r 5 flight.tlog           # recovery pass corrupts the length of every 5th frame
+//
+// A .tlog (Mission Planner, QGroundControl, MAVProxy) is each packet as
+// received, preceded by an 8-byte big-endian timestamp. The file is parsed
+// as a raw byte stream, so the timestamps show up as garbage bytes the
+// parser has to skip, much like line noise. Three passes:
+//   in place  - MavlinkParser over the whole file, no copies
+//   chunked   - the firmware's readMavlink(): a 1 KB buffer filled `chunk`
+//               bytes at a time, the partial frame moved to the front
+//   bytewise  - a byte-at-a-time state machine that copies each frame out,
+//               like the reference C library, as the baseline
+// The first two must find the same frames. The baseline can find fewer: a
+// 0xFD in a timestamp or in noise swallows the frame behind it, and it
+// cannot rescan after the false start.
+// A recovery pass then overwrites the length byte of every n-th frame (known
+// or not) and counts how many of the untouched frames are still found;
+// -r 0 skips it.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+
+#include "fc_telemetry.h"
+#include "mavlink_v2.h"
+
+namespace {
+
+struct PassResult {
+    uint64_t frames{0};
+    uint64_t digest{0};         // Order-sensitive hash of msgid + payload, for cross-checks
+    double us{0};
+};
+
+struct MessageCount {
+    uint32_t id;
+    const char* name;
+    uint64_t count;
+};
+
+double elapsedUs(std::chrono::steady_clock::time_point start, int iterations) {
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+uint64_t mix(uint64_t digest, uint32_t msgid, const uint8_t* payload, size_t length) {
+    digest = (digest ^ msgid) * 1099511628211ull;
+    for (size_t i = 0; i < length; i++) {
+        digest = (digest ^ payload[i]) * 1099511628211ull;
+    }
+    return digest;
+}
+
+bool readFile(const char* path, std::vector<uint8_t>& data) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    uint8_t chunk[65536];
+    size_t length;
+    while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + length);
+    }
+    fclose(file);
+    return true;
+}
+
+PassResult passInPlace(const std::vector<uint8_t>& data, int iterations, MavlinkParserStats& stats) {
+    PassResult result;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        MavlinkParser parser;
+        MavlinkFrame frame;
+        size_t offset = 0;
+        result.frames = 0;
+        result.digest = 14695981039346656037ull;
+        while (parser.next(data.data(), data.size(), offset, frame)) {
+            result.frames++;
+            result.digest = mix(result.digest, frame.msgid, frame.payload(), frame.length);
+        }
+        stats = parser.getStats();
+    }
+    result.us = elapsedUs(start, iterations);
+    return result;
+}
+
+// Same buffer handling as FlightController::readMavlink()
+PassResult passChunked(const std::vector<uint8_t>& data, size_t chunk, int iterations) {
+    PassResult result;
+    uint8_t buffer[1024];
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        MavlinkParser parser;
+        MavlinkFrame frame;
+        size_t buffered = 0;
+        result.frames = 0;
+        result.digest = 14695981039346656037ull;
+        for (size_t position = 0; position < data.size();) {
+            size_t room = sizeof(buffer) - buffered;
+            size_t length = data.size() - position;
+            if (length > chunk) length = chunk;
+            if (length > room) length = room;
+            memcpy(buffer + buffered, data.data() + position, length);     // The UART driver's copy
+            position += length;
+            buffered += length;
+
+            size_t offset = 0;
+            while (parser.next(buffer, buffered, offset, frame)) {
+                result.frames++;
+                result.digest = mix(result.digest, frame.msgid, frame.payload(), frame.length);
+            }
+            buffered -= offset;
+            memmove(buffer, buffer + offset, buffered);
+        }
+    }
+    result.us = elapsedUs(start, iterations);
+    return result;
+}
+
+// Baseline: one state per header byte, every byte copied into a frame
+// buffer and checksummed as it arrives
+class BytewiseParser {
+public:
+    bool feed(uint8_t byte) {
+        switch (state_) {
+            case 0:
+                if (byte != MavlinkConfig::STX) return false;
+                length_ = 0;
+                crc_ = 0xFFFF;
+                frame_[length_++] = byte;
+                state_ = 1;
+                return false;
+            case 1:
+                if (length_ == 3 && (frame_[2] & ~MavlinkConfig::INCOMPAT_SIGNED)) {
+                    state_ = 0;
+                    return feed(byte);
+                }
+                frame_[length_++] = byte;
+                crc_ = MavlinkDetail::x25(crc_, byte);
+                if (length_ == MavlinkConfig::HEADER_SIZE + frame_[1]) state_ = 2;
+                return false;
+            case 2:
+                frame_[length_++] = byte;
+                if (length_ < MavlinkConfig::HEADER_SIZE + frame_[1] + MavlinkConfig::CHECKSUM_SIZE) return false;
+                if ((frame_[2] & MavlinkConfig::INCOMPAT_SIGNED) == 0) return finish();
+                state_ = 3;
+                return false;
+            default:
+                frame_[length_++] = byte;
+                if (length_ < MavlinkConfig::HEADER_SIZE + frame_[1] + MavlinkConfig::CHECKSUM_SIZE +
+                              MavlinkConfig::SIGNATURE_SIZE) {
+                    return false;
+                }
+                return finish();
+        }
+    }
+
+    uint32_t msgid() const { return frame_[7] | ((uint32_t)frame_[8] << 8) | ((uint32_t)frame_[9] << 16); }
+    const uint8_t* payload() const { return frame_ + MavlinkConfig::HEADER_SIZE; }
+    uint8_t length() const { return frame_[1]; }
+
+private:
+    uint8_t frame_[MavlinkConfig::MAX_FRAME];
+    size_t length_{0};
+    uint16_t crc_{0xFFFF};
+    int state_{0};
+
+    bool finish() {
+        state_ = 0;
+        const MavlinkMessageInfo* info = mavlinkFindMessage(msgid());
+        if (!info) return false;
+        uint16_t crc = MavlinkDetail::x25(crc_, info->crc_extra);
+        const uint8_t* checksum = frame_ + MavlinkConfig::HEADER_SIZE + frame_[1];
+        return crc == (uint16_t)(checksum[0] | (checksum[1] << 8));
+    }
+};
+
+PassResult passBytewise(const std::vector<uint8_t>& data, int iterations) {
+    PassResult result;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        BytewiseParser parser;
+        result.frames = 0;
+        result.digest = 14695981039346656037ull;
+        for (uint8_t byte : data) {
+            if (!parser.feed(byte)) continue;
+            result.frames++;
+            result.digest = mix(result.digest, parser.msgid(), parser.payload(), parser.length());
+        }
+    }
+    result.us = elapsedUs(start, iterations);
+    return result;
+}
+
+uint32_t xorshift(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Where the length fields lay frames out, checksums unchecked: the frames a
+// parser that trusts every length would step through
+std::vector<size_t> frameStarts(const std::vector<uint8_t>& data) {
+    std::vector<size_t> starts;
+    for (size_t i = 0; i + 3 <= data.size();) {
+        if (data[i] != MavlinkConfig::STX || (data[i + 2] & ~MavlinkConfig::INCOMPAT_SIGNED)) {
+            i++;
+            continue;
+        }
+        size_t size = MavlinkConfig::HEADER_SIZE + data[i + 1] + MavlinkConfig::CHECKSUM_SIZE +
+                      ((data[i + 2] & MavlinkConfig::INCOMPAT_SIGNED) ? MavlinkConfig::SIGNATURE_SIZE : 0);
+        if (i + size > data.size()) break;
+        starts.push_back(i);
+        i += size;
+    }
+    return starts;
+}
+
+struct RecoveryResult {
+    size_t corrupted{0};        // Length bytes overwritten
+    size_t intact{0};           // Valid frames none of whose bytes were touched
+    size_t recovered{0};        // ...of which the parser still found
+    size_t false_frames{0};     // Found in the corrupted data, not in the clean one
+    bool chunked_match{true};
+};
+
+// A wrong length on a frame outside the subset is the case the checksum
+// cannot catch: the parser must not skip the real frames it covers
+RecoveryResult passRecovery(const std::vector<uint8_t>& data, size_t chunk, uint32_t every) {
+    RecoveryResult result;
+    std::vector<size_t> clean_offsets, clean_sizes;
+    {
+        MavlinkParser parser;
+        MavlinkFrame frame;
+        size_t offset = 0;
+        while (parser.next(data.data(), data.size(), offset, frame)) {
+            clean_offsets.push_back((size_t)(frame.data - data.data()));
+            clean_sizes.push_back(frame.size());
+        }
+    }
+
+    std::vector<uint8_t> corrupted = data;
+    std::vector<bool> touched(data.size(), false);
+    std::vector<size_t> starts = frameStarts(data);
+    uint32_t random = 88172645u;
+    for (size_t i = every - 1; i < starts.size(); i += every) {
+        uint8_t& length = corrupted[starts[i] + 1];
+        length = (uint8_t)(length + 1 + xorshift(random) % 254);
+        touched[starts[i] + 1] = true;
+        result.corrupted++;
+    }
+
+    std::vector<bool> intact(data.size(), false);
+    for (size_t i = 0; i < clean_offsets.size(); i++) {
+        bool untouched = true;
+        for (size_t b = clean_offsets[i]; b < clean_offsets[i] + clean_sizes[i] && untouched; b++) {
+            untouched = !touched[b];
+        }
+        if (untouched) {
+            intact[clean_offsets[i]] = true;
+            result.intact++;
+        }
+    }
+
+    MavlinkParser parser;
+    MavlinkFrame frame;
+    size_t offset = 0;
+    uint64_t digest = 14695981039346656037ull;
+    size_t frames = 0;
+    while (parser.next(corrupted.data(), corrupted.size(), offset, frame)) {
+        size_t at = (size_t)(frame.data - corrupted.data());
+        if (intact[at]) {
+            result.recovered++;
+        } else if (!std::binary_search(clean_offsets.begin(), clean_offsets.end(), at)) {
+            result.false_frames++;
+        }
+        frames++;
+        digest = mix(digest, frame.msgid, frame.payload(), frame.length);
+    }
+    PassResult chunked = passChunked(corrupted, chunk, 1);
+    result.chunked_match = chunked.frames == frames && chunked.digest == digest;
+    return result;
+}
+
+void printPass(const char* name, const PassResult& pass, size_t bytes) {
+    printf("  %-9s %9.1f us  %8.1f MB/s  %9.0f frames/s  %6.1f ns/frame\n", name, pass.us,
+           bytes / pass.us, pass.frames / (pass.us / 1e6), pass.frames ? pass.us * 1000 / pass.frames : 0.0);
+}
+
+// Message counts and, with -d, the telemetry the firmware would have cached
+void printContents(const std::vector<uint8_t>& data, bool decode) {
+    MessageCount counts[] = {
+        {MavlinkMessage::HEARTBEAT.id, MavlinkMessage::HEARTBEAT.name, 0},
+        {MavlinkMessage::SYS_STATUS.id, MavlinkMessage::SYS_STATUS.name, 0},
+        {MavlinkMessage::RAW_IMU.id, MavlinkMessage::RAW_IMU.name, 0},
+        {MavlinkMessage::ATTITUDE.id, MavlinkMessage::ATTITUDE.name, 0},
+        {MavlinkMessage::GLOBAL_POSITION_INT.id, MavlinkMessage::GLOBAL_POSITION_INT.name, 0},
+        {MavlinkMessage::RC_CHANNELS.id, MavlinkMessage::RC_CHANNELS.name, 0},
+        {MavlinkMessage::COMMAND_LONG.id, MavlinkMessage::COMMAND_LONG.name, 0},
+        {MavlinkMessage::COMMAND_ACK.id, MavlinkMessage::COMMAND_ACK.name, 0},
+        {MavlinkMessage::BATTERY_STATUS.id, MavlinkMessage::BATTERY_STATUS.name, 0},
+    };
+    MavlinkParser parser;
+    MavlinkFrame frame;
+    FcTelemetry telemetry;
+    uint64_t decoded = 0;
+    size_t offset = 0;
+    uint8_t system_id = 0, component_id = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    while (parser.next(data.data(), data.size(), offset, frame)) {
+        for (MessageCount& count : counts) {
+            if (count.id == frame.msgid) count.count++;
+        }
+        // Only the autopilot counts, as in FlightController::handleMavlinkFrame()
+        if (system_id == 0 && frame.msgid == MavlinkMessage::HEARTBEAT.id &&
+            frame.get<uint8_t>(5) != MavlinkEnum::MAV_AUTOPILOT_INVALID &&
+            frame.get<uint8_t>(4) != MavlinkEnum::MAV_TYPE_GCS) {
+            system_id = frame.system_id;
+            component_id = frame.component_id;
+        }
+        if (decode && frame.system_id == system_id && frame.component_id == component_id &&
+            decodeMavlinkTelemetry(frame, telemetry) != FcField::COUNT) {
+            decoded++;
+        }
+    }
+    double us = elapsedUs(start, 1);
+
+    for (const MessageCount& count : counts) {
+        if (count.count) printf("  %-20s %8llu\n", count.name, (unsigned long long)count.count);
+    }
+    if (!decode) return;
+    printf("  parse + decode: %.1f us, %llu telemetry updates from system %u component %u\n", us,
+           (unsigned long long)decoded, system_id, component_id);
+    printf("  last: roll %.1f pitch %.1f yaw %d deg, %u RC channels (ch1 %u), %s, %.2f V, %.2f A, %u mAh, "
+           "alt %.2f m, vario %d cm/s\n", telemetry.roll_dd / 10.0, telemetry.pitch_dd / 10.0, telemetry.yaw_deg,
+           telemetry.rc_count, telemetry.rc[0], telemetry.armed ? "armed" : "disarmed",
+           telemetry.battery_cv / 100.0, telemetry.current_ca / 100.0, telemetry.consumed_mah,
+           telemetry.altitude_cm / 100.0, telemetry.vario_cms);
+}
+
+int benchFile(const char* path, int iterations, size_t chunk, bool decode, uint32_t every) {
+    std::vector<uint8_t> data;
+    if (!readFile(path, data)) {
+        perror(path);
+        return 2;
+    }
+    MavlinkParserStats stats;
+    PassResult in_place = passInPlace(data, iterations, stats);
+    PassResult chunked = passChunked(data, chunk, iterations);
+    PassResult bytewise = passBytewise(data, iterations);
+
+    printf("%s: %zu bytes, %llu frames (%u checksum errors, %u not in subset, %u signed, %u bad headers, "
+           "%u garbage bytes)\n", path, data.size(), (unsigned long long)in_place.frames, stats.crc_errors,
+           stats.unknown, stats.signed_frames, stats.bad_headers, stats.garbage_bytes);
+    printPass("in place", in_place, data.size());
+    printPass("chunked", chunked, data.size());
+    printPass("bytewise", bytewise, data.size());
+    if (bytewise.frames != in_place.frames) {
+        printf("  bytewise found %lld frames fewer (no rescan after a false start)\n",
+               (long long)in_place.frames - (long long)bytewise.frames);
+    }
+    printContents(data, decode);
+
+    if (chunked.frames != in_place.frames || chunked.digest != in_place.digest) {
+        printf("  MISMATCH: chunked pass found different frames\n");
+        return 1;
+    }
+    if (every == 0) return 0;
+
+    RecoveryResult recovery = passRecovery(data, chunk, every);
+    printf("  recovery: %zu length bytes corrupted (1 in %u frames), %zu of %zu intact frames found "
+           "(%zu lost, %zu false)\n", recovery.corrupted, every, recovery.recovered, recovery.intact,
+           recovery.intact - recovery.recovered, recovery.false_frames);
+    if (!recovery.chunked_match) {
+        printf("  MISMATCH: chunked pass found different frames in the corrupted data\n");
+        return 1;
+    }
+    return 0;
+}
+
+// ---- Synthetic capture ----
+
+struct SyntheticStream {
+    const MavlinkMessageInfo* info;
+    uint32_t id;                // Messages outside the subset get random payloads
+    uint8_t length;
+    uint8_t system_id;
+    uint8_t component_id;
+    uint32_t period_ms;
+};
+
+void fillPayload(uint8_t* p, const SyntheticStream& stream, double s, uint32_t& random) {
+    memset(p, 0, MavlinkConfig::MAX_PAYLOAD);
+    if (!stream.info) {
+        for (size_t i = 0; i < stream.length; i++) p[i] = (uint8_t)xorshift(random);
+        return;
+    }
+    uint32_t boot_ms = (uint32_t)(s * 1000);
+    switch (stream.id) {
+        case MavlinkMessage::HEARTBEAT.id:
+            mavlinkPut<uint32_t>(p, 0, stream.system_id == 255 ? 0 : 5);       // Loiter
+            p[4] = stream.system_id == 255 ? MavlinkEnum::MAV_TYPE_GCS : 2;   // Quadrotor
+            p[5] = stream.system_id == 255 ? MavlinkEnum::MAV_AUTOPILOT_INVALID : 3;  // ArduPilot
+            p[6] = s > 2 && stream.system_id != 255 ? MavlinkEnum::MAV_MODE_FLAG_SAFETY_ARMED | 0x01 : 0x01;
+            p[7] = MavlinkEnum::MAV_STATE_ACTIVE;
+            p[8] = 3;
+            break;
+        case MavlinkMessage::ATTITUDE.id:
+            mavlinkPut<uint32_t>(p, 0, boot_ms);
+            mavlinkPut<float>(p, 4, (float)(0.5 * sin(s * 2.1)));
+            mavlinkPut<float>(p, 8, (float)(0.3 * sin(s * 1.3)));
+            mavlinkPut<float>(p, 12, (float)(fmod(s * 0.3, 6.2831853) - 3.1415926));
+            mavlinkPut<float>(p, 16, (float)(1.05 * cos(s * 2.1)));
+            break;
+        case MavlinkMessage::RAW_IMU.id:
+            mavlinkPut<uint64_t>(p, 0, (uint64_t)(s * 1e6));
+            for (int i = 0; i < 3; i++) {
+                mavlinkPut<int16_t>(p, 8 + 2 * i, (int16_t)((i == 2 ? -1000 : 0) + 30 * sin(s * (7 + i))));
+                mavlinkPut<int16_t>(p, 14 + 2 * i, (int16_t)(120 * sin(s * (3 + i))));
+                mavlinkPut<int16_t>(p, 20 + 2 * i, (int16_t)(200 + i * 50));
+            }
+            break;
+        case MavlinkMessage::RC_CHANNELS.id:
+            mavlinkPut<uint32_t>(p, 0, boot_ms);
+            for (int i = 0; i < 16; i++) {
+                mavlinkPut<uint16_t>(p, 4 + 2 * i, (uint16_t)(i < 4 ? 1500 + 400 * sin(s * (0.5 + i)) : 1000));
+            }
+            p[40] = 16;
+            p[41] = 255;
+            break;
+        case MavlinkMessage::SYS_STATUS.id:
+            mavlinkPut<uint16_t>(p, 12, 250);
+            mavlinkPut<uint16_t>(p, 14, (uint16_t)(16800 - s * 20));
+            mavlinkPut<int16_t>(p, 16, (int16_t)(s > 2 ? 1250 : 40));
+            p[30] = 87;
+            break;
+        case MavlinkMessage::BATTERY_STATUS.id:
+            mavlinkPut<int32_t>(p, 0, (int32_t)(s * 3.5));
+            mavlinkPut<int32_t>(p, 4, -1);
+            for (int i = 0; i < 10; i++) mavlinkPut<uint16_t>(p, 10 + 2 * i, i < 4 ? 4200 : UINT16_MAX);
+            mavlinkPut<int16_t>(p, 30, (int16_t)(s > 2 ? 1250 : 40));
+            p[35] = 87;
+            break;
+        case MavlinkMessage::GLOBAL_POSITION_INT.id:
+            mavlinkPut<uint32_t>(p, 0, boot_ms);
+            mavlinkPut<int32_t>(p, 4, 557558000);
+            mavlinkPut<int32_t>(p, 8, 376173000);
+            mavlinkPut<int32_t>(p, 12, (int32_t)(150000 + (s > 2 ? (s - 2) * 500 : 0)));
+            mavlinkPut<int32_t>(p, 16, (int32_t)(s > 2 ? (s - 2) * 500 : 0));
+            mavlinkPut<int16_t>(p, 24, (int16_t)(s > 2 ? -50 : 0));
+            mavlinkPut<uint16_t>(p, 26, (uint16_t)(fmod(s * 17, 360) * 100));
+            break;
+        default:
+            break;
+    }
+}
+
+// ArduPilot-like telemetry at the rates the firmware asks for at 50 Hz,
+// plus traffic outside the subset and a GCS heartbeat routed through
+int writeSynthetic(const char* path, uint32_t seconds, uint32_t corrupt_permille) {
+    using namespace MavlinkMessage;
+    const SyntheticStream streams[] = {
+        {&HEARTBEAT, HEARTBEAT.id, HEARTBEAT.length, 1, 1, 1000},
+        {&HEARTBEAT, HEARTBEAT.id, HEARTBEAT.length, 255, 190, 1000},     // GCS, routed to this port
+        {&ATTITUDE, ATTITUDE.id, ATTITUDE.length, 1, 1, 20},
+        {&RAW_IMU, RAW_IMU.id, RAW_IMU.length, 1, 1, 20},
+        {&RC_CHANNELS, RC_CHANNELS.id, RC_CHANNELS.length, 1, 1, 20},
+        {&SYS_STATUS, SYS_STATUS.id, SYS_STATUS.length, 1, 1, 100},
+        {&BATTERY_STATUS, BATTERY_STATUS.id, BATTERY_STATUS.length, 1, 1, 100},
+        {&GLOBAL_POSITION_INT, GLOBAL_POSITION_INT.id, GLOBAL_POSITION_INT.length, 1, 1, 100},
+        {nullptr, 24, 30, 1, 1, 200},       // GPS_RAW_INT
+        {nullptr, 36, 21, 1, 1, 100},       // SERVO_OUTPUT_RAW
+        {nullptr, 74, 20, 1, 1, 100},       // VFR_HUD
+        {nullptr, 241, 32, 1, 1, 500},      // VIBRATION
+        {nullptr, 253, 51, 1, 1, 5000},     // STATUSTEXT
+    };
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        perror(path);
+        return 2;
+    }
+    uint8_t frame[MavlinkConfig::MAX_FRAME];
+    uint8_t sequence[256] = {};
+    uint32_t random = 2463534242u;
+    uint64_t epoch_us = 1767225600000000ull;      // tlog stamps are wall clock
+    uint64_t records = 0, bytes = 0, corrupted = 0;
+
+    for (uint32_t ms = 0; ms < seconds * 1000; ms++) {
+        for (const SyntheticStream& stream : streams) {
+            if (ms % stream.period_ms != 0) continue;
+            MavlinkMessageInfo info = stream.info ? *stream.info : MavlinkMessageInfo{stream.id, "", stream.length, 0};
+            fillPayload(frame + MavlinkConfig::HEADER_SIZE, stream, ms / 1000.0, random);
+            size_t size = mavlinkFinishFrame(frame, info, sequence[stream.system_id]++, stream.system_id,
+                                             stream.component_id);
+            if (xorshift(random) % 1000 < corrupt_permille) {
+                frame[xorshift(random) % size] ^= (uint8_t)(1 + xorshift(random) % 255);
+                corrupted++;
+            }
+            uint64_t stamp = epoch_us + (uint64_t)ms * 1000 + xorshift(random) % 1000;
+            uint8_t header[8];
+            for (int i = 0; i < 8; i++) header[i] = (uint8_t)(stamp >> (56 - 8 * i));
+            fwrite(header, 1, sizeof(header), file);
+            fwrite(frame, 1, size, file);
+            records++;
+            bytes += size;
+        }
+    }
+    fclose(file);
+    fprintf(stderr, "wrote %s: %llu frames, %llu corrupted, %.1f KB/s of MAVLink (%.0f baud needed)\n", path,
+            (unsigned long long)records, (unsigned long long)corrupted, bytes / 1024.0 / seconds,
+            bytes * 10.0 / seconds);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* synthetic_path = nullptr;
+    uint32_t synthetic_seconds = 60;
+    uint32_t corrupt_permille = 0;
+    int iterations = 20;
+    size_t chunk = 64;
+    bool decode = false;
+    uint32_t every = 10;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "i:c:dr:g:n:x:")) != -1) {
+        switch (opt) {
+            case 'i': iterations = atoi(optarg); break;
+            case 'c': chunk = (size_t)atoi(optarg); break;
+            case 'd': decode = true; break;
+            case 'r': every = (uint32_t)atoi(optarg); break;
+            case 'g': synthetic_path = optarg; break;
+            case 'n': synthetic_seconds = (uint32_t)atoi(optarg); break;
+            case 'x': corrupt_permille = (uint32_t)atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-i iterations] [-c chunk] [-d] [-r every] capture.tlog [...]\n"
+                                "       %s -g out.tlog [-n seconds] [-x permille]\n", argv[0], argv[0]);
+                return 2;
+        }
+    }
+    if (synthetic_path) {
+        if (synthetic_seconds == 0 || corrupt_permille > 1000) {
+            fprintf(stderr, "at least 1 second, corruption 0-1000 permille\n");
+            return 2;
+        }
+        return writeSynthetic(synthetic_path, synthetic_seconds, corrupt_permille);
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "need a capture file\n");
+        return 2;
+    }
+    if (iterations < 1 || chunk < 1 || chunk > 1024 - MavlinkConfig::MAX_FRAME) {
+        fprintf(stderr, "iterations >= 1, chunk 1-%zu bytes\n", 1024 - MavlinkConfig::MAX_FRAME);
+        return 2;
+    }
+
+    int status = 0;
+    for (int i = optind; i < argc; i++) {
+        int result = benchFile(argv[i], iterations, chunk, decode, every);
+        if (result > status) status = result;
+    }
+    return status;
+}
@@ -0,0 +1,391 @@
+// tools/motion_detector_test.cpp - Host test for the motion detector's SWAR row kernel and thresholds
+//
+// Build:  g++ -std=c++11 -O1 -g -fsanitize=address,undefined -Iinclude tools/motion_detector_test.cpp src/camera/motion_detector.cpp -o motion_detector_test
+// Usage:  motion_detector_test [-n random_planes] [-s seed] [-b bench_iterations]
+//
+//   motion_detector_test             # kernel equality, threshold corpus, 200 random planes
+//   motion_detector_test -b 20000    # also times a 160x90 plane per path (build with -O2, no sanitizers)
+//
+// rowDiffSwar() must give the same cell sums as rowDiffScalar() on any data,
+// and analyze() must give the same result whichever path it takes (a plane at
+// an odd address forces the scalar one). Both are held to a plain per-pixel
+// reference, including widths that are not a multiple of 4 and planes whose
+// last cell row/column is partial.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "motion_detector.h"
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool ok, const std::string& name, const char* detail = "") {
+    if (!ok) {
+        g_failures++;
+        printf("FAIL %s %s\n", name.c_str(), detail);
+    } else {
+        printf("ok   %s\n", name.c_str());
+    }
+}
+
+// A luma plane at a chosen address: offset 0 is word-aligned, 1 is not
+class Plane {
+public:
+    Plane(uint16_t width, uint16_t height, size_t offset = 0)
+        : width_(width), height_(height), offset_(offset), storage_((size_t)width * height + 8, 0) {}
+
+    uint8_t* data() { return reinterpret_cast<uint8_t*>(words()) + offset_; }
+    uint8_t& at(uint16_t x, uint16_t y) { return data()[(size_t)y * width_ + x]; }
+    size_t size() const { return (size_t)width_ * height_; }
+
+    void copyFrom(Plane& other) { memcpy(data(), other.data(), size()); }
+
+private:
+    uint32_t* words() { return storage_.data(); }
+
+    uint16_t width_;
+    uint16_t height_;
+    size_t offset_;
+    std::vector<uint32_t> storage_;
+};
+
+// Textured but smooth background, kept below 200 so cases can brighten it
+void fillScene(Plane& plane, uint16_t width, uint16_t height) {
+    for (uint16_t y = 0; y < height; y++) {
+        for (uint16_t x = 0; x < width; x++) {
+            plane.at(x, y) = (uint8_t)(40 + (x * 3 + y * 2) % 150);
+        }
+    }
+}
+
+void fillRandom(std::mt19937& rng, uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        // Lane extremes are where a SWAR borrow would show up
+        switch (rng() % 8) {
+            case 0: data[i] = 0; break;
+            case 1: data[i] = 255; break;
+            case 2: data[i] = (uint8_t)(rng() % 2 ? 1 : 254); break;
+            default: data[i] = (uint8_t)rng(); break;
+        }
+    }
+}
+
+// Per-pixel reference for analyze(), written without rows or words
+MotionResult referenceResult(const uint8_t* luma, const uint8_t* ref, uint16_t width, uint16_t height,
+                             const MotionThresholds& t) {
+    const int cell = MotionConfig::CELL_SIZE;
+    int cells_x = (width + cell - 1) / cell;
+    int cells_y = (height + cell - 1) / cell;
+    std::vector<uint64_t> sums((size_t)cells_x * cells_y, 0);
+    std::vector<uint32_t> pixels((size_t)cells_x * cells_y, 0);
+    uint64_t total = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            size_t i = (size_t)y * width + x;
+            int diff = abs((luma[i] >> 1) - (ref[i] >> 1));
+            size_t c = (size_t)(y / cell) * cells_x + x / cell;
+            sums[c] += diff;
+            pixels[c]++;
+            total += diff;
+        }
+    }
+
+    MotionResult r;
+    r.total_cells = (uint16_t)(cells_x * cells_y);
+    r.mean_abs_diff = total * 2.0f / ((uint32_t)width * height);
+    for (size_t c = 0; c < sums.size(); c++) {
+        if (sums[c] * 2 > (uint64_t)t.cell_diff * pixels[c]) r.changed_cells++;
+    }
+    r.scene_change = r.mean_abs_diff >= t.scene_diff ||
+        (uint32_t)r.changed_cells * 100 >= (uint32_t)t.scene_cell_percent * r.total_cells;
+    r.motion = r.scene_change || r.changed_cells >= t.min_changed_cells;
+    r.is_static = r.changed_cells == 0 && r.mean_abs_diff < t.static_diff;
+    return r;
+}
+
+bool sameResult(const MotionResult& a, const MotionResult& b) {
+    return a.mean_abs_diff == b.mean_abs_diff && a.changed_cells == b.changed_cells &&
+           a.total_cells == b.total_cells && a.motion == b.motion && a.scene_change == b.scene_change &&
+           a.is_static == b.is_static;
+}
+
+std::string sizeName(const char* prefix, uint16_t width, uint16_t height) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s %ux%u", prefix, width, height);
+    return name;
+}
+
+// --- Row kernels ---
+
+// Multiples of 4 only: the firmware takes the SWAR path for nothing else
+void testKernels(std::mt19937& rng) {
+    const uint16_t widths[] = {4, 8, 12, 44, 80, 100, 160, 240};
+    for (uint16_t width : widths) {
+        bool match = true;
+        for (int round = 0; round < 50 && match; round++) {
+            std::vector<uint32_t> a(width / 4), b(width / 4);
+            fillRandom(rng, reinterpret_cast<uint8_t*>(a.data()), width);
+            fillRandom(rng, reinterpret_cast<uint8_t*>(b.data()), width);
+            uint32_t swar_cells[MotionConfig::MAX_PLANE_WIDTH / MotionConfig::CELL_SIZE + 1] = {0};
+            uint32_t scalar_cells[MotionConfig::MAX_PLANE_WIDTH / MotionConfig::CELL_SIZE + 1] = {0};
+            uint32_t swar = MotionDetector::rowDiffSwar(a.data(), b.data(), width / 4, swar_cells);
+            uint32_t scalar = MotionDetector::rowDiffScalar(reinterpret_cast<const uint8_t*>(a.data()),
+                                                            reinterpret_cast<const uint8_t*>(b.data()),
+                                                            width, scalar_cells);
+            match = swar == scalar && memcmp(swar_cells, scalar_cells, sizeof(swar_cells)) == 0;
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "SWAR == scalar, width %u", width);
+        check(match, name);
+    }
+
+    // Every byte pair in every lane: a borrow between lanes cannot hide
+    bool exhaustive = true;
+    for (int x = 0; x < 256 && exhaustive; x++) {
+        for (int y = 0; y < 256 && exhaustive; y++) {
+            uint8_t row_a[8], row_b[8];
+            for (int i = 0; i < 8; i++) {
+                row_a[i] = (uint8_t)(i % 2 ? x : y);
+                row_b[i] = (uint8_t)(i % 2 ? y : x);
+            }
+            uint32_t wa[2], wb[2];
+            memcpy(wa, row_a, sizeof(wa));
+            memcpy(wb, row_b, sizeof(wb));
+            uint32_t swar_cells[1] = {0};
+            uint32_t scalar_cells[1] = {0};
+            MotionDetector::rowDiffSwar(wa, wb, 2, swar_cells);
+            MotionDetector::rowDiffScalar(row_a, row_b, 8, scalar_cells);
+            exhaustive = swar_cells[0] == scalar_cells[0];
+        }
+    }
+    check(exhaustive, "SWAR == scalar, all byte pairs");
+}
+
+// --- analyze(): both paths against the per-pixel reference ---
+
+bool analyzeMatches(MotionDetector& detector, Plane& previous, Plane& current, uint16_t width, uint16_t height) {
+    MotionResult expected = referenceResult(current.data(), previous.data(), width, height, detector.thresholds());
+
+    Plane shifted(width, height, 1);
+    shifted.copyFrom(current);
+    MotionResult aligned, unaligned;
+    detector.setReference(previous.data(), width, height);
+    bool ok = detector.analyze(current.data(), width, height, aligned);
+    ok = detector.analyze(shifted.data(), width, height, unaligned) && ok;
+    return ok && sameResult(aligned, expected) && sameResult(unaligned, expected);
+}
+
+// Aligned widths take SWAR at an even address; the rest are scalar either way
+void testAnalyzePaths(std::mt19937& rng, int planes) {
+    const uint16_t sizes[][2] = {
+        {80, 60}, {100, 75}, {160, 90}, {240, 150}, {4, 4},                 // Multiples of 4
+        {50, 37}, {30, 30}, {13, 9}, {1, 1}, {239, 149}, {7, 150},          // Not multiples of 4
+    };
+    MotionDetector detector;
+    for (const auto& size : sizes) {
+        uint16_t width = size[0], height = size[1];
+        Plane previous(width, height), current(width, height);
+        bool match = true;
+        for (int i = 0; i < planes && match; i++) {
+            fillRandom(rng, previous.data(), previous.size());
+            // Mostly small changes, so cell thresholds are crossed both ways
+            current.copyFrom(previous);
+            int spread = 1 + (int)(rng() % 40);
+            for (size_t p = 0; p < current.size(); p++) {
+                int v = current.data()[p] + (int)(rng() % (2 * spread + 1)) - spread;
+                current.data()[p] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+            }
+            match = analyzeMatches(detector, previous, current, width, height);
+        }
+        check(match, sizeName((width % 4) == 0 ? "analyze SWAR/scalar/reference" : "analyze scalar/reference",
+                              width, height));
+    }
+}
+
+// --- Threshold corpus ---
+
+struct Expect {
+    bool motion;
+    bool scene_change;
+    bool is_static;
+};
+
+void expectResult(const std::string& name, MotionDetector& detector, Plane& previous, Plane& current,
+                  uint16_t width, uint16_t height, Expect expect) {
+    MotionResult aligned, unaligned;
+    detector.setReference(previous.data(), width, height);
+    bool ok = detector.analyze(current.data(), width, height, aligned);
+    Plane shifted(width, height, 1);
+    shifted.copyFrom(current);
+    ok = detector.analyze(shifted.data(), width, height, unaligned) && ok;
+
+    char detail[96];
+    snprintf(detail, sizeof(detail), "(diff %.2f, %u/%u cells, motion %d scene %d static %d)",
+             aligned.mean_abs_diff, aligned.changed_cells, aligned.total_cells, aligned.motion,
+             aligned.scene_change, aligned.is_static);
+    check(ok && sameResult(aligned, unaligned) && aligned.motion == expect.motion &&
+              aligned.scene_change == expect.scene_change && aligned.is_static == expect.is_static,
+          name, detail);
+}
+
+// Adds `delta` to the cells [first, first + count) in raster order
+void brightenCells(Plane& plane, uint16_t width, uint16_t height, size_t first, size_t count, int delta) {
+    const int cell = MotionConfig::CELL_SIZE;
+    size_t cells_x = (width + cell - 1) / cell;
+    for (uint16_t y = 0; y < height; y++) {
+        for (uint16_t x = 0; x < width; x++) {
+            size_t c = (y / cell) * cells_x + x / cell;
+            if (c >= first && c < first + count) {
+                plane.at(x, y) = (uint8_t)(plane.at(x, y) + delta);
+            }
+        }
+    }
+}
+
+void testThresholds(std::mt19937& rng) {
+    // VGA takes the SWAR path, CIF (50x37) the scalar one with partial edge cells
+    const uint16_t sizes[][2] = {{80, 60}, {50, 37}};
+    for (const auto& size : sizes) {
+        uint16_t width = size[0], height = size[1];
+        const int cell = MotionConfig::CELL_SIZE;
+        size_t total_cells = (size_t)((width + cell - 1) / cell) * ((height + cell - 1) / cell);
+        MotionDetector detector;
+        Plane previous(width, height), current(width, height);
+        fillScene(previous, width, height);
+
+        current.copyFrom(previous);
+        expectResult(sizeName("static: identical", width, height), detector, previous, current, width, height,
+                     {false, false, true});
+
+        current.copyFrom(previous);
+        for (size_t p = 0; p < current.size(); p++) {
+            current.data()[p] = (uint8_t)(current.data()[p] + (int)(rng() % 3) - 1);
+        }
+        expectResult(sizeName("static: sensor noise +-1", width, height), detector, previous, current, width,
+                     height, {false, false, true});
+
+        current.copyFrom(previous);
+        for (size_t p = 0; p < current.size(); p++) current.data()[p] += 6;
+        expectResult(sizeName("quiet: uniform +6 under cell threshold", width, height), detector, previous,
+                     current, width, height, {false, false, false});
+
+        current.copyFrom(previous);
+        brightenCells(current, width, height, 1, 1, 40);
+        expectResult(sizeName("quiet: one changed cell", width, height), detector, previous, current, width,
+                     height, {false, false, false});
+
+        current.copyFrom(previous);
+        brightenCells(current, width, height, 1, 3, 40);
+        expectResult(sizeName("small motion: three cells", width, height), detector, previous, current, width,
+                     height, {true, false, false});
+
+        current.copyFrom(previous);
+        brightenCells(current, width, height, total_cells - 2, 2, 40);
+        expectResult(sizeName("small motion: partial edge cells", width, height), detector, previous, current,
+                     width, height, {true, false, false});
+
+        current.copyFrom(previous);
+        for (size_t p = 0; p < current.size(); p++) current.data()[p] += 40;
+        expectResult(sizeName("scene change: brightness jump", width, height), detector, previous, current,
+                     width, height, {true, true, false});
+
+        current.copyFrom(previous);
+        brightenCells(current, width, height, 0, (total_cells * 65 + 99) / 100, 20);
+        expectResult(sizeName("scene change: 65% of cells", width, height), detector, previous, current, width,
+                     height, {true, true, false});
+
+        current.copyFrom(previous);
+        brightenCells(current, width, height, 0, total_cells / 2, 20);
+        expectResult(sizeName("motion: half of cells", width, height), detector, previous, current, width,
+                     height, {true, false, false});
+    }
+
+    // No comparable reference: reported as a scene change so the caller re-anchors
+    MotionDetector detector;
+    Plane plane(80, 60);
+    fillScene(plane, 80, 60);
+    MotionResult result;
+    bool analyzed = detector.analyze(plane.data(), 80, 60, result);
+    check(!analyzed && result.scene_change && result.changed_cells == result.total_cells, "no reference");
+    detector.setReference(plane.data(), 80, 60);
+    analyzed = detector.analyze(plane.data(), 80, 40, result);
+    check(!analyzed && result.scene_change && result.total_cells == 50, "plane size changed");
+    detector.setReference(plane.data(), MotionConfig::MAX_PLANE_WIDTH + 4, 1);
+    analyzed = detector.analyze(plane.data(), MotionConfig::MAX_PLANE_WIDTH + 4, 1, result);
+    check(!analyzed && result.scene_change, "plane wider than MAX_PLANE_WIDTH");
+}
+
+double elapsedUs(std::chrono::steady_clock::time_point start, int iterations) {
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+// The 720p plane (160x90) through each path
+void bench(int iterations, std::mt19937& rng) {
+    const uint16_t width = 160, height = 90;
+    Plane previous(width, height), current(width, height), shifted(width, height, 1);
+    fillRandom(rng, previous.data(), previous.size());
+    fillRandom(rng, current.data(), current.size());
+    shifted.copyFrom(current);
+
+    MotionDetector detector;
+    detector.setReference(previous.data(), width, height);
+    MotionResult result;
+    uint32_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        detector.analyze(current.data(), width, height, result);
+        sink += result.changed_cells;
+    }
+    double swar_us = elapsedUs(start, iterations);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        detector.analyze(shifted.data(), width, height, result);
+        sink += result.changed_cells;
+    }
+    double scalar_us = elapsedUs(start, iterations);
+
+    printf("bench: %ux%u plane, SWAR %.2f us/frame, scalar %.2f us/frame (x%.2f) [%u]\n", width, height,
+           swar_us, scalar_us, scalar_us / swar_us, sink);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int planes = 200;
+    unsigned seed = 1;
+    int bench_iterations = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:b:")) != -1) {
+        switch (opt) {
+            case 'n': planes = atoi(optarg) > 0 ? atoi(optarg) : 0; break;
+            case 's': seed = (unsigned)strtoul(optarg, nullptr, 0); break;
+            case 'b': bench_iterations = atoi(optarg) > 0 ? atoi(optarg) : 0; break;
+            default:
+                fprintf(stderr, "usage: %s [-n random_planes] [-s seed] [-b bench_iterations]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    std::mt19937 rng(seed);
+    testKernels(rng);
+    if (planes > 0) testAnalyzePaths(rng, planes);
+    testThresholds(rng);
+    if (bench_iterations > 0) bench(bench_iterations, rng);
+
+    if (g_failures) {
+        printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
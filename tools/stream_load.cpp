@@ -0,0 +1,454 @@
+// tools/stream_load.cpp - Linux load generator: many concurrent /stream and WebSocket viewers
+//
+// Build:  g++ -std=c++11 -O2 -pthread tools/stream_load.cpp -o stream_load
+// Usage:  stream_load [-H host] [-p http_port] [-P ws_port] [-d seconds] [-r throttle_kbps]
+//                     [-k pilot_token] [-s sessions]
+//
+//   stream_load -s fast:2,throttled:2                  # 4 multipart viewers
+//   stream_load -s fast:1,stalled:2 -d 30              # head-of-line blocking behind stalled readers
+//   stream_load -s fast:1,storm:3                      # reconnect storm
+//   stream_load -s ws/fast:2 -P 8080                   # WebSocket sessions (binary JPEG messages)
+//   stream_load -H 127.0.0.1 -p 8000 -s fast:8         # any host-side server speaking the same protocol
+//
+// Sessions are `[stream/|ws/]profile:count`, comma separated:
+//   fast       reads as fast as the socket delivers
+//   throttled  reads at -r KB/s, like a viewer on a weak link
+//   stalled    reads the first frame, then stops reading but keeps the socket open
+//   storm      connects, waits for one frame, disconnects, repeats
+//
+// Per session it reports frame rate, inter-arrival p95 and, for multipart
+// streams, delivery delay from the X-Timestamp part header. Server and host
+// clocks are not synchronised, so delay is measured above the session's
+// fastest frame (queueing and head-of-line blocking, not absolute latency).
+// Fairness is Jain's index over the fast sessions' frame rates.
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+enum class Profile { FAST, THROTTLED, STALLED, STORM };
+enum class Transport { STREAM, WS };
+
+const char* profileName(Profile profile) {
+    switch (profile) {
+        case Profile::FAST:      return "fast";
+        case Profile::THROTTLED: return "throttled";
+        case Profile::STALLED:   return "stalled";
+        case Profile::STORM:     return "storm";
+    }
+    return "?";
+}
+
+struct Options {
+    std::string host{"192.168.4.1"};
+    int http_port{80};
+    int ws_port{8080};
+    int seconds{20};
+    double throttle_kbps{50};
+    std::string token;
+};
+
+struct SessionSpec {
+    Profile profile;
+    Transport transport;
+};
+
+struct SessionResult {
+    uint32_t connects{0};
+    uint32_t connect_failures{0};
+    uint32_t rejects{0};            // HTTP status other than 200/101 (e.g. 503 viewer limit)
+    uint32_t frames{0};
+    uint64_t bytes{0};
+    std::vector<double> offsets_ms; // Receive time minus X-Timestamp
+    std::vector<double> interarrival_ms;
+    double active_s{0};
+};
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+double wallMs() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+int connectTo(const std::string& host, int port) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0) {
+        return -1;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        freeaddrinfo(result);
+        return -1;
+    }
+    timeval timeout = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    // Small receive buffer, so a slow reader pushes back on the server quickly
+    int rcvbuf = 16 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    if (connect(fd, result->ai_addr, result->ai_addrlen) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+bool sendAll(int fd, const void* data, size_t length) {
+    const char* p = (const char*)data;
+    while (length > 0) {
+        ssize_t n = send(fd, p, length, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        p += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+// Buffered socket reader with an optional byte rate cap and a deadline
+class Reader {
+public:
+    Reader(int fd, double bytes_per_s, Clock::time_point deadline)
+        : fd_(fd), rate_(bytes_per_s), deadline_(deadline), start_(0), end_(0),
+          allowance_(0), refill_(Clock::now()) {}
+
+    bool readLine(std::string& line) {
+        line.clear();
+        for (;;) {
+            for (; start_ < end_; start_++) {
+                char c = buffer_[start_];
+                if (c == '\n') {
+                    start_++;
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    return true;
+                }
+                line.push_back(c);
+                if (line.size() > 1024) return false;
+            }
+            if (!fill()) return false;
+        }
+    }
+
+    bool read(void* out, size_t length) {
+        uint8_t* p = (uint8_t*)out;
+        while (length > 0) {
+            if (start_ == end_ && !fill()) return false;
+            size_t n = std::min(length, end_ - start_);
+            if (p) {
+                memcpy(p, buffer_ + start_, n);
+                p += n;
+            }
+            start_ += n;
+            length -= n;
+        }
+        return true;
+    }
+
+    bool skip(size_t length) { return read(nullptr, length); }
+
+private:
+    bool fill() {
+        for (;;) {
+            if (Clock::now() >= deadline_) return false;
+            size_t want = sizeof(buffer_);
+            if (rate_ > 0) {
+                double elapsed = std::chrono::duration<double>(Clock::now() - refill_).count();
+                refill_ = Clock::now();
+                allowance_ = std::min(allowance_ + elapsed * rate_, rate_ / 10 + 1460);
+                if (allowance_ < 1) {
+                    usleep(5000);
+                    continue;
+                }
+                want = std::min(want, (size_t)allowance_);
+            }
+            ssize_t n = recv(fd_, buffer_, want, 0);
+            if (n > 0) {
+                start_ = 0;
+                end_ = (size_t)n;
+                allowance_ -= n;
+                return true;
+            }
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) return false;
+        }
+    }
+
+    int fd_;
+    double rate_;
+    Clock::time_point deadline_;
+    uint8_t buffer_[16384];
+    size_t start_;
+    size_t end_;
+    double allowance_;
+    Clock::time_point refill_;
+};
+
+bool readHttpStatus(Reader& reader, int& status) {
+    std::string line;
+    if (!reader.readLine(line) || sscanf(line.c_str(), "HTTP/%*s %d", &status) != 1) {
+        return false;
+    }
+    while (reader.readLine(line)) {
+        if (line.empty()) return true;
+    }
+    return false;
+}
+
+// Next multipart part; false at the end of the stream
+bool readPart(Reader& reader, size_t& length, double& timestamp_ms) {
+    std::string line;
+    do {
+        if (!reader.readLine(line)) return false;
+    } while (line.compare(0, 7, "--frame") != 0);
+
+    length = 0;
+    timestamp_ms = -1;
+    while (reader.readLine(line) && !line.empty()) {
+        const char* value = strchr(line.c_str(), ':');
+        if (!value) continue;
+        if (strncasecmp(line.c_str(), "Content-Length", 14) == 0) length = strtoul(value + 1, nullptr, 10);
+        if (strncasecmp(line.c_str(), "X-Timestamp", 11) == 0) timestamp_ms = atof(value + 1) * 1000.0;
+    }
+    return length > 0 && reader.skip(length);
+}
+
+// Next binary WebSocket message; answers pings, false on close
+bool readWsMessage(int fd, Reader& reader, size_t& length) {
+    length = 0;
+    for (;;) {
+        uint8_t head[2];
+        if (!reader.read(head, 2)) return false;
+        bool fin = head[0] & 0x80;
+        uint8_t opcode = head[0] & 0x0F;
+        uint64_t size = head[1] & 0x7F;
+        if (size == 126 || size == 127) {
+            uint8_t ext[8];
+            size_t n = size == 126 ? 2 : 8;
+            if (!reader.read(ext, n)) return false;
+            size = 0;
+            for (size_t i = 0; i < n; i++) size = (size << 8) | ext[i];
+        }
+        uint8_t mask[4] = {0, 0, 0, 0};
+        if ((head[1] & 0x80) && !reader.read(mask, 4)) return false;
+
+        if (opcode == 0x8) return false;
+        if (opcode == 0x9 && size <= 125) {
+            uint8_t pong[2 + 4 + 125] = {0x8A, (uint8_t)(0x80 | size), 0, 0, 0, 0};
+            if (!reader.read(pong + 6, (size_t)size)) return false;
+            sendAll(fd, pong, 6 + (size_t)size);     // Zero mask key
+            continue;
+        }
+        if (!reader.skip((size_t)size)) return false;
+        if (opcode == 0x2 || opcode == 0x0) {
+            length += (size_t)size;
+            if (fin) return true;
+        }
+    }
+}
+
+bool openSession(int fd, const SessionSpec& spec, const Options& options, Reader& reader, SessionResult& result) {
+    std::string request;
+    if (spec.transport == Transport::STREAM) {
+        request = "GET /stream" + (options.token.empty() ? std::string() : "?token=" + options.token) +
+                  " HTTP/1.1\r\nHost: " + options.host + "\r\n\r\n";
+    } else {
+        request = "GET / HTTP/1.1\r\nHost: " + options.host +
+                  "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                  "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    }
+    int status = 0;
+    if (!sendAll(fd, request.data(), request.size()) || !readHttpStatus(reader, status)) {
+        result.connect_failures++;
+        return false;
+    }
+    if (status != (spec.transport == Transport::STREAM ? 200 : 101)) {
+        result.rejects++;
+        return false;
+    }
+    return true;
+}
+
+void runSession(const SessionSpec& spec, const Options& options, Clock::time_point deadline, SessionResult& result) {
+    double rate = spec.profile == Profile::THROTTLED ? options.throttle_kbps * 1024 : 0;
+    Clock::time_point start = Clock::now();
+
+    while (Clock::now() < deadline) {
+        int fd = connectTo(options.host, spec.transport == Transport::STREAM ? options.http_port : options.ws_port);
+        result.connects++;
+        if (fd < 0) {
+            result.connect_failures++;
+            usleep(200000);
+            continue;
+        }
+
+        Reader reader(fd, rate, deadline);
+        if (!openSession(fd, spec, options, reader, result)) {
+            close(fd);
+            usleep(spec.profile == Profile::STORM ? 10000 : 500000);
+            continue;
+        }
+
+        double last_frame = -1;
+        for (;;) {
+            size_t length = 0;
+            double timestamp_ms = -1;
+            bool ok = spec.transport == Transport::STREAM ? readPart(reader, length, timestamp_ms)
+                                                          : readWsMessage(fd, reader, length);
+            if (!ok) break;
+
+            double now = secondsSince(start);
+            result.frames++;
+            result.bytes += length;
+            if (timestamp_ms >= 0) result.offsets_ms.push_back(wallMs() - timestamp_ms);
+            if (last_frame >= 0) result.interarrival_ms.push_back((now - last_frame) * 1000);
+            last_frame = now;
+
+            if (spec.profile == Profile::STORM) break;
+            if (spec.profile == Profile::STALLED) {
+                // Hold the connection without reading; the server's writes back up
+                while (Clock::now() < deadline) usleep(100000);
+                break;
+            }
+        }
+        close(fd);
+        if (spec.profile != Profile::STORM && Clock::now() < deadline) {
+            usleep(200000);     // Server closed on us; reconnect like a browser would
+        }
+    }
+    result.active_s = secondsSince(start);
+}
+
+bool parseSessions(const char* text, std::vector<SessionSpec>& sessions) {
+    std::string spec(text);
+    size_t pos = 0;
+    while (pos <= spec.size()) {
+        size_t end = spec.find(',', pos);
+        if (end == std::string::npos) end = spec.size();
+        std::string item = spec.substr(pos, end - pos);
+        pos = end + 1;
+
+        Transport transport = Transport::STREAM;
+        if (item.compare(0, 3, "ws/") == 0) {
+            transport = Transport::WS;
+            item.erase(0, 3);
+        } else if (item.compare(0, 7, "stream/") == 0) {
+            item.erase(0, 7);
+        }
+        size_t colon = item.find(':');
+        int count = colon == std::string::npos ? 1 : atoi(item.c_str() + colon + 1);
+        std::string name = item.substr(0, colon);
+        Profile profile;
+        if (name == "fast") profile = Profile::FAST;
+        else if (name == "throttled") profile = Profile::THROTTLED;
+        else if (name == "stalled") profile = Profile::STALLED;
+        else if (name == "storm") profile = Profile::STORM;
+        else return false;
+        if (count <= 0 || count > 64) return false;
+        for (int i = 0; i < count; i++) {
+            sessions.push_back({profile, transport});
+        }
+    }
+    return !sessions.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    std::vector<SessionSpec> sessions;
+    const char* spec = "fast:2";
+
+    int opt;
+    while ((opt = getopt(argc, argv, "H:p:P:d:r:k:s:")) != -1) {
+        switch (opt) {
+            case 'H': options.host = optarg; break;
+            case 'p': options.http_port = atoi(optarg); break;
+            case 'P': options.ws_port = atoi(optarg); break;
+            case 'd': options.seconds = atoi(optarg); break;
+            case 'r': options.throttle_kbps = atof(optarg); break;
+            case 'k': options.token = optarg; break;
+            case 's': spec = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-H host] [-p http_port] [-P ws_port] [-d seconds] [-r throttle_kbps] "
+                                "[-k pilot_token] [-s [ws/]fast|throttled|stalled|storm:count,...]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (!parseSessions(spec, sessions) || options.seconds <= 0 || options.throttle_kbps <= 0) {
+        fprintf(stderr, "invalid arguments\n");
+        return 2;
+    }
+
+    printf("%s: %zu session(s) for %d s, throttled readers at %.0f KB/s\n", options.host.c_str(),
+           sessions.size(), options.seconds, options.throttle_kbps);
+    std::vector<SessionResult> results(sessions.size());
+    std::vector<std::thread> threads;
+    Clock::time_point deadline = Clock::now() + std::chrono::seconds(options.seconds);
+    for (size_t i = 0; i < sessions.size(); i++) {
+        threads.emplace_back(runSession, std::cref(sessions[i]), std::cref(options), deadline, std::ref(results[i]));
+        usleep(20000);      // Stagger connects so admission order is stable
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    printf("\n%3s %-6s %-9s %8s %7s %7s %7s %8s %9s %10s %10s\n", "id", "proto", "profile", "connects", "reject",
+           "frames", "fps", "MB", "ia p95ms", "delay p50", "delay p95");
+    double sum = 0, sum_sq = 0, total_fps = 0;
+    int fast = 0;
+    for (size_t i = 0; i < sessions.size(); i++) {
+        const SessionResult& r = results[i];
+        double fps = r.active_s > 0 ? r.frames / r.active_s : 0;
+        double min_offset = r.offsets_ms.empty() ? 0 : *std::min_element(r.offsets_ms.begin(), r.offsets_ms.end());
+        std::vector<double> delay;
+        for (double offset : r.offsets_ms) delay.push_back(offset - min_offset);
+        printf("%3zu %-6s %-9s %8u %7u %7u %7.1f %8.2f %9.1f %10.1f %10.1f\n", i,
+               sessions[i].transport == Transport::WS ? "ws" : "stream", profileName(sessions[i].profile),
+               r.connects, r.rejects, r.frames, fps, r.bytes / 1048576.0, percentile(r.interarrival_ms, 0.95),
+               percentile(delay, 0.50), percentile(delay, 0.95));
+        if (sessions[i].profile != Profile::STORM) {
+            total_fps += fps;       // A storm's "fps" is its reconnect rate
+        }
+        if (sessions[i].profile == Profile::FAST) {
+            sum += fps;
+            sum_sq += fps * fps;
+            fast++;
+        }
+    }
+
+    printf("\ntotal %.1f frames/s delivered to non-storm sessions", total_fps);
+    if (fast > 0) {
+        printf(", fast sessions: mean %.1f fps, Jain fairness %.3f", sum / fast,
+               sum_sq > 0 ? sum * sum / (fast * sum_sq) : 0.0);
+    }
+    printf("\n");
+    return 0;
+}
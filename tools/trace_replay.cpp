@@ -0,0 +1,383 @@
+// tools/trace_replay.cpp - Host replay of a recorded frame trace through the stream path
+//
+// Build:  g++ -std=c++11 -O2 -Iinclude tools/trace_replay.cpp src/camera/frame_trace.cpp src/camera/jpeg_validator.cpp src/http/viewer_policy.cpp -o trace_replay
+// Usage:  trace_replay [-r link_mbit] [-l loss_percent] [-x retransmit_ms] [-o observers]
+//                      [-q fb_count] [-v off|fast|strict] [-p sync|gate]
+//                      [-b baseline.txt] [-t tolerance_percent] trace
+//         trace_replay -g out.trace [-n frames]          # writes a synthetic 30 fps trace
+//
+//   curl -o flight.trace http://192.168.4.1/trace      # after `trace start` / `trace stop`
+//   trace_replay flight.trace > before.txt
+//   trace_replay -b before.txt flight.trace            # exit status 1 on a regression
+//   trace_replay -p gate flight.trace                  # the old fixed 33 ms loop gate, for comparison
+//
+// Frames arrive at their recorded timestamps into a driver queue of fb_count
+// buffers (a full queue drops the frame, like GRAB_WHEN_EMPTY). The stream
+// loop takes the oldest frame as soon as one is queued and the previous writes
+// returned (frame-synchronized; `-p gate` models the old 33 ms gate), validates and trims
+// it with the firmware validator, plans viewers with ViewerPolicy and writes
+// multipart parts over one shared link. Writes block like the firmware's socket
+// writes; each lost TCP segment adds a retransmit delay. The simulation uses a
+// fixed PRNG seed, so the same trace and options always give the same metrics.
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "frame_trace.h"
+#include "jpeg_validator.h"
+#include "viewer_policy.h"
+
+namespace {
+
+const size_t TCP_MSS = 1460;
+const size_t MULTIPART_OVERHEAD = 2;    // Trailing CRLF after each part
+const uint64_t LEGACY_GATE_US = 33000;  // Stream loop gate before frame-synchronized pacing
+
+struct Options {
+    double link_mbit{12.0};             // Effective TCP goodput of a busy 2.4 GHz AP
+    double loss_percent{0.0};
+    double retransmit_ms{40.0};         // Fast retransmit after duplicate ACKs
+    int observers{0};
+    size_t fb_count{3};                 // Same as the firmware camera config
+    JpegValidation validation{JpegValidation::FAST};
+    bool fixed_gate{false};             // Old stream loop: at most one frame per 33 ms
+    uint32_t seed{12345};
+};
+
+struct Random {
+    uint32_t state;
+    double next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (state >> 8) / 16777216.0;
+    }
+};
+
+// Shared radio link; a write returns when its last byte is acknowledged
+struct Link {
+    double bytes_per_us;
+    double loss;
+    uint64_t retransmit_us;
+    uint64_t free_at_us;
+    uint32_t lost_segments;
+
+    uint64_t write(uint64_t now_us, size_t bytes, Random& random) {
+        uint64_t start = std::max(now_us, free_at_us);
+        uint64_t duration = (uint64_t)(bytes / bytes_per_us);
+        size_t segments = (bytes + TCP_MSS - 1) / TCP_MSS;
+        for (size_t i = 0; loss > 0 && i < segments; i++) {
+            if (random.next() < loss) {
+                duration += retransmit_us + (uint64_t)(TCP_MSS / bytes_per_us);
+                lost_segments++;
+            }
+        }
+        free_at_us = start + duration;
+        return free_at_us;
+    }
+};
+
+struct Metric {
+    const char* name;
+    bool higher_is_better;
+    double slack;           // Absolute change always tolerated (counts, sub-ms noise)
+};
+
+const Metric METRICS[] = {
+    {"frames_in",            true,  0},
+    {"sensor_drops",         false, 1},
+    {"corrupt_drops",        false, 0},
+    {"pilot_frames",         true,  1},
+    {"pilot_fps",            true,  0.1},
+    {"pilot_latency_p50_ms", false, 0.5},
+    {"pilot_latency_p95_ms", false, 0.5},
+    {"pilot_latency_p99_ms", false, 0.5},
+    {"pilot_latency_max_ms", false, 1.0},
+    {"pilot_jitter_ms",      false, 0.2},
+    {"observer_fps",         true,  0.1},
+    {"throughput_mbit",      true,  0.05},
+    {"lost_segments",        false, 1},
+};
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t index = std::min(values.size() - 1, (size_t)(p * values.size()));
+    return values[index];
+}
+
+// Same jitter definition as the firmware's pacing report
+double meanAbsoluteDeviation(const std::vector<double>& values) {
+    if (values.empty()) return 0;
+    double mean = 0;
+    for (double v : values) mean += v;
+    mean /= values.size();
+    double deviation = 0;
+    for (double v : values) deviation += fabs(v - mean);
+    return deviation / values.size();
+}
+
+size_t multipartHeaderLength(size_t length, uint32_t timestamp_us) {
+    // Same part header as writeMultipartFrame() in src/http/mjpeg_server.cpp
+    char header[128];
+    return (size_t)snprintf(header, sizeof(header),
+                            "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\nX-Timestamp: %ld.%06ld\r\n\r\n",
+                            (unsigned)length, (long)(timestamp_us / 1000000), (long)(timestamp_us % 1000000));
+}
+
+std::map<std::string, double> replay(const std::vector<FrameTraceRecord>& frames, const Options& options) {
+    ViewerPolicy policy;
+    Random random = {options.seed};
+    Link link = {options.link_mbit / 8.0, options.loss_percent / 100.0,
+                 (uint64_t)(options.retransmit_ms * 1000), 0, 0};
+    int evicted;
+    policy.admit(ViewerRole::PILOT, nullptr, 0, &evicted);
+    for (int i = 0; i < options.observers; i++) {
+        policy.admit(ViewerRole::OBSERVER, nullptr, 0, &evicted);
+    }
+
+    std::deque<size_t> queue;
+    std::vector<double> pilot_latency;
+    std::vector<double> pilot_intervals;
+    uint64_t last_pilot_send = 0;
+    uint32_t sensor_drops = 0;
+    uint32_t corrupt_drops = 0;
+    uint32_t pilot_frames = 0;
+    uint32_t observer_frames = 0;
+    uint64_t bytes_sent = 0;
+    uint64_t next_gate = 0;
+    size_t arrived = 0;
+
+    while (arrived < frames.size() || !queue.empty()) {
+        uint64_t now = std::max(next_gate, link.free_at_us);
+        if (queue.empty() && arrived < frames.size()) {
+            now = std::max<uint64_t>(now, frames[arrived].timestamp_us);
+        }
+        for (; arrived < frames.size() && frames[arrived].timestamp_us <= now; arrived++) {
+            if (queue.size() >= options.fb_count) {
+                sensor_drops++;
+            } else {
+                queue.push_back(arrived);
+            }
+        }
+
+        const FrameTraceRecord& frame = frames[queue.front()];
+        queue.pop_front();
+        size_t frame_end = frame.length;
+        if (validateJpegFrame(frame.data, frame.length, options.validation, frame_end) != JpegCheck::OK) {
+            corrupt_drops++;
+            continue;
+        }
+        if (options.fixed_gate) {
+            next_gate = now + LEGACY_GATE_US;
+        }
+
+        size_t part = multipartHeaderLength(frame_end, frame.timestamp_us) + frame_end + MULTIPART_OVERHEAD;
+        int order[ViewerConfig::MAX_VIEWERS];
+        size_t count = policy.planFrame((uint32_t)(now / 1000), frame_end, order, ViewerConfig::MAX_VIEWERS);
+        for (size_t k = 0; k < count; k++) {
+            uint64_t done = link.write(now, part, random);
+            policy.frameWritten(order[k], frame_end);
+            bytes_sent += part;
+            if (policy.getSlot(order[k]).role == ViewerRole::PILOT) {
+                pilot_latency.push_back((done - frame.timestamp_us) / 1000.0);
+                if (last_pilot_send != 0) {
+                    pilot_intervals.push_back((now - last_pilot_send) / 1000.0);
+                }
+                last_pilot_send = now;
+                pilot_frames++;
+            } else {
+                observer_frames++;
+            }
+        }
+    }
+
+    double seconds = frames.empty() ? 0
+        : std::max<uint64_t>(link.free_at_us, frames.back().timestamp_us) / 1e6;
+    std::map<std::string, double> metrics;
+    metrics["frames_in"] = frames.size();
+    metrics["sensor_drops"] = sensor_drops;
+    metrics["corrupt_drops"] = corrupt_drops;
+    metrics["pilot_frames"] = pilot_frames;
+    metrics["pilot_fps"] = seconds > 0 ? pilot_frames / seconds : 0;
+    metrics["pilot_latency_p50_ms"] = percentile(pilot_latency, 0.50);
+    metrics["pilot_latency_p95_ms"] = percentile(pilot_latency, 0.95);
+    metrics["pilot_latency_p99_ms"] = percentile(pilot_latency, 0.99);
+    metrics["pilot_latency_max_ms"] = percentile(pilot_latency, 1.0);
+    metrics["pilot_jitter_ms"] = meanAbsoluteDeviation(pilot_intervals);
+    metrics["observer_fps"] = seconds > 0 && options.observers ? observer_frames / seconds / options.observers : 0;
+    metrics["throughput_mbit"] = seconds > 0 ? bytes_sent * 8 / seconds / 1e6 : 0;
+    metrics["lost_segments"] = link.lost_segments;
+    return metrics;
+}
+
+bool readFile(const char* path, std::vector<uint8_t>& data) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(f);
+    return true;
+}
+
+// Minimal JPEG structure the validator accepts: SOI, APP0, SOS, scan, EOI
+void syntheticFrame(std::vector<uint8_t>& frame, size_t length, Random& random, bool truncate) {
+    static const uint8_t HEADER[] = {
+        0xFF, 0xD8,
+        0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00, 0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00,
+        0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x11, 0x03, 0x11, 0x00, 0x3F, 0x00,
+    };
+    frame.assign(HEADER, HEADER + sizeof(HEADER));
+    while (frame.size() + 2 < length) {
+        frame.push_back((uint8_t)(random.next() * 255));     // Never 0xFF
+    }
+    if (!truncate) {
+        frame.push_back(0xFF);
+        frame.push_back(0xD9);
+    }
+}
+
+int writeSynthetic(const char* path, uint32_t count) {
+    Random random = {2463534242u};
+    std::vector<uint8_t> buffer(FrameTraceConfig::HEADER_SIZE + (size_t)count * (40 * 1024 + 16));
+    FrameTraceWriter writer;
+    writer.begin(buffer.data(), buffer.size());
+
+    std::vector<uint8_t> frame;
+    uint64_t timestamp = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        // 30 fps with jitter; size swings between hover (~15 KB) and fast motion (~35 KB)
+        timestamp += 33333 + (uint64_t)(random.next() * 4000) - 2000;
+        double scene = 0.5 + 0.5 * sin(i / 45.0);
+        size_t length = 15 * 1024 + (size_t)(scene * 20 * 1024) + (size_t)(random.next() * 2048);
+        syntheticFrame(frame, length, random, i % 150 == 149);
+        writer.append(timestamp, 2000 + (uint32_t)(random.next() * 1000), 1280, 720, frame.data(), frame.size());
+    }
+
+    FILE* f = fopen(path, "wb");
+    if (!f || fwrite(writer.data(), 1, writer.size(), f) != writer.size()) {
+        fprintf(stderr, "cannot write %s\n", path);
+        if (f) fclose(f);
+        return 1;
+    }
+    fclose(f);
+    printf("wrote %s: %u frames, %zu bytes\n", path, writer.frames(), writer.size());
+    return 0;
+}
+
+bool readBaseline(const char* path, std::map<std::string, double>& baseline) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char name[64];
+    double value;
+    while (fscanf(f, "%63s %lf", name, &value) == 2) {
+        baseline[name] = value;
+    }
+    fclose(f);
+    return true;
+}
+
+// Prints current vs baseline; true if no metric got worse beyond tolerance
+bool compare(const std::map<std::string, double>& current, const std::map<std::string, double>& baseline,
+             double tolerance) {
+    bool ok = true;
+    printf("%-22s %12s %12s %9s\n", "metric", "baseline", "current", "change");
+    for (const Metric& metric : METRICS) {
+        auto base = baseline.find(metric.name);
+        if (base == baseline.end()) continue;
+        double now = current.at(metric.name);
+        double delta = now - base->second;
+        double worse = metric.higher_is_better ? -delta : delta;
+        bool regressed = worse > metric.slack && worse > fabs(base->second) * tolerance;
+        ok = ok && !regressed;
+        printf("%-22s %12.2f %12.2f %+8.1f%%%s\n", metric.name, base->second, now,
+               base->second != 0 ? delta * 100 / fabs(base->second) : 0.0, regressed ? "  REGRESSION" : "");
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    const char* baseline_path = nullptr;
+    const char* synthetic_path = nullptr;
+    uint32_t synthetic_frames = 600;
+    double tolerance = 5.0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:l:x:o:q:v:p:b:t:g:n:")) != -1) {
+        switch (opt) {
+            case 'r': options.link_mbit = atof(optarg); break;
+            case 'l': options.loss_percent = atof(optarg); break;
+            case 'x': options.retransmit_ms = atof(optarg); break;
+            case 'o': options.observers = atoi(optarg); break;
+            case 'q': options.fb_count = (size_t)atoi(optarg); break;
+            case 'v':
+                if (!strcmp(optarg, "off")) options.validation = JpegValidation::OFF;
+                else if (!strcmp(optarg, "strict")) options.validation = JpegValidation::STRICT;
+                else options.validation = JpegValidation::FAST;
+                break;
+            case 'p': options.fixed_gate = !strcmp(optarg, "gate"); break;
+            case 'b': baseline_path = optarg; break;
+            case 't': tolerance = atof(optarg); break;
+            case 'g': synthetic_path = optarg; break;
+            case 'n': synthetic_frames = (uint32_t)atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-r mbit] [-l loss%%] [-x retransmit_ms] [-o observers] [-q fb_count] "
+                                "[-v off|fast|strict] [-p sync|gate] [-b baseline] [-t tolerance%%] trace\n"
+                                "       %s -g out.trace [-n frames]\n", argv[0], argv[0]);
+                return 2;
+        }
+    }
+    if (synthetic_path) {
+        return writeSynthetic(synthetic_path, synthetic_frames);
+    }
+    if (optind >= argc || options.link_mbit <= 0 || options.fb_count == 0 || options.observers < 0 ||
+        options.observers >= (int)ViewerConfig::MAX_VIEWERS) {
+        fprintf(stderr, "need a trace file; observers 0-%u\n", (unsigned)ViewerConfig::MAX_VIEWERS - 1);
+        return 2;
+    }
+
+    std::vector<uint8_t> file;
+    FrameTraceReader reader;
+    if (!readFile(argv[optind], file) || !reader.open(file.data(), file.size())) {
+        fprintf(stderr, "%s: not a frame trace\n", argv[optind]);
+        return 2;
+    }
+    std::vector<FrameTraceRecord> frames;
+    FrameTraceRecord record;
+    while (reader.next(record)) {
+        frames.push_back(record);
+    }
+    if (reader.truncated()) {
+        fprintf(stderr, "warning: trace truncated, replaying %zu of %u frames\n", frames.size(), reader.frameCount());
+    }
+
+    std::map<std::string, double> metrics = replay(frames, options);
+    if (!baseline_path) {
+        for (const Metric& metric : METRICS) {
+            printf("%s %.3f\n", metric.name, metrics[metric.name]);
+        }
+        return 0;
+    }
+
+    std::map<std::string, double> baseline;
+    if (!readBaseline(baseline_path, baseline)) {
+        fprintf(stderr, "cannot read %s\n", baseline_path);
+        return 2;
+    }
+    bool ok = compare(metrics, baseline, tolerance / 100.0);
+    printf("%s\n", ok ? "PASS" : "FAIL: pipeline regression");
+    return ok ? 0 : 1;
+}
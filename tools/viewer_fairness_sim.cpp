@@ -0,0 +1,303 @@
+// tools/viewer_fairness_sim.cpp - Host simulation of pilot/observer airtime sharing
+//
+// Build:  g++ -std=c++11 -O2 -Iinclude tools/viewer_fairness_sim.cpp src/http/viewer_policy.cpp -o viewer_fairness_sim
+// Usage:  viewer_fairness_sim [-r link_mbit] [-f frame_kb] [-s seconds_per_phase]
+//
+// Replays the stream loop against a shared link: one pilot streams alone,
+// then observers join one by one up to the station limit. Frame writes block
+// the loop until the part is on the air, so airtime spent on observers delays
+// the next capture. The ViewerPolicy schedule is compared with an equal-share
+// round-robin over all viewers.
+//
+// A second table puts one slow (reads below the frame rate) or stalled (reads
+// nothing) observer next to the pilot. "blocking" is WiFiClient::write, which
+// retries a full send buffer for ~10 s per call; "bounded" is the firmware's
+// non-blocking part write: skip while the buffer is full, drop the viewer when
+// a started part misses WRITE_DEADLINE_MS. Dropped observers reconnect.
+//
+// Exits with status 1 if the pilot's frame rate or latency under the policy
+// (with bounded writes) degrades when observers are connected.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+
+#include "viewer_policy.h"
+
+namespace {
+
+const uint64_t FRAME_INTERVAL_US = 33333;   // Sensor VSYNC period, 30 fps
+const size_t SEND_BUFFER = 5744;            // lwIP TCP_SND_BUF of the Arduino core
+const uint64_t BLOCKING_RETRY_US = 10000000;    // WiFiClient: 10 select() retries of 1 s
+const uint64_t RECONNECT_US = 2000000;      // Browser retry after a dropped stream
+
+enum class Receiver { NORMAL, SLOW, STALLED };
+enum class WriteMode { BLOCKING, BOUNDED };
+
+const char* receiverName(Receiver receiver) {
+    switch (receiver) {
+        case Receiver::NORMAL:  return "normal";
+        case Receiver::SLOW:    return "slow";
+        case Receiver::STALLED: return "stalled";
+    }
+    return "?";
+}
+
+struct Link {
+    double bytes_per_us;
+    uint64_t free_at_us;
+
+    // Blocking write: returns the completion time
+    uint64_t write(uint64_t now_us, size_t bytes) {
+        uint64_t start = std::max(now_us, free_at_us);
+        free_at_us = start + (uint64_t)(bytes / bytes_per_us);
+        return free_at_us;
+    }
+};
+
+// A viewer's TCP send buffer, drained at the rate its client reads
+struct Socket {
+    double read_bytes_per_us;       // < 0: as fast as the link
+    double buffered;
+    uint64_t updated_us;
+
+    void drain(uint64_t now_us) {
+        double drained = read_bytes_per_us < 0 ? buffered : (now_us - updated_us) * read_bytes_per_us;
+        buffered = std::max(0.0, buffered - drained);
+        updated_us = now_us;
+    }
+};
+
+enum class PartResult { SENT, NO_ROOM, SHORT };
+
+// One part written at `start`; *done is when the loop gets control back
+PartResult writePart(Link& link, Socket& socket, WriteMode mode, uint64_t start, size_t len, uint64_t* done) {
+    socket.drain(start);
+    double room = SEND_BUFFER - socket.buffered;
+    if (mode == WriteMode::BOUNDED && room < 1) {
+        *done = start;
+        return PartResult::NO_ROOM;
+    }
+    uint64_t on_air = link.write(start, len);
+    uint64_t finished = on_air;
+    if (socket.read_bytes_per_us >= 0 && len > room) {
+        finished = socket.read_bytes_per_us > 0
+            ? std::max(on_air, start + (uint64_t)((len - room) / socket.read_bytes_per_us))
+            : UINT64_MAX;
+    }
+    uint64_t limit = mode == WriteMode::BOUNDED ? (uint64_t)ViewerConfig::WRITE_DEADLINE_MS * 1000
+                                                : BLOCKING_RETRY_US;
+    if (finished - start > limit) {
+        *done = start + limit;
+        socket.buffered = SEND_BUFFER;
+        socket.updated_us = *done;
+        // Blocking writes give up and return short, the caller never noticed
+        return mode == WriteMode::BOUNDED ? PartResult::SHORT : PartResult::SENT;
+    }
+    *done = finished;
+    socket.buffered = std::min<double>(SEND_BUFFER, socket.buffered + len);
+    socket.updated_us = finished;
+    return PartResult::SENT;
+}
+
+struct PhaseResult {
+    double pilot_fps;
+    double pilot_p50_ms;
+    double pilot_p99_ms;
+    double observer_fps;
+    uint32_t drops;
+};
+
+double percentile(std::vector<double>& values, double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t index = std::min(values.size() - 1, (size_t)(p * values.size()));
+    return values[index];
+}
+
+// Deterministic frame sizes: nominal +-20%
+struct FrameSizes {
+    uint32_t state;
+    size_t nominal;
+    size_t next() {
+        state = state * 1664525u + 1013904223u;
+        return nominal * 8 / 10 + (state >> 8) % (nominal * 4 / 10 + 1);
+    }
+};
+
+struct Phase {
+    bool use_policy;
+    int observers;
+    Receiver receiver;          // Of the observers
+    WriteMode mode;
+    double link_mbit;
+    size_t frame_bytes;
+    int seconds;
+};
+
+PhaseResult runPhase(const Phase& phase) {
+    ViewerPolicy policy;
+    Link link = {phase.link_mbit / 8.0, 0};
+    FrameSizes sizes = {12345u, phase.frame_bytes};
+    int evicted;
+
+    // Pilot joins first, observers shortly after
+    Socket sockets[ViewerConfig::MAX_VIEWERS] = {};
+    policy.admit(ViewerRole::PILOT, nullptr, 0, &evicted);
+    sockets[0].read_bytes_per_us = -1;
+    for (int i = 0; i < phase.observers; i++) {
+        policy.admit(ViewerRole::OBSERVER, nullptr, 10 * (i + 1), &evicted);
+        sockets[i + 1].read_bytes_per_us = phase.receiver == Receiver::NORMAL ? -1
+                                         : phase.receiver == Receiver::SLOW ? 0.1     // 100 KB/s
+                                         : 0;
+    }
+    int viewers = phase.observers + 1;
+    uint64_t rejoin_at[ViewerConfig::MAX_VIEWERS] = {};
+
+    std::vector<double> pilot_latency;
+    uint32_t pilot_frames = 0;
+    uint32_t observer_frames = 0;
+    uint32_t drops = 0;
+    uint64_t end_us = (uint64_t)phase.seconds * 1000000;
+    uint64_t next_tick = 0;
+    uint64_t loop_free = 0;
+    uint32_t round = 0;
+
+    while (next_tick < end_us) {
+        // The loop can't take the next frame before the previous writes return
+        uint64_t now = std::max(next_tick, loop_free);
+        size_t len = sizes.next();
+
+        for (int i = 1; i < viewers; i++) {
+            if (rejoin_at[i] != 0 && now >= rejoin_at[i]) {
+                rejoin_at[i] = 0;
+                policy.admit(ViewerRole::OBSERVER, nullptr, (uint32_t)(now / 1000), &evicted);
+                sockets[i].buffered = 0;
+                sockets[i].updated_us = now;
+            }
+        }
+
+        int order[ViewerConfig::MAX_VIEWERS];
+        size_t count;
+        if (phase.use_policy) {
+            count = policy.planFrame((uint32_t)(now / 1000), len, order, ViewerConfig::MAX_VIEWERS);
+        } else {
+            count = (size_t)viewers;
+            for (int k = 0; k < viewers; k++) {
+                order[k] = (int)((round + k) % viewers);
+            }
+            round++;
+        }
+
+        uint64_t t = now;
+        for (size_t k = 0; k < count; k++) {
+            uint64_t done;
+            PartResult result = writePart(link, sockets[order[k]], phase.mode, t, len, &done);
+            t = done;
+            if (result == PartResult::SHORT) {
+                drops++;
+                policy.release(order[k]);
+                rejoin_at[order[k]] = done + RECONNECT_US;
+                continue;
+            }
+            if (result == PartResult::NO_ROOM) {
+                if (phase.use_policy) policy.frameSkipped(order[k]);
+                continue;
+            }
+            if (phase.use_policy) {
+                policy.frameWritten(order[k], len);
+            }
+            if (order[k] == 0) {
+                pilot_latency.push_back((done - now) / 1000.0);
+                pilot_frames++;
+            } else {
+                observer_frames++;
+            }
+        }
+        loop_free = t;
+
+        // Frame-synchronized loop: the next frame is the first VSYNC after the writes
+        next_tick = (now / FRAME_INTERVAL_US + 1) * FRAME_INTERVAL_US;
+    }
+
+    PhaseResult result;
+    result.pilot_fps = pilot_frames / (double)phase.seconds;
+    result.pilot_p50_ms = percentile(pilot_latency, 0.50);
+    result.pilot_p99_ms = percentile(pilot_latency, 0.99);
+    result.observer_fps = phase.observers ? observer_frames / (double)phase.seconds / phase.observers : 0;
+    result.drops = drops;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double link_mbit = 12.0;    // Effective TCP goodput of a busy 2.4 GHz AP
+    size_t frame_kb = 22;
+    int seconds = 10;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:f:s:")) != -1) {
+        switch (opt) {
+            case 'r': link_mbit = atof(optarg); break;
+            case 'f': frame_kb = (size_t)atoi(optarg); break;
+            case 's': seconds = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-r link_mbit] [-f frame_kb] [-s seconds_per_phase]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (link_mbit <= 0 || frame_kb == 0 || seconds <= 0) {
+        fprintf(stderr, "invalid arguments\n");
+        return 2;
+    }
+
+    printf("link %.1f Mbit/s, frames ~%zu KB, %d s per phase\n\n", link_mbit, frame_kb, seconds);
+    printf("%-12s %9s %10s %12s %12s %13s\n", "schedule", "observers", "pilot fps", "pilot p50 ms",
+           "pilot p99 ms", "observer fps");
+
+    bool ok = true;
+    const int max_observers = (int)ViewerConfig::MAX_VIEWERS - 1;
+    for (int mode = 0; mode < 2; mode++) {
+        bool use_policy = mode == 1;
+        Phase phase = {use_policy, 0, Receiver::NORMAL, WriteMode::BOUNDED, link_mbit, frame_kb * 1024, seconds};
+        PhaseResult alone = runPhase(phase);
+        for (int observers = 0; observers <= max_observers; observers++) {
+            phase.observers = observers;
+            PhaseResult r = observers ? runPhase(phase) : alone;
+            printf("%-12s %9d %10.1f %12.1f %12.1f %13.1f\n", use_policy ? "policy" : "equal-share",
+                   observers, r.pilot_fps, r.pilot_p50_ms, r.pilot_p99_ms, r.observer_fps);
+
+            if (use_policy && (r.pilot_fps < alone.pilot_fps * 0.95 || r.pilot_p99_ms > alone.pilot_p99_ms * 1.1 + 1.0)) {
+                ok = false;
+            }
+        }
+        printf("\n");
+    }
+
+    // One misbehaving observer next to the pilot
+    Phase phase = {true, 0, Receiver::NORMAL, WriteMode::BOUNDED, link_mbit, frame_kb * 1024, seconds};
+    PhaseResult alone = runPhase(phase);
+    printf("%-12s %9s %10s %12s %12s %13s %6s\n", "writes", "observer", "pilot fps", "pilot p50 ms",
+           "pilot p99 ms", "observer fps", "drops");
+    for (int mode = 0; mode < 2; mode++) {
+        phase.mode = mode == 0 ? WriteMode::BLOCKING : WriteMode::BOUNDED;
+        for (Receiver receiver : {Receiver::SLOW, Receiver::STALLED}) {
+            phase.observers = 1;
+            phase.receiver = receiver;
+            PhaseResult r = runPhase(phase);
+            printf("%-12s %9s %10.1f %12.1f %12.1f %13.1f %6u\n", mode == 0 ? "blocking" : "bounded",
+                   receiverName(receiver), r.pilot_fps, r.pilot_p50_ms, r.pilot_p99_ms, r.observer_fps, r.drops);
+            if (phase.mode == WriteMode::BOUNDED &&
+                (r.pilot_fps < alone.pilot_fps * 0.95 || r.pilot_p99_ms > alone.pilot_p99_ms * 1.1 + 1.0)) {
+                ok = false;
+            }
+        }
+    }
+    printf("\n");
+
+    printf("%s: pilot %s when observers join\n", ok ? "PASS" : "FAIL", ok ? "unaffected" : "degraded");
+    return ok ? 0 : 1;
+}